@@ -0,0 +1,88 @@
+#!/usr/bin/env python
+############################################################################
+#
+#   Copyright (C) 2018 PX4 Development Team. All rights reserved.
+
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in
+#    the documentation and/or other materials provided with the
+#    distribution.
+# 3. Neither the name PX4 nor the names of its contributors may be
+#    used to endorse or promote products derived from this software
+#    without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+# FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+# COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+# BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+# OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+# AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+# ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+############################################################################
+
+
+"""
+check_lz4_frame.py:
+Decode an LZ4 frame written by the logger (or by `tests log_compression`)
+with the reference LZ4 implementation and compare it to the uncompressed
+data. Uses the python lz4 module if installed, the lz4 command line tool
+otherwise.
+
+Exits with 0 if the decoded frame matches, 1 otherwise.
+"""
+
+from __future__ import print_function
+import argparse
+import subprocess
+import sys
+
+
+def decompress(frame_file):
+    try:
+        import lz4.frame
+    except ImportError:
+        return subprocess.check_output(['lz4', '-d', '-c', frame_file])
+
+    with open(frame_file, 'rb') as f:
+        # decodes the first frame, the block index after it is a skippable frame
+        return lz4.frame.decompress(f.read())
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check an LZ4 frame against the reference decoder.")
+    parser.add_argument('frame', help="compressed file (.ulg.lz4)")
+    parser.add_argument('data', help="uncompressed data the frame was written from")
+    args = parser.parse_args()
+
+    with open(args.data, 'rb') as f:
+        data = f.read()
+
+    try:
+        decoded = decompress(args.frame)
+    except Exception as e:
+        print("log_compression_lz4 FAILED: can't decode {0}: {1}".format(args.frame, e))
+        sys.exit(1)
+
+    if decoded != data:
+        offset = next((i for i, (a, b) in enumerate(zip(decoded, data)) if a != b), min(len(decoded), len(data)))
+        print("log_compression_lz4 FAILED: decoded {0} bytes, expected {1}, first difference at {2}".format(
+            len(decoded), len(data), offset))
+        sys.exit(1)
+
+    print("log_compression_lz4 PASSED: {0} bytes".format(len(data)))
+
+
+if __name__ == '__main__':
+    main()
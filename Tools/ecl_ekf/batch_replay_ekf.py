@@ -0,0 +1,140 @@
+#! /usr/bin/env python
+# -*- coding: utf-8 -*-
+
+from __future__ import print_function
+
+import argparse
+import glob
+import multiprocessing
+from multiprocessing.pool import ThreadPool
+import os
+import shutil
+import subprocess
+import time
+
+"""
+Replays the .ulg (and .ulg.lz4) files in the supplied directory through ekf2 (ekf2 replay mode) and collects the
+summary metrics of all logs (runtime, innovation test ratios, filter faults) in a single csv file.
+Every log is replayed by a separate px4 process running in its own working directory, so the uORB topics, the
+parameters and the timing of the replays are isolated from each other. Several logs are replayed in parallel,
+by default one per core.
+Requires a 'make posix_sitl_default' build. The replayed logs and the console output of each replay are kept in
+<output_dir>/<log name>/.
+"""
+
+parser = argparse.ArgumentParser(description='Replay the .ulg files in the specified directory through ekf2 and '
+                                             'summarize the estimator metrics')
+parser.add_argument("directory_path")
+parser.add_argument('-j', '--jobs', type=int, default=multiprocessing.cpu_count(),
+                    help='Number of replays to run in parallel (default: number of cores)')
+parser.add_argument('-o', '--output-dir', default='replay_results',
+                    help='Directory for the replay working directories and the summary (default: replay_results)')
+parser.add_argument('-b', '--build-dir', default=None,
+                    help='PX4 build directory (default: build/posix_sitl_default)')
+parser.add_argument('-t', '--timeout', type=float, default=3600,
+                    help='Maximum duration of a single replay in seconds (default: 3600)')
+
+args = parser.parse_args()
+
+src_path = os.path.realpath(os.path.join(os.path.dirname(__file__), '..', '..'))
+build_path = args.build_dir if args.build_dir else os.path.join(src_path, 'build', 'posix_sitl_default')
+px4_bin = os.path.realpath(os.path.join(build_path, 'src', 'firmware', 'posix', 'px4'))
+startup_script = os.path.join(src_path, 'posix-configs', 'SITL', 'init', 'ekf2', 'iris_replay_batch')
+output_dir = os.path.realpath(args.output_dir)
+
+if not os.path.isfile(px4_bin):
+    parser.error('px4 binary not found: {}'.format(px4_bin))
+
+if not os.path.isdir(args.directory_path):
+    parser.error('The directory {} does not exist'.format(args.directory_path))
+
+# same publisher rules as for a single replay (see Tools/sitl_run.sh)
+publisher_rules = ('restrict_topics: sensor_combined, vehicle_gps_position, vehicle_land_detected\n'
+                   'module: replay\n'
+                   'ignore_others: false\n')
+
+
+def replay_log(ulog_file):
+    """ replay a single log in a new px4 process and return (log file, summary file or None, wall time) """
+    name = os.path.basename(ulog_file)
+    name = name[:name.rfind('.ulg')]
+    working_dir = os.path.join(output_dir, name)
+
+    if os.path.exists(working_dir):
+        shutil.rmtree(working_dir)
+
+    os.makedirs(os.path.join(working_dir, 'rootfs'))
+
+    with open(os.path.join(working_dir, 'rootfs', 'orb_publisher.rules'), 'w') as rules_file:
+        rules_file.write(publisher_rules)
+
+    summary_file = os.path.join(working_dir, 'summary.csv')
+    env = dict(os.environ)
+    env['replay'] = os.path.realpath(ulog_file)
+    env['replay_mode'] = 'ekf2'
+    env['replay_summary'] = summary_file
+
+    start_time = time.time()
+
+    with open(os.path.join(working_dir, 'out.log'), 'w') as out, open(os.devnull, 'r') as devnull:
+        process = subprocess.Popen([px4_bin, '-d', src_path, startup_script], cwd=working_dir, env=env,
+                                   stdin=devnull, stdout=out, stderr=subprocess.STDOUT)
+
+        while process.poll() is None:
+            if time.time() - start_time > args.timeout:
+                process.kill()
+                process.wait()
+                print('{}: timeout'.format(ulog_file))
+                break
+
+            time.sleep(0.2)
+
+    wall_time = time.time() - start_time
+
+    if not os.path.exists(summary_file):
+        print('{}: replay failed (see {})'.format(ulog_file, os.path.join(working_dir, 'out.log')))
+        return ulog_file, None, wall_time
+
+    print('{}: done in {:.1f} s'.format(ulog_file, wall_time))
+    return ulog_file, summary_file, wall_time
+
+
+# get all the ulog files found in the specified directory. Skip replayed logs
+ulog_files = sorted(glob.glob(os.path.join(args.directory_path, '*.ulg')) +
+                    glob.glob(os.path.join(args.directory_path, '*.ulg.lz4')))
+ulog_files = [ulog_file for ulog_file in ulog_files if '_replayed' not in os.path.basename(ulog_file)]
+
+if not os.path.exists(output_dir):
+    os.makedirs(output_dir)
+
+print('replaying {} logs with {} jobs'.format(len(ulog_files), args.jobs))
+sweep_start_time = time.time()
+
+# the work is done by the px4 processes, so threads are sufficient to manage them
+pool = ThreadPool(max(args.jobs, 1))
+results = pool.map(replay_log, ulog_files)
+pool.close()
+
+# merge the summaries, failed replays get a row without metrics
+header = 'log_file'
+summaries = {}
+
+for ulog_file, summary_file, wall_time in results:
+    if summary_file:
+        with open(summary_file, 'r') as file:
+            header, summaries[ulog_file] = file.read().splitlines()[0:2]
+
+summary_path = os.path.join(output_dir, 'summary.csv')
+
+with open(summary_path, 'w') as file:
+    file.write('{},wall_time_s,status\n'.format(header))
+
+    for ulog_file, summary_file, wall_time in results:
+        if ulog_file in summaries:
+            file.write('{},{:.1f},ok\n'.format(summaries[ulog_file], wall_time))
+        else:
+            file.write('{}{},{:.1f},failed\n'.format(os.path.realpath(ulog_file), ',' * header.count(','), wall_time))
+
+num_failed = sum(1 for result in results if result[1] is None)
+print('\n{} logs replayed in {:.1f} s, {} failed. Summary: {}'.format(
+    len(results), time.time() - sweep_start_time, num_failed, summary_path))
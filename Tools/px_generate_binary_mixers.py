@@ -0,0 +1,256 @@
+#!/usr/bin/env python
+############################################################################
+#
+#   Copyright (C) 2018 PX4 Development Team. All rights reserved.
+
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#
+# 1. Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in
+#    the documentation and/or other materials provided with the
+#    distribution.
+# 3. Neither the name PX4 nor the names of its contributors may be
+#    used to endorse or promote products derived from this software
+#    without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+# "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+# LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+# FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+# COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+# BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+# OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+# AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+# LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+# ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+# POSSIBILITY OF SUCH DAMAGE.
+#
+############################################################################
+
+
+"""
+px_generate_binary_mixers.py:
+Compile the mixer files of a ROMFS folder into a binary mixer set.
+
+The set (see src/lib/mixer/mixer_binary.h) holds the mixers of every file in
+their in-memory layout, so that they can be loaded without parsing text. The
+values are computed with the same single precision operations as the text
+parsers of the mixer library, so both give bit-identical mixers.
+
+Files that cannot be compiled are left out with a warning, they are still
+loaded from text.
+"""
+
+from __future__ import print_function
+import argparse
+import os
+import struct
+import sys
+
+MIXER_BINARY_MAGIC = 0x424d5850
+MIXER_BINARY_INDEX_MAGIC = 0x494d5850
+MIXER_BINARY_VERSION = 1
+MIXER_BINARY_NAME_LEN = 32
+MIXER_BINARY_SET_NAME = 'mixers.bin'
+
+# the limit of the mixer command buffer
+MAX_IMAGE_SIZE = 2048
+
+M_PI_F = 3.14159265
+
+
+def f32(value):
+    """ round to single precision (exact for a single +, -, *, / of single precision operands) """
+    return struct.unpack('<f', struct.pack('<f', value))[0]
+
+
+def scaled(value):
+    """ value / 10000.0f """
+    return f32(value / 10000.0)
+
+
+def crc32(data):
+    """ crc32part(data, len, 0) as used by PX4 (no inversion) """
+    crc = 0
+
+    for byte in bytearray(data):
+        crc ^= byte
+
+        for _ in range(8):
+            crc = (crc >> 1) ^ (0xedb88320 if crc & 1 else 0)
+
+    return crc
+
+
+class MixerError(Exception):
+    pass
+
+
+def read_lines(file_path):
+    """ the mixer definition lines, like load_mixer_file() """
+    lines = []
+
+    with open(file_path, 'r') as f:
+        for line in f:
+            if len(line) < 2 or not line[0].isupper() or line[1] != ':':
+                continue
+
+            lines.append((line[0], line[2:].split()))
+
+    return lines
+
+
+def parse_ints(tag, fields, count):
+    if len(fields) < count:
+        raise MixerError('{}: expected {} values, got {}'.format(tag, count, len(fields)))
+
+    try:
+        return [int(field) for field in fields[:count]]
+    except ValueError:
+        raise MixerError('{}: invalid value in {}'.format(tag, fields))
+
+
+def record(tag, control_count, payload):
+    return struct.pack('<BBH', ord(tag), control_count, len(payload)) + payload
+
+
+def scaler(values):
+    return struct.pack('<5f', *[scaled(value) for value in values])
+
+
+def compile_mixers(lines):
+    """ compile the mixer definition lines into records """
+    records = []
+    i = 0
+
+    def next_line(tag):
+        if i >= len(lines) or lines[i][0] != tag:
+            raise MixerError('expected {}: line'.format(tag))
+
+        return lines[i][1]
+
+    while i < len(lines):
+        tag, fields = lines[i]
+        i += 1
+
+        if tag == 'Z':
+            records.append(record('Z', 0, b''))
+
+        elif tag == 'M':
+            count = parse_ints('M', fields, 1)[0]
+
+            if count < 1 or count > 255:
+                raise MixerError('M: invalid control count {}'.format(count))
+
+            # mixer_simple_s: the output scaler, then the controls
+            output_scaler = [10000, 10000, 0, -10000, 10000]
+
+            if i < len(lines) and lines[i][0] == 'O':
+                output_scaler = parse_ints('O', lines[i][1], 5)
+                i += 1
+
+            payload = struct.pack('<B3x', count) + scaler(output_scaler)
+
+            for _ in range(count):
+                values = parse_ints('S', next_line('S'), 7)
+                i += 1
+
+                if values[0] > 255 or values[1] > 255 or values[0] < 0 or values[1] < 0:
+                    raise MixerError('S: invalid control {} {}'.format(values[0], values[1]))
+
+                payload += struct.pack('<BB2x', values[0], values[1]) + scaler(values[2:])
+
+            records.append(record('M', count, payload))
+
+        elif tag == 'R':
+            if len(fields) < 5 or len(fields[0]) > 7:
+                raise MixerError('R: invalid multirotor definition')
+
+            values = parse_ints('R', fields[1:], 4)
+            payload = struct.pack('<8s4f', fields[0].encode('ascii'), *[scaled(value) for value in values])
+            records.append(record('R', 0, payload))
+
+        elif tag == 'H':
+            count = parse_ints('H', fields, 1)[0]
+
+            if count < 3 or count > 4:
+                raise MixerError('H: only swash plates with 3 or 4 servos are supported')
+
+            throttle_curve = parse_ints('T', next_line('T'), 5)
+            i += 1
+            pitch_curve = parse_ints('P', next_line('P'), 5)
+            i += 1
+
+            # mixer_heli_s: the curves, then 4 servos
+            payload = struct.pack('<B3x', count) + scaler(throttle_curve) + scaler(pitch_curve)
+
+            for _ in range(count):
+                values = parse_ints('S', next_line('S'), 6)
+                i += 1
+                angle = f32(f32(values[0] * f32(M_PI_F)) / 180.0)
+                payload += struct.pack('<f', angle) + struct.pack('<5f', *[scaled(value) for value in values[1:]])
+
+            payload += b'\0' * (6 * 4) * (4 - count)
+            records.append(record('H', count, payload))
+
+        # other lines are skipped like by the text parser
+
+    if not records:
+        raise MixerError('no mixers')
+
+    data = b''.join(records)
+    header = struct.pack('<IHHI', MIXER_BINARY_MAGIC, MIXER_BINARY_VERSION, len(data), crc32(data))
+
+    if len(header) + len(data) > MAX_IMAGE_SIZE:
+        raise MixerError('too large ({} bytes)'.format(len(header) + len(data)))
+
+    return header + data
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compile mixer files into a binary mixer set.")
+    parser.add_argument('--folder', action="store", required=True,
+                        help="Folder containing the .mix files.")
+    parser.add_argument('-o', '--output', action="store",
+                        help="Output file (default: <folder>/" + MIXER_BINARY_SET_NAME + ").")
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.folder):
+        # ROMFS without mixers
+        return
+
+    output = args.output if args.output else os.path.join(args.folder, MIXER_BINARY_SET_NAME)
+    images = []
+
+    for file_name in sorted(os.listdir(args.folder)):
+        if not file_name.endswith('.mix'):
+            continue
+
+        if len(file_name) >= MIXER_BINARY_NAME_LEN:
+            print('{}: name too long, loaded from text'.format(file_name), file=sys.stderr)
+            continue
+
+        try:
+            images.append((file_name, compile_mixers(read_lines(os.path.join(args.folder, file_name)))))
+        except MixerError as e:
+            print('{}: {}, loaded from text'.format(file_name, e), file=sys.stderr)
+
+    offset = 8 + len(images) * (MIXER_BINARY_NAME_LEN + 8)
+    index = struct.pack('<IHH', MIXER_BINARY_INDEX_MAGIC, MIXER_BINARY_VERSION, len(images))
+    data = b''
+
+    for file_name, image in images:
+        index += struct.pack('<32sII', file_name.encode('ascii'), offset + len(data), len(image))
+        data += image
+
+    with open(output, 'wb') as f:
+        f.write(index + data)
+
+
+if __name__ == '__main__':
+    main()
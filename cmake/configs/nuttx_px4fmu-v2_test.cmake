@@ -2,6 +2,9 @@ px4_nuttx_configure(HWCLASS m4 CONFIG nsh ROMFS y ROMFSROOT px4fmu_test IO px4io
 
 #set(config_uavcan_num_ifaces 2)
 
+# no flash space for the precompiled mixers, the text mixers are loaded instead
+set(config_romfs_binary_mixers OFF)
+
 set(config_module_list
 	#
 	# Board support modules
@@ -210,6 +210,11 @@ function(px4_os_add_flags)
 			)
 	endif()
 
+	# SITL: allow the simulator to drive the system time (lockstep, see SIM_LOCKSTEP)
+	if ("${BOARD}" STREQUAL "sitl" AND NOT (APPLE AND DARWIN_VERSION LESS 16))
+		add_definitions(-DENABLE_LOCKSTEP_SCHEDULER)
+	endif()
+
 	# This block sets added_c_flags (appends to others).
 	if ("${BOARD}" STREQUAL "eagle")
 
@@ -17,6 +17,7 @@ set(tests
 	hrt
 	hysteresis
 	int
+	log_compression
 	mathlib
 	matrix
 	mavlink
@@ -59,6 +60,16 @@ foreach(test_name ${tests})
 	set_tests_properties(${test_name} PROPERTIES PASS_REGULAR_EXPRESSION "${test_name} PASSED")
 endforeach()
 
+# decode the frame written by the log_compression test with the reference LZ4 implementation
+add_test(NAME posix_log_compression_lz4
+	COMMAND ${PYTHON_EXECUTABLE} ${PX4_SOURCE_DIR}/Tools/check_lz4_frame.py
+		rootfs/fs/microsd/log_compression_test.ulg.lz4
+		rootfs/fs/microsd/log_compression_test.ulg
+	WORKING_DIRECTORY ${SITL_WORKING_DIR})
+
+set_tests_properties(posix_log_compression_lz4 PROPERTIES DEPENDS log_compression)
+set_tests_properties(posix_log_compression_lz4 PROPERTIES PASS_REGULAR_EXPRESSION "log_compression_lz4 PASSED")
+
 # run arbitrary commands
 set(test_cmds
 	hello
@@ -43,6 +43,11 @@ __BEGIN_DECLS
 extern px4_sem_t _hrt_work_lock;
 extern struct wqueue_s g_hrt_work;
 
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+/* wakes up the worker thread in lockstep mode, where it does not sleep but waits on the simulated time */
+extern px4_sem_t _hrt_work_wakeup;
+#endif
+
 void hrt_work_queue_init(void);
 int hrt_work_queue(struct work_s *work, worker_t worker, void *arg, uint32_t usdelay);
 void hrt_work_cancel(struct work_s *work);
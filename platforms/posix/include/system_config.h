@@ -63,6 +63,17 @@
 #define CONFIG_SCHED_HPWORK 1
 #define CONFIG_SCHED_LPWORK 1
 
+/** number of worker threads per work queue. With more than one, work items
+ *  of the same queue run concurrently, so a board only opts in (e.g.
+ *  -DCONFIG_SCHED_HPNTHREADS=2) if its work items do not rely on being
+ *  serialised by the queue. **/
+#ifndef CONFIG_SCHED_HPNTHREADS
+#define CONFIG_SCHED_HPNTHREADS 1
+#endif
+#ifndef CONFIG_SCHED_LPNTHREADS
+#define CONFIG_SCHED_LPNTHREADS 1
+#endif
+
 /** time in ms between checks for work in work queues **/
 #define CONFIG_SCHED_WORKPERIOD 50000
 
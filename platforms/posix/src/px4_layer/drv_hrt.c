@@ -48,9 +48,38 @@
 #include <string.h>
 #include <inttypes.h>
 #include <errno.h>
-#include "hrt_work.h"
+#include <unistd.h>
+#ifdef __PX4_LINUX
+#include <sys/timerfd.h>
+#endif
+
+/*
+ * Callouts are kept in a hierarchical timer wheel: HRT_WHEEL_LEVELS levels of HRT_WHEEL_SLOTS
+ * unsorted slots each. A slot of level 0 spans 2^HRT_WHEEL_RES_BITS us, each level above
+ * covers HRT_WHEEL_SLOTS times the range of the level below, and its entries are moved down
+ * (cascaded) when the lower level wraps around. Insertion and removal are O(1), the next
+ * deadline is found through the per-level bitmaps of non-empty slots.
+ */
+#define HRT_WHEEL_RES_BITS	6
+#define HRT_WHEEL_SLOT_BITS	6
+#define HRT_WHEEL_SLOTS		(1 << HRT_WHEEL_SLOT_BITS)
+#define HRT_WHEEL_MASK		(HRT_WHEEL_SLOTS - 1)
+#define HRT_WHEEL_LEVELS	5
 
-static struct sq_queue_s	callout_queue;
+static struct sq_entry_s	*_wheel[HRT_WHEEL_LEVELS][HRT_WHEEL_SLOTS];
+static uint64_t			_wheel_bitmap[HRT_WHEEL_LEVELS];	///< non-empty slots
+static hrt_abstime		_wheel_tick;				///< current tick (in level 0 slots)
+
+/*
+ * An entry is queued iff its back link is set: the wheel clears it when the entry is removed,
+ * and struct hrt_call must be zero-initialised before its first use (as on NuttX).
+ */
+static inline bool hrt_wheel_queued(const struct hrt_call *entry)
+{
+	return entry->link_prev != NULL;
+}
+
+#define HRT_NO_DEADLINE		UINT64_MAX
 
 /* latency histogram */
 #define LATENCY_BUCKET_COUNT 8
@@ -58,27 +87,77 @@ __EXPORT const uint16_t latency_bucket_count = LATENCY_BUCKET_COUNT;
 __EXPORT const uint16_t	latency_buckets[LATENCY_BUCKET_COUNT] = { 1, 2, 5, 10, 20, 50, 100, 1000 };
 __EXPORT uint32_t	latency_counters[LATENCY_BUCKET_COUNT + 1];
 
-static void		hrt_call_reschedule(void);
-
-// Intervals in usec
-#define HRT_INTERVAL_MIN	50
-#define HRT_INTERVAL_MAX	50000000
-
 static px4_sem_t 	_hrt_lock;
-static struct work_s	_hrt_work;
+
+/* the timer thread runs the callouts: it sleeps until the next deadline and is
+ * woken up early when an entry with an earlier deadline is inserted */
+static px4_sem_t	_hrt_timer_wakeup;
+static hrt_abstime	_hrt_timer_armed = 0;	///< deadline the timer thread waits for
+#ifdef __PX4_LINUX
+static int		_hrt_timerfd = -1;
+static bool		_hrt_timer_on_fd = false;	///< the timer thread waits on _hrt_timerfd (not the semaphore)
+#endif
 #ifndef __PX4_QURT
 static hrt_abstime px4_timestart = 0;
 #else
 static int32_t dsp_offset = 0;
 #endif
+/*
+ * hrt_absolute_time() is lock-free: the delay state below is only modified by the (rare)
+ * hrt_*_delay() calls, which serialize on _hrt_mutex and publish the state through the
+ * sequence counter _delay_seq (odd while an update is in progress). max_time enforces
+ * monotonicity across threads with a CAS.
+ */
 static hrt_abstime _start_delay_time = 0;
 static hrt_abstime _delay_interval = 0;
+static unsigned _delay_seq = 0;
 static hrt_abstime max_time = 0;
 pthread_mutex_t _hrt_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-static void
+/* Going back in time by less than this can happen when threads race for max_time,
+ * anything beyond is reported (e.g. if the delay compensation was wrong) */
+#define HRT_NEGATIVE_TIME_TOLERANCE	1000
+
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+/*
+ * Lockstep scheduler: once enabled, the time is no longer taken from the system clock but
+ * only advances when the simulator calls hrt_lockstep_set_time(). Threads blocked in
+ * hrt_lockstep_cond_timedwait() are registered in _lockstep_waiters and woken up as soon
+ * as the simulated time reaches their deadline.
+ */
+struct lockstep_waiter {
+	hrt_abstime deadline;
+	pthread_cond_t *cond;
+	pthread_mutex_t *lock;
+	bool timed_out;			///< protected by *lock
+	bool pending;			///< protected by _lockstep_mutex: set_time is about to signal this waiter
+	struct lockstep_waiter *next;	///< protected by _lockstep_mutex
+};
+
+static bool _lockstep_enabled = false;
+static hrt_abstime _lockstep_time = 0;
+static hrt_abstime _lockstep_realtime_offset = 0;	///< CLOCK_REALTIME - simulated time
+static hrt_abstime _lockstep_monotonic_offset = 0;	///< CLOCK_MONOTONIC - simulated time
+static struct lockstep_waiter *_lockstep_waiters = NULL;
+static pthread_mutex_t _lockstep_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _lockstep_cond = PTHREAD_COND_INITIALIZER;
+
+/* the HRT itself always runs on the system clock, px4_clock_gettime() follows the simulation */
+#define hrt_clock_gettime clock_gettime
+#else
+#define hrt_clock_gettime px4_clock_gettime
+#endif
+
+static hrt_abstime
 hrt_call_invoke(void);
 
+static void		hrt_wheel_remove(struct hrt_call *entry);
+static void		hrt_wheel_rebase(hrt_abstime now);
+static int		hrt_timer_thread(int argc, char *argv[]);
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+static void		hrt_timer_kick(void);
+#endif
+
 static hrt_abstime
 _hrt_absolute_time_internal(void);
 
@@ -133,6 +212,27 @@ int px4_clock_gettime(clockid_t clk_id, struct timespec *tp)
 	return clock_gettime(clk_id, tp);
 }
 
+#elif defined(ENABLE_LOCKSTEP_SCHEDULER)
+
+int px4_clock_gettime(clockid_t clk_id, struct timespec *tp)
+{
+	if (!hrt_lockstep_enabled()) {
+		return clock_gettime(clk_id, tp);
+	}
+
+	/* keep the clocks continuous, but advancing with the simulation */
+	if (clk_id == CLOCK_REALTIME) {
+		abstime_to_ts(tp, hrt_absolute_time() + _lockstep_realtime_offset);
+		return 0;
+
+	} else if (clk_id == CLOCK_MONOTONIC) {
+		abstime_to_ts(tp, hrt_absolute_time() + _lockstep_monotonic_offset);
+		return 0;
+	}
+
+	return clock_gettime(clk_id, tp);
+}
+
 #endif
 
 #ifndef __PX4_QURT
@@ -142,7 +242,7 @@ int px4_clock_gettime(clockid_t clk_id, struct timespec *tp)
 uint64_t hrt_system_time(void)
 {
 	struct timespec ts;
-	px4_clock_gettime(CLOCK_MONOTONIC, &ts);
+	hrt_clock_gettime(CLOCK_MONOTONIC, &ts);
 	return ts_to_abstime(&ts);
 }
 #endif
@@ -167,13 +267,25 @@ hrt_abstime _hrt_absolute_time_internal(void)
 
 #else
 
-	if (!px4_timestart) {
-		px4_clock_gettime(CLOCK_MONOTONIC, &ts);
-		px4_timestart = ts_to_abstime(&ts);
+	hrt_abstime timestart = __atomic_load_n(&px4_timestart, __ATOMIC_ACQUIRE);
+
+	if (!timestart) {
+		hrt_clock_gettime(CLOCK_MONOTONIC, &ts);
+		hrt_abstime expected = 0;
+
+		/* the first caller defines the start time */
+		if (__atomic_compare_exchange_n(&px4_timestart, &expected, ts_to_abstime(&ts), false,
+						__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			timestart = ts_to_abstime(&ts);
+
+		} else {
+			timestart = expected;
+		}
 	}
 
-	px4_clock_gettime(CLOCK_MONOTONIC, &ts);
-	return ts_to_abstime(&ts) - px4_timestart;
+	/* on Linux this is a vDSO call, no syscall involved */
+	hrt_clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts_to_abstime(&ts) - timestart;
 #endif
 }
 
@@ -185,42 +297,94 @@ int hrt_set_absolute_time_offset(int32_t time_diff_us)
 }
 #endif
 
+/*
+ * Current time including the delay compensation, without the monotonicity check.
+ */
+static hrt_abstime hrt_compensated_time(void)
+{
+	hrt_abstime ret;
+	unsigned seq;
+
+	do {
+		while ((seq = __atomic_load_n(&_delay_seq, __ATOMIC_ACQUIRE)) & 1) {
+			/* a delay update is in progress */
+		}
+
+		hrt_abstime start_delay_time = __atomic_load_n(&_start_delay_time, __ATOMIC_RELAXED);
+
+		if (start_delay_time > 0) {
+			ret = start_delay_time;
+
+		} else {
+			ret = _hrt_absolute_time_internal();
+		}
+
+		ret -= __atomic_load_n(&_delay_interval, __ATOMIC_RELAXED);
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while (__atomic_load_n(&_delay_seq, __ATOMIC_RELAXED) != seq);
+
+	return ret;
+}
+
 /*
  * Get absolute time.
  */
 hrt_abstime hrt_absolute_time(void)
 {
-	pthread_mutex_lock(&_hrt_mutex);
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
 
-	hrt_abstime ret;
+	if (__atomic_load_n(&_lockstep_enabled, __ATOMIC_ACQUIRE)) {
+		return __atomic_load_n(&_lockstep_time, __ATOMIC_ACQUIRE);
+	}
 
-	if (_start_delay_time > 0) {
-		ret = _start_delay_time;
+#endif
 
-	} else {
-		ret = _hrt_absolute_time_internal();
-	}
+	hrt_abstime ret = hrt_compensated_time();
+	hrt_abstime last = __atomic_load_n(&max_time, __ATOMIC_RELAXED);
+	bool retried = false;
 
-	ret -= _delay_interval;
+	for (;;) {
+		if (ret >= last) {
+			if (__atomic_compare_exchange_n(&max_time, &last, ret, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+				return ret;
+			}
 
-	if (ret < max_time) {
-		PX4_ERR("WARNING! TIME IS NEGATIVE! %d vs %d", (int)ret, (int)max_time);
-		ret = max_time;
-	}
+			/* on failure, last is updated with the current value: check again */
+			continue;
+		}
 
-	max_time = ret;
-	pthread_mutex_unlock(&_hrt_mutex);
+		/* If we got preempted after reading the clock, other threads may legitimately
+		 * have returned a later time already. Only complain if a fresh reading is still behind. */
+		if (!retried) {
+			retried = true;
+			ret = hrt_compensated_time();
+			last = __atomic_load_n(&max_time, __ATOMIC_RELAXED);
+			continue;
+		}
 
-	return ret;
+		if (ret + HRT_NEGATIVE_TIME_TOLERANCE < last) {
+			PX4_ERR("WARNING! TIME IS NEGATIVE! %d vs %d", (int)ret, (int)last);
+		}
+
+		return last;
+	}
 }
 
 __EXPORT hrt_abstime hrt_reset(void)
 {
 #ifndef __PX4_QURT
-	px4_timestart = 0;
+	__atomic_store_n(&px4_timestart, 0, __ATOMIC_RELEASE);
 #endif
-	max_time = 0;
-	return _hrt_absolute_time_internal();
+	__atomic_store_n(&max_time, 0, __ATOMIC_RELAXED);
+	hrt_abstime now = _hrt_absolute_time_internal();
+
+	/* the time went back: move the wheel to the new time base */
+	hrt_lock();
+	hrt_wheel_rebase(now);
+	hrt_unlock();
+
+	return now;
 }
 
 /*
@@ -236,6 +400,16 @@ hrt_abstime ts_to_abstime(struct timespec *ts)
 	return result;
 }
 
+/*
+ * Convert absolute time to a timespec.
+ */
+void	abstime_to_ts(struct timespec *ts, hrt_abstime abstime)
+{
+	ts->tv_sec = abstime / 1000000;
+	abstime -= ts->tv_sec * 1000000;
+	ts->tv_nsec = abstime * 1000;
+}
+
 /*
  * Compute the delta between a timestamp taken in the past
  * and now.
@@ -278,7 +452,11 @@ bool	hrt_called(struct hrt_call *entry)
 void	hrt_cancel(struct hrt_call *entry)
 {
 	hrt_lock();
-	sq_rem(&entry->link, &callout_queue);
+
+	if (hrt_wheel_queued(entry)) {
+		hrt_wheel_remove(entry);
+	}
+
 	entry->deadline = 0;
 
 	/* if this is a periodic call being removed by the callout, prevent it from
@@ -314,7 +492,9 @@ void	hrt_call_delay(struct hrt_call *entry, hrt_abstime delay)
  */
 void	hrt_init(void)
 {
-	sq_init(&callout_queue);
+	memset(_wheel, 0, sizeof(_wheel));
+	memset(_wheel_bitmap, 0, sizeof(_wheel_bitmap));
+	_wheel_tick = hrt_absolute_time() >> HRT_WHEEL_RES_BITS;
 
 	int sem_ret = px4_sem_init(&_hrt_lock, 0, 1);
 
@@ -322,13 +502,46 @@ void	hrt_init(void)
 		PX4_ERR("SEM INIT FAIL: %s", strerror(errno));
 	}
 
-	memset(&_hrt_work, 0, sizeof(_hrt_work));
+	px4_sem_init(&_hrt_timer_wakeup, 0, 0);
+	px4_sem_setprotocol(&_hrt_timer_wakeup, SEM_PRIO_NONE);
+
+#ifdef __PX4_LINUX
+	_hrt_timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+
+	if (_hrt_timerfd < 0) {
+		PX4_WARN("timerfd_create failed (%s), using a semaphore", strerror(errno));
+	}
+
+#endif
+
+	px4_task_spawn_cmd("hrt_timer",
+			   SCHED_DEFAULT,
+			   SCHED_PRIORITY_MAX,
+			   2000,
+			   hrt_timer_thread,
+			   (char *const *)NULL);
+}
+
+/*
+ * Writer side of the delay state: must be called with _hrt_mutex held.
+ */
+static void hrt_delay_update_begin(void)
+{
+	__atomic_store_n(&_delay_seq, _delay_seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void hrt_delay_update_end(void)
+{
+	__atomic_store_n(&_delay_seq, _delay_seq + 1, __ATOMIC_RELEASE);
 }
 
 void	hrt_start_delay()
 {
 	pthread_mutex_lock(&_hrt_mutex);
-	_start_delay_time = _hrt_absolute_time_internal();
+	hrt_delay_update_begin();
+	__atomic_store_n(&_start_delay_time, _hrt_absolute_time_internal(), __ATOMIC_RELAXED);
+	hrt_delay_update_end();
 	pthread_mutex_unlock(&_hrt_mutex);
 }
 
@@ -342,8 +555,10 @@ void	hrt_stop_delay_delta(hrt_abstime delta)
 		delta = delta_measured;
 	}
 
-	_delay_interval += delta;
-	_start_delay_time = 0;
+	hrt_delay_update_begin();
+	__atomic_store_n(&_delay_interval, _delay_interval + delta, __ATOMIC_RELAXED);
+	__atomic_store_n(&_start_delay_time, 0, __ATOMIC_RELAXED);
+	hrt_delay_update_end();
 
 	pthread_mutex_unlock(&_hrt_mutex);
 
@@ -353,110 +568,532 @@ void	hrt_stop_delay()
 {
 	pthread_mutex_lock(&_hrt_mutex);
 	uint64_t delta = _hrt_absolute_time_internal() - _start_delay_time;
-	_delay_interval += delta;
-	_start_delay_time = 0;
+
+	hrt_delay_update_begin();
+	__atomic_store_n(&_delay_interval, _delay_interval + delta, __ATOMIC_RELAXED);
+	__atomic_store_n(&_start_delay_time, 0, __ATOMIC_RELAXED);
+	hrt_delay_update_end();
 
 	pthread_mutex_unlock(&_hrt_mutex);
 
 }
 
-static void
-hrt_call_enter(struct hrt_call *entry)
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+
+void	hrt_lockstep_enable()
+{
+	pthread_mutex_lock(&_lockstep_mutex);
+
+	if (!_lockstep_enabled) {
+		struct timespec ts;
+		hrt_abstime now = hrt_absolute_time();
+
+		clock_gettime(CLOCK_REALTIME, &ts);
+		_lockstep_realtime_offset = ts_to_abstime(&ts) - now;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		_lockstep_monotonic_offset = ts_to_abstime(&ts) - now;
+
+		/* freeze the time until the simulator advances it */
+		__atomic_store_n(&_lockstep_time, now, __ATOMIC_RELAXED);
+		__atomic_store_n(&_lockstep_enabled, true, __ATOMIC_RELEASE);
+	}
+
+	pthread_mutex_unlock(&_lockstep_mutex);
+
+	/* the timer thread has to wait for the simulated time from now on */
+	hrt_timer_kick();
+}
+
+bool	hrt_lockstep_enabled()
+{
+	return __atomic_load_n(&_lockstep_enabled, __ATOMIC_ACQUIRE);
+}
+
+void	hrt_lockstep_set_time(hrt_abstime time)
+{
+	struct lockstep_waiter *expired = NULL;
+
+	pthread_mutex_lock(&_lockstep_mutex);
+
+	if (time <= _lockstep_time) {
+		/* the time never goes backwards */
+		pthread_mutex_unlock(&_lockstep_mutex);
+		return;
+	}
+
+	__atomic_store_n(&_lockstep_time, time, __ATOMIC_RELEASE);
+
+	/* unlink everyone whose deadline passed. The waiters cannot leave while pending is set */
+	struct lockstep_waiter **prev = &_lockstep_waiters;
+
+	while (*prev) {
+		struct lockstep_waiter *waiter = *prev;
+
+		if (waiter->deadline <= time) {
+			*prev = waiter->next;
+			waiter->pending = true;
+			waiter->next = expired;
+			expired = waiter;
+
+		} else {
+			prev = &waiter->next;
+		}
+	}
+
+	pthread_mutex_unlock(&_lockstep_mutex);
+
+	/* the waiter locks are taken outside of _lockstep_mutex: the waiters register themselves
+	 * while holding their lock, so the inverse order would deadlock */
+	while (expired) {
+		struct lockstep_waiter *waiter = expired;
+		expired = waiter->next;
+
+		pthread_mutex_lock(waiter->lock);
+		waiter->timed_out = true;
+		pthread_cond_broadcast(waiter->cond);
+		pthread_mutex_unlock(waiter->lock);
+
+		pthread_mutex_lock(&_lockstep_mutex);
+		waiter->pending = false;
+		pthread_cond_broadcast(&_lockstep_cond);
+		pthread_mutex_unlock(&_lockstep_mutex);
+	}
+}
+
+int	hrt_lockstep_cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *lock, const struct timespec *abstime)
 {
-	struct hrt_call	*call, *next;
+	struct timespec ts = *abstime;
+	struct lockstep_waiter waiter;
+
+	waiter.deadline = ts_to_abstime(&ts) - _lockstep_realtime_offset;
+	waiter.cond = cond;
+	waiter.lock = lock;
+	waiter.timed_out = false;
+	waiter.pending = false;
+
+	pthread_mutex_lock(&_lockstep_mutex);
+
+	if (_lockstep_time >= waiter.deadline) {
+		pthread_mutex_unlock(&_lockstep_mutex);
+		return ETIMEDOUT;
+	}
 
-	//PX4_INFO("hrt_call_enter");
-	call = (struct hrt_call *)sq_peek(&callout_queue);
+	waiter.next = _lockstep_waiters;
+	_lockstep_waiters = &waiter;
 
-	if ((call == NULL) || (entry->deadline < call->deadline)) {
-		sq_addfirst(&entry->link, &callout_queue);
-		//if (call != NULL) PX4_INFO("call enter at head, reschedule (%lu %lu)", entry->deadline, call->deadline);
-		/* we changed the next deadline, reschedule the timer event */
-		hrt_call_reschedule();
+	pthread_mutex_unlock(&_lockstep_mutex);
+
+	int ret = pthread_cond_wait(cond, lock);
+
+	pthread_mutex_lock(&_lockstep_mutex);
+
+	if (waiter.pending) {
+		/* hrt_lockstep_set_time() needs the lock to wake us up, wait for it to finish */
+		pthread_mutex_unlock(lock);
+
+		while (waiter.pending) {
+			pthread_cond_wait(&_lockstep_cond, &_lockstep_mutex);
+		}
+
+		pthread_mutex_unlock(&_lockstep_mutex);
+		pthread_mutex_lock(lock);
 
 	} else {
-		do {
-			next = (struct hrt_call *)sq_next(&call->link);
+		/* woken up before the deadline, still registered */
+		struct lockstep_waiter **prev = &_lockstep_waiters;
 
-			if ((next == NULL) || (entry->deadline < next->deadline)) {
-				//lldbg("call enter after head\n");
-				sq_addafter(&call->link, &entry->link, &callout_queue);
+		while (*prev) {
+			if (*prev == &waiter) {
+				*prev = waiter.next;
 				break;
 			}
-		} while ((call = next) != NULL);
+
+			prev = &(*prev)->next;
+		}
+
+		pthread_mutex_unlock(&_lockstep_mutex);
+	}
+
+	if (ret == 0 && waiter.timed_out) {
+		ret = ETIMEDOUT;
 	}
 
-	//PX4_INFO("scheduled");
+	return ret;
 }
 
-/**
- * Timer interrupt handler
+#endif
+
+/*
+ * Unlink an entry from its wheel slot.
+ */
+static void
+hrt_wheel_remove(struct hrt_call *entry)
+{
+	struct sq_entry_s **prev = entry->link_prev;
+	struct sq_entry_s *next = entry->link.flink;
+	struct sq_entry_s **heads = &_wheel[0][0];
+
+	*prev = next;
+
+	if (next != NULL) {
+		((struct hrt_call *)next)->link_prev = prev;
+
+	} else if (prev >= heads && prev < heads + HRT_WHEEL_LEVELS * HRT_WHEEL_SLOTS) {
+		/* that was the last entry of the slot */
+		unsigned index = prev - heads;
+		_wheel_bitmap[index / HRT_WHEEL_SLOTS] &= ~((uint64_t)1 << (index % HRT_WHEEL_SLOTS));
+	}
+
+	entry->link.flink = NULL;
+	entry->link_prev = NULL;
+}
+
+/*
+ * Put an entry into the slot of its deadline.
+ */
+static void
+hrt_wheel_insert(struct hrt_call *entry)
+{
+	hrt_abstime tick = entry->deadline >> HRT_WHEEL_RES_BITS;
+	hrt_abstime range = (hrt_abstime)1 << (HRT_WHEEL_LEVELS * HRT_WHEEL_SLOT_BITS);
+	unsigned level = 0;
+
+	if (tick < _wheel_tick) {
+		/* already expired, run it with the current tick */
+		tick = _wheel_tick;
+	}
+
+	if (tick - _wheel_tick >= range) {
+		/* beyond the wheel: park it in the last slot, it is re-inserted when that is cascaded */
+		tick = _wheel_tick + range - 1;
+	}
+
+	while (level < HRT_WHEEL_LEVELS - 1 &&
+	       tick - _wheel_tick >= ((hrt_abstime)1 << ((level + 1) * HRT_WHEEL_SLOT_BITS))) {
+		level++;
+	}
+
+	unsigned slot = (tick >> (level * HRT_WHEEL_SLOT_BITS)) & HRT_WHEEL_MASK;
+	struct sq_entry_s **head = &_wheel[level][slot];
+
+	entry->link.flink = *head;
+
+	if (*head != NULL) {
+		((struct hrt_call *)*head)->link_prev = &entry->link.flink;
+	}
+
+	*head = &entry->link;
+	entry->link_prev = head;
+	_wheel_bitmap[level] |= (uint64_t)1 << slot;
+}
+
+/*
+ * Move the entries of an upper level slot down to the levels below.
+ */
+static void
+hrt_wheel_cascade(unsigned level, unsigned slot)
+{
+	struct sq_entry_s *link = _wheel[level][slot];
+
+	_wheel[level][slot] = NULL;
+	_wheel_bitmap[level] &= ~((uint64_t)1 << slot);
+
+	while (link != NULL) {
+		struct hrt_call *call = (struct hrt_call *)link;
+		link = link->flink;
+		hrt_wheel_insert(call);
+	}
+}
+
+/*
+ * Next tick at which an upper level gets cascaded, HRT_NO_DEADLINE if they are all empty.
+ */
+static hrt_abstime
+hrt_wheel_next_cascade(void)
+{
+	for (unsigned level = 1; level < HRT_WHEEL_LEVELS; level++) {
+		if (_wheel_bitmap[level] != 0) {
+			unsigned shift = level * HRT_WHEEL_SLOT_BITS;
+			return ((_wheel_tick >> shift) + 1) << shift;
+		}
+	}
+
+	return HRT_NO_DEADLINE;
+}
+
+/*
+ * Advance the wheel towards now_tick by at least one tick.
+ */
+static void
+hrt_wheel_advance(hrt_abstime now_tick)
+{
+	hrt_abstime tick = _wheel_tick + 1;
+
+	if (_wheel_bitmap[0] == 0) {
+		/* nothing to run before the next cascade: skip the empty slots */
+		hrt_abstime cascade = hrt_wheel_next_cascade();
+		tick = (cascade < now_tick) ? cascade : now_tick;
+	}
+
+	_wheel_tick = tick;
+
+	/* cascade every upper level whose lower level wrapped around */
+	for (unsigned level = 1; level < HRT_WHEEL_LEVELS; level++) {
+		unsigned shift = level * HRT_WHEEL_SLOT_BITS;
+
+		if ((tick & (((hrt_abstime)1 << shift) - 1)) != 0) {
+			break;
+		}
+
+		hrt_wheel_cascade(level, (tick >> shift) & HRT_WHEEL_MASK);
+	}
+}
+
+/*
+ * Unlink and return an entry whose deadline passed, NULL if there is none.
+ */
+static struct hrt_call *
+hrt_wheel_pop_expired(hrt_abstime now)
+{
+	hrt_abstime now_tick = now >> HRT_WHEEL_RES_BITS;
+
+	for (;;) {
+		struct sq_entry_s *link = _wheel[0][_wheel_tick & HRT_WHEEL_MASK];
+
+		if (_wheel_tick >= now_tick) {
+			/* the current tick only elapsed partially */
+			while (link != NULL && ((struct hrt_call *)link)->deadline > now) {
+				link = link->flink;
+			}
+
+			if (link != NULL) {
+				hrt_wheel_remove((struct hrt_call *)link);
+			}
+
+			return (struct hrt_call *)link;
+		}
+
+		if (link != NULL) {
+			/* everything in an elapsed tick is due */
+			hrt_wheel_remove((struct hrt_call *)link);
+			return (struct hrt_call *)link;
+		}
+
+		hrt_wheel_advance(now_tick);
+	}
+}
+
+/*
+ * Earliest deadline in the wheel, or the next cascade if that comes first.
+ */
+static hrt_abstime
+hrt_wheel_next_deadline(void)
+{
+	hrt_abstime next = hrt_wheel_next_cascade();
+
+	if (next != HRT_NO_DEADLINE) {
+		next <<= HRT_WHEEL_RES_BITS;
+	}
+
+	if (_wheel_bitmap[0] != 0) {
+		/* the first non-empty slot from the current tick on holds the earliest entries */
+		unsigned current = _wheel_tick & HRT_WHEEL_MASK;
+		uint64_t pending = _wheel_bitmap[0] >> current;
+
+		if (current != 0) {
+			pending |= _wheel_bitmap[0] << (HRT_WHEEL_SLOTS - current);
+		}
+
+		unsigned slot = (current + __builtin_ctzll(pending)) & HRT_WHEEL_MASK;
+
+		for (struct sq_entry_s *link = _wheel[0][slot]; link != NULL; link = link->flink) {
+			if (((struct hrt_call *)link)->deadline < next) {
+				next = ((struct hrt_call *)link)->deadline;
+			}
+		}
+	}
+
+	return next;
+}
+
+/*
+ * Re-insert everything relative to the current time (after the time base changed).
+ */
+static void
+hrt_wheel_rebase(hrt_abstime now)
+{
+	struct sq_entry_s *all = NULL;
+
+	for (unsigned level = 0; level < HRT_WHEEL_LEVELS; level++) {
+		for (unsigned slot = 0; slot < HRT_WHEEL_SLOTS; slot++) {
+			while (_wheel[level][slot] != NULL) {
+				struct hrt_call *call = (struct hrt_call *)_wheel[level][slot];
+				hrt_wheel_remove(call);
+				call->link.flink = all;
+				all = &call->link;
+			}
+		}
+	}
+
+	_wheel_tick = now >> HRT_WHEEL_RES_BITS;
+
+	while (all != NULL) {
+		struct hrt_call *call = (struct hrt_call *)all;
+		all = all->flink;
+		hrt_wheel_insert(call);
+	}
+}
+
+#ifdef __PX4_LINUX
+/*
+ * Arm the timerfd for an HRT deadline (HRT_NO_DEADLINE disarms it).
+ */
+static void
+hrt_timerfd_arm(hrt_abstime deadline)
+{
+	struct itimerspec its;
+	memset(&its, 0, sizeof(its));
+
+	if (deadline != HRT_NO_DEADLINE) {
+		/* the HRT may be delayed or simulated, convert the remaining time instead of the absolute one */
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		hrt_abstime now = hrt_absolute_time();
+		abstime_to_ts(&its.it_value, ts_to_abstime(&ts) + (deadline > now ? deadline - now : 0) + 1);
+	}
+
+	if (timerfd_settime(_hrt_timerfd, TFD_TIMER_ABSTIME, &its, NULL) != 0) {
+		PX4_ERR("timerfd_settime failed: %s", strerror(errno));
+	}
+}
+#endif
+
+/*
+ * Wake up the timer thread if it sleeps past the given deadline.
  *
- * This routine simulates a timer interrupt handler
+ * Must be called with the lock held.
  */
 static void
-hrt_tim_isr(void *p)
+hrt_timer_update(hrt_abstime deadline)
 {
+	if (deadline >= _hrt_timer_armed) {
+		return;
+	}
+
+	_hrt_timer_armed = deadline;
+
+#ifdef __PX4_LINUX
+
+	if (_hrt_timer_on_fd) {
+		hrt_timerfd_arm(deadline);
+		return;
+	}
+
+#endif
+
+	px4_sem_post(&_hrt_timer_wakeup);
+}
+
+/*
+ * Timer thread: runs the callouts, then sleeps until the next deadline
+ * (on a timerfd, or on a semaphore when the time is simulated).
+ */
+static int
+hrt_timer_thread(int argc, char *argv[])
+{
+	for (;;) {
+		hrt_lock();
+
+		/* no need to wake us up while we are running the callouts */
+		_hrt_timer_armed = 0;
+
+		hrt_abstime deadline = hrt_call_invoke();
+
+		_hrt_timer_armed = deadline;
+
+#ifdef __PX4_LINUX
+		_hrt_timer_on_fd = (_hrt_timerfd >= 0);
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+		_hrt_timer_on_fd = _hrt_timer_on_fd && !hrt_lockstep_enabled();
+#endif
+
+		if (_hrt_timer_on_fd) {
+			hrt_timerfd_arm(deadline);
+			hrt_unlock();
+
+			uint64_t expirations;
+
+			if (read(_hrt_timerfd, &expirations, sizeof(expirations)) < 0 && errno != EINTR) {
+				PX4_ERR("timerfd read failed: %s", strerror(errno));
+			}
+
+			continue;
+		}
+
+#endif
+		hrt_unlock();
+
+		if (deadline == HRT_NO_DEADLINE) {
+			px4_sem_wait(&_hrt_timer_wakeup);
+
+		} else {
+			struct timespec ts;
+			hrt_abstime now = hrt_absolute_time();
+			px4_clock_gettime(CLOCK_REALTIME, &ts);
+			abstime_to_ts(&ts, ts_to_abstime(&ts) + (deadline > now ? deadline - now : 0));
+			px4_sem_timedwait(&_hrt_timer_wakeup, &ts);
+		}
+	}
 
-	//PX4_INFO("hrt_tim_isr");
-	/* run any callouts that have met their deadline */
-	hrt_call_invoke();
+	return PX4_OK;
+}
 
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+/*
+ * Make the timer thread re-evaluate how it waits (the time source changed).
+ */
+static void
+hrt_timer_kick(void)
+{
 	hrt_lock();
 
-	/* and schedule the next interrupt */
-	hrt_call_reschedule();
+#ifdef __PX4_LINUX
+
+	if (_hrt_timer_on_fd) {
+		hrt_timerfd_arm(0);
+	}
+
+#endif
 
+	px4_sem_post(&_hrt_timer_wakeup);
 	hrt_unlock();
 }
+#endif
 
-/**
- * Reschedule the next timer interrupt.
- *
- * This routine must be called with interrupts disabled.
- */
 static void
-hrt_call_reschedule()
-{
-	hrt_abstime	now = hrt_absolute_time();
-	hrt_abstime	delay = HRT_INTERVAL_MAX;
-	struct hrt_call	*next = (struct hrt_call *)sq_peek(&callout_queue);
-	hrt_abstime	deadline = now + HRT_INTERVAL_MAX;
-
-	//PX4_INFO("hrt_call_reschedule");
-
-	/*
-	 * Determine what the next deadline will be.
-	 *
-	 * Note that we ensure that this will be within the counter
-	 * period, so that when we truncate all but the low 16 bits
-	 * the next time the compare matches it will be the deadline
-	 * we want.
-	 *
-	 * It is important for accurate timekeeping that the compare
-	 * interrupt fires sufficiently often that the base_time update in
-	 * hrt_absolute_time runs at least once per timer period.
-	 */
-	if (next != NULL) {
-		//lldbg("entry in queue\n");
-		if (next->deadline <= (now + HRT_INTERVAL_MIN)) {
-			//lldbg("pre-expired\n");
-			/* set a minimal deadline so that we call ASAP */
-			delay = HRT_INTERVAL_MIN;
-
-		} else if (next->deadline < deadline) {
-			//lldbg("due soon\n");
-			delay = next->deadline - now;
+hrt_latency_update(hrt_abstime latency)
+{
+	unsigned	index;
+
+	/* bounded buckets */
+	for (index = 0; index < LATENCY_BUCKET_COUNT; index++) {
+		if (latency <= latency_buckets[index]) {
+			latency_counters[index]++;
+			return;
 		}
 	}
 
-	// There is no timer ISR, so simulate one by putting an event on the
-	// high priority work queue
+	/* catch-all at the end */
+	latency_counters[index]++;
+}
 
-	// Remove the existing expiry and update with the new expiry
-	hrt_work_cancel(&_hrt_work);
+static void
+hrt_call_enter(struct hrt_call *entry)
+{
+	hrt_wheel_insert(entry);
 
-	hrt_work_queue(&_hrt_work, (worker_t)&hrt_tim_isr, NULL, delay);
+	/* we might have changed the next deadline */
+	hrt_timer_update(entry->deadline);
 }
 
 static void
@@ -465,17 +1102,9 @@ hrt_call_internal(struct hrt_call *entry, hrt_abstime deadline, hrt_abstime inte
 	PX4_DEBUG("hrt_call_internal deadline=%lu interval = %lu", deadline, interval);
 	hrt_lock();
 
-	//PX4_INFO("hrt_call_internal after lock");
 	/* if the entry is currently queued, remove it */
-	/* note that we are using a potentially uninitialised
-	   entry->link here, but it is safe as sq_rem() doesn't
-	   dereference the passed node unless it is found in the
-	   list. So we potentially waste a bit of time searching the
-	   queue for the uninitialised entry->link but we don't do
-	   anything actually unsafe.
-	*/
-	if (entry->deadline != 0) {
-		sq_rem(&entry->link, &callout_queue);
+	if (hrt_wheel_queued(entry)) {
+		hrt_wheel_remove(entry);
 	}
 
 #if 1
@@ -535,41 +1164,33 @@ void	hrt_call_at(struct hrt_call *entry, hrt_abstime calltime, hrt_callout callo
 	hrt_call_internal(entry, calltime, 0, callout, arg);
 }
 
-#if 0
 /*
- * Convert absolute time to a timespec.
+ * Run the callouts whose deadline passed. Must be called with the lock held,
+ * which is released while a callout runs.
+ *
+ * @return the next deadline, HRT_NO_DEADLINE if nothing is queued.
  */
-void	abstime_to_ts(struct timespec *ts, hrt_abstime abstime);
-#endif
-
-static void
+static hrt_abstime
 hrt_call_invoke(void)
 {
 	struct hrt_call	*call;
 	hrt_abstime deadline;
 
-	hrt_lock();
-
 	while (true) {
 		/* get the current time */
 		hrt_abstime now = hrt_absolute_time();
 
-		call = (struct hrt_call *)sq_peek(&callout_queue);
+		call = hrt_wheel_pop_expired(now);
 
 		if (call == NULL) {
-			break;
-		}
-
-		if (call->deadline > now) {
-			break;
+			return hrt_wheel_next_deadline();
 		}
 
-		sq_rem(&call->link, &callout_queue);
-		//PX4_INFO("call pop");
-
 		/* save the intended deadline for periodic calls */
 		deadline = call->deadline;
 
+		hrt_latency_update(now - deadline);
+
 		/* zero the deadline, as the call has occurred */
 		call->deadline = 0;
 
@@ -578,26 +1199,22 @@ hrt_call_invoke(void)
 			// Unlock so we don't deadlock in callback
 			hrt_unlock();
 
-			//PX4_INFO("call %p: %p(%p)", call, call->callout, call->arg);
 			call->callout(call->arg);
 
 			hrt_lock();
 		}
 
-		/* if the callout has a non-zero period, it has to be re-entered */
-		if (call->period != 0) {
+		/* if the callout has a non-zero period, it has to be re-entered
+		 * (unless it has been re-scheduled in the meantime) */
+		if (call->period != 0 && !hrt_wheel_queued(call)) {
 			// re-check call->deadline to allow for
 			// callouts to re-schedule themselves
 			// using hrt_call_delay()
 			if (call->deadline <= now) {
 				call->deadline = deadline + call->period;
-				//PX4_INFO("call deadline set to %lu now=%lu", call->deadline,  now);
 			}
 
-			hrt_call_enter(call);
+			hrt_wheel_insert(call);
 		}
 	}
-
-	hrt_unlock();
 }
-
@@ -45,9 +45,16 @@
 #include <pthread.h>
 #include <errno.h>
 
-#if defined(__PX4_DARWIN) || defined(__PX4_CYGWIN)
+#if defined(__PX4_DARWIN) || defined(__PX4_CYGWIN) || defined(ENABLE_LOCKSTEP_SCHEDULER)
 
 #include <px4_posix.h>
+#include <drivers/drv_hrt.h>
+
+/*
+ * value is the number of available posts, it never gets negative (same as
+ * sem_getvalue() on Linux). The waiters re-check it after every wakeup, so
+ * spurious wakeups are harmless.
+ */
 
 int px4_sem_init(px4_sem_t *s, int pshared, unsigned value)
 {
@@ -73,17 +80,15 @@ int px4_sem_wait(px4_sem_t *s)
 		return ret;
 	}
 
-	s->value--;
-
-	if (s->value < 0) {
+	while (s->value <= 0 && ret == 0) {
 		ret = pthread_cond_wait(&(s->wait), &(s->lock));
-
-	} else {
-		ret = 0;
 	}
 
 	if (ret) {
 		PX4_WARN("px4_sem_wait failure");
+
+	} else {
+		s->value--;
 	}
 
 	int mret = pthread_mutex_unlock(&(s->lock));
@@ -112,6 +117,19 @@ int px4_sem_trywait(px4_sem_t *s)
 	return (ret) ? ret : mret;
 }
 
+static int px4_sem_cond_timedwait(px4_sem_t *s, const struct timespec *abstime)
+{
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+
+	if (hrt_lockstep_enabled()) {
+		return hrt_lockstep_cond_timedwait(&(s->wait), &(s->lock), abstime);
+	}
+
+#endif
+
+	return pthread_cond_timedwait(&(s->wait), &(s->lock), abstime);
+}
+
 int px4_sem_timedwait(px4_sem_t *s, const struct timespec *abstime)
 {
 	int ret = pthread_mutex_lock(&(s->lock));
@@ -120,13 +138,15 @@ int px4_sem_timedwait(px4_sem_t *s, const struct timespec *abstime)
 		return ret;
 	}
 
-	s->value--;
 	errno = 0;
 
-	if (s->value < 0) {
-		ret = pthread_cond_timedwait(&(s->wait), &(s->lock), abstime);
+	while (s->value <= 0 && ret == 0) {
+		ret = px4_sem_cond_timedwait(s, abstime);
+	}
 
-	} else {
+	if (s->value > 0) {
+		// a post that raced with the timeout still counts
+		s->value--;
 		ret = 0;
 	}
 
@@ -143,6 +163,10 @@ int px4_sem_timedwait(px4_sem_t *s, const struct timespec *abstime)
 
 	int mret = pthread_mutex_unlock(&(s->lock));
 
+	if (err) {
+		errno = err;
+	}
+
 	return (err) ? err : mret;
 }
 
@@ -156,12 +180,7 @@ int px4_sem_post(px4_sem_t *s)
 
 	s->value++;
 
-	if (s->value <= 0) {
-		ret = pthread_cond_signal(&(s->wait));
-
-	} else {
-		ret = 0;
-	}
+	ret = pthread_cond_signal(&(s->wait));
 
 	if (ret) {
 		PX4_WARN("px4_sem_post failure");
@@ -46,6 +46,10 @@
 #include <px4_time.h>
 #include <queue.h>
 
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+#include <pthread.h>
+#endif
+
 __BEGIN_DECLS
 
 /**
@@ -67,6 +71,8 @@ typedef void	(* hrt_callout)(void *arg);
 
 /**
  * Callout record.
+ *
+ * Must be zero-initialised (e.g. with hrt_call_init()) before it is used the first time.
  */
 typedef struct hrt_call {
 	struct sq_entry_s	link;
@@ -75,6 +81,9 @@ typedef struct hrt_call {
 	hrt_abstime		period;
 	hrt_callout		callout;
 	void			*arg;
+#ifdef __PX4_POSIX
+	struct sq_entry_s	**link_prev;	/**< timer wheel back link (slot head or previous link), NULL if not queued */
+#endif
 } *hrt_call_t;
 
 /**
@@ -191,6 +200,37 @@ __EXPORT extern void	hrt_stop_delay(void);
  */
 __EXPORT extern void	hrt_stop_delay_delta(hrt_abstime delta);
 
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+
+/**
+ * Switch to lockstep mode: from now on the time only advances through
+ * hrt_lockstep_set_time(), which is driven by the simulator.
+ */
+__EXPORT extern void	hrt_lockstep_enable(void);
+
+/**
+ * Check if the time is driven by the simulator.
+ */
+__EXPORT extern bool	hrt_lockstep_enabled(void);
+
+/**
+ * Advance the simulated time and wake up everyone whose timeout expired.
+ *
+ * Going back in time is ignored.
+ */
+__EXPORT extern void	hrt_lockstep_set_time(hrt_abstime time);
+
+/**
+ * pthread_cond_timedwait() on the simulated time: abstime is on the
+ * px4_clock_gettime(CLOCK_REALTIME) clock. Must be called with lock held.
+ *
+ * @return 0 if the condition was signalled, ETIMEDOUT otherwise.
+ */
+__EXPORT extern int	hrt_lockstep_cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *lock,
+		const struct timespec *abstime);
+
+#endif
+
 #endif
 
 __END_DECLS
@@ -109,6 +109,18 @@ struct mixer_simple_s {
  */
 #define MIXERIOCLOADBUF		_MIXERIOC(5)
 
+/**
+ * Add mixer(s) from the precompiled image in (const struct mixer_binary_buf_s *)arg,
+ * see lib/mixer/mixer_binary.h
+ */
+#define MIXERIOCLOADBIN		_MIXERIOC(6)
+
+/** argument of MIXERIOCLOADBIN */
+struct mixer_binary_buf_s {
+	const void	*buf;		/**< the image (header and records) */
+	unsigned	buflen;		/**< size of the image in bytes */
+};
+
 /*
  * XXX Thoughts for additional operations:
  *
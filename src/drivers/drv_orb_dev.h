@@ -96,4 +96,10 @@
 /** Check whether the topic is published, sets *(unsigned long *)arg to 1 if published, 0 otherwise */
 #define ORBIOCISPUBLISHED	_ORBIOC(17)
 
+/** Borrow the next message in place instead of copying it, fills *(struct orb_borrowdata *)arg */
+#define ORBIOCBORROW		_ORBIOC(18)
+
+/** Set a bit in a bitmap on every publication, arg is a (struct orb_notifydata *), a null bitmap removes it */
+#define ORBIOCSETNOTIFY		_ORBIOC(19)
+
 #endif /* _DRV_UORB_H */
@@ -565,6 +565,36 @@ PWMSim::ioctl(device::file_t *filp, int cmd, unsigned long arg)
 			break;
 		}
 
+	case MIXERIOCLOADBIN: {
+			const mixer_binary_buf_s *image = (const mixer_binary_buf_s *)arg;
+
+			if (_mixers == nullptr) {
+				_mixers = new MixerGroup(control_callback, (uintptr_t)&_controls);
+			}
+
+			if (_mixers == nullptr) {
+				_groups_required = 0;
+				ret = -ENOMEM;
+
+			} else if (_mixers->load_from_binary(image->buf, image->buflen) != 0) {
+				/* the group is unchanged, the caller can fall back to the text mixer */
+				PX4_DEBUG("binary mixer load failed");
+
+				if (_mixers->count() == 0) {
+					delete _mixers;
+					_mixers = nullptr;
+					_groups_required = 0;
+				}
+
+				ret = -EINVAL;
+
+			} else {
+				_mixers->groups_required(_groups_required);
+			}
+
+			break;
+		}
+
 
 	default:
 		ret = -ENOTTY;
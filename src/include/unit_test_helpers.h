@@ -0,0 +1,100 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file unit_test_helpers.h
+ *
+ * Support code shared by the unit tests.
+ */
+
+#pragma once
+
+#include <drivers/drv_hrt.h>
+#include <stdint.h>
+
+/// @brief Pseudo-random numbers for unit tests (linear congruential generator).
+/// The sequence only depends on the seed, so test data and failures are reproducible.
+class UnitTestRandom
+{
+public:
+	explicit UnitTestRandom(uint32_t seed = 1) : _state(seed) {}
+
+	/// @brief Advance the generator. The upper bits are the most random ones.
+	uint32_t next()
+	{
+		_state = _state * 1103515245u + 12345u;
+		return _state;
+	}
+
+	/// @brief The last value returned by next() (or the seed), without advancing.
+	uint32_t state() const { return _state; }
+
+	/// @brief Uniformly distributed in [-range, range].
+	float uniform(float range)
+	{
+		return ((next() >> 8) & 0xffff) / 65535.0f * 2.0f * range - range;
+	}
+
+private:
+	uint32_t _state;
+};
+
+/// @brief Time per call [us] of an implementation and of its reference, see ut_benchmark().
+struct UnitTestBenchmark {
+	double time;
+	double reference_time;
+};
+
+/// @brief Time an implementation against its reference implementation, each called num_calls times
+/// with the call index. The timings depend on the machine and its load, so they are only to be reported,
+/// not asserted.
+template<typename Implementation, typename Reference>
+UnitTestBenchmark ut_benchmark(unsigned num_calls, Implementation implementation, Reference reference)
+{
+	UnitTestBenchmark result;
+	hrt_abstime start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < num_calls; i++) {
+		implementation(i);
+	}
+
+	result.time = (double)hrt_elapsed_time(&start) / num_calls;
+	start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < num_calls; i++) {
+		reference(i);
+	}
+
+	result.reference_time = (double)hrt_elapsed_time(&start) / num_calls;
+	return result;
+}
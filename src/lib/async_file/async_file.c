@@ -0,0 +1,599 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file async_file.c
+ *
+ * io_uring based implementation of the asynchronous file writer. The ring is set up
+ * with the raw system calls, so there is no dependency on liburing.
+ */
+
+#include "async_file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <drivers/drv_hrt.h>
+
+#if defined(__PX4_LINUX) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define ASYNC_FILE_IO_URING
+#endif
+#endif
+
+#ifdef ASYNC_FILE_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#define ASYNC_FILE_ALIGNMENT 4096
+#define ASYNC_FILE_SYNC_TAG ((uint64_t)-1)
+
+struct async_file_block {
+	uint8_t *data;
+	struct iovec iov;
+	off_t offset; ///< file offset of the request in flight
+	hrt_abstime submit_time;
+	bool in_flight;
+};
+
+struct async_file_s {
+	int fd;
+	int ring_fd;
+	bool direct;
+
+	/* submission queue */
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned sq_mask;
+	unsigned *sq_array;
+	struct io_uring_sqe *sqes;
+
+	/* completion queue */
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned cq_mask;
+	struct io_uring_cqe *cqes;
+
+	void *sq_ring;
+	size_t sq_ring_size;
+	void *cq_ring;
+	size_t cq_ring_size;
+	size_t sqes_size;
+
+	struct async_file_block *blocks;
+	unsigned num_blocks;
+	size_t block_size;
+
+	unsigned current; ///< index of the block being filled
+	size_t fill; ///< number of bytes in the current block
+	off_t offset; ///< file offset of the current block
+	unsigned in_flight; ///< number of requests in flight
+	bool sync_in_flight;
+	int error; ///< first error of a completed request
+
+	perf_counter_t perf_latency;
+};
+
+static int ring_setup(struct async_file_s *f, unsigned entries)
+{
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+
+	f->ring_fd = syscall(__NR_io_uring_setup, entries, &p);
+
+	if (f->ring_fd < 0) {
+		return -errno;
+	}
+
+	f->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	f->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	f->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	bool single_mmap = false;
+
+#ifdef IORING_FEAT_SINGLE_MMAP
+
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		single_mmap = true;
+
+		if (f->cq_ring_size > f->sq_ring_size) {
+			f->sq_ring_size = f->cq_ring_size;
+		}
+
+		f->cq_ring_size = f->sq_ring_size;
+	}
+
+#endif
+
+	f->sq_ring = mmap(NULL, f->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, f->ring_fd,
+			  IORING_OFF_SQ_RING);
+
+	if (f->sq_ring == MAP_FAILED) {
+		f->sq_ring = NULL;
+		return -errno;
+	}
+
+	if (single_mmap) {
+		f->cq_ring = f->sq_ring;
+
+	} else {
+		f->cq_ring = mmap(NULL, f->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, f->ring_fd,
+				  IORING_OFF_CQ_RING);
+
+		if (f->cq_ring == MAP_FAILED) {
+			f->cq_ring = NULL;
+			return -errno;
+		}
+	}
+
+	f->sqes = (struct io_uring_sqe *)mmap(NULL, f->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+					      f->ring_fd, IORING_OFF_SQES);
+
+	if (f->sqes == MAP_FAILED) {
+		f->sqes = NULL;
+		return -errno;
+	}
+
+	uint8_t *sq = (uint8_t *)f->sq_ring;
+	f->sq_head = (unsigned *)(sq + p.sq_off.head);
+	f->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+	f->sq_mask = *(unsigned *)(sq + p.sq_off.ring_mask);
+	f->sq_array = (unsigned *)(sq + p.sq_off.array);
+
+	uint8_t *cq = (uint8_t *)f->cq_ring;
+	f->cq_head = (unsigned *)(cq + p.cq_off.head);
+	f->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+	f->cq_mask = *(unsigned *)(cq + p.cq_off.ring_mask);
+	f->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+	return 0;
+}
+
+static void ring_teardown(struct async_file_s *f)
+{
+	if (f->sqes) {
+		munmap(f->sqes, f->sqes_size);
+	}
+
+	if (f->cq_ring && f->cq_ring != f->sq_ring) {
+		munmap(f->cq_ring, f->cq_ring_size);
+	}
+
+	if (f->sq_ring) {
+		munmap(f->sq_ring, f->sq_ring_size);
+	}
+
+	if (f->ring_fd >= 0) {
+		close(f->ring_fd);
+	}
+}
+
+/**
+ * Get the next submission queue entry. The queue is sized to hold all the requests that
+ * can be in flight, so this cannot fail.
+ */
+static struct io_uring_sqe *get_sqe(struct async_file_s *f)
+{
+	const unsigned tail = *f->sq_tail;
+	const unsigned index = tail & f->sq_mask;
+	struct io_uring_sqe *sqe = &f->sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	f->sq_array[index] = index;
+	__atomic_store_n(f->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	++f->in_flight;
+	return sqe;
+}
+
+static int ring_enter(struct async_file_s *f, unsigned to_submit, unsigned min_complete)
+{
+	const unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+	int ret;
+
+	do {
+		ret = syscall(__NR_io_uring_enter, f->ring_fd, to_submit, min_complete, flags, NULL, 0);
+	} while (ret < 0 && errno == EINTR);
+
+	return ret < 0 ? -errno : 0;
+}
+
+/**
+ * Process all the available completions
+ */
+static void reap(struct async_file_s *f)
+{
+	unsigned head = *f->cq_head;
+	const unsigned tail = __atomic_load_n(f->cq_tail, __ATOMIC_ACQUIRE);
+	const hrt_abstime now = hrt_absolute_time();
+
+	while (head != tail) {
+		const struct io_uring_cqe *cqe = &f->cqes[head & f->cq_mask];
+		--f->in_flight;
+
+		if (cqe->user_data == ASYNC_FILE_SYNC_TAG) {
+			f->sync_in_flight = false;
+
+			if (cqe->res < 0 && f->error == 0) {
+				f->error = cqe->res;
+			}
+
+		} else {
+			struct async_file_block *block = &f->blocks[cqe->user_data];
+			block->in_flight = false;
+
+			if (f->perf_latency) {
+				perf_set_elapsed(f->perf_latency, now - block->submit_time);
+			}
+
+			if (cqe->res < 0 && f->error == 0) {
+				f->error = cqe->res;
+
+			} else if ((size_t)cqe->res != block->iov.iov_len && f->error == 0) {
+				/* a short write would leave a hole, unaligned for O_DIRECT */
+				f->error = -EIO;
+			}
+		}
+
+		++head;
+	}
+
+	__atomic_store_n(f->cq_head, head, __ATOMIC_RELEASE);
+}
+
+/**
+ * Block until at least one request completed
+ */
+static int wait_completion(struct async_file_s *f)
+{
+	int ret = ring_enter(f, 0, 1);
+
+	if (ret == 0) {
+		reap(f);
+	}
+
+	return ret;
+}
+
+/**
+ * Wait until there is no write request in flight for the given file offset, so that
+ * requests for the same block (partial and full) complete in order.
+ */
+static int wait_offset_idle(struct async_file_s *f, off_t offset)
+{
+	for (unsigned i = 0; i < f->num_blocks; ++i) {
+		while (f->blocks[i].in_flight && f->blocks[i].offset == offset) {
+			int ret = wait_completion(f);
+
+			if (ret < 0) {
+				return ret;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static int find_free_block(struct async_file_s *f, bool wait)
+{
+	while (true) {
+		for (unsigned i = 1; i <= f->num_blocks; ++i) {
+			const unsigned index = (f->current + i) % f->num_blocks;
+
+			if (!f->blocks[index].in_flight && index != f->current) {
+				return index;
+			}
+		}
+
+		if (!wait) {
+			return -EAGAIN;
+		}
+
+		int ret = wait_completion(f);
+
+		if (ret < 0) {
+			return ret;
+		}
+	}
+}
+
+static struct io_uring_sqe *prepare_write(struct async_file_s *f, unsigned index, off_t offset)
+{
+	struct async_file_block *block = &f->blocks[index];
+	block->iov.iov_base = block->data;
+	block->iov.iov_len = f->block_size;
+	block->offset = offset;
+	block->submit_time = hrt_absolute_time();
+	block->in_flight = true;
+
+	struct io_uring_sqe *sqe = get_sqe(f);
+	sqe->opcode = IORING_OP_WRITEV;
+	sqe->fd = f->fd;
+	sqe->off = offset;
+	sqe->addr = (uint64_t)(uintptr_t)&block->iov;
+	sqe->len = 1;
+	sqe->user_data = index;
+	return sqe;
+}
+
+/**
+ * Submit the (full) current block and switch to the next free one
+ */
+static int submit_current(struct async_file_s *f)
+{
+	int ret = wait_offset_idle(f, f->offset);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	prepare_write(f, f->current, f->offset);
+	ret = ring_enter(f, 1, 0);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	ret = find_free_block(f, true);
+
+	if (ret < 0) {
+		return ret;
+	}
+
+	f->current = ret;
+	f->fill = 0;
+	f->offset += f->block_size;
+	return 0;
+}
+
+async_file_t async_file_open(const char *path, mode_t mode, size_t block_size, unsigned num_blocks,
+			     perf_counter_t perf_latency)
+{
+	if (block_size == 0 || block_size % ASYNC_FILE_ALIGNMENT != 0 || num_blocks < 2) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	struct async_file_s *f = (struct async_file_s *)calloc(1, sizeof(struct async_file_s));
+
+	if (!f) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	f->ring_fd = -1;
+	f->block_size = block_size;
+	f->num_blocks = num_blocks;
+	f->perf_latency = perf_latency;
+	f->direct = true;
+	f->fd = open(path, O_CREAT | O_WRONLY | O_TRUNC | O_DIRECT, mode);
+
+	if (f->fd < 0 && errno == EINVAL) {
+		/* the file system does not support O_DIRECT (e.g. tmpfs), use the page cache */
+		f->direct = false;
+		f->fd = open(path, O_CREAT | O_WRONLY | O_TRUNC, mode);
+	}
+
+	int ret = f->fd < 0 ? -errno : 0;
+
+	if (ret == 0) {
+		/* all the blocks, the partial block and a sync can be in flight */
+		ret = ring_setup(f, num_blocks + 2);
+	}
+
+	if (ret == 0) {
+		f->blocks = (struct async_file_block *)calloc(num_blocks, sizeof(struct async_file_block));
+		ret = f->blocks ? 0 : -ENOMEM;
+	}
+
+	for (unsigned i = 0; ret == 0 && i < num_blocks; ++i) {
+		void *data = NULL;
+		ret = -posix_memalign(&data, ASYNC_FILE_ALIGNMENT, block_size);
+		f->blocks[i].data = (uint8_t *)data;
+	}
+
+	if (ret != 0) {
+		async_file_close(f);
+		errno = -ret;
+		return NULL;
+	}
+
+	return f;
+}
+
+int async_file_write(async_file_t f, const void *buffer, size_t size)
+{
+	const uint8_t *data = (const uint8_t *)buffer;
+	size_t remaining = size;
+
+	reap(f);
+
+	while (f->error == 0 && remaining > 0) {
+		size_t n = f->block_size - f->fill;
+
+		if (n > remaining) {
+			n = remaining;
+		}
+
+		memcpy(f->blocks[f->current].data + f->fill, data, n);
+		f->fill += n;
+		data += n;
+		remaining -= n;
+
+		if (f->fill == f->block_size) {
+			int ret = submit_current(f);
+
+			if (ret < 0 && f->error == 0) {
+				f->error = ret;
+			}
+		}
+	}
+
+	return f->error < 0 ? f->error : (int)size;
+}
+
+int async_file_sync(async_file_t f)
+{
+	reap(f);
+
+	if (f->error < 0) {
+		return f->error;
+	}
+
+	if (f->sync_in_flight) {
+		return 0;
+	}
+
+	unsigned to_submit = 0;
+
+	if (f->fill > 0) {
+		/* write a padded copy of the partial block, unless an earlier one is still in flight */
+		int index = find_free_block(f, false);
+		bool offset_busy = false;
+
+		for (unsigned i = 0; i < f->num_blocks; ++i) {
+			offset_busy |= f->blocks[i].in_flight && f->blocks[i].offset == f->offset;
+		}
+
+		if (index < 0 || offset_busy) {
+			return 0;
+		}
+
+		memcpy(f->blocks[index].data, f->blocks[f->current].data, f->fill);
+		memset(f->blocks[index].data + f->fill, 0, f->block_size - f->fill);
+		struct io_uring_sqe *sqe = prepare_write(f, index, f->offset);
+		sqe->flags |= IOSQE_IO_LINK; // sync after this write
+		++to_submit;
+	}
+
+	/* the sync is not ordered against the other writes in flight, so it does not stall them */
+	struct io_uring_sqe *sqe = get_sqe(f);
+	sqe->opcode = IORING_OP_FSYNC;
+	sqe->fd = f->fd;
+	sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+	sqe->user_data = ASYNC_FILE_SYNC_TAG;
+	f->sync_in_flight = true;
+	++to_submit;
+
+	return ring_enter(f, to_submit, 0);
+}
+
+int async_file_close(async_file_t f)
+{
+	int ret = 0;
+
+	if (f->sq_ring && f->blocks && f->error == 0 && f->fill > 0) {
+		memset(f->blocks[f->current].data + f->fill, 0, f->block_size - f->fill);
+		ret = wait_offset_idle(f, f->offset);
+
+		if (ret == 0) {
+			prepare_write(f, f->current, f->offset);
+			ret = ring_enter(f, 1, 0);
+		}
+	}
+
+	while (ret == 0 && f->in_flight > 0) {
+		ret = wait_completion(f);
+	}
+
+	if (ret == 0) {
+		ret = f->error;
+	}
+
+	if (f->fd >= 0) {
+		/* remove the padding of the last block */
+		if (f->sq_ring && ftruncate(f->fd, f->offset + f->fill) != 0 && ret == 0) {
+			ret = -errno;
+		}
+
+		if (fsync(f->fd) != 0 && ret == 0) {
+			ret = -errno;
+		}
+
+		if (close(f->fd) != 0 && ret == 0) {
+			ret = -errno;
+		}
+	}
+
+	ring_teardown(f);
+
+	if (f->blocks) {
+		for (unsigned i = 0; i < f->num_blocks; ++i) {
+			free(f->blocks[i].data);
+		}
+
+		free(f->blocks);
+	}
+
+	free(f);
+	return ret;
+}
+
+bool async_file_is_direct(async_file_t f)
+{
+	return f->direct;
+}
+
+#else /* ASYNC_FILE_IO_URING */
+
+async_file_t async_file_open(const char *path, mode_t mode, size_t block_size, unsigned num_blocks,
+			     perf_counter_t perf_latency)
+{
+	errno = ENOSYS;
+	return NULL;
+}
+
+int async_file_write(async_file_t file, const void *buffer, size_t size)
+{
+	return -ENOSYS;
+}
+
+int async_file_sync(async_file_t file)
+{
+	return -ENOSYS;
+}
+
+int async_file_close(async_file_t file)
+{
+	return -ENOSYS;
+}
+
+bool async_file_is_direct(async_file_t file)
+{
+	return false;
+}
+
+#endif /* ASYNC_FILE_IO_URING */
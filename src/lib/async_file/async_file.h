@@ -0,0 +1,98 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file async_file.h
+ *
+ * Sequential file writer with asynchronous, block aligned write requests.
+ *
+ * The data is collected in aligned blocks, which are written with O_DIRECT
+ * (if the file system supports it) through an io_uring submission queue. The
+ * caller only blocks if all the blocks are in flight, which decouples it from
+ * the latency of the storage device (and e.g. fsync stalls on eMMC).
+ *
+ * Only available on Linux, on other platforms async_file_open() fails with ENOSYS.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include <px4_defines.h>
+#include <perf/perf_counter.h>
+
+__BEGIN_DECLS
+
+typedef struct async_file_s *async_file_t;
+
+/**
+ * Open (create or truncate) a file for asynchronous writing.
+ * @param path file path
+ * @param mode file mode for O_CREAT
+ * @param block_size size of a write request, must be a multiple of 4096
+ * @param num_blocks number of blocks (maximum number of write requests in flight + 1)
+ * @param perf_latency optional PC_ELAPSED counter, which gets the latency of every write request
+ * @return handle, or NULL on error with errno set
+ */
+__EXPORT extern async_file_t async_file_open(const char *path, mode_t mode, size_t block_size, unsigned num_blocks,
+		perf_counter_t perf_latency);
+
+/**
+ * Append data to the file. Full blocks are submitted right away.
+ * This only blocks if there is no free block left.
+ * @return size on success, <0 errno of a failed (or earlier failed) write request
+ */
+__EXPORT extern int async_file_write(async_file_t file, const void *buffer, size_t size);
+
+/**
+ * Submit the current partial block followed by an fdatasync, without waiting for either.
+ * The file contains zero padding up to the next block boundary until it is closed.
+ * @return 0 on success (or if a sync is still in flight), <0 errno otherwise
+ */
+__EXPORT extern int async_file_sync(async_file_t file);
+
+/**
+ * Write the remaining data, wait for all the requests, truncate the padding and close the file.
+ * The handle is freed, even on error.
+ * @return 0 on success, <0 errno of the first failed request otherwise
+ */
+__EXPORT extern int async_file_close(async_file_t file);
+
+/**
+ * Check if the file is opened with O_DIRECT (bypassing the page cache)
+ */
+__EXPORT extern bool async_file_is_direct(async_file_t file);
+
+__END_DECLS
@@ -48,6 +48,7 @@
 #include <px4_log.h>
 #include <px4_posix.h>
 #include <px4_time.h>
+#include <drivers/drv_hrt.h>
 
 #include "DevMgr.hpp"
 
@@ -59,8 +60,6 @@ const device::px4_file_operations_t device::CDev::fops = {};
 pthread_mutex_t devmutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_mutex_t filemutex = PTHREAD_MUTEX_INITIALIZER;
 
-px4_sem_t lockstep_sem;
-bool sim_lockstep = false;
 volatile bool sim_delay = false;
 
 #define PX4_MAX_FD 350
@@ -154,26 +153,10 @@ extern "C" {
 		return ret;
 	}
 
-	int px4_open(const char *path, int flags, ...)
+	static int open_device(device::CDev *dev, int flags, const char *path)
 	{
-		PX4_DEBUG("px4_open");
-		device::CDev *dev = getDev(path);
 		int ret = 0;
 		int i;
-		mode_t mode;
-
-		if (!dev && (flags & (PX4_F_WRONLY | PX4_F_CREAT)) != 0 &&
-		    strncmp(path, "/obj/", 5) != 0 &&
-		    strncmp(path, "/dev/", 5) != 0) {
-			va_list p;
-			va_start(p, flags);
-			mode = va_arg(p, int);
-			va_end(p);
-
-			// Create the file
-			PX4_DEBUG("Creating virtual file %s", path);
-			dev = device::VFile::createFile(path, mode);
-		}
 
 		if (dev) {
 
@@ -223,6 +206,33 @@ extern "C" {
 		return i;
 	}
 
+	int px4_open(const char *path, int flags, ...)
+	{
+		PX4_DEBUG("px4_open");
+		device::CDev *dev = getDev(path);
+		mode_t mode;
+
+		if (!dev && (flags & (PX4_F_WRONLY | PX4_F_CREAT)) != 0 &&
+		    strncmp(path, "/obj/", 5) != 0 &&
+		    strncmp(path, "/dev/", 5) != 0) {
+			va_list p;
+			va_start(p, flags);
+			mode = va_arg(p, int);
+			va_end(p);
+
+			// Create the file
+			PX4_DEBUG("Creating virtual file %s", path);
+			dev = device::VFile::createFile(path, mode);
+		}
+
+		return open_device(dev, flags, path);
+	}
+
+	int px4_open_device(device::CDev *dev, int flags)
+	{
+		return open_device(dev, flags, "device");
+	}
+
 	int px4_close(int fd)
 	{
 		int ret;
@@ -524,13 +534,14 @@ extern "C" {
 
 	void px4_enable_sim_lockstep()
 	{
-		px4_sem_init(&lockstep_sem, 0, 0);
-
-		// lockstep_sem use case is a signal
-		px4_sem_setprotocol(&lockstep_sem, SEM_PRIO_NONE);
-
-		sim_lockstep = true;
 		sim_delay = false;
+
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+		// from now on the time (and with it all timeouts) is driven by the simulator
+		hrt_lockstep_enable();
+#else
+		PX4_WARN("lockstep scheduler not supported in this build");
+#endif
 	}
 
 	void px4_sim_start_delay()
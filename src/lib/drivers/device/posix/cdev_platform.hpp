@@ -25,8 +25,16 @@ struct file_t {
 	file_t(int f, void *c) : flags(f), priv(nullptr), vdev(c) {}
 };
 
+class CDev;
+
 } // namespace device
 
 extern "C" __EXPORT int register_driver(const char *name, const device::px4_file_operations_t *fops,
 					device::mode_t mode, void *data);
 extern "C" __EXPORT int unregister_driver(const char *path);
+
+/**
+ * Open a registered device object directly, without looking up its path.
+ * Same semantics and return value as px4_open().
+ */
+extern "C" __EXPORT int px4_open_device(device::CDev *dev, int flags);
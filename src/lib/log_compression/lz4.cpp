@@ -0,0 +1,340 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file lz4.cpp
+ *
+ * LZ4 block compression and decompression.
+ */
+
+#include "lz4.h"
+
+#include <string.h>
+
+namespace log_compression
+{
+
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t LAST_LITERALS = 5; ///< the last 5 bytes of a block are always literals
+static constexpr size_t MF_LIMIT = 12; ///< the last match must start at least 12 bytes before the end
+static constexpr unsigned HASH_BITS = 12;
+static constexpr unsigned SKIP_TRIGGER = 6; ///< step up the search faster on incompressible data
+
+static_assert(LZ4_HASH_TABLE_SIZE == (1 << HASH_BITS), "hash table size mismatch");
+
+static inline uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline unsigned hash(uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static inline uint8_t *write_length(uint8_t *op, size_t length)
+{
+	while (length >= 255) {
+		*op++ = 255;
+		length -= 255;
+	}
+
+	*op++ = (uint8_t)length;
+	return op;
+}
+
+static inline bool read_length(const uint8_t *&ip, const uint8_t *iend, size_t &length)
+{
+	uint8_t b;
+
+	do {
+		if (ip >= iend) {
+			return false;
+		}
+
+		b = *ip++;
+		length += b;
+	} while (b == 255);
+
+	return true;
+}
+
+int lz4_compress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_capacity, uint16_t *hash_table)
+{
+	if (src_size > LZ4_MAX_BLOCK_SIZE) {
+		return -1;
+	}
+
+	uint8_t *op = dst;
+	uint8_t *const oend = dst + dst_capacity;
+	size_t anchor = 0;
+
+	if (src_size > MF_LIMIT) {
+		memset(hash_table, 0, LZ4_HASH_TABLE_SIZE * sizeof(hash_table[0]));
+		const size_t mflimit = src_size - MF_LIMIT;
+		const size_t matchlimit = src_size - LAST_LITERALS;
+		size_t ip = 1; // all the table entries point to position 0
+
+		while (ip <= mflimit) {
+			const uint32_t sequence = read32(src + ip);
+			const unsigned h = hash(sequence);
+			size_t ref = hash_table[h];
+			hash_table[h] = (uint16_t)ip;
+
+			if (ref >= ip || read32(src + ref) != sequence) {
+				ip += 1 + ((ip - anchor) >> SKIP_TRIGGER);
+				continue;
+			}
+
+			/* extend the match backwards and forwards */
+			while (ip > anchor && ref > 0 && src[ip - 1] == src[ref - 1]) {
+				--ip;
+				--ref;
+			}
+
+			size_t length = MIN_MATCH;
+
+			while (ip + length < matchlimit && src[ref + length] == src[ip + length]) {
+				++length;
+			}
+
+			const size_t literals = ip - anchor;
+
+			if ((size_t)(oend - op) < 1 + literals + literals / 255 + 1 + 2 + length / 255 + 1) {
+				return -1;
+			}
+
+			/* sequence: token, literal length, literals, offset, match length */
+			uint8_t *token = op++;
+
+			if (literals >= 15) {
+				*token = 15 << 4;
+				op = write_length(op, literals - 15);
+
+			} else {
+				*token = (uint8_t)(literals << 4);
+			}
+
+			memcpy(op, src + anchor, literals);
+			op += literals;
+
+			const size_t offset = ip - ref;
+			*op++ = (uint8_t)offset;
+			*op++ = (uint8_t)(offset >> 8);
+
+			if (length - MIN_MATCH >= 15) {
+				*token |= 15;
+				op = write_length(op, length - MIN_MATCH - 15);
+
+			} else {
+				*token |= (uint8_t)(length - MIN_MATCH);
+			}
+
+			ip += length;
+			anchor = ip;
+
+			/* index a position within the match, this helps on repetitive data */
+			if (ip <= mflimit) {
+				hash_table[hash(read32(src + ip - 2))] = (uint16_t)(ip - 2);
+			}
+		}
+	}
+
+	const size_t literals = src_size - anchor;
+
+	if ((size_t)(oend - op) < 1 + literals + literals / 255 + 1) {
+		return -1;
+	}
+
+	if (literals >= 15) {
+		*op++ = 15 << 4;
+		op = write_length(op, literals - 15);
+
+	} else {
+		*op++ = (uint8_t)(literals << 4);
+	}
+
+	memcpy(op, src + anchor, literals);
+	op += literals;
+
+	return op - dst;
+}
+
+int lz4_decompress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_capacity)
+{
+	const uint8_t *ip = src;
+	const uint8_t *const iend = src + src_size;
+	uint8_t *op = dst;
+	uint8_t *const oend = dst + dst_capacity;
+
+	while (ip < iend) {
+		const unsigned token = *ip++;
+		size_t literals = token >> 4;
+
+		if (literals == 15 && !read_length(ip, iend, literals)) {
+			return -1;
+		}
+
+		if ((size_t)(iend - ip) < literals || (size_t)(oend - op) < literals) {
+			return -1;
+		}
+
+		memcpy(op, ip, literals);
+		op += literals;
+		ip += literals;
+
+		if (ip == iend) {
+			break; // the last sequence only has literals
+		}
+
+		if (iend - ip < 2) {
+			return -1;
+		}
+
+		const size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+
+		if (offset == 0 || offset > (size_t)(op - dst)) {
+			return -1;
+		}
+
+		size_t length = token & 15;
+
+		if (length == 15 && !read_length(ip, iend, length)) {
+			return -1;
+		}
+
+		length += MIN_MATCH;
+
+		if ((size_t)(oend - op) < length) {
+			return -1;
+		}
+
+		const uint8_t *match = op - offset;
+
+		if (offset >= length) {
+			memcpy(op, match, length);
+
+		} else {
+			/* overlapping match: repeats the last offset bytes */
+			for (size_t i = 0; i < length; ++i) {
+				op[i] = match[i];
+			}
+		}
+
+		op += length;
+	}
+
+	return op - dst;
+}
+
+int lz4_decompressed_size(const uint8_t *src, size_t src_size)
+{
+	const uint8_t *ip = src;
+	const uint8_t *const iend = src + src_size;
+	size_t size = 0;
+
+	while (ip < iend) {
+		const unsigned token = *ip++;
+		size_t literals = token >> 4;
+
+		if (literals == 15 && !read_length(ip, iend, literals)) {
+			return -1;
+		}
+
+		if ((size_t)(iend - ip) < literals) {
+			return -1;
+		}
+
+		size += literals;
+		ip += literals;
+
+		if (ip == iend) {
+			break;
+		}
+
+		if (iend - ip < 2) {
+			return -1;
+		}
+
+		const size_t offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+
+		if (offset == 0 || offset > size) {
+			return -1;
+		}
+
+		size_t length = token & 15;
+
+		if (length == 15 && !read_length(ip, iend, length)) {
+			return -1;
+		}
+
+		size += length + MIN_MATCH;
+	}
+
+	return size;
+}
+
+uint32_t xxh32_short(const uint8_t *data, size_t size, uint32_t seed)
+{
+	static constexpr uint32_t PRIME1 = 2654435761u;
+	static constexpr uint32_t PRIME2 = 2246822519u;
+	static constexpr uint32_t PRIME3 = 3266489917u;
+	static constexpr uint32_t PRIME4 = 668265263u;
+	static constexpr uint32_t PRIME5 = 374761393u;
+
+	auto rotl = [](uint32_t x, unsigned r) { return (x << r) | (x >> (32 - r)); };
+
+	uint32_t h = seed + PRIME5 + (uint32_t)size;
+
+	for (; size >= 4; size -= 4, data += 4) {
+		const uint32_t v = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+		h = rotl(h + v * PRIME3, 17) * PRIME4;
+	}
+
+	for (; size > 0; --size, ++data) {
+		h = rotl(h + *data * PRIME5, 11) * PRIME1;
+	}
+
+	h ^= h >> 15;
+	h *= PRIME2;
+	h ^= h >> 13;
+	h *= PRIME3;
+	h ^= h >> 16;
+	return h;
+}
+
+} // namespace log_compression
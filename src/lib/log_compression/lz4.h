@@ -0,0 +1,93 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file lz4.h
+ *
+ * LZ4 block compression (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md).
+ *
+ * A small, allocation-free implementation of the fast (greedy) compressor and the
+ * decompressor. The output is compatible with the reference implementation.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace log_compression
+{
+
+/** maximum input size of a block: match offsets and the hash table positions are 16 bit */
+static constexpr size_t LZ4_MAX_BLOCK_SIZE = 64 * 1024;
+
+/** number of entries of the hash table passed to lz4_compress() */
+static constexpr size_t LZ4_HASH_TABLE_SIZE = 1 << 12;
+
+/**
+ * Worst case size of the compressed data (incompressible input)
+ */
+static constexpr size_t lz4_compress_bound(size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+/**
+ * Compress a block.
+ * @param src input data
+ * @param src_size input size, at most LZ4_MAX_BLOCK_SIZE
+ * @param dst output buffer
+ * @param dst_capacity size of dst, lz4_compress_bound(src_size) is always sufficient
+ * @param hash_table scratch memory of LZ4_HASH_TABLE_SIZE entries
+ * @return compressed size, or -1 if the input is too large or dst too small
+ */
+int lz4_compress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_capacity, uint16_t *hash_table);
+
+/**
+ * Decompress a block.
+ * @return decompressed size, or -1 if the input is malformed or dst too small
+ */
+int lz4_decompress(const uint8_t *src, size_t src_size, uint8_t *dst, size_t dst_capacity);
+
+/**
+ * Get the decompressed size of a block by parsing its sequences, without decompressing it.
+ * @return decompressed size, or -1 if the input is malformed
+ */
+int lz4_decompressed_size(const uint8_t *src, size_t src_size);
+
+/**
+ * xxHash32 of a short input (less than 16 bytes), as used for the LZ4 frame header checksum
+ */
+uint32_t xxh32_short(const uint8_t *data, size_t size, uint32_t seed);
+
+} // namespace log_compression
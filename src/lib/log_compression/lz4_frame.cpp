@@ -0,0 +1,413 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file lz4_frame.cpp
+ *
+ * LZ4 frame encoder with a block index, and the corresponding reader.
+ */
+
+#include "lz4_frame.h"
+
+#include <string.h>
+
+namespace log_compression
+{
+
+static constexpr size_t FRAME_HEADER_SIZE = 7;
+static constexpr size_t INDEX_HEADER_SIZE = 12; ///< end mark + skippable frame magic + frame size
+static constexpr size_t INDEX_FOOTER_SIZE = 8;
+static constexpr uint32_t BLOCK_UNCOMPRESSED = 0x80000000u;
+
+static inline void write32(uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t read32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+LZ4FrameEncoder::~LZ4FrameEncoder()
+{
+	delete[] _block;
+	delete[] _output;
+	delete[] _hash_table;
+	delete[] _index;
+}
+
+bool LZ4FrameEncoder::init(size_t block_size)
+{
+	if (block_size == 0 || block_size > LZ4_MAX_BLOCK_SIZE) {
+		return false;
+	}
+
+	_block_size = block_size;
+	_block = new uint8_t[block_size];
+	_output = new uint8_t[4 + lz4_compress_bound(block_size)];
+	_hash_table = new uint16_t[LZ4_HASH_TABLE_SIZE];
+
+	return _block && _output && _hash_table;
+}
+
+const uint8_t *LZ4FrameEncoder::begin(size_t &size)
+{
+	write32(_header, LZ4F_MAGIC);
+	_header[4] = 0x60; // FLG: version 01, independent blocks, no checksums, no content size
+	_header[5] = 0x40; // BD: 64 KiB maximum block size
+	_header[6] = (uint8_t)(xxh32_short(&_header[4], 2, 0) >> 8);
+
+	_fill = 0;
+	_bytes_in = 0;
+	_bytes_out = FRAME_HEADER_SIZE;
+
+	/* the index is built in the final output format, with the header space reserved */
+	_index_size = INDEX_HEADER_SIZE;
+	_index_valid = true;
+
+	size = FRAME_HEADER_SIZE;
+	return _header;
+}
+
+size_t LZ4FrameEncoder::append(const void *data, size_t size)
+{
+	size_t n = _block_size - _fill;
+
+	if (n > size) {
+		n = size;
+	}
+
+	memcpy(_block + _fill, data, n);
+	_fill += n;
+	_bytes_in += n;
+	return n;
+}
+
+const uint8_t *LZ4FrameEncoder::compress_block(size_t &size)
+{
+	if (_fill == 0) {
+		return nullptr;
+	}
+
+	int compressed = lz4_compress(_block, _fill, _output + 4, lz4_compress_bound(_block_size), _hash_table);
+	uint32_t block_header;
+
+	if (compressed < 0 || (size_t)compressed >= _fill) {
+		/* incompressible data is stored as is */
+		memcpy(_output + 4, _block, _fill);
+		block_header = _fill | BLOCK_UNCOMPRESSED;
+		size = 4 + _fill;
+
+	} else {
+		block_header = compressed;
+		size = 4 + compressed;
+	}
+
+	write32(_output, block_header);
+
+	if (_index_valid) {
+		_index_valid = index_append(size, _fill);
+	}
+
+	_bytes_out += size;
+	_fill = 0;
+	return _output;
+}
+
+bool LZ4FrameEncoder::index_append(uint32_t compressed_size, uint32_t decompressed_size)
+{
+	const size_t needed = _index_size + 8 + INDEX_FOOTER_SIZE;
+
+	if (needed > _index_capacity) {
+		size_t capacity = _index_capacity > 0 ? _index_capacity * 2 : 1024;
+
+		uint8_t *index = new uint8_t[capacity];
+
+		if (!index) {
+			return false;
+		}
+
+		if (_index) {
+			memcpy(index, _index, _index_size);
+			delete[] _index;
+		}
+
+		_index = index;
+		_index_capacity = capacity;
+	}
+
+	write32(_index + _index_size, compressed_size);
+	write32(_index + _index_size + 4, decompressed_size);
+	_index_size += 8;
+	return true;
+}
+
+const uint8_t *LZ4FrameEncoder::end(size_t &size)
+{
+	static const uint8_t end_mark[4] {};
+
+	if (!_index_valid || !_index) {
+		/* no index: the reader will have to scan the blocks */
+		size = sizeof(end_mark);
+		_bytes_out += size;
+		return end_mark;
+	}
+
+	const uint32_t num_blocks = (_index_size - INDEX_HEADER_SIZE) / 8;
+	write32(_index + _index_size, num_blocks);
+	write32(_index + _index_size + 4, LZ4F_INDEX_FOOTER_MAGIC);
+	size = _index_size + INDEX_FOOTER_SIZE;
+
+	write32(_index, 0); // end mark
+	write32(_index + 4, LZ4F_INDEX_FRAME_MAGIC);
+	write32(_index + 8, size - INDEX_HEADER_SIZE);
+
+	_bytes_out += size;
+	return _index;
+}
+
+LZ4FrameReader::~LZ4FrameReader()
+{
+	delete[] _blocks;
+}
+
+bool LZ4FrameReader::init(const uint8_t *data, size_t size)
+{
+	delete[] _blocks;
+	_blocks = nullptr;
+	_num_blocks = 0;
+	_max_block_size = 0;
+	_has_index = false;
+	_data = data;
+	_size = size;
+
+	if (size < FRAME_HEADER_SIZE || read32(data) != LZ4F_MAGIC) {
+		return false;
+	}
+
+	const uint8_t flags = data[4];
+
+	if ((flags >> 6) != 1 || !(flags & 0x20)) {
+		/* unknown version or linked blocks, which cannot be decompressed independently */
+		return false;
+	}
+
+	_block_checksum = flags & 0x10;
+	size_t pos = 6;
+
+	if (flags & 0x08) {
+		pos += 8; // content size
+	}
+
+	if (flags & 0x01) {
+		pos += 4; // dictionary id
+	}
+
+	if (pos >= size || data[pos] != (uint8_t)(xxh32_short(data + 4, pos - 4, 0) >> 8)) {
+		return false;
+	}
+
+	++pos;
+
+	return read_index(pos) || scan_blocks(pos);
+}
+
+bool LZ4FrameReader::read_index(size_t blocks_start)
+{
+	if (_size < blocks_start + INDEX_HEADER_SIZE + INDEX_FOOTER_SIZE) {
+		return false;
+	}
+
+	const uint8_t *footer = _data + _size - INDEX_FOOTER_SIZE;
+	const uint32_t num_blocks = read32(footer);
+
+	if (read32(footer + 4) != LZ4F_INDEX_FOOTER_MAGIC || num_blocks == 0 || num_blocks > _size / 8) {
+		return false;
+	}
+
+	const size_t index_size = 8 + num_blocks * 8 + INDEX_FOOTER_SIZE;
+
+	if (index_size > _size - blocks_start) {
+		return false;
+	}
+
+	const uint8_t *frame = _data + _size - index_size;
+
+	if (read32(frame) != LZ4F_INDEX_FRAME_MAGIC || read32(frame + 4) != index_size - 8) {
+		return false;
+	}
+
+	_blocks = new Block[num_blocks + 1];
+
+	if (!_blocks) {
+		return false;
+	}
+
+	const uint8_t *entry = frame + 8;
+	uint64_t offset = blocks_start;
+	uint64_t decompressed_offset = 0;
+
+	for (unsigned i = 0; i < num_blocks; ++i, entry += 8) {
+		const uint32_t compressed_size = read32(entry);
+		const uint32_t decompressed_size = read32(entry + 4);
+
+		/* the index needs to match the block headers */
+		if (offset + 4 > _size || compressed_size != 4 + (read32(_data + offset) & ~BLOCK_UNCOMPRESSED)
+		    + (_block_checksum ? 4 : 0)) {
+			delete[] _blocks;
+			_blocks = nullptr;
+			return false;
+		}
+
+		_blocks[i].offset = offset;
+		_blocks[i].decompressed_offset = decompressed_offset;
+		offset += compressed_size;
+		decompressed_offset += decompressed_size;
+
+		if (decompressed_size > _max_block_size) {
+			_max_block_size = decompressed_size;
+		}
+	}
+
+	_blocks[num_blocks].offset = offset;
+	_blocks[num_blocks].decompressed_offset = decompressed_offset;
+	_num_blocks = num_blocks;
+	_has_index = true;
+	return true;
+}
+
+bool LZ4FrameReader::scan_blocks(size_t blocks_start)
+{
+	/* first pass counts the blocks, the second one fills in the offsets */
+	for (int pass = 0; pass < 2; ++pass) {
+		size_t offset = blocks_start;
+		uint64_t decompressed_offset = 0;
+		unsigned num_blocks = 0;
+
+		while (offset + 4 <= _size) {
+			const uint32_t block_header = read32(_data + offset);
+			const size_t length = block_header & ~BLOCK_UNCOMPRESSED;
+
+			if (block_header == 0 || length > _size - offset - 4 - (_block_checksum ? 4 : 0)) {
+				break; // end mark, or a truncated block
+			}
+
+			const int decompressed_size = (block_header & BLOCK_UNCOMPRESSED) ? (int)length :
+						      lz4_decompressed_size(_data + offset + 4, length);
+
+			if (decompressed_size < 0) {
+				break;
+			}
+
+			if (_blocks) {
+				_blocks[num_blocks].offset = offset;
+				_blocks[num_blocks].decompressed_offset = decompressed_offset;
+
+				if ((size_t)decompressed_size > _max_block_size) {
+					_max_block_size = decompressed_size;
+				}
+			}
+
+			offset += 4 + length + (_block_checksum ? 4 : 0);
+			decompressed_offset += decompressed_size;
+			++num_blocks;
+		}
+
+		if (_blocks) {
+			_blocks[num_blocks].offset = offset;
+			_blocks[num_blocks].decompressed_offset = decompressed_offset;
+			_num_blocks = num_blocks;
+			return true;
+		}
+
+		_blocks = new Block[num_blocks + 1];
+
+		if (!_blocks) {
+			return false;
+		}
+	}
+
+	return false;
+}
+
+int LZ4FrameReader::find_block(uint64_t offset) const
+{
+	if (offset >= size()) {
+		return -1;
+	}
+
+	/* last block starting at or before offset */
+	unsigned low = 0;
+	unsigned high = _num_blocks - 1;
+
+	while (low < high) {
+		const unsigned mid = (low + high + 1) / 2;
+
+		if (_blocks[mid].decompressed_offset <= offset) {
+			low = mid;
+
+		} else {
+			high = mid - 1;
+		}
+	}
+
+	return low;
+}
+
+int LZ4FrameReader::read_block(unsigned block, uint8_t *buffer, size_t buffer_size) const
+{
+	if (block >= _num_blocks) {
+		return -1;
+	}
+
+	const uint8_t *src = _data + _blocks[block].offset;
+	const uint32_t block_header = read32(src);
+	const size_t length = block_header & ~BLOCK_UNCOMPRESSED;
+
+	if (block_header & BLOCK_UNCOMPRESSED) {
+		if (length > buffer_size) {
+			return -1;
+		}
+
+		memcpy(buffer, src + 4, length);
+		return length;
+	}
+
+	return lz4_decompress(src + 4, length, buffer, buffer_size);
+}
+
+} // namespace log_compression
@@ -0,0 +1,191 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file lz4_frame.h
+ *
+ * Streaming LZ4 frame encoder and random access reader.
+ *
+ * The output is a standard LZ4 frame (https://github.com/lz4/lz4/blob/dev/doc/lz4_Frame_format.md)
+ * with independent blocks, followed by a skippable frame holding a block index:
+ *
+ *   [frame header][block]...[block][end mark][index frame]
+ *
+ * Index frame (all fields uint32, little endian):
+ *   LZ4F_INDEX_FRAME_MAGIC, frame size,
+ *   per block: compressed size (including the 4 byte block header), decompressed size,
+ *   number of blocks, LZ4F_INDEX_FOOTER_MAGIC
+ *
+ * The footer is at the end of the file, so the index can be located from there. The lz4 tools
+ * ignore skippable frames. If the index is missing (e.g. the log was not closed), the reader
+ * scans the block headers instead.
+ */
+
+#pragma once
+
+#include "lz4.h"
+
+namespace log_compression
+{
+
+static constexpr uint32_t LZ4F_MAGIC = 0x184D2204;
+static constexpr uint32_t LZ4F_INDEX_FRAME_MAGIC = 0x184D2A5E; ///< one of the skippable frame magics
+static constexpr uint32_t LZ4F_INDEX_FOOTER_MAGIC = 0x495A4C55; ///< "ULZI"
+
+class LZ4FrameEncoder
+{
+public:
+	LZ4FrameEncoder() = default;
+	~LZ4FrameEncoder();
+
+	/**
+	 * Allocate the buffers.
+	 * @param block_size decompressed size of a block, at most LZ4_MAX_BLOCK_SIZE.
+	 *  Larger blocks compress better, the memory usage is about 2 * block_size + 8 KiB.
+	 */
+	bool init(size_t block_size);
+
+	/**
+	 * Start a new frame.
+	 * @return the frame header to write
+	 */
+	const uint8_t *begin(size_t &size);
+
+	/**
+	 * Append data to the current block.
+	 * @return number of bytes consumed. If it is less than size, the block is full and compress_block()
+	 *         needs to be called before appending the rest.
+	 */
+	size_t append(const void *data, size_t size);
+
+	bool block_full() const { return _fill == _block_size; }
+
+	/** number of bytes appended, but not compressed yet */
+	size_t pending() const { return _fill; }
+
+	/**
+	 * Compress the current (possibly partial) block and add it to the index.
+	 * @return the block to write (valid until the next call), or nullptr if nothing is pending
+	 */
+	const uint8_t *compress_block(size_t &size);
+
+	/**
+	 * End the frame. The pending data must be compressed before.
+	 * @return the end mark and the index frame to write (valid until the next begin())
+	 */
+	const uint8_t *end(size_t &size);
+
+	uint64_t bytes_in() const { return _bytes_in; }
+	uint64_t bytes_out() const { return _bytes_out; }
+
+private:
+	bool index_append(uint32_t compressed_size, uint32_t decompressed_size);
+
+	size_t _block_size{0};
+	uint8_t *_block{nullptr}; ///< decompressed data of the current block
+	size_t _fill{0};
+	uint8_t *_output{nullptr}; ///< block header + compressed data
+	uint16_t *_hash_table{nullptr};
+	uint8_t _header[7] {};
+
+	uint8_t *_index{nullptr}; ///< end mark, index frame header, entries, (footer)
+	size_t _index_size{0}; ///< used bytes
+	size_t _index_capacity{0};
+	bool _index_valid{false}; ///< false if the index could not be allocated
+
+	uint64_t _bytes_in{0};
+	uint64_t _bytes_out{0};
+};
+
+class LZ4FrameReader
+{
+public:
+	LZ4FrameReader() = default;
+	~LZ4FrameReader();
+
+	/**
+	 * Parse a frame in memory (e.g. an mmap'ed file). The data must stay valid while the reader is used.
+	 * Only frames with independent blocks are supported.
+	 * @return false if the data is not a supported LZ4 frame
+	 */
+	bool init(const uint8_t *data, size_t size);
+
+	/** true if the index frame was used (as opposed to scanning the blocks) */
+	bool has_index() const { return _has_index; }
+
+	unsigned num_blocks() const { return _num_blocks; }
+
+	/** total decompressed size */
+	uint64_t size() const { return _num_blocks > 0 ? _blocks[_num_blocks].decompressed_offset : 0; }
+
+	/** largest decompressed block size: the buffer size needed for read_block() */
+	size_t max_block_size() const { return _max_block_size; }
+
+	uint64_t block_offset(unsigned block) const { return _blocks[block].decompressed_offset; }
+
+	size_t block_size(unsigned block) const
+	{
+		return _blocks[block + 1].decompressed_offset - _blocks[block].decompressed_offset;
+	}
+
+	/**
+	 * Find the block containing a decompressed offset
+	 * @return block index, -1 if the offset is beyond the end
+	 */
+	int find_block(uint64_t offset) const;
+
+	/**
+	 * Decompress a block
+	 * @return decompressed size, -1 on error
+	 */
+	int read_block(unsigned block, uint8_t *buffer, size_t buffer_size) const;
+
+private:
+	struct Block {
+		uint64_t offset; ///< file offset of the block header
+		uint64_t decompressed_offset;
+	};
+
+	bool read_index(size_t blocks_start);
+	bool scan_blocks(size_t blocks_start);
+
+	const uint8_t *_data{nullptr};
+	size_t _size{0};
+	bool _block_checksum{false};
+	bool _has_index{false};
+	Block *_blocks{nullptr}; ///< _num_blocks + 1 entries, the last one marks the end
+	unsigned _num_blocks{0};
+	size_t _max_block_size{0};
+};
+
+} // namespace log_compression
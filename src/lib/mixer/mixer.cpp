@@ -52,6 +52,12 @@ Mixer::Mixer(ControlCallback control_cb, uintptr_t cb_handle) :
 {
 }
 
+void
+Mixer::compile(MixerKernel &kernel)
+{
+	kernel.add_mixer(this);
+}
+
 float
 Mixer::get_control(uint8_t group, uint8_t index)
 {
@@ -208,6 +214,12 @@ NullMixer::groups_required(uint32_t &groups)
 
 }
 
+void
+NullMixer::compile(MixerKernel &kernel)
+{
+	kernel.add_null();
+}
+
 NullMixer *
 NullMixer::from_text(const char *buf, unsigned &buflen)
 {
@@ -131,8 +131,11 @@
 #include <px4_config.h>
 #include "drivers/drv_mixer.h"
 
+#include "mixer_binary.h"
 #include "mixer_load.h"
 
+class MixerKernel;
+
 /**
  * Abstract class defining a mixer mixing zero or more inputs to
  * one or more outputs.
@@ -225,7 +228,18 @@ public:
 	 */
 	virtual void set_airmode(bool airmode) {};
 
+	/**
+	 * Add this mixer to a compiled mixer group, see MixerKernel.
+	 *
+	 * The default implementation adds the mixer as it is: the kernel calls mix().
+	 *
+	 * @param kernel		The kernel being compiled.
+	 */
+	virtual void			compile(MixerKernel &kernel);
+
 protected:
+	friend class MixerKernel;
+
 	/** client-supplied callback used when fetching control values */
 	ControlCallback			_control_cb;
 	uintptr_t			_cb_handle;
@@ -294,9 +308,132 @@ private:
 	Mixer &operator=(const Mixer &);
 };
 
+class MultirotorMixer;
+
+/**
+ * Compiled form of a list of mixers.
+ *
+ * Instead of calling every mixer, which fetches each of its inputs through the
+ * control callback, the kernel
+ * - fetches every control used by the mixers once per cycle into a single array,
+ * - flattens consecutive simple and null mixers into contiguous tables of outputs
+ *   and input terms, mixed in one loop,
+ * - lets multirotor mixers mix from the fetched controls.
+ * Other mixers (helicopter) are called through mix() as before.
+ *
+ * Compiling is done in two passes over the mixers: the first one counts the
+ * entries, the second one fills the tables, which are allocated in between.
+ */
+class __EXPORT MixerKernel
+{
+public:
+	MixerKernel() = default;
+	~MixerKernel() { reset(); }
+
+	/**
+	 * Compile a list of mixers.
+	 *
+	 * @param first			First mixer of the list (linked through Mixer::_next).
+	 * @param control_cb		Callback used to fetch the controls.
+	 * @param cb_handle		Handle passed to the control callback.
+	 * @return			false if the tables could not be allocated.
+	 */
+	bool				compile(Mixer *first, Mixer::ControlCallback control_cb, uintptr_t cb_handle);
+
+	/**
+	 * Free the tables. Must be called before any of the compiled mixers is deleted.
+	 */
+	void				reset();
+
+	bool				valid() const { return _steps != nullptr; }
+
+	/**
+	 * Mix all the compiled mixers, same as calling mix() of each of them in order.
+	 *
+	 * @param outputs		Array into which mixed output(s) should be placed.
+	 * @param space			The number of available entries in the output array.
+	 * @return			The number of entries in the output array that were populated.
+	 */
+	unsigned			mix(float *outputs, unsigned space);
+
+	/* used by Mixer::compile() */
+	void				add_simple(const mixer_simple_s *info);
+	void				add_null();
+	void				add_multirotor(MultirotorMixer *mixer);
+	void				add_mixer(Mixer *mixer);
+
+private:
+	enum class StepType : uint8_t {
+		SIMPLE,		/**< run of consecutive simple or null mixer outputs */
+		MULTIROTOR,
+		MIXER		/**< any other mixer, called through mix() */
+	};
+
+	struct Step {
+		StepType	type;
+		uint8_t		controls[4];	/**< multirotor: slots of roll, pitch, yaw and thrust */
+		uint16_t	first_output;	/**< simple: index of the first entry in _outputs */
+		uint16_t	output_count;	/**< simple: number of outputs */
+		Mixer		*mixer;
+	};
+
+	struct Output {
+		const mixer_scaler_s *scaler;	/**< owned by the mixer, so that trim changes apply */
+		uint16_t	first_term;	/**< index of the first entry in _terms */
+		uint16_t	term_count;
+	};
+
+	struct Term {
+		mixer_scaler_s	scaler;
+		uint8_t		control;	/**< slot in _values */
+	};
+
+	struct Control {
+		uint8_t		group;
+		uint8_t		index;
+	};
+
+	/** @return slot of a control in _values, adding it if needed */
+	uint8_t				add_control(uint8_t group, uint8_t index);
+
+	/** @return the new step, nullptr in the counting pass */
+	Step				*add_step(StepType type);
+
+	void				add_output(const mixer_scaler_s *scaler, const mixer_control_s *controls,
+						   unsigned control_count);
+
+	static constexpr unsigned MAX_CONTROLS = 256; ///< the slots are stored in an uint8_t
+
+	Mixer::ControlCallback		_control_cb{nullptr};
+	uintptr_t			_cb_handle{0};
+
+	bool				_counting{false};	/**< first pass: only count the entries */
+	bool				_overflow{false};	/**< more distinct controls than slots */
+	bool				_in_simple_run{false};	/**< the last step is a SIMPLE step */
+
+	Step				*_steps{nullptr};
+	Output				*_outputs{nullptr};
+	Term				*_terms{nullptr};
+	Control				*_controls{nullptr};
+	float				*_values{nullptr};	/**< fetched control values, same order as _controls */
+
+	unsigned			_step_count{0};
+	unsigned			_output_count{0};
+	unsigned			_term_count{0};
+	unsigned			_control_count{0};
+	unsigned			_control_capacity{0};
+
+	/* do not allow to copy due to pointer data members */
+	MixerKernel(const MixerKernel &) = delete;
+	MixerKernel &operator=(const MixerKernel &) = delete;
+};
+
 /**
  * Group of mixers, built up from single mixers and processed
  * in order when mixing.
+ *
+ * The mixers are compiled into a MixerKernel by the first call to mix()
+ * after the group was changed.
  */
 class __EXPORT MixerGroup : public Mixer
 {
@@ -382,6 +519,19 @@ public:
 	 */
 	int				load_from_buf(const char *buf, unsigned &buflen);
 
+	/**
+	 * Adds mixers to the group from a precompiled image, see mixer_binary.h.
+	 *
+	 * The header, checksum and record layout are validated before any
+	 * mixer is added, and the group is left unchanged if the image is
+	 * rejected.
+	 *
+	 * @param buf			Buffer starting with a mixer_binary_header_s.
+	 * @param buflen		Length of the buffer in bytes.
+	 * @return			Zero on successful load, nonzero otherwise.
+	 */
+	int				load_from_binary(const void *buf, unsigned buflen);
+
 	/**
 	 * @brief      Update slew rate parameter. This tells instances of the class MultirotorMixer
 	 *             the maximum allowed change of the output values per cycle.
@@ -424,6 +574,14 @@ public:
 private:
 	Mixer				*_first;	/**< linked list of mixers */
 
+	MixerKernel			_kernel;	/**< compiled form of the mixers */
+	bool				_kernel_dirty{true};	/**< the mixers changed since the kernel was compiled */
+
+	/**
+	 * Drop the compiled kernel, it is compiled again by the next mix().
+	 */
+	void				invalidate_kernel();
+
 	/* do not allow to copy due to pointer data members */
 	MixerGroup(const MixerGroup &);
 	MixerGroup operator=(const MixerGroup &);
@@ -458,6 +616,7 @@ public:
 	virtual unsigned		mix(float *outputs, unsigned space);
 	virtual uint16_t		get_saturation_status(void);
 	virtual void			groups_required(uint32_t &groups);
+	virtual void			compile(MixerKernel &kernel);
 	virtual void 			set_offset(float trim) {}
 	unsigned set_trim(float trim)
 	{
@@ -512,6 +671,22 @@ public:
 			const char *buf,
 			unsigned &buflen);
 
+	/**
+	 * Factory method for a precompiled mixer, see mixer_binary.h.
+	 *
+	 * @param control_cb		The callback to invoke when fetching a
+	 *				control value.
+	 * @param cb_handle		Handle passed to the control callback.
+	 * @param record		The record header of the mixer.
+	 * @param payload		The record payload, a mixer_simple_s.
+	 * @return			A new SimpleMixer instance, or nullptr
+	 *				if the record is invalid.
+	 */
+	static SimpleMixer		*from_binary(Mixer::ControlCallback control_cb,
+			uintptr_t cb_handle,
+			const mixer_binary_record_s &record,
+			const void *payload);
+
 	/**
 	 * Factory method for PWM/PPM input to internal float representation.
 	 *
@@ -531,6 +706,7 @@ public:
 	virtual unsigned		mix(float *outputs, unsigned space);
 	virtual uint16_t		get_saturation_status(void);
 	virtual void			groups_required(uint32_t &groups);
+	virtual void			compile(MixerKernel &kernel);
 
 	/**
 	 * Check that the mixer configuration as loaded is sensible.
@@ -635,9 +811,37 @@ public:
 	static MultirotorMixer		*from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handle, const char *buf,
 			unsigned &buflen);
 
+	/**
+	 * Factory method for a precompiled mixer, see mixer_binary.h.
+	 *
+	 * @param control_cb		The callback to invoke when fetching a
+	 *				control value.
+	 * @param cb_handle		Handle passed to the control callback.
+	 * @param record		The record header of the mixer.
+	 * @param payload		The record payload, a mixer_binary_multirotor_s.
+	 * @return			A new MultirotorMixer instance, or nullptr
+	 *				if the record is invalid or the geometry unknown.
+	 */
+	static MultirotorMixer		*from_binary(Mixer::ControlCallback control_cb, uintptr_t cb_handle,
+			const mixer_binary_record_s &record, const void *payload);
+
 	virtual unsigned		mix(float *outputs, unsigned space);
 	virtual uint16_t		get_saturation_status(void);
 	virtual void			groups_required(uint32_t &groups);
+	virtual void			compile(MixerKernel &kernel);
+
+	/**
+	 * Perform the mixing function from control values fetched by the caller.
+	 *
+	 * @param outputs		Array into which mixed output(s) should be placed.
+	 * @param space			The number of available entries in the output array;
+	 * @param roll			Control group 0, index 0.
+	 * @param pitch			Control group 0, index 1.
+	 * @param yaw			Control group 0, index 2.
+	 * @param thrust		Control group 0, index 3.
+	 * @return			The number of entries in the output array that were populated.
+	 */
+	unsigned			mix_controls(float *outputs, unsigned space, float roll, float pitch, float yaw, float thrust);
 
 	/**
 	 * @brief      Update slew rate parameter. This tells the multicopter mixer
@@ -771,6 +975,20 @@ public:
 	static HelicopterMixer		*from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handle, const char *buf,
 			unsigned &buflen);
 
+	/**
+	 * Factory method for a precompiled mixer, see mixer_binary.h.
+	 *
+	 * @param control_cb		The callback to invoke when fetching a
+	 *				control value.
+	 * @param cb_handle		Handle passed to the control callback.
+	 * @param record		The record header of the mixer.
+	 * @param payload		The record payload, a mixer_heli_s.
+	 * @return			A new HelicopterMixer instance, or nullptr
+	 *				if the record is invalid.
+	 */
+	static HelicopterMixer		*from_binary(Mixer::ControlCallback control_cb, uintptr_t cb_handle,
+			const mixer_binary_record_s &record, const void *payload);
+
 	virtual unsigned		mix(float *outputs, unsigned space);
 	virtual void			groups_required(uint32_t &groups);
 
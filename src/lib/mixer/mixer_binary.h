@@ -0,0 +1,106 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file mixer_binary.h
+ *
+ * Precompiled (binary) mixer format.
+ *
+ * The ROMFS mixer files are compiled at build time by Tools/px_generate_binary_mixers.py
+ * into a single mixer set (MIXER_BINARY_SET_NAME) stored next to them. The set is
+ *
+ *   mixer_binary_index_s
+ *   mixer_binary_entry_s[file_count]	one per compiled mixer file
+ *   images				one per compiled mixer file
+ *
+ * An image holds the mixers of one file: a mixer_binary_header_s followed by
+ * one record per mixer. A record is a mixer_binary_record_s followed by the
+ * configuration of the mixer in its in-memory layout, so that loading a mixer
+ * is a copy instead of parsing text:
+ *
+ *   'Z'	null mixer, no payload
+ *   'M'	simple mixer, mixer_simple_s with control_count controls
+ *   'R'	multirotor mixer, mixer_binary_multirotor_s
+ *   'H'	helicopter mixer, mixer_heli_s
+ *
+ * All values are little-endian. The payload sizes are checked against the
+ * structures of the target when loading.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define MIXER_BINARY_MAGIC		0x424d5850	/**< "PXMB", image header */
+#define MIXER_BINARY_INDEX_MAGIC	0x494d5850	/**< "PXMI", mixer set index */
+#define MIXER_BINARY_VERSION		1
+#define MIXER_BINARY_NAME_LEN		32
+#define MIXER_BINARY_SET_NAME		"mixers.bin"
+
+/** mixer set index */
+struct mixer_binary_index_s {
+	uint32_t	magic;		/**< MIXER_BINARY_INDEX_MAGIC */
+	uint16_t	version;	/**< MIXER_BINARY_VERSION */
+	uint16_t	file_count;	/**< number of entries following the index */
+};
+
+/** mixer set entry */
+struct mixer_binary_entry_s {
+	char		name[MIXER_BINARY_NAME_LEN];	/**< name of the mixer file, nul-terminated */
+	uint32_t	offset;		/**< offset of the image from the start of the set */
+	uint32_t	size;		/**< size of the image, including its header */
+};
+
+/** image header */
+struct mixer_binary_header_s {
+	uint32_t	magic;		/**< MIXER_BINARY_MAGIC */
+	uint16_t	version;	/**< MIXER_BINARY_VERSION */
+	uint16_t	size;		/**< size of the records following the header */
+	uint32_t	crc;		/**< crc32part() of the records, starting from 0 */
+};
+
+/** mixer record header */
+struct mixer_binary_record_s {
+	uint8_t		type;		/**< mixer tag: 'Z', 'M', 'R' or 'H' */
+	uint8_t		control_count;	/**< number of controls (simple mixer) or servos (helicopter mixer) */
+	uint16_t	size;		/**< size of the payload following the record header */
+};
+
+/** multirotor mixer payload */
+struct mixer_binary_multirotor_s {
+	char		geometry[8];	/**< geometry key, nul-terminated (e.g. "4x") */
+	float		roll_scale;
+	float		pitch_scale;
+	float		yaw_scale;
+	float		idle_speed;
+};
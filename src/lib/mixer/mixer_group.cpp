@@ -50,6 +50,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <unistd.h>
+#include <crc32.h>
 
 #include "mixer.h"
 
@@ -82,6 +83,15 @@ MixerGroup::add_mixer(Mixer *mixer)
 
 	*mpp = mixer;
 	mixer->_next = nullptr;
+
+	invalidate_kernel();
+}
+
+void
+MixerGroup::invalidate_kernel()
+{
+	_kernel.reset();
+	_kernel_dirty = true;
 }
 
 void
@@ -90,6 +100,9 @@ MixerGroup::reset()
 	Mixer *mixer;
 	Mixer *next = _first;
 
+	/* the kernel references the mixers */
+	invalidate_kernel();
+
 	/* flag mixer as invalid */
 	_first = nullptr;
 
@@ -105,6 +118,16 @@ MixerGroup::reset()
 unsigned
 MixerGroup::mix(float *outputs, unsigned space)
 {
+	if (_kernel_dirty) {
+		/* if the compilation fails, the mixers are called one by one */
+		_kernel.compile(_first, _control_cb, _cb_handle);
+		_kernel_dirty = false;
+	}
+
+	if (_kernel.valid()) {
+		return _kernel.mix(outputs, space);
+	}
+
 	Mixer	*mixer = _first;
 	unsigned index = 0;
 
@@ -305,6 +328,103 @@ MixerGroup::load_from_buf(const char *buf, unsigned &buflen)
 	return ret;
 }
 
+int
+MixerGroup::load_from_binary(const void *buf, unsigned buflen)
+{
+	const uint8_t *data = (const uint8_t *)buf;
+	mixer_binary_header_s header;
+	mixer_binary_record_s record;
+
+	if (buflen < sizeof(header)) {
+		return -1;
+	}
+
+	memcpy(&header, data, sizeof(header));
+	data += sizeof(header);
+
+	if (header.magic != MIXER_BINARY_MAGIC || header.version != MIXER_BINARY_VERSION
+	    || header.size > buflen - sizeof(header) || header.size == 0) {
+		debug("binary mixer rejected: magic 0x%08x, version %u, size %u", header.magic, header.version, header.size);
+		return -1;
+	}
+
+	if (crc32part(data, header.size, 0) != header.crc) {
+		debug("binary mixer checksum mismatch");
+		return -1;
+	}
+
+	/* check that the records exactly fill the image before creating anything */
+	for (unsigned offset = 0; offset < header.size; offset += sizeof(record) + record.size) {
+		if (header.size - offset < sizeof(record)) {
+			return -1;
+		}
+
+		memcpy(&record, data + offset, sizeof(record));
+
+		if (record.size > header.size - offset - sizeof(record)) {
+			return -1;
+		}
+	}
+
+	/* create the mixers into a separate list, which is only added if all of them are valid */
+	Mixer *first = nullptr;
+	Mixer **last = &first;
+
+	for (unsigned offset = 0; offset < header.size; offset += sizeof(record) + record.size) {
+		Mixer *m = nullptr;
+		memcpy(&record, data + offset, sizeof(record));
+		const uint8_t *payload = data + offset + sizeof(record);
+
+		switch (record.type) {
+		case 'Z':
+			if (record.size == 0) {
+				m = new NullMixer;
+			}
+
+			break;
+
+		case 'M':
+			m = SimpleMixer::from_binary(_control_cb, _cb_handle, record, payload);
+			break;
+
+		case 'R':
+			m = MultirotorMixer::from_binary(_control_cb, _cb_handle, record, payload);
+			break;
+
+		case 'H':
+			m = HelicopterMixer::from_binary(_control_cb, _cb_handle, record, payload);
+			break;
+
+		default:
+			break;
+		}
+
+		if (m == nullptr) {
+			debug("binary mixer record '%c' at %u rejected", record.type, offset);
+
+			while (first != nullptr) {
+				m = first;
+				first = first->_next;
+				delete m;
+			}
+
+			return -1;
+		}
+
+		m->_next = nullptr;
+		*last = m;
+		last = &m->_next;
+	}
+
+	while (first != nullptr) {
+		Mixer *m = first;
+		first = first->_next;
+		add_mixer(m);
+	}
+
+	return 0;
+}
+
 void MixerGroup::set_max_delta_out_once(float delta_out_max)
 {
 	Mixer	*mixer = _first;
@@ -208,6 +208,26 @@ HelicopterMixer::from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handl
 	return hm;
 }
 
+HelicopterMixer *
+HelicopterMixer::from_binary(Mixer::ControlCallback control_cb, uintptr_t cb_handle,
+			     const mixer_binary_record_s &record, const void *payload)
+{
+	mixer_heli_s mixer_info;
+
+	if (record.control_count < 3 || record.control_count > 4 || record.size != sizeof(mixer_info)) {
+		debug("helicopter record rejected: %u servos, %u bytes", record.control_count, record.size);
+		return nullptr;
+	}
+
+	memcpy(&mixer_info, payload, sizeof(mixer_info));
+
+	if (mixer_info.control_count != record.control_count) {
+		return nullptr;
+	}
+
+	return new HelicopterMixer(control_cb, cb_handle, &mixer_info);
+}
+
 unsigned
 HelicopterMixer::mix(float *outputs, unsigned space)
 {
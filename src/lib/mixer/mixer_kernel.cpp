@@ -0,0 +1,285 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file mixer_kernel.cpp
+ *
+ * Compiled form of a mixer group.
+ */
+
+#include "mixer.h"
+
+#include <stdint.h>
+
+void
+MixerKernel::reset()
+{
+	delete[] _steps;
+	delete[] _outputs;
+	delete[] _terms;
+	delete[] _controls;
+	delete[] _values;
+
+	_steps = nullptr;
+	_outputs = nullptr;
+	_terms = nullptr;
+	_controls = nullptr;
+	_values = nullptr;
+
+	_step_count = 0;
+	_output_count = 0;
+	_term_count = 0;
+	_control_count = 0;
+	_control_capacity = 0;
+}
+
+bool
+MixerKernel::compile(Mixer *first, Mixer::ControlCallback control_cb, uintptr_t cb_handle)
+{
+	reset();
+
+	_control_cb = control_cb;
+	_cb_handle = cb_handle;
+
+	/* first pass: count the entries (the controls are counted once per use) */
+	_counting = true;
+	_in_simple_run = false;
+
+	for (Mixer *mixer = first; mixer != nullptr; mixer = mixer->_next) {
+		mixer->compile(*this);
+	}
+
+	_counting = false;
+
+	if (_output_count > UINT16_MAX || _term_count > UINT16_MAX) {
+		reset();
+		return false;
+	}
+
+	_control_capacity = _control_count < MAX_CONTROLS ? _control_count : MAX_CONTROLS;
+
+	_steps = new Step[_step_count];
+	_outputs = new Output[_output_count];
+	_terms = new Term[_term_count];
+	_controls = new Control[_control_capacity];
+	_values = new float[_control_capacity];
+
+	if (_steps == nullptr || _outputs == nullptr || _terms == nullptr || _controls == nullptr || _values == nullptr) {
+		reset();
+		return false;
+	}
+
+	/* second pass: fill the tables */
+	_step_count = 0;
+	_output_count = 0;
+	_term_count = 0;
+	_control_count = 0;
+	_overflow = false;
+	_in_simple_run = false;
+
+	for (Mixer *mixer = first; mixer != nullptr; mixer = mixer->_next) {
+		mixer->compile(*this);
+	}
+
+	if (_overflow) {
+		reset();
+		return false;
+	}
+
+	return true;
+}
+
+uint8_t
+MixerKernel::add_control(uint8_t group, uint8_t index)
+{
+	if (_counting) {
+		_control_count++;
+		return 0;
+	}
+
+	for (unsigned i = 0; i < _control_count; i++) {
+		if (_controls[i].group == group && _controls[i].index == index) {
+			return i;
+		}
+	}
+
+	if (_control_count >= _control_capacity) {
+		_overflow = true;
+		return 0;
+	}
+
+	_controls[_control_count].group = group;
+	_controls[_control_count].index = index;
+	_values[_control_count] = 0.0f;
+
+	return _control_count++;
+}
+
+MixerKernel::Step *
+MixerKernel::add_step(StepType type)
+{
+	_in_simple_run = (type == StepType::SIMPLE);
+
+	if (_counting) {
+		_step_count++;
+		return nullptr;
+	}
+
+	Step *step = &_steps[_step_count++];
+	step->type = type;
+	step->first_output = _output_count;
+	step->output_count = 0;
+	step->mixer = nullptr;
+
+	return step;
+}
+
+void
+MixerKernel::add_output(const mixer_scaler_s *scaler, const mixer_control_s *controls, unsigned control_count)
+{
+	/* consecutive simple mixers share a step */
+	if (!_in_simple_run) {
+		add_step(StepType::SIMPLE);
+	}
+
+	if (!_counting) {
+		Output &output = _outputs[_output_count];
+		output.scaler = scaler;
+		output.first_term = _term_count;
+		output.term_count = control_count;
+		_steps[_step_count - 1].output_count++;
+	}
+
+	for (unsigned i = 0; i < control_count; i++) {
+		const uint8_t control = add_control(controls[i].control_group, controls[i].control_index);
+
+		if (!_counting) {
+			_terms[_term_count + i].scaler = controls[i].scaler;
+			_terms[_term_count + i].control = control;
+		}
+	}
+
+	_output_count++;
+	_term_count += control_count;
+}
+
+void
+MixerKernel::add_simple(const mixer_simple_s *info)
+{
+	add_output(&info->output_scaler, info->controls, info->control_count);
+}
+
+void
+MixerKernel::add_null()
+{
+	/* scaling 0 to [0, 0] gives the 0 output of the null mixer */
+	static const mixer_scaler_s zero = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+	add_output(&zero, nullptr, 0);
+}
+
+void
+MixerKernel::add_multirotor(MultirotorMixer *mixer)
+{
+	Step *step = add_step(StepType::MULTIROTOR);
+
+	for (uint8_t i = 0; i < 4; i++) {
+		const uint8_t control = add_control(0, i);
+
+		if (step != nullptr) {
+			step->controls[i] = control;
+		}
+	}
+
+	if (step != nullptr) {
+		step->mixer = mixer;
+	}
+}
+
+void
+MixerKernel::add_mixer(Mixer *mixer)
+{
+	Step *step = add_step(StepType::MIXER);
+
+	if (step != nullptr) {
+		step->mixer = mixer;
+	}
+}
+
+unsigned
+MixerKernel::mix(float *outputs, unsigned space)
+{
+	/* fetch every control once */
+	for (unsigned i = 0; i < _control_count; i++) {
+		_values[i] = 0.0f;
+		_control_cb(_cb_handle, _controls[i].group, _controls[i].index, _values[i]);
+	}
+
+	unsigned index = 0;
+
+	for (unsigned s = 0; (s < _step_count) && (index < space); s++) {
+		const Step &step = _steps[s];
+
+		switch (step.type) {
+		case StepType::SIMPLE: {
+				const Output *output = &_outputs[step.first_output];
+				const unsigned count = (step.output_count < space - index) ? step.output_count : space - index;
+
+				for (unsigned o = 0; o < count; o++) {
+					const Term *term = &_terms[output[o].first_term];
+					float sum = 0.0f;
+
+					for (unsigned t = 0; t < output[o].term_count; t++) {
+						sum += Mixer::scale(term[t].scaler, _values[term[t].control]);
+					}
+
+					outputs[index + o] = Mixer::scale(*output[o].scaler, sum);
+				}
+
+				index += count;
+				break;
+			}
+
+		case StepType::MULTIROTOR:
+			index += static_cast<MultirotorMixer *>(step.mixer)->mix_controls(outputs + index, space - index,
+					_values[step.controls[0]], _values[step.controls[1]],
+					_values[step.controls[2]], _values[step.controls[3]]);
+			break;
+
+		case StepType::MIXER:
+			index += step.mixer->mix(outputs + index, space - index);
+			break;
+		}
+	}
+
+	return index;
+}
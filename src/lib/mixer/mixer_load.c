@@ -43,6 +43,7 @@
 #include <ctype.h>
 #include <systemlib/err.h>
 
+#include "mixer_binary.h"
 #include "mixer_load.h"
 
 int load_mixer_file(const char *fname, char *buf, unsigned maxlen)
@@ -112,3 +113,62 @@ int load_mixer_file(const char *fname, char *buf, unsigned maxlen)
 	fclose(fp);
 	return 0;
 }
+
+int load_mixer_binary(const char *fname, void *buf, unsigned maxlen)
+{
+	char		path[120];
+	const char	*name = strrchr(fname, '/');
+	unsigned	dirlen = (name != NULL) ? name - fname + 1 : 0;
+
+	name = (name != NULL) ? name + 1 : fname;
+
+	if (dirlen + sizeof(MIXER_BINARY_SET_NAME) > sizeof(path) || strlen(name) >= MIXER_BINARY_NAME_LEN) {
+		return -1;
+	}
+
+	/* the mixer set is in the directory of the mixer file */
+	memcpy(path, fname, dirlen);
+	strcpy(path + dirlen, MIXER_BINARY_SET_NAME);
+
+	FILE *fp = fopen(path, "r");
+
+	if (fp == NULL) {
+		return -1;
+	}
+
+	struct mixer_binary_index_s index;
+	struct mixer_binary_entry_s entry;
+	int ret = -1;
+
+	if (fread(&index, sizeof(index), 1, fp) != 1 || index.magic != MIXER_BINARY_INDEX_MAGIC
+	    || index.version != MIXER_BINARY_VERSION) {
+		goto out;
+	}
+
+	for (unsigned i = 0; i < index.file_count; i++) {
+		if (fread(&entry, sizeof(entry), 1, fp) != 1) {
+			break;
+		}
+
+		if (strncmp(entry.name, name, MIXER_BINARY_NAME_LEN) != 0) {
+			continue;
+		}
+
+		/* the image is validated by the loader, only its size is checked here: the index
+		 * and the image header have to agree on it */
+		if (entry.size >= sizeof(struct mixer_binary_header_s) && entry.size <= maxlen
+		    && fseek(fp, entry.offset, SEEK_SET) == 0 && fread(buf, entry.size, 1, fp) == 1) {
+			const struct mixer_binary_header_s *header = (const struct mixer_binary_header_s *)buf;
+
+			if (header->size + sizeof(*header) == entry.size) {
+				ret = entry.size;
+			}
+		}
+
+		break;
+	}
+
+out:
+	fclose(fp);
+	return ret;
+}
@@ -46,6 +46,17 @@ __BEGIN_DECLS
 
 __EXPORT int load_mixer_file(const char *fname, char *buf, unsigned maxlen);
 
+/**
+ * Read the precompiled image of a mixer file from the mixer set in the same
+ * directory (see mixer_binary.h).
+ *
+ * @param fname		Path of the mixer text file, e.g. /etc/mixers/quad_x.main.mix
+ * @param buf		Buffer for the image
+ * @param maxlen	Size of the buffer
+ * @return		Size of the image, or -1 if there is no set or the file is not in it
+ */
+__EXPORT int load_mixer_binary(const char *fname, void *buf, unsigned maxlen);
+
 __END_DECLS
 
 #endif
@@ -90,6 +90,19 @@ MultirotorMixer::~MultirotorMixer()
 	}
 }
 
+static MultirotorGeometry
+geometry_from_key(const char *key)
+{
+	for (MultirotorGeometryUnderlyingType i = 0; i < (MultirotorGeometryUnderlyingType)MultirotorGeometry::MAX_GEOMETRY;
+	     i++) {
+		if (!strcmp(key, _config_key[i])) {
+			return (MultirotorGeometry)i;
+		}
+	}
+
+	return MultirotorGeometry::MAX_GEOMETRY;
+}
+
 MultirotorMixer *
 MultirotorMixer::from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handle, const char *buf, unsigned &buflen)
 {
@@ -122,13 +135,7 @@ MultirotorMixer::from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handl
 
 	debug("remaining in buf: %d, first char: %c", buflen, buf[0]);
 
-	for (MultirotorGeometryUnderlyingType i = 0; i < (MultirotorGeometryUnderlyingType)MultirotorGeometry::MAX_GEOMETRY;
-	     i++) {
-		if (!strcmp(geomname, _config_key[i])) {
-			geometry = (MultirotorGeometry)i;
-			break;
-		}
-	}
+	geometry = geometry_from_key(geomname);
 
 	if (geometry == MultirotorGeometry::MAX_GEOMETRY) {
 		debug("unrecognised geometry '%s'", geomname);
@@ -147,8 +154,51 @@ MultirotorMixer::from_text(Mixer::ControlCallback control_cb, uintptr_t cb_handl
 		       s[3] / 10000.0f);
 }
 
+MultirotorMixer *
+MultirotorMixer::from_binary(Mixer::ControlCallback control_cb, uintptr_t cb_handle,
+			     const mixer_binary_record_s &record, const void *payload)
+{
+	mixer_binary_multirotor_s config;
+
+	if (record.size != sizeof(config)) {
+		debug("multirotor record rejected: %u bytes", record.size);
+		return nullptr;
+	}
+
+	memcpy(&config, payload, sizeof(config));
+	config.geometry[sizeof(config.geometry) - 1] = '\0';
+
+	MultirotorGeometry geometry = geometry_from_key(config.geometry);
+
+	if (geometry == MultirotorGeometry::MAX_GEOMETRY) {
+		debug("unrecognised geometry '%s'", config.geometry);
+		return nullptr;
+	}
+
+	return new MultirotorMixer(
+		       control_cb,
+		       cb_handle,
+		       geometry,
+		       config.roll_scale,
+		       config.pitch_scale,
+		       config.yaw_scale,
+		       config.idle_speed);
+}
+
 unsigned
 MultirotorMixer::mix(float *outputs, unsigned space)
+{
+	float roll = get_control(0, 0);
+	float pitch = get_control(0, 1);
+	float yaw = get_control(0, 2);
+	float thrust = get_control(0, 3);
+
+	return mix_controls(outputs, space, roll, pitch, yaw, thrust);
+}
+
+unsigned
+MultirotorMixer::mix_controls(float *outputs, unsigned space, float roll_control, float pitch_control,
+			      float yaw_control, float thrust_control)
 {
 	/* Summary of mixing strategy:
 	1) mix roll, pitch and thrust without yaw.
@@ -161,10 +211,10 @@ MultirotorMixer::mix(float *outputs, unsigned space)
 	4) scale all outputs to range [idle_speed,1]
 	*/
 
-	float		roll    = math::constrain(get_control(0, 0) * _roll_scale, -1.0f, 1.0f);
-	float		pitch   = math::constrain(get_control(0, 1) * _pitch_scale, -1.0f, 1.0f);
-	float		yaw     = math::constrain(get_control(0, 2) * _yaw_scale, -1.0f, 1.0f);
-	float		thrust  = math::constrain(get_control(0, 3), 0.0f, 1.0f);
+	float		roll    = math::constrain(roll_control * _roll_scale, -1.0f, 1.0f);
+	float		pitch   = math::constrain(pitch_control * _pitch_scale, -1.0f, 1.0f);
+	float		yaw     = math::constrain(yaw_control * _yaw_scale, -1.0f, 1.0f);
+	float		thrust  = math::constrain(thrust_control, 0.0f, 1.0f);
 	float		min_out = 1.0f;
 	float		max_out = 0.0f;
 
@@ -444,6 +494,12 @@ MultirotorMixer::groups_required(uint32_t &groups)
 	groups |= (1 << 0);
 }
 
+void
+MultirotorMixer::compile(MixerKernel &kernel)
+{
+	kernel.add_multirotor(this);
+}
+
 uint16_t MultirotorMixer::get_saturation_status()
 {
 	return _saturation_status.value;
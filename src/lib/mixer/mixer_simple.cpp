@@ -239,6 +239,40 @@ out:
 	return sm;
 }
 
+SimpleMixer *
+SimpleMixer::from_binary(Mixer::ControlCallback control_cb, uintptr_t cb_handle, const mixer_binary_record_s &record,
+			 const void *payload)
+{
+	/* at least 1 input is required */
+	if (record.control_count == 0 || record.size != MIXER_SIMPLE_SIZE(record.control_count)) {
+		debug("simple record rejected: %u inputs, %u bytes", record.control_count, record.size);
+		return nullptr;
+	}
+
+	mixer_simple_s *mixinfo = (mixer_simple_s *)malloc(record.size);
+
+	if (mixinfo == nullptr) {
+		debug("could not allocate memory for mixer info");
+		return nullptr;
+	}
+
+	memcpy(mixinfo, payload, record.size);
+
+	if (mixinfo->control_count != record.control_count) {
+		free(mixinfo);
+		return nullptr;
+	}
+
+	SimpleMixer *sm = new SimpleMixer(control_cb, cb_handle, mixinfo);
+
+	if (sm == nullptr) {
+		debug("could not allocate memory for mixer");
+		free(mixinfo);
+	}
+
+	return sm;
+}
+
 SimpleMixer *
 SimpleMixer::pwm_input(Mixer::ControlCallback control_cb, uintptr_t cb_handle, unsigned input, uint16_t min,
 		       uint16_t mid, uint16_t max)
@@ -343,6 +377,17 @@ SimpleMixer::groups_required(uint32_t &groups)
 	}
 }
 
+void
+SimpleMixer::compile(MixerKernel &kernel)
+{
+	if (_pinfo == nullptr) {
+		kernel.add_mixer(this);
+		return;
+	}
+
+	kernel.add_simple(_pinfo);
+}
+
 int
 SimpleMixer::check()
 {
@@ -51,7 +51,6 @@
 
 #include <parameters/param.h>
 
-#include "systemlib/uthash/utarray.h"
 #include <parameters/tinybson/tinybson.h>
 #include "flashparams.h"
 #include "flashfs.h"
@@ -63,19 +62,16 @@
 #endif
 
 
-/**
- * Storage for modified parameters.
- */
-struct param_wbuf_s {
-	union param_value_u     val;
-	param_t                 param;
-	bool                    unsaved;
-};
+/* access to the bitsets of param.c */
+static inline bool
+param_bit_test(const uint8_t *bits, param_t param)
+{
+	return bits[param / 8] & (1 << param % 8);
+}
 
 static int
 param_export_internal(bool only_unsaved)
 {
-	struct param_wbuf_s *s = NULL;
 	struct bson_encoder_s encoder;
 	int     result = -1;
 
@@ -89,40 +85,46 @@ param_export_internal(bool only_unsaved)
 		goto out;
 	}
 
-	while ((s = (struct param_wbuf_s *)utarray_next(param_values, s)) != NULL) {
+	for (param_t param = 0; param < param_count(); param++) {
 
 		int32_t i;
 		float   f;
 
+		if (!param_bit_test(param_values_changed, param)) {
+			continue;
+		}
+
 		/*
 		 * If we are only saving values changed since last save, and this
 		 * one hasn't, then skip it
 		 */
-		if (only_unsaved && !s->unsaved) {
+		if (only_unsaved && !param_bit_test(param_values_unsaved, param)) {
 			continue;
 		}
 
-		s->unsaved = false;
+		param_values_unsaved[param / 8] &= ~(1 << param % 8);
+
+		union param_value_u *s = &param_values[param];
 
 		/* append the appropriate BSON type object */
 
-		switch (param_type(s->param)) {
+		switch (param_type(param)) {
 
 		case PARAM_TYPE_INT32:
-			i = s->val.i;
+			i = s->i;
 
-			if (bson_encoder_append_int(&encoder, param_name(s->param), i)) {
-				debug("BSON append failed for '%s'", param_name(s->param));
+			if (bson_encoder_append_int(&encoder, param_name(param), i)) {
+				debug("BSON append failed for '%s'", param_name(param));
 				goto out;
 			}
 
 			break;
 
 		case PARAM_TYPE_FLOAT:
-			f = s->val.f;
+			f = s->f;
 
-			if (bson_encoder_append_double(&encoder, param_name(s->param), f)) {
-				debug("BSON append failed for '%s'", param_name(s->param));
+			if (bson_encoder_append_double(&encoder, param_name(param), f)) {
+				debug("BSON append failed for '%s'", param_name(param));
 				goto out;
 			}
 
@@ -130,11 +132,11 @@ param_export_internal(bool only_unsaved)
 
 		case PARAM_TYPE_STRUCT ... PARAM_TYPE_STRUCT_MAX:
 			if (bson_encoder_append_binary(&encoder,
-						       param_name(s->param),
+						       param_name(param),
 						       BSON_BIN_BINARY,
-						       param_size(s->param),
-						       param_get_value_ptr_external(s->param))) {
-				debug("BSON append failed for '%s'", param_name(s->param));
+						       param_size(param),
+						       param_get_value_ptr_external(param))) {
+				debug("BSON append failed for '%s'", param_name(param));
 				goto out;
 			}
 
@@ -49,18 +49,19 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <sys/types.h>
-#include "systemlib/uthash/utarray.h"
 
 __BEGIN_DECLS
 
 /*
  * When using the flash based parameter store we have to force
- * the param_values and 2 functions to be global
+ * the param_values table, its bitsets and 2 functions to be global
  */
 
 #define FLASH_PARAMS_EXPOSE __EXPORT
 
-__EXPORT extern UT_array        *param_values;
+__EXPORT extern union param_value_u *param_values;
+__EXPORT extern uint8_t *param_values_changed;
+__EXPORT extern uint8_t *param_values_unsaved;
 __EXPORT int param_set_external(param_t param, const void *val, bool mark_saved, bool notify_changes);
 __EXPORT const void *param_get_value_ptr_external(param_t param);
 
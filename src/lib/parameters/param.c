@@ -57,7 +57,6 @@
 #include <px4_shutdown.h>
 
 #include <perf/perf_counter.h>
-#include <systemlib/uthash/utarray.h>
 
 //#define PARAM_NO_ORB ///< if defined, avoid uorb dependency. This disables publication of parameter_update on param change
 //#define PARAM_NO_AUTOSAVE ///< if defined, do not autosave (avoids LP work queue dependency)
@@ -105,16 +104,6 @@ static bool autosave_disabled = false;
 static const struct param_info_s *param_info_base = (const struct param_info_s *) &px4_parameters;
 #define	param_info_count px4_parameters.param_count
 
-/**
- * Storage for modified parameters.
- */
-struct param_wbuf_s {
-	union param_value_u	val;
-	param_t			param;
-	bool			unsaved;
-};
-
-
 uint8_t  *param_changed_storage = NULL;
 int size_param_changed_storage_bytes = 0;
 const int bits_per_allocation_unit  = (sizeof(*param_changed_storage) * 8);
@@ -140,11 +129,35 @@ get_param_info_count(void)
 	return param_info_count;
 }
 
-/** flexible array holding modified parameter values */
-FLASH_PARAMS_EXPOSE UT_array        *param_values;
+/**
+ * Storage for modified parameters, indexed by param_t (allocated on the first param_set()).
+ * An entry is only valid if its bit in param_values_changed is set.
+ */
+FLASH_PARAMS_EXPOSE union param_value_u *param_values = NULL;
+
+/** bitset of the parameters with a modified value in param_values */
+FLASH_PARAMS_EXPOSE uint8_t *param_values_changed = NULL;
+
+/** bitset of the modified parameters not saved yet */
+FLASH_PARAMS_EXPOSE uint8_t *param_values_unsaved = NULL;
 
-/** array info for the modified parameters array */
-FLASH_PARAMS_EXPOSE const UT_icd    param_icd = {sizeof(struct param_wbuf_s), NULL, NULL, NULL};
+static inline bool
+param_bit_test(const uint8_t *bits, param_t param)
+{
+	return bits[param / bits_per_allocation_unit] & (1 << param % bits_per_allocation_unit);
+}
+
+static inline void
+param_bit_set(uint8_t *bits, param_t param)
+{
+	bits[param / bits_per_allocation_unit] |= (1 << param % bits_per_allocation_unit);
+}
+
+static inline void
+param_bit_clear(uint8_t *bits, param_t param)
+{
+	bits[param / bits_per_allocation_unit] &= ~(1 << param % bits_per_allocation_unit);
+}
 
 #if !defined(PARAM_NO_ORB)
 /** parameter update topic handle */
@@ -253,48 +266,69 @@ handle_in_range(param_t param)
 }
 
 /**
- * Compare two modifid parameter structures to determine ordering.
+ * Locate the modified value of a parameter, if it exists.
+ *
+ * @param param			The parameter being searched (must be in range).
+ * @return			The modified value, or
+ *				NULL if the parameter has not been modified.
+ */
+static union param_value_u *
+param_find_changed(param_t param)
+{
+	param_assert_locked();
+
+	if (param_values != NULL && param_bit_test(param_values_changed, param)) {
+		return &param_values[param];
+	}
+
+	return NULL;
+}
+
+/**
+ * Allocate the modified values table and its bitsets (with the writer lock held).
  *
- * This function is suitable for passing to qsort or bsearch.
+ * @return			0 on success
  */
 static int
-param_compare_values(const void *a, const void *b)
+param_values_alloc(void)
 {
-	struct param_wbuf_s *pa = (struct param_wbuf_s *)a;
-	struct param_wbuf_s *pb = (struct param_wbuf_s *)b;
+	if (param_values != NULL) {
+		return 0;
+	}
 
-	if (pa->param < pb->param) {
+	unsigned count = get_param_info_count();
+
+	if (count == 0) {
 		return -1;
 	}
 
-	if (pa->param > pb->param) {
-		return 1;
+	/* single allocation: values first (for alignment), then both bitsets */
+	uint8_t *buf = calloc(1, count * sizeof(union param_value_u) + 2 * size_param_changed_storage_bytes);
+
+	if (buf == NULL) {
+		return -1;
 	}
 
+	param_values_changed = buf + count * sizeof(union param_value_u);
+	param_values_unsaved = param_values_changed + size_param_changed_storage_bytes;
+	param_values = (union param_value_u *)buf;
+
 	return 0;
 }
 
 /**
- * Locate the modified parameter structure for a parameter, if it exists.
- *
- * @param param			The parameter being searched.
- * @return			The structure holding the modified value, or
- *				NULL if the parameter has not been modified.
+ * Drop the modified value of a parameter (with the writer lock held).
  */
-static struct param_wbuf_s *
-param_find_changed(param_t param)
+static void
+param_values_erase(param_t param)
 {
-	struct param_wbuf_s	*s = NULL;
-
-	param_assert_locked();
-
-	if (param_values != NULL) {
-		struct param_wbuf_s key;
-		key.param = param;
-		s = utarray_find(param_values, &key, param_compare_values);
+	if (param_type(param) >= PARAM_TYPE_STRUCT && param_type(param) <= PARAM_TYPE_STRUCT_MAX) {
+		free(param_values[param].p);
 	}
 
-	return s;
+	param_values[param].p = NULL;
+	param_bit_clear(param_values_changed, param);
+	param_bit_clear(param_values_unsaved, param);
 }
 
 static void
@@ -331,34 +365,19 @@ param_find_internal(const char *name, bool notification)
 {
 	perf_begin(param_find_perf);
 
-	param_t middle;
-	param_t front = 0;
-	param_t last = get_param_info_count();
-
-	/* perform a binary search of the known parameters */
-
-	while (front <= last) {
-		middle = front + (last - front) / 2;
-		int ret = strcmp(name, param_info_base[middle].name);
-
-		if (ret == 0) {
-			if (notification) {
-				param_set_used_internal(middle);
-			}
-
-			perf_end(param_find_perf);
-			return middle;
-
-		} else if (middle == front) {
-			/* An end point has been hit, but there has been no match */
-			break;
+	/* look up the name in the generated perfect hash table: a single string compare */
+	uint16_t seed = px4_parameters_hash_seeds[px4_parameters_hash(name, 0) % PX4_PARAMETERS_HASH_BUCKETS];
+	param_t param = px4_parameters_hash_slots[px4_parameters_hash(name, seed) % PX4_PARAMETERS_HASH_SLOTS];
 
-		} else if (ret < 0) {
-			last = middle;
+	if (param != PX4_PARAMETERS_HASH_SLOT_EMPTY && handle_in_range(param)
+	    && strcmp(name, param_info_base[param].name) == 0) {
 
-		} else {
-			front = middle;
+		if (notification) {
+			param_set_used_internal(param);
 		}
+
+		perf_end(param_find_perf);
+		return param;
 	}
 
 	perf_end(param_find_perf);
@@ -498,20 +517,25 @@ param_is_volatile(param_t param)
 bool
 param_value_is_default(param_t param)
 {
-	struct param_wbuf_s *s;
+	if (!handle_in_range(param)) {
+		return true;
+	}
+
 	param_lock_reader();
-	s = param_find_changed(param);
+	union param_value_u *v = param_find_changed(param);
 	param_unlock_reader();
-	return s ? false : true;
+	return v ? false : true;
 }
 
 bool
 param_value_unsaved(param_t param)
 {
-	struct param_wbuf_s *s;
+	if (!handle_in_range(param)) {
+		return false;
+	}
+
 	param_lock_reader();
-	s = param_find_changed(param);
-	bool ret = s && s->unsaved;
+	bool ret = param_find_changed(param) && param_bit_test(param_values_unsaved, param);
 	param_unlock_reader();
 	return ret;
 }
@@ -564,12 +588,9 @@ param_get_value_ptr(param_t param)
 		const union param_value_u *v;
 
 		/* work out whether we're fetching the default or a written value */
-		struct param_wbuf_s *s = param_find_changed(param);
+		v = param_find_changed(param);
 
-		if (s != NULL) {
-			v = &s->val;
-
-		} else {
+		if (v == NULL) {
 			v = &param_info_base[param].val;
 		}
 
@@ -695,68 +716,55 @@ param_set_internal(param_t param, const void *val, bool mark_saved, bool notify_
 	param_lock_writer();
 	perf_begin(param_set_perf);
 
-	if (param_values == NULL) {
-		utarray_new(param_values, &param_icd);
-	}
-
-	if (param_values == NULL) {
+	if (param_values_alloc() != 0) {
 		PX4_ERR("failed to allocate modified values array");
 		goto out;
 	}
 
 	if (handle_in_range(param)) {
 
-		struct param_wbuf_s *s = param_find_changed(param);
+		union param_value_u *s = param_find_changed(param);
 
 		if (s == NULL) {
 
-			/* construct a new parameter */
-			struct param_wbuf_s buf = {
-				.param = param,
-				.val.p = NULL,
-				.unsaved = false
-			};
+			/* start a new modified value */
+			s = &param_values[param];
+			s->p = NULL;
+			param_bit_set(param_values_changed, param);
 			params_changed = true;
-
-			/* add it to the array and sort */
-			utarray_push_back(param_values, &buf);
-			utarray_sort(param_values, param_compare_values);
-
-			/* find it after sorting */
-			s = param_find_changed(param);
 		}
 
 		/* update the changed value */
 		switch (param_type(param)) {
 
 		case PARAM_TYPE_INT32:
-			params_changed = params_changed || s->val.i != *(int32_t *)val;
-			s->val.i = *(int32_t *)val;
+			params_changed = params_changed || s->i != *(int32_t *)val;
+			s->i = *(int32_t *)val;
 			break;
 
 		case PARAM_TYPE_FLOAT:
-			params_changed = params_changed || fabsf(s->val.f - * (float *)val) > FLT_EPSILON;
-			s->val.f = *(float *)val;
+			params_changed = params_changed || fabsf(s->f - * (float *)val) > FLT_EPSILON;
+			s->f = *(float *)val;
 			break;
 
 		case PARAM_TYPE_STRUCT ... PARAM_TYPE_STRUCT_MAX:
-			if (s->val.p == NULL) {
+			if (s->p == NULL) {
 				size_t psize = param_size(param);
 
 				if (psize > 0) {
-					s->val.p = malloc(psize);
+					s->p = malloc(psize);
 
 				} else {
-					s->val.p = NULL;
+					s->p = NULL;
 				}
 
-				if (s->val.p == NULL) {
+				if (s->p == NULL) {
 					PX4_ERR("failed to allocate parameter storage");
 					goto out;
 				}
 			}
 
-			memcpy(s->val.p, val, param_size(param));
+			memcpy(s->p, val, param_size(param));
 			params_changed = true;
 			break;
 
@@ -764,7 +772,13 @@ param_set_internal(param_t param, const void *val, bool mark_saved, bool notify_
 			goto out;
 		}
 
-		s->unsaved = !mark_saved;
+		if (mark_saved) {
+			param_bit_clear(param_values_unsaved, param);
+
+		} else {
+			param_bit_set(param_values_unsaved, param);
+		}
+
 		result = 0;
 
 		if (!mark_saved) { // this is false when importing parameters
@@ -845,7 +859,7 @@ void param_set_used_internal(param_t param)
 int
 param_reset(param_t param)
 {
-	struct param_wbuf_s *s = NULL;
+	union param_value_u *s = NULL;
 	bool param_found = false;
 
 	param_lock_writer();
@@ -857,8 +871,7 @@ param_reset(param_t param)
 
 		/* if we found one, erase it */
 		if (s != NULL) {
-			int pos = utarray_eltidx(param_values, s);
-			utarray_erase(param_values, pos, 1);
+			param_values_erase(param);
 		}
 
 		param_found = true;
@@ -879,13 +892,15 @@ param_reset_all_internal(bool auto_save)
 {
 	param_lock_writer();
 
+	/* mark as reset / deleted (the table is kept allocated) */
 	if (param_values != NULL) {
-		utarray_free(param_values);
+		for (param_t param = 0; handle_in_range(param); param++) {
+			if (param_bit_test(param_values_changed, param)) {
+				param_values_erase(param);
+			}
+		}
 	}
 
-	/* mark as reset / deleted */
-	param_values = NULL;
-
 	if (auto_save) {
 		param_autosave();
 	}
@@ -1034,7 +1049,6 @@ param_export(int fd, bool only_unsaved)
 {
 	perf_begin(param_export_perf);
 
-	struct param_wbuf_s *s = NULL;
 	int	result = -1;
 
 	struct bson_encoder_s encoder;
@@ -1059,27 +1073,33 @@ param_export(int fd, bool only_unsaved)
 		goto out;
 	}
 
-	while ((s = (struct param_wbuf_s *)utarray_next(param_values, s)) != NULL) {
+	for (param_t param = 0; handle_in_range(param); param++) {
+		union param_value_u *s = param_find_changed(param);
+
+		if (s == NULL) {
+			continue;
+		}
+
 		/*
 		 * If we are only saving values changed since last save, and this
 		 * one hasn't, then skip it
 		 */
-		if (only_unsaved && !s->unsaved) {
+		if (only_unsaved && !param_bit_test(param_values_unsaved, param)) {
 			continue;
 		}
 
-		s->unsaved = false;
+		param_bit_clear(param_values_unsaved, param);
 
-		const char *name = param_name(s->param);
-		const size_t size = param_size(s->param);
+		const char *name = param_name(param);
+		const size_t size = param_size(param);
 
 		/* append the appropriate BSON type object */
-		switch (param_type(s->param)) {
+		switch (param_type(param)) {
 
 		case PARAM_TYPE_INT32: {
-				const int32_t i = s->val.i;
+				const int32_t i = s->i;
 
-				debug("exporting: %s (%d) size: %d val: %d", name, s->param, size, i);
+				debug("exporting: %s (%d) size: %d val: %d", name, param, size, i);
 
 				if (bson_encoder_append_int(&encoder, name, i)) {
 					PX4_ERR("BSON append failed for '%s'", name);
@@ -1089,9 +1109,9 @@ param_export(int fd, bool only_unsaved)
 			break;
 
 		case PARAM_TYPE_FLOAT: {
-				const float f = s->val.f;
+				const float f = s->f;
 
-				debug("exporting: %s (%d) size: %d val: %.3f", name, s->param, size, (double)f);
+				debug("exporting: %s (%d) size: %d val: %.3f", name, param, size, (double)f);
 
 				if (bson_encoder_append_double(&encoder, name, f)) {
 					PX4_ERR("BSON append failed for '%s'", name);
@@ -1101,7 +1121,7 @@ param_export(int fd, bool only_unsaved)
 			break;
 
 		case PARAM_TYPE_STRUCT ... PARAM_TYPE_STRUCT_MAX: {
-				const void *value_ptr = param_get_value_ptr(s->param);
+				const void *value_ptr = param_get_value_ptr(param);
 
 				/* lock as short as possible */
 				if (bson_encoder_append_binary(&encoder,
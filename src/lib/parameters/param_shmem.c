@@ -294,17 +294,17 @@ param_notify_changes(void)
 param_t
 param_find_internal(const char *name, bool notification)
 {
-	param_t param;
-
-	/* perform a linear search of the known parameters */
-	for (param = 0; handle_in_range(param); param++) {
-		if (!strcmp(param_info_base[param].name, name)) {
-			if (notification) {
-				param_set_used_internal(param);
-			}
-
-			return param;
+	/* look up the name in the generated perfect hash table: a single string compare */
+	uint16_t seed = px4_parameters_hash_seeds[px4_parameters_hash(name, 0) % PX4_PARAMETERS_HASH_BUCKETS];
+	param_t param = px4_parameters_hash_slots[px4_parameters_hash(name, seed) % PX4_PARAMETERS_HASH_SLOTS];
+
+	if (param != PX4_PARAMETERS_HASH_SLOT_EMPTY && handle_in_range(param)
+	    && !strcmp(param_info_base[param].name, name)) {
+		if (notification) {
+			param_set_used_internal(param);
 		}
+
+		return param;
 	}
 
 	/* not found */
@@ -9,6 +9,59 @@ import argparse
 from jinja2 import Environment, FileSystemLoader
 import os
 
+# marks an unused slot in the hash table (limits the number of params to 0xfffe)
+HASH_SLOT_EMPTY = 0xffff
+
+def param_hash(name, seed):
+    """
+    32 bit FNV-1a hash of the name, mixed with a seed.
+    Must match px4_parameters_hash() in px4_parameters.h.jinja.
+    """
+    h = (2166136261 ^ seed) & 0xffffffff
+    for c in bytearray(name.encode('ascii')):
+        h ^= c
+        h = (h * 16777619) & 0xffffffff
+    return h
+
+def generate_perfect_hash(names):
+    """
+    Build a perfect hash (hash and displace) for the parameter names, so that
+    param_find() needs a single string compare.
+
+    The names are distributed into buckets with seed 0. Then, starting with the
+    largest bucket, a seed is searched for every bucket that maps all of its
+    names to free slots.
+
+    @return (seeds, slots): seed per bucket, parameter index per slot
+    """
+    num_buckets = max(1, (len(names) + 3) // 4)
+    num_slots = max(1, len(names) + len(names) // 4)
+
+    buckets = [[] for _ in range(num_buckets)]
+    for index, name in enumerate(names):
+        buckets[param_hash(name, 0) % num_buckets].append(index)
+
+    seeds = [0] * num_buckets
+    slots = [HASH_SLOT_EMPTY] * num_slots
+
+    for bucket in sorted(range(num_buckets), key=lambda b: -len(buckets[b])):
+        if not buckets[bucket]:
+            break
+        for seed in range(1, 0x10000):
+            bucket_slots = set(param_hash(names[i], seed) % num_slots
+                    for i in buckets[bucket])
+            if len(bucket_slots) == len(buckets[bucket]) and \
+                    all(slots[s] == HASH_SLOT_EMPTY for s in bucket_slots):
+                break
+        else:
+            raise Exception('failed to generate the parameter hash table')
+
+        seeds[bucket] = seed
+        for i in buckets[bucket]:
+            slots[param_hash(names[i], seed) % num_slots] = i
+
+    return seeds, slots
+
 def generate(xml_file, dest='.'):
     """
     Generate px4 param source from xml.
@@ -29,6 +82,12 @@ def generate(xml_file, dest='.'):
 
     params = sorted(params, key=lambda name: name.attrib["name"])
 
+    if len(params) >= HASH_SLOT_EMPTY:
+        raise Exception('too many parameters')
+
+    hash_seeds, hash_slots = generate_perfect_hash(
+        [param.attrib["name"] for param in params])
+
     script_path = os.path.dirname(os.path.realpath(__file__))
 
     # for jinja docs see: http://jinja.pocoo.org/docs/2.9/api/
@@ -47,7 +106,9 @@ def generate(xml_file, dest='.'):
         template = env.get_template(template_file)
         with open(os.path.join(
                 dest, template_file.replace('.jinja','')), 'w') as fid:
-            fid.write(template.render(params=params))
+            fid.write(template.render(params=params,
+                hash_seeds=hash_seeds, hash_slots=hash_slots,
+                hash_slot_empty=HASH_SLOT_EMPTY))
 
 if __name__ == "__main__":
     arg_parser = argparse.ArgumentParser()
@@ -245,6 +245,30 @@ static px4_sem_t *g_item_locks[DM_KEY_NUM_KEYS];
 static px4_sem_t g_sys_state_mutex_mission;
 static px4_sem_t g_sys_state_mutex_fence;
 
+/* RAM cache of the mission items for the file backend. Cached items are returned by dm_read() directly in the
+ * context of the caller, without a round trip through the work queue and the file system. The cache is filled
+ * by the worker thread whenever it reads or writes an item, and grows as needed up to k_cache_max_items items
+ * per type. */
+#if defined(MEMORY_CONSTRAINED_SYSTEM)
+static constexpr unsigned k_cache_max_items = 0;
+#elif defined(__PX4_NUTTX)
+static constexpr unsigned k_cache_max_items = 100;
+#else
+static constexpr unsigned k_cache_max_items = NUM_MISSIONS_SUPPORTED;
+#endif
+
+static constexpr unsigned k_cache_min_items = 16;
+
+typedef struct {
+	uint8_t *data;		/* items stored like in the RAM backend, byte 1 of the header is set for valid items */
+	unsigned capacity;	/* number of allocated items */
+} dm_cache_t;
+
+static dm_cache_t g_cache[DM_KEY_NUM_KEYS];
+static px4_sem_t g_cache_mutex;
+static bool g_cache_enabled = false;
+static unsigned g_cache_hits = 0;
+
 /* The data manager store file handle and file name */
 #if defined(__PX4_POSIX_EAGLE) || defined(__PX4_POSIX_EXCELSIOR)
 static const char *default_device_path = PX4_ROOTFSDIR"/dataman";
@@ -445,6 +469,98 @@ calculate_offset(dm_item_t item, unsigned index)
 	return g_key_offsets[item] + (index * g_per_item_size[item]);
 }
 
+static bool
+cache_item(dm_item_t item)
+{
+	return g_cache_enabled && (item == DM_KEY_WAYPOINTS_OFFBOARD_0 || item == DM_KEY_WAYPOINTS_OFFBOARD_1
+				   || item == DM_KEY_WAYPOINTS_ONBOARD);
+}
+
+/* Read an item from the cache, returns false if it is not cached */
+static bool
+cache_read(dm_item_t item, unsigned index, void *buf, size_t count, ssize_t *result)
+{
+	bool hit = false;
+
+	px4_sem_wait(&g_cache_mutex);
+
+	if (index < g_cache[item].capacity) {
+		const uint8_t *buffer = &g_cache[item].data[index * g_per_item_size[item]];
+
+		/* anything unusual (e.g. a too small buffer) is left to the backend, to return the same error */
+		if (buffer[1] && buffer[0] <= count) {
+			memcpy(buf, buffer + DM_SECTOR_HDR_SIZE, buffer[0]);
+			*result = buffer[0];
+			++g_cache_hits;
+			hit = true;
+		}
+	}
+
+	px4_sem_post(&g_cache_mutex);
+
+	return hit;
+}
+
+/* Store an item that was just read or written by the backend (worker thread only) */
+static void
+cache_store(dm_item_t item, unsigned index, const void *buf, size_t count)
+{
+	const unsigned max_items = g_per_item_max_index[item] < k_cache_max_items ? g_per_item_max_index[item] :
+				   k_cache_max_items;
+
+	if (index >= max_items || count > g_per_item_size[item] - DM_SECTOR_HDR_SIZE) {
+		return;
+	}
+
+	px4_sem_wait(&g_cache_mutex);
+
+	dm_cache_t &cache = g_cache[item];
+
+	if (index >= cache.capacity) {
+		unsigned capacity = cache.capacity > 0 ? cache.capacity : k_cache_min_items;
+
+		while (capacity <= index) {
+			capacity *= 2;
+		}
+
+		if (capacity > max_items) {
+			capacity = max_items;
+		}
+
+		uint8_t *data = (uint8_t *)realloc(cache.data, capacity * g_per_item_size[item]);
+
+		if (data == nullptr) {
+			px4_sem_post(&g_cache_mutex);
+			return;
+		}
+
+		memset(data + cache.capacity * g_per_item_size[item], 0, (capacity - cache.capacity) * g_per_item_size[item]);
+		cache.data = data;
+		cache.capacity = capacity;
+	}
+
+	uint8_t *buffer = &cache.data[index * g_per_item_size[item]];
+	buffer[0] = count;
+	buffer[1] = 1;
+
+	if (count > 0) {
+		memcpy(buffer + DM_SECTOR_HDR_SIZE, buf, count);
+	}
+
+	px4_sem_post(&g_cache_mutex);
+}
+
+/* Drop all cached items of a type (worker thread only) */
+static void
+cache_invalidate(dm_item_t item)
+{
+	px4_sem_wait(&g_cache_mutex);
+	free(g_cache[item].data);
+	g_cache[item].data = nullptr;
+	g_cache[item].capacity = 0;
+	px4_sem_post(&g_cache_mutex);
+}
+
 /* Each data item is stored as follows
  *
  * byte 0: Length of user data item
@@ -1120,6 +1236,12 @@ dm_read(dm_item_t item, unsigned index, void *buf, size_t count)
 		return -1;
 	}
 
+	ssize_t result;
+
+	if (item < DM_KEY_NUM_KEYS && cache_item(item) && cache_read(item, index, buf, count, &result)) {
+		return result;
+	}
+
 	/* get a work item and queue up a read request */
 	if ((work = create_work_item()) == nullptr) {
 		return -1;
@@ -1304,6 +1426,17 @@ task_main(int argc, char *argv[])
 	g_item_locks[DM_KEY_MISSION_STATE] = &g_sys_state_mutex_mission;
 	g_item_locks[DM_KEY_FENCE_POINTS] = &g_sys_state_mutex_fence;
 
+	px4_sem_init(&g_cache_mutex, 1, 1);
+
+	for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++) {
+		g_cache[i].data = nullptr;
+		g_cache[i].capacity = 0;
+	}
+
+	/* the RAM based backends do not need a cache */
+	g_cache_hits = 0;
+	g_cache_enabled = backend == BACKEND_FILE && k_cache_max_items > 0;
+
 	g_task_should_exit = false;
 
 	init_q(&g_work_q);
@@ -1387,22 +1520,50 @@ task_main(int argc, char *argv[])
 					g_dm_ops->write(work->write_params.item, work->write_params.index, work->write_params.persistence,
 							work->write_params.buf,
 							work->write_params.count);
+
+				if (cache_item(work->write_params.item)) {
+					if (work->result == (ssize_t)work->write_params.count) {
+						cache_store(work->write_params.item, work->write_params.index, work->write_params.buf,
+							    work->write_params.count);
+
+					} else {
+						/* the stored item is unknown after a failed write */
+						cache_invalidate(work->write_params.item);
+					}
+				}
+
 				break;
 
 			case dm_read_func:
 				g_func_counts[dm_read_func]++;
 				work->result =
 					g_dm_ops->read(work->read_params.item, work->read_params.index, work->read_params.buf, work->read_params.count);
+
+				if (work->result >= 0 && cache_item(work->read_params.item)) {
+					cache_store(work->read_params.item, work->read_params.index, work->read_params.buf, work->result);
+				}
+
 				break;
 
 			case dm_clear_func:
 				g_func_counts[dm_clear_func]++;
 				work->result = g_dm_ops->clear(work->clear_params.item);
+
+				if (cache_item(work->clear_params.item)) {
+					cache_invalidate(work->clear_params.item);
+				}
+
 				break;
 
 			case dm_restart_func:
 				g_func_counts[dm_restart_func]++;
 				work->result = g_dm_ops->restart(work->restart_params.reason);
+
+				/* the restart erases items depending on their persistence, which is not cached */
+				for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++) {
+					cache_invalidate((dm_item_t)i);
+				}
+
 				break;
 
 			default: /* should never happen */
@@ -1422,6 +1583,12 @@ task_main(int argc, char *argv[])
 
 	g_dm_ops->shutdown();
 
+	for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++) {
+		cache_invalidate((dm_item_t)i);
+	}
+
+	g_cache_enabled = false;
+
 	/* The work queue is now empty, empty the free queue */
 	for (;;) {
 		if ((work = (work_q_item_t *)sq_remfirst(&(g_free_q.q))) == nullptr) {
@@ -1440,6 +1607,7 @@ end:
 	px4_sem_destroy(&g_work_queued_sema);
 	px4_sem_destroy(&g_sys_state_mutex_mission);
 	px4_sem_destroy(&g_sys_state_mutex_fence);
+	px4_sem_destroy(&g_cache_mutex);
 
 	return 0;
 }
@@ -1475,6 +1643,17 @@ status()
 	/* display usage statistics */
 	PX4_INFO("Writes   %d", g_func_counts[dm_write_func]);
 	PX4_INFO("Reads    %d", g_func_counts[dm_read_func]);
+
+	if (g_cache_enabled) {
+		unsigned cache_size = 0;
+
+		for (unsigned i = 0; i < DM_KEY_NUM_KEYS; i++) {
+			cache_size += g_cache[i].capacity * g_per_item_size[i];
+		}
+
+		PX4_INFO("Cache hits %d, size %d bytes", g_cache_hits, cache_size);
+	}
+
 	PX4_INFO("Clears   %d", g_func_counts[dm_clear_func]);
 	PX4_INFO("Restarts %d", g_func_counts[dm_restart_func]);
 	PX4_INFO("Max Q lengths work %d, free %d", g_work_q.max_size, g_free_q.max_size);
@@ -1508,6 +1687,9 @@ Each type has a specific type and a fixed maximum amount of storage items, so th
 Reading and writing a single item is always atomic. If multiple items need to be read/modified atomically, there is
 an additional lock per item type via `dm_lock`.
 
+With the file backend, the mission items are cached in RAM once they are read or written, so that navigator and
+mavlink can read them without waiting for the dataman task and the file system.
+
 **DM_KEY_FENCE_POINTS** and **DM_KEY_SAFE_POINTS** items: the first data element is a `mission_stats_entry_s` struct,
 which stores the number of items for these types. These items are always updated atomically in one transaction (from
 the mavlink mission manager). During that time, navigator will try to acquire the geofence item lock, fail, and will not
@@ -161,14 +161,6 @@ BlockLocalPositionEstimator::BlockLocalPositionEstimator() :
 	       (_fusion.get() & FUSE_BARO) != 0);
 }
 
-Vector<float, BlockLocalPositionEstimator::n_x> BlockLocalPositionEstimator::dynamics(
-	float t,
-	const Vector<float, BlockLocalPositionEstimator::n_x> &x,
-	const Vector<float, BlockLocalPositionEstimator::n_u> &u)
-{
-	return _A * x + _B * u;
-}
-
 void BlockLocalPositionEstimator::update()
 {
 	// wait for a sensor update, check for exit condition every 100 ms
@@ -789,10 +781,10 @@ void BlockLocalPositionEstimator::predict()
 	// https://en.wikipedia.org/wiki/Runge%E2%80%93Kutta_methods
 	float h = getDt();
 	Vector<float, n_x> k1, k2, k3, k4;
-	k1 = dynamics(0, _x, _u);
-	k2 = dynamics(h / 2, _x + k1 * h / 2, _u);
-	k3 = dynamics(h / 2, _x + k2 * h / 2, _u);
-	k4 = dynamics(h, _x + k3 * h, _u);
+	k1 = dynamics(_A, _x, _u);
+	k2 = dynamics(_A, _x + k1 * h / 2, _u);
+	k3 = dynamics(_A, _x + k2 * h / 2, _u);
+	k4 = dynamics(_A, _x + k3 * h, _u);
 	Vector<float, n_x> dx = (k1 + k2 * 2 + k3 * 2 + k4) * (h / 6);
 
 	// don't integrate position if no valid xy data
@@ -835,8 +827,9 @@ void BlockLocalPositionEstimator::predict()
 
 	// propagate
 	_x += dx;
-	Matrix<float, n_x, n_x> dP = (_A * _P + _P * _A.transpose() +
-				      _B * _R * _B.transpose() + _Q) * getDt();
+	// dP = (A * P + P * A' + B * R * B' + Q) * dt, P is symmetric (forced in update())
+	Matrix<float, n_x, n_x> dP;
+	covarianceDerivative(_A, _P, _R, _Q, getDt(), dP);
 
 	// covariance propagation logic
 	for (int i = 0; i < n_x; i++) {
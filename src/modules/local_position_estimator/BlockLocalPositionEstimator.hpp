@@ -151,6 +151,20 @@ public:
 	void update();
 	virtual ~BlockLocalPositionEstimator() = default;
 
+	// prediction, using the fixed sparsity of the state space
+	// (A, B, R and Q as set by initSS), see prediction.cpp
+	static Vector<float, n_x> dynamics(
+		const Matrix<float, n_x, n_x> &A,
+		const Vector<float, n_x> &x,
+		const Vector<float, n_u> &u);
+	static void covarianceDerivative(
+		const Matrix<float, n_x, n_x> &A,
+		const Matrix<float, n_x, n_x> &P,
+		const Matrix<float, n_u, n_u> &R,
+		const Matrix<float, n_x, n_x> &Q,
+		float dt,
+		Matrix<float, n_x, n_x> &dP);
+
 private:
 	BlockLocalPositionEstimator(const BlockLocalPositionEstimator &) = delete;
 	BlockLocalPositionEstimator operator=(const BlockLocalPositionEstimator &) = delete;
@@ -158,10 +172,6 @@ private:
 	// methods
 	// ----------------------------
 	//
-	Vector<float, n_x> dynamics(
-		float t,
-		const Vector<float, n_x> &x,
-		const Vector<float, n_u> &u);
 	void initP();
 	void initSS();
 	void updateSSStates();
@@ -0,0 +1,80 @@
+#include "BlockLocalPositionEstimator.hpp"
+
+// The state space has a fixed structure (see initSS() and updateSSStates()):
+//
+//  A: ones at (x, vx), (y, vy), (z, vz) and the negative rotation from
+//     body to local frame at (vx..vz, bx..bz), all other elements are zero
+//  B: identity for vx..vz, zero otherwise
+//  R, Q: diagonal
+//
+// so only the non-zero elements are computed below. The products are summed
+// in the same order as the dense matrix products, which gives the same results.
+
+Vector<float, BlockLocalPositionEstimator::n_x> BlockLocalPositionEstimator::dynamics(
+	const Matrix<float, BlockLocalPositionEstimator::n_x, BlockLocalPositionEstimator::n_x> &A,
+	const Vector<float, BlockLocalPositionEstimator::n_x> &x,
+	const Vector<float, BlockLocalPositionEstimator::n_u> &u)
+{
+	Vector<float, n_x> dx;
+
+	for (int i = 0; i < 3; i++) {
+		// derivative of position is velocity
+		dx(X_x + i) = x(X_vx + i);
+
+		// derivative of velocity is acceleration - bias (in body frame)
+		dx(X_vx + i) = A(X_vx + i, X_bx) * x(X_bx)
+			       + A(X_vx + i, X_by) * x(X_by)
+			       + A(X_vx + i, X_bz) * x(X_bz)
+			       + u(U_ax + i);
+
+		// bias is constant
+		dx(X_bx + i) = 0;
+	}
+
+	// terrain altitude is constant
+	dx(X_tz) = 0;
+
+	return dx;
+}
+
+void BlockLocalPositionEstimator::covarianceDerivative(
+	const Matrix<float, BlockLocalPositionEstimator::n_x, BlockLocalPositionEstimator::n_x> &A,
+	const Matrix<float, BlockLocalPositionEstimator::n_x, BlockLocalPositionEstimator::n_x> &P,
+	const Matrix<float, BlockLocalPositionEstimator::n_u, BlockLocalPositionEstimator::n_u> &R,
+	const Matrix<float, BlockLocalPositionEstimator::n_x, BlockLocalPositionEstimator::n_x> &Q,
+	float dt,
+	Matrix<float, BlockLocalPositionEstimator::n_x, BlockLocalPositionEstimator::n_x> &dP)
+{
+	// rows x..vz of A * P, the other rows are zero
+	static const int n_ap = X_vz + 1;
+	float AP[n_ap][n_x];
+
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < n_x; j++) {
+			AP[X_x + i][j] = P(X_vx + i, j);
+			AP[X_vx + i][j] = A(X_vx + i, X_bx) * P(X_bx, j)
+					  + A(X_vx + i, X_by) * P(X_by, j)
+					  + A(X_vx + i, X_bz) * P(X_bz, j);
+		}
+	}
+
+	// P is symmetric, so P * A' = (A * P)' and dP is symmetric:
+	// compute the upper triangle and mirror it
+	for (int i = 0; i < n_x; i++) {
+		for (int j = i; j < n_x; j++) {
+			float d = (i < n_ap ? AP[i][j] : 0.0f) + (j < n_ap ? AP[j][i] : 0.0f);
+
+			if (i == j) {
+				// B * R * B'
+				if (i >= X_vx && i <= X_vz) {
+					d += R(U_ax + i - X_vx, U_ax + i - X_vx);
+				}
+
+				d += Q(i, i);
+			}
+
+			dP(i, j) = d * dt;
+			dP(j, i) = dP(i, j);
+		}
+	}
+}
@@ -38,11 +38,12 @@ namespace px4
 namespace logger
 {
 
-LogWriter::LogWriter(Backend configured_backend, size_t file_buffer_size, unsigned int queue_size)
+LogWriter::LogWriter(Backend configured_backend, size_t file_buffer_size, unsigned int queue_size,
+		     bool file_async_io, bool file_compress)
 	: _backend(configured_backend)
 {
 	if (configured_backend & BackendFile) {
-		_log_writer_file_for_write = _log_writer_file = new LogWriterFile(file_buffer_size);
+		_log_writer_file_for_write = _log_writer_file = new LogWriterFile(file_buffer_size, file_async_io, file_compress);
 
 		if (!_log_writer_file) {
 			PX4_ERR("LogWriterFile allocation failed");
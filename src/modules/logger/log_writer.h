@@ -55,7 +55,12 @@ public:
 	static constexpr Backend BackendMavlink = 1 << 1;
 	static constexpr Backend BackendAll = BackendFile | BackendMavlink;
 
-	LogWriter(Backend configured_backend, size_t file_buffer_size, unsigned int queue_size);
+	/**
+	 * @param file_async_io use asynchronous I/O for the file backend (@see LogWriterFile)
+	 * @param file_compress compress the log file (@see LogWriterFile)
+	 */
+	LogWriter(Backend configured_backend, size_t file_buffer_size, unsigned int queue_size, bool file_async_io = false,
+		  bool file_compress = false);
 	~LogWriter();
 
 	bool init();
@@ -83,6 +88,11 @@ public:
 	 */
 	bool is_started(Backend query_backend) const;
 
+	/**
+	 * whether the file backend compresses the log (valid after init())
+	 */
+	bool is_file_compressed() const { return _log_writer_file && _log_writer_file->compressed(); }
+
 	/**
 	 * Write a single ulog message (including header). The caller must call lock() before calling this.
 	 * @param dropout_start timestamp when lastest dropout occured. 0 if no dropout at the moment.
@@ -52,20 +52,34 @@ namespace logger
 constexpr size_t LogWriterFile::_min_write_chunk;
 
 
-LogWriterFile::LogWriterFile(size_t buffer_size) :
+LogWriterFile::LogWriterFile(size_t buffer_size, bool async_io, bool compress) :
 	//We always write larger chunks (orb messages) to the buffer, so the buffer
 	//needs to be larger than the minimum write chunk (300 is somewhat arbitrary)
-	_buffer_size(math::max(buffer_size, _min_write_chunk + 300))
+	_buffer_size(math::max(buffer_size, _min_write_chunk + 300)),
+	_async_io(async_io),
+	_compress(compress)
 {
 	pthread_mutex_init(&_mtx, nullptr);
 	pthread_cond_init(&_cv, nullptr);
 	/* allocate write performance counters */
 	_perf_write = perf_alloc(PC_ELAPSED, "logger_sd_write");
 	_perf_fsync = perf_alloc(PC_ELAPSED, "logger_sd_fsync");
+	_perf_dropouts = perf_alloc(PC_COUNT, "logger_sd_dropouts");
+	_perf_compress = perf_alloc(PC_ELAPSED, "logger_compress");
 }
 
 bool LogWriterFile::init()
 {
+	if (_compress) {
+		_compressor = new log_compression::LZ4FrameEncoder();
+
+		if (!_compressor || !_compressor->init(_compress_block_size)) {
+			PX4_ERR("Can't allocate the log compression buffers, logging uncompressed");
+			delete _compressor;
+			_compressor = nullptr;
+		}
+	}
+
 	return true;
 }
 
@@ -75,11 +89,19 @@ LogWriterFile::~LogWriterFile()
 	pthread_cond_destroy(&_cv);
 	perf_free(_perf_write);
 	perf_free(_perf_fsync);
+	perf_free(_perf_dropouts);
+	perf_free(_perf_compress);
 
 	if (_fd >= 0) {
 		::close(_fd);
 	}
 
+	if (_async_file) {
+		async_file_close(_async_file);
+	}
+
+	delete _compressor;
+
 	if (_buffer) {
 		delete[] _buffer;
 	}
@@ -91,15 +113,32 @@ void LogWriterFile::start_log(const char *filename)
 	// the hardfault handler will append the crash log to that file on the next reboot.
 	// Note that we don't deregister it when closing the log, so that crashes after disarming
 	// are appended as well (the same holds for crashes before arming, which can be a bit misleading)
-	int ret = hardfault_store_filename(filename);
+	// A compressed file cannot be appended to.
+	if (!_compressor) {
+		int ret = hardfault_store_filename(filename);
 
-	if (ret) {
-		PX4_ERR("Failed to register ULog file to the hardfault handler (%i)", ret);
+		if (ret) {
+			PX4_ERR("Failed to register ULog file to the hardfault handler (%i)", ret);
+		}
 	}
 
-	_fd = ::open(filename, O_CREAT | O_WRONLY, PX4_O_MODE_666);
+	if (_async_io) {
+		// in async mode, logger_sd_write measures the latency of each write request
+		_async_file = async_file_open(filename, PX4_O_MODE_666, _async_block_size, _async_num_blocks, _perf_write);
 
-	if (_fd < 0) {
+		if (_async_file) {
+			PX4_INFO("Using asynchronous%s I/O", async_file_is_direct(_async_file) ? " direct" : "");
+
+		} else {
+			PX4_WARN("Asynchronous I/O not available (%i), using blocking writes", errno);
+		}
+	}
+
+	if (!_async_file) {
+		_fd = ::open(filename, O_CREAT | O_WRONLY, PX4_O_MODE_666);
+	}
+
+	if (_fd < 0 && !_async_file) {
 		PX4_ERR("Can't open log file %s, errno: %d", filename, errno);
 		_should_run = false;
 		return;
@@ -110,8 +149,28 @@ void LogWriterFile::start_log(const char *filename)
 
 		if (_buffer == nullptr) {
 			PX4_ERR("Can't create log buffer");
-			::close(_fd);
-			_fd = -1;
+
+			if (_async_file) {
+				async_file_close(_async_file);
+				_async_file = nullptr;
+
+			} else {
+				::close(_fd);
+				_fd = -1;
+			}
+
+			_should_run = false;
+			return;
+		}
+	}
+
+	if (_compressor) {
+		size_t header_size;
+		const uint8_t *header = _compressor->begin(header_size);
+
+		if (write_all(header, header_size) < 0) {
+			PX4_ERR("Can't write to log file %s", filename);
+			close_file();
 			_should_run = false;
 			return;
 		}
@@ -263,23 +322,22 @@ void LogWriterFile::run()
 			written = 0;
 
 			if (available > 0) {
-				perf_begin(_perf_write);
-				written = ::write(_fd, read_ptr, available);
-				perf_end(_perf_write);
+				written = write_file(read_ptr, available);
 
 				const hrt_abstime now = hrt_absolute_time();
+				const bool periodic_sync = now - last_fsync > 1_s;
 
-				/* call fsync periodically to minimize potential loss of data */
-				if (++poll_count >= 100 || now - last_fsync > 1_s) {
-					perf_begin(_perf_fsync);
-					::fsync(_fd);
-					perf_end(_perf_fsync);
+				/* call fsync periodically to minimize potential loss of data. The asynchronous sync does not
+				 * block, so there is no need to limit the amount of unsynced data */
+				if (periodic_sync || (!_async_file && ++poll_count >= 100)) {
+					sync_file(periodic_sync);
 					poll_count = 0;
 					last_fsync = now;
 				}
 
 				if (written < 0) {
-					PX4_WARN("error writing log file");
+					PX4_WARN("error writing log file (%i)", written);
+					close_file();
 					_should_run = false;
 					/* GOTO end of block */
 					break;
@@ -299,13 +357,16 @@ void LogWriterFile::run()
 				_head = 0;
 				_count = 0;
 
-				if (_fd >= 0) {
-					int res = ::close(_fd);
-					_fd = -1;
+				if (_fd >= 0 || _async_file) {
+					int res = close_file();
 
 					if (res) {
 						PX4_WARN("error closing log file");
 
+					} else if (_compressor) {
+						PX4_INFO("closed logfile, bytes written: %zu, compressed: %" PRIu64, _total_written,
+							 _compressor->bytes_out());
+
 					} else {
 						PX4_INFO("closed logfile, bytes written: %zu", _total_written);
 					}
@@ -317,6 +378,125 @@ void LogWriterFile::run()
 	}
 }
 
+int LogWriterFile::write_file(const void *data, size_t size)
+{
+	if (!_compressor) {
+		return write_raw(data, size);
+	}
+
+	const uint8_t *ptr = static_cast<const uint8_t *>(data);
+	size_t remaining = size;
+
+	while (remaining > 0) {
+		const size_t n = _compressor->append(ptr, remaining);
+		ptr += n;
+		remaining -= n;
+
+		if (_compressor->block_full()) {
+			int ret = write_compressed_block();
+
+			if (ret < 0) {
+				return ret;
+			}
+		}
+	}
+
+	return size;
+}
+
+int LogWriterFile::write_compressed_block()
+{
+	size_t size;
+	perf_begin(_perf_compress);
+	const uint8_t *block = _compressor->compress_block(size);
+	perf_end(_perf_compress);
+
+	return block ? write_all(block, size) : 0;
+}
+
+int LogWriterFile::write_all(const void *data, size_t size)
+{
+	const uint8_t *ptr = static_cast<const uint8_t *>(data);
+	size_t remaining = size;
+
+	while (remaining > 0) {
+		int ret = write_raw(ptr, remaining);
+
+		if (ret <= 0) {
+			return ret < 0 ? ret : -EIO;
+		}
+
+		ptr += ret;
+		remaining -= ret;
+	}
+
+	return size;
+}
+
+int LogWriterFile::write_raw(const void *data, size_t size)
+{
+	if (_async_file) {
+		/* this only blocks if all the write requests are in flight */
+		return async_file_write(_async_file, data, size);
+	}
+
+	perf_begin(_perf_write);
+	int ret = ::write(_fd, data, size);
+	perf_end(_perf_write);
+
+	return ret < 0 ? -errno : ret;
+}
+
+void LogWriterFile::sync_file(bool flush_compressor)
+{
+	if (_compressor && flush_compressor) {
+		/* a partial block, so that the data can be recovered if the log is not closed properly */
+		write_compressed_block();
+	}
+
+	if (_async_file) {
+		async_file_sync(_async_file);
+
+	} else {
+		perf_begin(_perf_fsync);
+		::fsync(_fd);
+		perf_end(_perf_fsync);
+	}
+}
+
+int LogWriterFile::close_file()
+{
+	int ret = 0;
+
+	if (_compressor) {
+		/* the remaining data, the end mark and the block index */
+		size_t size;
+		ret = write_compressed_block();
+
+		const uint8_t *trailer = _compressor->end(size);
+
+		if (ret >= 0) {
+			ret = write_all(trailer, size);
+		}
+
+		ret = ret < 0 ? ret : 0;
+	}
+
+	if (_async_file) {
+		/* waits for all the requests in flight */
+		int res = async_file_close(_async_file);
+		_async_file = nullptr;
+		ret = ret ? ret : res;
+
+	} else if (_fd >= 0) {
+		int res = ::close(_fd);
+		_fd = -1;
+		ret = ret ? ret : res;
+	}
+
+	return ret;
+}
+
 int LogWriterFile::write_message(void *ptr, size_t size, uint64_t dropout_start)
 {
 	if (_need_reliable_transfer) {
@@ -332,7 +512,13 @@ int LogWriterFile::write_message(void *ptr, size_t size, uint64_t dropout_start)
 		return ret;
 	}
 
-	return write(ptr, size, dropout_start);
+	int ret = write(ptr, size, dropout_start);
+
+	if (ret == -1) {
+		perf_count(_perf_dropouts);
+	}
+
+	return ret;
 }
 
 int LogWriterFile::write(void *ptr, size_t size, uint64_t dropout_start)
@@ -38,6 +38,8 @@
 #include <pthread.h>
 #include <drivers/drv_hrt.h>
 #include <perf/perf_counter.h>
+#include <lib/async_file/async_file.h>
+#include <lib/log_compression/lz4_frame.h>
 
 namespace px4
 {
@@ -51,7 +53,13 @@ namespace logger
 class LogWriterFile
 {
 public:
-	LogWriterFile(size_t buffer_size);
+	/**
+	 * @param buffer_size
+	 * @param async_io write the file with asynchronous, aligned requests (@see async_file.h) instead of
+	 *                 blocking write() and fsync() calls. Falls back to the latter if not supported.
+	 * @param compress compress the file into an LZ4 frame with a block index (@see lz4_frame.h)
+	 */
+	LogWriterFile(size_t buffer_size, bool async_io = false, bool compress = false);
 	~LogWriterFile();
 
 	bool init();
@@ -115,6 +123,9 @@ public:
 
 	pthread_t thread_id() const { return _thread; }
 
+	/** true if the log file is compressed (only valid after init()) */
+	bool compressed() const { return _compressor != nullptr; }
+
 private:
 	static void *run_helper(void *);
 
@@ -140,6 +151,30 @@ private:
 	 */
 	int write(void *ptr, size_t size, uint64_t dropout_start);
 
+	/**
+	 * Write data from the buffer to the file, compressing it if enabled.
+	 * @return size (or less if not compressed), <0 errno on error
+	 */
+	int write_file(const void *data, size_t size);
+
+	/** compress the pending data and write the block */
+	int write_compressed_block();
+
+	/** write all of data to the file, @return size or <0 errno */
+	int write_all(const void *data, size_t size);
+
+	/** a single write()/async_file_write() call, @return bytes written or <0 errno */
+	int write_raw(const void *data, size_t size);
+
+	/**
+	 * fsync the file.
+	 * @param flush_compressor also write the partial compressed block
+	 */
+	void sync_file(bool flush_compressor);
+
+	/** finish the compressed frame and close the file, @return 0 on success */
+	int close_file();
+
 	/**
 	 * Write to the buffer but assuming there is enough space
 	 */
@@ -148,9 +183,22 @@ private:
 	/* 512 didn't seem to work properly, 4096 should match the FAT cluster size */
 	static constexpr size_t	_min_write_chunk = 4096;
 
+	static constexpr size_t	_async_block_size = 32 * 1024;
+	static constexpr unsigned	_async_num_blocks = 8;
+
+#ifdef __PX4_NUTTX
+	static constexpr size_t	_compress_block_size = 16 * 1024;
+#else
+	static constexpr size_t	_compress_block_size = 64 * 1024;
+#endif
+
 	int			_fd = -1;
+	async_file_t		_async_file = nullptr; ///< used instead of _fd in async mode
+	log_compression::LZ4FrameEncoder *_compressor = nullptr;
 	uint8_t 	*_buffer = nullptr;
 	const size_t	_buffer_size;
+	const bool		_async_io;
+	const bool		_compress;
 	size_t			_head = 0; ///< next position to write to
 	size_t			_count = 0; ///< number of bytes in _buffer to be written
 	size_t		_total_written = 0;
@@ -162,6 +210,8 @@ private:
 	pthread_cond_t		_cv;
 	perf_counter_t _perf_write;
 	perf_counter_t _perf_fsync;
+	perf_counter_t _perf_dropouts;
+	perf_counter_t _perf_compress;
 	pthread_t _thread = 0;
 };
 
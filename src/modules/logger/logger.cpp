@@ -207,6 +207,8 @@ $ logger on
 	PRINT_MODULE_USAGE_PARAM_INT('r', 280, 0, 8000, "Log rate in Hz, 0 means unlimited rate", true);
 	PRINT_MODULE_USAGE_PARAM_INT('b', 12, 4, 10000, "Log buffer size in KiB", true);
 	PRINT_MODULE_USAGE_PARAM_INT('q', 14, 1, 100, "uORB queue size for mavlink mode", true);
+	PRINT_MODULE_USAGE_PARAM_FLAG('a', "Write the log file with asynchronous direct I/O (io_uring, Linux only)", true);
+	PRINT_MODULE_USAGE_PARAM_FLAG('z', "Compress the log file (LZ4 frame with a block index, .ulg.lz4)", true);
 	PRINT_MODULE_USAGE_PARAM_STRING('p', nullptr, "<topic_name>",
 					 "Poll on a topic instead of running with fixed rate (Log rate and topic intervals are ignored if this is set)", true);
 	PRINT_MODULE_USAGE_COMMAND_DESCR("on", "start logging now, override arming (logger must be running)");
@@ -288,12 +290,14 @@ Logger *Logger::instantiate(int argc, char *argv[])
 	// topic sizes get reduced
 	LogWriter::Backend backend = LogWriter::BackendAll;
 	const char *poll_topic = nullptr;
+	bool async_io = false;
+	bool compress = false;
 
 	int myoptind = 1;
 	int ch;
 	const char *myoptarg = nullptr;
 
-	while ((ch = px4_getopt(argc, argv, "r:b:etfm:q:p:", &myoptind, &myoptarg)) != EOF) {
+	while ((ch = px4_getopt(argc, argv, "r:b:etfm:q:p:az", &myoptind, &myoptarg)) != EOF) {
 		switch (ch) {
 		case 'r': {
 				unsigned long r = strtoul(myoptarg, nullptr, 10);
@@ -360,6 +364,14 @@ Logger *Logger::instantiate(int argc, char *argv[])
 
 			break;
 
+		case 'a':
+			async_io = true;
+			break;
+
+		case 'z':
+			compress = true;
+			break;
+
 		case '?':
 			error_flag = true;
 			break;
@@ -376,7 +388,7 @@ Logger *Logger::instantiate(int argc, char *argv[])
 	}
 
 	Logger *logger = new Logger(backend, log_buffer_size, log_interval, poll_topic, log_on_start,
-				    log_until_shutdown, log_name_timestamp, queue_size);
+				    log_until_shutdown, log_name_timestamp, queue_size, async_io, compress);
 
 #if defined(DBGPRINT) && defined(__PX4_NUTTX)
 	struct mallinfo alloc_info = mallinfo();
@@ -405,12 +417,13 @@ Logger *Logger::instantiate(int argc, char *argv[])
 
 
 Logger::Logger(LogWriter::Backend backend, size_t buffer_size, uint32_t log_interval, const char *poll_topic_name,
-	       bool log_on_start, bool log_until_shutdown, bool log_name_timestamp, unsigned int queue_size) :
+	       bool log_on_start, bool log_until_shutdown, bool log_name_timestamp, unsigned int queue_size,
+	       bool async_io, bool compress) :
 	_arm_override(false),
 	_log_on_start(log_on_start),
 	_log_until_shutdown(log_until_shutdown),
 	_log_name_timestamp(log_name_timestamp),
-	_writer(backend, buffer_size, queue_size),
+	_writer(backend, buffer_size, queue_size, async_io, compress),
 	_log_interval(log_interval)
 {
 	_log_utc_offset = param_find("SDLOG_UTC_OFFSET");
@@ -482,6 +495,10 @@ LoggerSubscription* Logger::add_topic(const orb_metadata *topic)
 
 	if (_subscriptions.push_back(LoggerSubscription(fd, topic))) {
 		subscription = &_subscriptions[_subscriptions.size() - 1];
+
+		if (fd >= 0) {
+			set_update_bitmap(*subscription, 0);
+		}
 	} else {
 		PX4_WARN("logger: failed to add topic. Too many subscriptions");
 		if (fd >= 0) {
@@ -526,17 +543,23 @@ bool Logger::add_topic(const char *name, unsigned interval)
 	}
 
 	if (subscription) {
-		if (subscription->fd[0] >= 0) {
-			orb_set_interval(subscription->fd[0], interval);
-		} else {
-			// store the interval: use a value < 0 to know it's not a valid fd
-			subscription->fd[0] = -interval - 1;
-		}
+		// the logger applies the interval itself: a uORB interval would hide publications from
+		// the update bitmap, and the topic would only be logged again on the next publication
+		subscription->interval = interval * 1000;
 	}
 
 	return subscription;
 }
 
+void Logger::set_update_bitmap(LoggerSubscription &sub, int multi_instance)
+{
+	unsigned bit = (&sub - &_subscriptions[0]) * ORB_MULTI_MAX_INSTANCES + multi_instance;
+
+	if (orb_set_update_bitmap(sub.fd[multi_instance], _updated_topics, bit) != PX4_OK) {
+		PX4_ERR("%s: update notification failed", sub.metadata->o_name);
+	}
+}
+
 bool Logger::copy_if_updated_multi(LoggerSubscription &sub, int multi_instance, void *buffer, bool try_to_subscribe)
 {
 	bool updated = false;
@@ -565,31 +588,48 @@ bool Logger::copy_if_updated_multi(LoggerSubscription &sub, int multi_instance,
 	return updated;
 }
 
+bool Logger::write_topic_if_updated(LoggerSubscription &sub, int multi_instance, bool try_to_subscribe)
+{
+	/* each message consists of a header followed by an orb data object
+	 */
+	size_t msg_size = sizeof(ulog_message_data_header_s) + sub.metadata->o_size_no_padding;
+
+	/* if this topic has been updated, copy the new data into the message buffer
+	 * and write a message to the log
+	 */
+	if (!copy_if_updated_multi(sub, multi_instance, _msg_buffer + sizeof(ulog_message_data_header_s),
+				   try_to_subscribe)) {
+		return false;
+	}
+
+	sub.last_write[multi_instance] = (uint32_t)hrt_absolute_time();
+
+	uint16_t write_msg_size = static_cast<uint16_t>(msg_size - ULOG_MSG_HEADER_LEN);
+	//write one byte after another (necessary because of alignment)
+	_msg_buffer[0] = (uint8_t)write_msg_size;
+	_msg_buffer[1] = (uint8_t)(write_msg_size >> 8);
+	_msg_buffer[2] = static_cast<uint8_t>(ULogMessageType::DATA);
+	uint16_t write_msg_id = sub.msg_ids[multi_instance];
+	_msg_buffer[3] = (uint8_t)write_msg_id;
+	_msg_buffer[4] = (uint8_t)(write_msg_id >> 8);
+
+	//PX4_INFO("topic: %s, size = %zu, out_size = %zu", sub.metadata->o_name, sub.metadata->o_size, msg_size);
+
+	// on a write buffer overflow, the record is skipped
+	return write_message(_msg_buffer, msg_size);
+}
+
 bool Logger::try_to_subscribe_topic(LoggerSubscription &sub, int multi_instance)
 {
 	bool ret = false;
 	if (OK == orb_exists(sub.metadata, multi_instance)) {
 
-		unsigned int interval;
-
-		if (multi_instance == 0) {
-			// the first instance and no subscription yet: this means we stored the negative interval as fd
-			interval = (unsigned int) (-(sub.fd[0] + 1));
-		} else {
-			// set to the same interval as the first instance
-			if (orb_get_interval(sub.fd[0], &interval) != 0) {
-				interval = 0;
-			}
-		}
-
 		int &handle = sub.fd[multi_instance];
 		handle = orb_subscribe_multi(sub.metadata, multi_instance);
 
 		if (handle >= 0) {
 			PX4_DEBUG("subscribed to instance %d of topic %s", multi_instance, sub.metadata->o_name);
-			if (interval > 0) {
-				orb_set_interval(handle, interval);
-			}
+			set_update_bitmap(sub, multi_instance);
 			ret = true;
 		} else {
 			PX4_ERR("orb_subscribe_multi %s failed (%i)", sub.metadata->o_name, errno);
@@ -647,6 +687,7 @@ void Logger::add_default_topics()
 	//add_topic("vtol_vehicle_status", 200);
 	//add_topic("wind_estimate", 200);
 	//add_topic("timesync_status");
+	add_topic("uorb_latency");
 	add_topic("mixer", 50);
 	add_topic("ude", 10);
 	//add_topic("innerloop_track", 100);
@@ -1087,46 +1128,56 @@ void Logger::run()
 			/* wait for lock on log buffer */
 			_writer.lock();
 
-			int sub_idx = 0;
+			/* only visit the topic instances which got published since the last iteration */
+			for (unsigned word = 0; word < UPDATED_TOPICS_WORDS; ++word) {
+				uint32_t updated = __atomic_exchange_n(&_updated_topics[word], 0, __ATOMIC_ACQUIRE);
+				uint32_t rate_limited = 0;
 
-			for (LoggerSubscription &sub : _subscriptions) {
-				/* each message consists of a header followed by an orb data object
-				 */
-				size_t msg_size = sizeof(ulog_message_data_header_s) + sub.metadata->o_size_no_padding;
+				while (updated != 0) {
+					const unsigned bit = __builtin_ctz(updated);
+					updated &= updated - 1;
 
-				/* if this topic has been updated, copy the new data into the message buffer
-				 * and write a message to the log
-				 */
-				for (int instance = 0; instance < ORB_MULTI_MAX_INSTANCES; instance++) {
-					if (copy_if_updated_multi(sub, instance, _msg_buffer + sizeof(ulog_message_data_header_s),
-								  sub_idx == next_subscribe_topic_index)) {
-
-						uint16_t write_msg_size = static_cast<uint16_t>(msg_size - ULOG_MSG_HEADER_LEN);
-						//write one byte after another (necessary because of alignment)
-						_msg_buffer[0] = (uint8_t)write_msg_size;
-						_msg_buffer[1] = (uint8_t)(write_msg_size >> 8);
-						_msg_buffer[2] = static_cast<uint8_t>(ULogMessageType::DATA);
-						uint16_t write_msg_id = sub.msg_ids[instance];
-						_msg_buffer[3] = (uint8_t)write_msg_id;
-						_msg_buffer[4] = (uint8_t)(write_msg_id >> 8);
+					LoggerSubscription &sub = _subscriptions[(word * 32 + bit) / ORB_MULTI_MAX_INSTANCES];
+					const int instance = (word * 32 + bit) % ORB_MULTI_MAX_INSTANCES;
 
-						//PX4_INFO("topic: %s, size = %zu, out_size = %zu", sub.metadata->o_name, sub.metadata->o_size, msg_size);
+					if (sub.interval > 0 && (uint32_t)loop_time - sub.last_write[instance] < sub.interval) {
+						/* keep it flagged until the interval passed */
+						rate_limited |= (uint32_t)1 << bit;
+						continue;
+					}
 
-						if (write_message(_msg_buffer, msg_size)) {
+					/* write all the queued messages (a single one if rate limited) */
+					while (write_topic_if_updated(sub, instance, false)) {
+						data_written = true;
 
 #ifdef DBGPRINT
-							total_bytes += msg_size;
+						total_bytes += sizeof(ulog_message_data_header_s) + sub.metadata->o_size_no_padding;
 #endif /* DBGPRINT */
 
-							data_written = true;
-
-						} else {
-							break;	// Write buffer overflow, skip this record
+						if (sub.interval > 0) {
+							break;
 						}
 					}
 				}
 
-				++sub_idx;
+				if (rate_limited != 0) {
+					__atomic_fetch_or(&_updated_topics[word], rate_limited, __ATOMIC_RELAXED);
+				}
+			}
+
+			/* try to subscribe to the missing instances of one topic per iteration */
+			if (next_subscribe_topic_index != -1) {
+				LoggerSubscription &sub = _subscriptions[next_subscribe_topic_index];
+
+				for (int instance = 0; instance < ORB_MULTI_MAX_INSTANCES; instance++) {
+					if (sub.fd[instance] < 0 && write_topic_if_updated(sub, instance, true)) {
+						data_written = true;
+
+#ifdef DBGPRINT
+						total_bytes += sizeof(ulog_message_data_header_s) + sub.metadata->o_size_no_padding;
+#endif /* DBGPRINT */
+					}
+				}
 			}
 
 			//check for new logging message(s)
@@ -1385,6 +1436,8 @@ int Logger::get_log_file_name(char *file_name, size_t file_name_size)
 		replay_suffix = "_replayed";
 	}
 
+	const char *extension = _writer.is_file_compressed() ? "ulg.lz4" : "ulg";
+
 
 	if (time_ok) {
 		if (create_log_dir(&tt)) {
@@ -1393,7 +1446,8 @@ int Logger::get_log_file_name(char *file_name, size_t file_name_size)
 
 		char log_file_name_time[16] = "";
 		strftime(log_file_name_time, sizeof(log_file_name_time), "%H_%M_%S", &tt);
-		snprintf(_log_file_name, sizeof(_log_file_name), "%s%s.ulg", log_file_name_time, replay_suffix);
+		snprintf(_log_file_name, sizeof(_log_file_name), "%s%s.%s", log_file_name_time, replay_suffix,
+			 extension);
 		snprintf(file_name, file_name_size, "%s/%s", _log_dir, _log_file_name);
 
 	} else {
@@ -1406,7 +1460,7 @@ int Logger::get_log_file_name(char *file_name, size_t file_name_size)
 		/* look for the next file that does not exist */
 		while (file_number <= MAX_NO_LOGFILE) {
 			/* format log file path: e.g. /fs/microsd/sess001/log001.ulg */
-			snprintf(_log_file_name, sizeof(_log_file_name), "log%03u%s.ulg", file_number, replay_suffix);
+			snprintf(_log_file_name, sizeof(_log_file_name), "log%03u%s.%s", file_number, replay_suffix, extension);
 			snprintf(file_name, file_name_size, "%s/%s", _log_dir, _log_file_name);
 
 			if (!file_exist(file_name)) {
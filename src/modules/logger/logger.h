@@ -77,9 +77,10 @@ inline bool operator&(SDLogProfileMask a, SDLogProfileMask b)
 }
 
 struct LoggerSubscription {
-	int fd[ORB_MULTI_MAX_INSTANCES]; ///< uorb subscription. The first fd is also used to store the interval if
-	/// not subscribed yet (-interval - 1)
+	int fd[ORB_MULTI_MAX_INSTANCES]; ///< uorb subscription, -1 if not subscribed (yet)
 	uint16_t msg_ids[ORB_MULTI_MAX_INSTANCES];
+	uint32_t last_write[ORB_MULTI_MAX_INSTANCES] {}; ///< lower 32 bits of the time the instance was last logged [us]
+	uint32_t interval = 0; ///< minimum interval between two logged messages [us]
 	const orb_metadata *metadata = nullptr;
 
 	LoggerSubscription() {}
@@ -103,7 +104,8 @@ class Logger : public ModuleBase<Logger>
 {
 public:
 	Logger(LogWriter::Backend backend, size_t buffer_size, uint32_t log_interval, const char *poll_topic_name,
-	       bool log_on_start, bool log_until_shutdown, bool log_name_timestamp, unsigned int queue_size);
+	       bool log_on_start, bool log_until_shutdown, bool log_name_timestamp, unsigned int queue_size,
+	       bool async_io, bool compress);
 
 	~Logger();
 
@@ -262,12 +264,24 @@ private:
 
 	inline bool copy_if_updated_multi(LoggerSubscription &sub, int multi_instance, void *buffer, bool try_to_subscribe);
 
+	/**
+	 * Copy a topic instance if it got updated and write it to the log.
+	 * _writer.lock() must be held when calling this.
+	 * @return true if a message was written
+	 */
+	bool write_topic_if_updated(LoggerSubscription &sub, int multi_instance, bool try_to_subscribe);
+
 	/**
 	 * Check if a topic instance exists and subscribe to it
 	 * @return true when topic exists and subscription successful
 	 */
 	bool try_to_subscribe_topic(LoggerSubscription &sub, int multi_instance);
 
+	/**
+	 * Let uORB flag the publications of a subscribed topic instance in _updated_topics
+	 */
+	void set_update_bitmap(LoggerSubscription &sub, int multi_instance);
+
 	/**
 	 * Write exactly one ulog message to the logger and handle dropouts.
 	 * Must be called with _writer.lock() held.
@@ -312,6 +326,7 @@ private:
 
 
 	static constexpr size_t 	MAX_TOPICS_NUM = 64; /**< Maximum number of logged topics */
+	static constexpr size_t		UPDATED_TOPICS_WORDS = (MAX_TOPICS_NUM * ORB_MULTI_MAX_INSTANCES + 31) / 32;
 	static constexpr unsigned	MAX_NO_LOGFILE = 999;	/**< Maximum number of log files */
 #if defined(__PX4_POSIX_EAGLE) || defined(__PX4_POSIX_EXCELSIOR)
 	static constexpr const char	*LOG_ROOT = PX4_ROOTFSDIR"/log";
@@ -340,6 +355,8 @@ private:
 	const bool 					_log_until_shutdown;
 	const bool					_log_name_timestamp;
 	Array<LoggerSubscription, MAX_TOPICS_NUM>	_subscriptions;
+	uint32_t					_updated_topics[UPDATED_TOPICS_WORDS] {}; ///< bit per subscription
+	/// and instance (index * ORB_MULTI_MAX_INSTANCES + instance), set by uORB on each publication
 	LogWriter					_writer;
 	uint32_t					_log_interval{0};
 	const orb_metadata				*_polling_topic_meta{nullptr}; ///< if non-null, poll on this topic instead of sleeping
@@ -41,6 +41,7 @@
 #include <sys/stat.h>
 #include <errno.h>
 #include <cstring>
+#include <mathlib/mathlib.h>
 
 #include "mavlink_ftp.h"
 #include "mavlink_main.h"
@@ -51,12 +52,18 @@ constexpr const char MavlinkFTP::_root_dir[];
 MavlinkFTP::MavlinkFTP(Mavlink *mavlink) :
 	_mavlink(mavlink)
 {
-	// initialize session
-	_session_info.fd = -1;
+	// initialize sessions
+	for (uint8_t i = 0; i < kMaxSessions; i++) {
+		_session_info[i].fd = -1;
+	}
 }
 
 MavlinkFTP::~MavlinkFTP()
 {
+	for (uint8_t i = 0; i < kMaxSessions; i++) {
+		_close_session(_session_info[i]);
+	}
+
 	if (_work_buffer1) {
 		delete[] _work_buffer1;
 	}
@@ -69,12 +76,13 @@ MavlinkFTP::~MavlinkFTP()
 unsigned
 MavlinkFTP::get_size()
 {
-	if (_session_info.stream_download) {
-		return MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
-
-	} else {
-		return 0;
+	for (uint8_t i = 0; i < kMaxSessions; i++) {
+		if (_session_info[i].stream_download) {
+			return MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL_LEN + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+		}
 	}
+
+	return 0;
 }
 
 #ifdef MAVLINK_FTP_UNIT_TEST
@@ -501,7 +509,13 @@ MavlinkFTP::_workList(PayloadHeader *payload, bool list_hidden)
 MavlinkFTP::ErrorCode
 MavlinkFTP::_workOpen(PayloadHeader *payload, int oflag)
 {
-	if (_session_info.fd >= 0) {
+	uint8_t session_index = 0;
+
+	while (session_index < kMaxSessions && _session_info[session_index].fd >= 0) {
+		session_index++;
+	}
+
+	if (session_index == kMaxSessions) {
 		PX4_ERR("FTP: Open failed - out of sessions\n");
 		return kErrNoSessionsAvailable;
 	}
@@ -535,11 +549,13 @@ MavlinkFTP::_workOpen(PayloadHeader *payload, int oflag)
 		return kErrFailErrno;
 	}
 
-	_session_info.fd = fd;
-	_session_info.file_size = fileSize;
-	_session_info.stream_download = false;
+	SessionInfo &session = _session_info[session_index];
+	session.fd = fd;
+	session.file_size = fileSize;
+	session.stream_download = false;
+	session.stream_buffer_len = 0;
 
-	payload->session = 0;
+	payload->session = session_index;
 	payload->size = sizeof(uint32_t);
 	std::memcpy(payload->data, &fileSize, payload->size);
 
@@ -550,7 +566,9 @@ MavlinkFTP::_workOpen(PayloadHeader *payload, int oflag)
 MavlinkFTP::ErrorCode
 MavlinkFTP::_workRead(PayloadHeader *payload)
 {
-	if (payload->session != 0 || _session_info.fd < 0) {
+	SessionInfo *session = _get_session(payload);
+
+	if (session == nullptr) {
 		return kErrInvalidSession;
 	}
 
@@ -559,17 +577,17 @@ MavlinkFTP::_workRead(PayloadHeader *payload)
 #endif
 
 	// We have to test seek past EOF ourselves, lseek will allow seek past EOF
-	if (payload->offset >= _session_info.file_size) {
+	if (payload->offset >= session->file_size) {
 		PX4_ERR("request past EOF");
 		return kErrEOF;
 	}
 
-	if (lseek(_session_info.fd, payload->offset, SEEK_SET) < 0) {
+	if (lseek(session->fd, payload->offset, SEEK_SET) < 0) {
 		PX4_ERR("seek fail");
 		return kErrFailErrno;
 	}
 
-	int bytes_read = ::read(_session_info.fd, &payload->data[0], kMaxDataLength);
+	int bytes_read = ::read(session->fd, &payload->data[0], kMaxDataLength);
 
 	if (bytes_read < 0) {
 		// Negative return indicates error other than eof
@@ -586,19 +604,35 @@ MavlinkFTP::_workRead(PayloadHeader *payload)
 MavlinkFTP::ErrorCode
 MavlinkFTP::_workBurst(PayloadHeader *payload, uint8_t target_system_id)
 {
-	if (payload->session != 0 && _session_info.fd < 0) {
+	SessionInfo *session = _get_session(payload);
+
+	if (session == nullptr) {
 		return kErrInvalidSession;
 	}
 
 #ifdef MAVLINK_FTP_DEBUG
-	PX4_INFO("FTP: burst offset:%d", payload->offset);
+	PX4_INFO("FTP: burst session:%d offset:%d", payload->session, payload->offset);
 #endif
+
+	if (session->stream_buffer == nullptr) {
+		session->stream_buffer = new uint8_t[kStreamBufferLen];
+
+		if (session->stream_buffer == nullptr) {
+			errno = ENOMEM;
+			return kErrFailErrno;
+		}
+	}
+
+	// The file might have been written meanwhile (by another session or process),
+	// so the read-ahead buffer is only reused within a burst.
+	session->stream_buffer_len = 0;
+
 	// Setup for streaming sends
-	_session_info.stream_download = true;
-	_session_info.stream_offset = payload->offset;
-	_session_info.stream_chunk_transmitted = 0;
-	_session_info.stream_seq_number = payload->seq_number + 1;
-	_session_info.stream_target_system_id = target_system_id;
+	session->stream_download = true;
+	session->stream_offset = payload->offset;
+	session->stream_chunk_transmitted = 0;
+	session->stream_seq_number = payload->seq_number + 1;
+	session->stream_target_system_id = target_system_id;
 
 	return kErrNone;
 }
@@ -607,17 +641,19 @@ MavlinkFTP::_workBurst(PayloadHeader *payload, uint8_t target_system_id)
 MavlinkFTP::ErrorCode
 MavlinkFTP::_workWrite(PayloadHeader *payload)
 {
-	if (payload->session != 0 && _session_info.fd < 0) {
+	SessionInfo *session = _get_session(payload);
+
+	if (session == nullptr) {
 		return kErrInvalidSession;
 	}
 
-	if (lseek(_session_info.fd, payload->offset, SEEK_SET) < 0) {
+	if (lseek(session->fd, payload->offset, SEEK_SET) < 0) {
 		// Unable to see to the specified location
 		PX4_ERR("seek fail");
 		return kErrFailErrno;
 	}
 
-	int bytes_written = ::write(_session_info.fd, &payload->data[0], payload->size);
+	int bytes_written = ::write(session->fd, &payload->data[0], payload->size);
 
 	if (bytes_written < 0) {
 		// Negative return indicates error other than eof
@@ -747,13 +783,13 @@ MavlinkFTP::_workTruncateFile(PayloadHeader *payload)
 MavlinkFTP::ErrorCode
 MavlinkFTP::_workTerminate(PayloadHeader *payload)
 {
-	if (payload->session != 0 || _session_info.fd < 0) {
+	SessionInfo *session = _get_session(payload);
+
+	if (session == nullptr) {
 		return kErrInvalidSession;
 	}
 
-	::close(_session_info.fd);
-	_session_info.fd = -1;
-	_session_info.stream_download = false;
+	_close_session(*session);
 
 	payload->size = 0;
 
@@ -764,10 +800,8 @@ MavlinkFTP::_workTerminate(PayloadHeader *payload)
 MavlinkFTP::ErrorCode
 MavlinkFTP::_workReset(PayloadHeader *payload)
 {
-	if (_session_info.fd != -1) {
-		::close(_session_info.fd);
-		_session_info.fd = -1;
-		_session_info.stream_download = false;
+	for (uint8_t i = 0; i < kMaxSessions; i++) {
+		_close_session(_session_info[i]);
 	}
 
 	payload->size = 0;
@@ -775,6 +809,34 @@ MavlinkFTP::_workReset(PayloadHeader *payload)
 	return kErrNone;
 }
 
+MavlinkFTP::SessionInfo *
+MavlinkFTP::_get_session(PayloadHeader *payload)
+{
+	if (payload->session >= kMaxSessions || _session_info[payload->session].fd < 0) {
+		return nullptr;
+	}
+
+	return &_session_info[payload->session];
+}
+
+void
+MavlinkFTP::_close_session(SessionInfo &session)
+{
+	if (session.fd >= 0) {
+		::close(session.fd);
+		session.fd = -1;
+	}
+
+	session.stream_download = false;
+
+	if (session.stream_buffer) {
+		delete[] session.stream_buffer;
+		session.stream_buffer = nullptr;
+	}
+
+	session.stream_buffer_len = 0;
+}
+
 /// @brief Responds to a Rename command
 MavlinkFTP::ErrorCode
 MavlinkFTP::_workRename(PayloadHeader *payload)
@@ -975,119 +1037,182 @@ void MavlinkFTP::send(const hrt_abstime t)
 	}
 
 	// Anything to stream?
-	if (!_session_info.stream_download) {
+	const unsigned packet_size = get_size();
+
+	if (packet_size == 0) {
+		_last_send = 0;
 		return;
 	}
 
 #ifndef MAVLINK_FTP_UNIT_TEST
-	// Skip send if not enough room
-	unsigned max_bytes_to_send = _mavlink->get_free_tx_buf();
-#ifdef MAVLINK_FTP_DEBUG
-	PX4_INFO("MavlinkFTP::send max_bytes_to_send(%d) get_free_tx_buf(%d)", max_bytes_to_send, _mavlink->get_free_tx_buf());
-#endif
+	// Refill the send window with what the link transmits in the meantime. The free space of the
+	// transmit buffer alone does not bound UDP links, which report a constant size.
+	const float link_rate = _mavlink->get_link_rate();
+	const float max_window = math::max(link_rate * kSendWindowTime, (float)packet_size);
 
-	if (max_bytes_to_send < get_size()) {
-		return;
+	if (_last_send == 0) {
+		_send_window = max_window;
+
+	} else {
+		_send_window = math::min(_send_window + link_rate * (t - _last_send) * 1e-6f, max_window);
 	}
 
+	_last_send = t;
+#ifdef MAVLINK_FTP_DEBUG
+	PX4_INFO("MavlinkFTP::send window(%d) get_free_tx_buf(%d)", (int)_send_window, _mavlink->get_free_tx_buf());
+#endif
 #endif
 
-	// Send stream packets until buffer is full
-
+	// Send stream packets of the active sessions in turn until the window or the buffer is full
 	bool more_data;
 
 	do {
 		more_data = false;
 
-		ErrorCode error_code = kErrNone;
+		for (uint8_t i = 0; i < kMaxSessions; i++) {
+			const uint8_t session_index = (_next_stream_session + i) % kMaxSessions;
+
+			// the state is checked for every packet: sending can recurse in unit test mode
+			if (!_session_info[session_index].stream_download) {
+				continue;
+			}
 
-		mavlink_file_transfer_protocol_t ftp_msg;
-		PayloadHeader *payload = reinterpret_cast<PayloadHeader *>(&ftp_msg.payload[0]);
+#ifndef MAVLINK_FTP_UNIT_TEST
 
-		payload->seq_number = _session_info.stream_seq_number;
-		payload->session = 0;
-		payload->opcode = kRspAck;
-		payload->req_opcode = kCmdBurstReadFile;
-		payload->offset = _session_info.stream_offset;
-		_session_info.stream_seq_number++;
+			if (_send_window < packet_size || _mavlink->get_free_tx_buf() < packet_size) {
+				// continue with this session next time
+				_next_stream_session = session_index;
+				return;
+			}
 
-#ifdef MAVLINK_FTP_DEBUG
-		PX4_INFO("stream send: offset %d", _session_info.stream_offset);
+			_send_window -= packet_size;
 #endif
 
-		// We have to test seek past EOF ourselves, lseek will allow seek past EOF
-		if (_session_info.stream_offset >= _session_info.file_size) {
-			error_code = kErrEOF;
+			_send_stream_packet(session_index);
+			more_data = true;
+		}
+	} while (more_data);
+}
+
+void
+MavlinkFTP::_send_stream_packet(uint8_t session_index)
+{
+	SessionInfo &session = _session_info[session_index];
+	ErrorCode error_code = kErrNone;
+
+	mavlink_file_transfer_protocol_t ftp_msg;
+	PayloadHeader *payload = reinterpret_cast<PayloadHeader *>(&ftp_msg.payload[0]);
+
+	payload->seq_number = session.stream_seq_number;
+	payload->session = session_index;
+	payload->opcode = kRspAck;
+	payload->req_opcode = kCmdBurstReadFile;
+	payload->burst_complete = false;
+	payload->offset = session.stream_offset;
+	session.stream_seq_number++;
+
 #ifdef MAVLINK_FTP_DEBUG
-			PX4_INFO("stream download: sending Nak EOF");
+	PX4_INFO("stream send: session %d offset %d", session_index, session.stream_offset);
 #endif
-		}
 
-		if (error_code == kErrNone) {
-			if (lseek(_session_info.fd, payload->offset, SEEK_SET) < 0) {
-				error_code = kErrFailErrno;
+	// We have to test seek past EOF ourselves, lseek will allow seek past EOF
+	if (session.stream_offset >= session.file_size) {
+		error_code = kErrEOF;
 #ifdef MAVLINK_FTP_DEBUG
-				PX4_WARN("stream download: seek fail");
+		PX4_INFO("stream download: sending Nak EOF");
 #endif
-			}
-		}
+	}
 
-		if (error_code == kErrNone) {
-			int bytes_read = ::read(_session_info.fd, &payload->data[0], kMaxDataLength);
+	if (error_code == kErrNone) {
+		int bytes_read = _read_stream_data(session, &payload->data[0]);
 
-			if (bytes_read < 0) {
-				// Negative return indicates error other than eof
-				error_code = kErrFailErrno;
+		if (bytes_read < 0) {
+			// Negative return indicates error other than eof
+			error_code = kErrFailErrno;
 #ifdef MAVLINK_FTP_DEBUG
-				PX4_WARN("stream download: read fail");
+			PX4_WARN("stream download: read fail");
 #endif
 
-			} else {
-				payload->size = bytes_read;
-				_session_info.stream_offset += bytes_read;
-				_session_info.stream_chunk_transmitted += bytes_read;
+		} else {
+			payload->size = bytes_read;
+			session.stream_offset += bytes_read;
+			session.stream_chunk_transmitted += bytes_read;
+
+			if (session.stream_chunk_transmitted >= _burst_size()) {
+				payload->burst_complete = true;
+				session.stream_download = false;
+				session.stream_chunk_transmitted = 0;
 			}
 		}
+	}
 
-		if (error_code != kErrNone) {
-			payload->opcode = kRspNak;
-			payload->size = 1;
-			uint8_t *pData = &payload->data[0];
-			*pData = error_code; // Straight reference to data[0] is causing bogus gcc array subscript error
+	if (error_code != kErrNone) {
+		payload->opcode = kRspNak;
+		payload->size = 1;
+		uint8_t *pData = &payload->data[0];
+		*pData = error_code; // Straight reference to data[0] is causing bogus gcc array subscript error
 
-			if (error_code == kErrFailErrno) {
-				int r_errno = errno;
-				payload->size = 2;
-				payload->data[1] = r_errno;
-			}
+		if (error_code == kErrFailErrno) {
+			int r_errno = errno;
+			payload->size = 2;
+			payload->data[1] = r_errno;
+		}
 
-			_session_info.stream_download = false;
+		session.stream_download = false;
+	}
 
-		} else {
-#ifndef MAVLINK_FTP_UNIT_TEST
+	ftp_msg.target_system = session.stream_target_system_id;
+	_reply(&ftp_msg);
+}
 
-			if (max_bytes_to_send < (get_size() * 2)) {
-				more_data = false;
+int
+MavlinkFTP::_read_stream_data(SessionInfo &session, uint8_t *data)
+{
+	// The buffer is read at the stream offset: it then holds a whole number of packets
+	// as long as the burst continues.
+	uint32_t available = 0;
 
-				/* perform transfers in 35K chunks - this is determined empirical */
-				if (_session_info.stream_chunk_transmitted > 35000) {
-					payload->burst_complete = true;
-					_session_info.stream_download = false;
-					_session_info.stream_chunk_transmitted = 0;
-				}
+	if (session.stream_offset >= session.stream_buffer_offset
+	    && session.stream_offset < session.stream_buffer_offset + session.stream_buffer_len) {
+		available = session.stream_buffer_offset + session.stream_buffer_len - session.stream_offset;
+	}
 
-			} else {
+	if (available < kMaxDataLength) {
+		if (lseek(session.fd, session.stream_offset, SEEK_SET) < 0) {
+#ifdef MAVLINK_FTP_DEBUG
+			PX4_WARN("stream download: seek fail");
 #endif
-				more_data = true;
-				payload->burst_complete = false;
-#ifndef MAVLINK_FTP_UNIT_TEST
-				max_bytes_to_send -= get_size();
-			}
+			return -1;
+		}
 
-#endif
+		int bytes_read = ::read(session.fd, session.stream_buffer, kStreamBufferLen);
+
+		if (bytes_read < 0) {
+			session.stream_buffer_len = 0;
+			return -1;
 		}
 
-		ftp_msg.target_system = _session_info.stream_target_system_id;
-		_reply(&ftp_msg);
-	} while (more_data);
+		session.stream_buffer_offset = session.stream_offset;
+		session.stream_buffer_len = bytes_read;
+		available = bytes_read;
+	}
+
+	if (available > kMaxDataLength) {
+		available = kMaxDataLength;
+	}
+
+	memcpy(data, session.stream_buffer + (session.stream_offset - session.stream_buffer_offset), available);
+	return available;
+}
+
+uint32_t
+MavlinkFTP::_burst_size()
+{
+#ifdef MAVLINK_FTP_UNIT_TEST
+	return kMinBurstSize;
+#else
+	// larger bursts on fast links: less time lost waiting for the request of the next burst
+	return math::constrain((uint32_t)(_mavlink->get_link_rate() * kBurstTime), (uint32_t)kMinBurstSize,
+			       (uint32_t)kMaxBurstSize);
+#endif
 }
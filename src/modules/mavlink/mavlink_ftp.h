@@ -146,6 +146,22 @@ private:
 	ErrorCode	_workRename(PayloadHeader *payload);
 	ErrorCode	_workCalcFileCRC32(PayloadHeader *payload);
 
+	struct SessionInfo;
+
+	/// @return the open session addressed by the request, nullptr if there is none
+	SessionInfo	*_get_session(PayloadHeader *payload);
+	void		_close_session(SessionInfo &session);
+
+	/// @brief Sends the next packet of a burst read session
+	void		_send_stream_packet(uint8_t session_index);
+
+	/// @brief Copies the data at the stream offset of a session into a packet, refilling the read-ahead buffer if needed
+	///	@return number of bytes copied, -1 on read error
+	int		_read_stream_data(SessionInfo &session, uint8_t *data);
+
+	/// @return number of bytes sent in a burst before it is marked complete
+	uint32_t	_burst_size();
+
 	uint8_t _getServerSystemId(void);
 	uint8_t _getServerComponentId(void);
 	uint8_t _getServerChannel(void);
@@ -163,6 +179,24 @@ private:
 	/// @brief Maximum data size in RequestHeader::data
 	static const uint8_t	kMaxDataLength = MAVLINK_MSG_FILE_TRANSFER_PROTOCOL_FIELD_PAYLOAD_LEN - sizeof(PayloadHeader);
 
+	/// Number of sessions which can be open at the same time, each one can run a burst read
+	static constexpr uint8_t kMaxSessions = 4;
+
+	/// Size of the read-ahead buffer of a burst read session: a multiple of the packet data size
+#ifdef __PX4_NUTTX
+	static constexpr uint32_t kStreamBufferLen = 4 * kMaxDataLength;
+#else
+	static constexpr uint32_t kStreamBufferLen = 32 * kMaxDataLength;
+#endif
+
+	/// Bursts are sized to last this long on the link [s], within the limits below [B]
+	static constexpr float kBurstTime = 0.5f;
+	static constexpr uint32_t kMinBurstSize = 35000;	///< determined empirically
+	static constexpr uint32_t kMaxBurstSize = 512 * 1024;
+
+	/// The send window holds the bytes the link can take during this time [s]
+	static constexpr float kSendWindowTime = 0.05f;
+
 	struct SessionInfo {
 		int		fd;
 		uint32_t	file_size;
@@ -171,8 +205,14 @@ private:
 		uint16_t	stream_seq_number;
 		uint8_t		stream_target_system_id;
 		unsigned	stream_chunk_transmitted;
+		uint8_t		*stream_buffer;		///< read-ahead buffer (kStreamBufferLen), allocated on the first burst
+		uint32_t	stream_buffer_offset;	///< file offset of the first byte in stream_buffer
+		uint32_t	stream_buffer_len;	///< number of valid bytes in stream_buffer
 	};
-	struct SessionInfo _session_info {};	///< Session info, fd=-1 for no active session
+	struct SessionInfo _session_info[kMaxSessions] {};	///< Session info, fd=-1 for no active session
+	uint8_t		_next_stream_session{0};	///< session sending first in the next send() (round robin)
+	float		_send_window{0.0f};		///< bytes that may be sent now [B]
+	hrt_abstime	_last_send{0};			///< time of the last send() while streaming, 0 if idle
 
 	ReceiveMessageFunc_t	_utRcvMsgFunc{};	///< Unit test override for mavlink message sending
 	void			*_worker_data{nullptr};	///< Additional parameter to _utRcvMsgFunc;
@@ -180,6 +180,8 @@ protected:
 
 	void update_data();
 
+	bool high_rate_update_data() { return true; }
+
 	void update_airspeed();
 
 	void update_tecs_status();
@@ -37,7 +37,9 @@
 #include "mavlink_log_handler.h"
 #include "mavlink_main.h"
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <time.h>
+#include <mathlib/mathlib.h>
 
 #define MOUNTPOINT PX4_ROOTFSDIR "/fs/microsd"
 
@@ -53,6 +55,19 @@ static const char *kTmpData    = MOUNTPOINT "/$log$.txt";
 #define PX4LOG_DIRECTORY    DT_DIR
 #endif
 
+//-- Size of the read-ahead window. Reads start at a sector boundary.
+#ifdef __PX4_NUTTX
+static constexpr uint32_t kReadBufferSize = 4 * 1024;
+#else
+static constexpr uint32_t kReadBufferSize = 64 * 1024;
+#endif
+static constexpr uint32_t kSectorSize = 512;
+
+//-- An arbitrary count of max bytes in one go
+static constexpr unsigned kMaxBytesSend = 256 * 1024;
+//-- The send window holds the bytes the link can take during this time [s]
+static constexpr float kSendWindowTime = 0.05f;
+
 //#define MAVLINK_LOG_HANDLER_VERBOSE
 
 #ifdef MAVLINK_LOG_HANDLER_VERBOSE
@@ -81,7 +96,9 @@ stat_file(const char *file, time_t *date = nullptr, uint32_t *size = nullptr)
 //-------------------------------------------------------------------
 MavlinkLogHandler::MavlinkLogHandler(Mavlink *mavlink)
 	: _pLogHandlerHelper(nullptr),
-	  _mavlink(mavlink)
+	  _mavlink(mavlink),
+	  _send_window(0.0f),
+	  _last_send(0)
 {
 
 }
@@ -129,22 +146,41 @@ MavlinkLogHandler::get_size()
 
 //-------------------------------------------------------------------
 void
-MavlinkLogHandler::send(const hrt_abstime /*t*/)
+MavlinkLogHandler::send(const hrt_abstime t)
 {
-	//-- An arbitrary count of max bytes in one go (one of the two below but never both)
-#define MAX_BYTES_SEND 256 * 1024
-	size_t count = 0;
+	unsigned packet_size = get_size();
+
+	if (packet_size == 0) {
+		_last_send = 0;
+		return;
+	}
+
+	//-- Refill the send window with what the link transmits in the meantime. The free space
+	//-- of the transmit buffer alone does not bound UDP links (and serial links on Linux),
+	//-- which then drop most of a large burst and the GCS has to request the data again.
+	const float link_rate = _mavlink->get_link_rate();
+	const float max_window = math::constrain(link_rate * kSendWindowTime, (float)packet_size, (float)kMaxBytesSend);
 
-	//-- Log Entries
-	while (_pLogHandlerHelper && _pLogHandlerHelper->current_status == LogListHelper::LOG_HANDLER_LISTING
-	       && _mavlink->get_free_tx_buf() > get_size() && count < MAX_BYTES_SEND) {
-		count += _log_send_listing();
+	if (_last_send == 0) {
+		_send_window = max_window;
+
+	} else {
+		_send_window = math::min(_send_window + link_rate * (t - _last_send) * 1e-6f, max_window);
 	}
 
-	//-- Log Data
-	while (_pLogHandlerHelper && _pLogHandlerHelper->current_status == LogListHelper::LOG_HANDLER_SENDING_DATA
-	       && _mavlink->get_free_tx_buf() > get_size() && count < MAX_BYTES_SEND) {
-		count += _log_send_data();
+	_last_send = t;
+
+	//-- Log entries or log data, as long as the window and the transmit buffer permit
+	while (packet_size > 0 && _send_window >= packet_size && _mavlink->get_free_tx_buf() > packet_size) {
+		if (_pLogHandlerHelper->current_status == LogListHelper::LOG_HANDLER_LISTING) {
+			_log_send_listing();
+
+		} else {
+			_log_send_data();
+		}
+
+		_send_window -= packet_size;
+		packet_size = get_size();
 	}
 }
 
@@ -323,6 +359,7 @@ MavlinkLogHandler::_log_send_data()
 	mavlink_msg_log_data_send_struct(_mavlink->get_channel(), &response);
 	_pLogHandlerHelper->current_log_data_offset    += read_size;
 	_pLogHandlerHelper->current_log_data_remaining -= read_size;
+	_mavlink->count_log_download_bytes(read_size);
 
 	if (read_size < sizeof(response.data) || _pLogHandlerHelper->current_log_data_remaining == 0) {
 		_pLogHandlerHelper->current_status = LogListHelper::LOG_HANDLER_IDLE;
@@ -341,7 +378,10 @@ LogListHelper::LogListHelper()
 	, current_log_size(0)
 	, current_log_data_offset(0)
 	, current_log_data_remaining(0)
-	, current_log_filep(nullptr)
+	, current_log_fd(-1)
+	, _read_buffer(nullptr)
+	, _read_buffer_offset(0)
+	, _read_buffer_len(0)
 {
 	_init();
 }
@@ -349,6 +389,8 @@ LogListHelper::LogListHelper()
 //-------------------------------------------------------------------
 LogListHelper::~LogListHelper()
 {
+	_close_log();
+
 	// Remove log data files (if any)
 	unlink(kLogData);
 	unlink(kTmpData);
@@ -397,18 +439,64 @@ LogListHelper::get_entry(int idx, uint32_t &size, uint32_t &date, char *filename
 bool
 LogListHelper::open_for_transmit()
 {
-	if (current_log_filep) {
-		::fclose(current_log_filep);
-		current_log_filep = nullptr;
-	}
+	_close_log();
 
-	current_log_filep = ::fopen(current_log_filename, "rb");
+	current_log_fd = ::open(current_log_filename, O_RDONLY);
 
-	if (!current_log_filep) {
+	if (current_log_fd < 0) {
 		PX4LOG_WARN("MavlinkLogHandler::open_for_transmit Could not open %s\n", current_log_filename);
 		return false;
 	}
 
+	_read_buffer = new uint8_t[kReadBufferSize];
+
+	if (!_read_buffer) {
+		PX4LOG_WARN("MavlinkLogHandler::open_for_transmit Could not allocate read buffer\n");
+		_close_log();
+		return false;
+	}
+
+	return true;
+}
+
+//-------------------------------------------------------------------
+void
+LogListHelper::_close_log()
+{
+	if (current_log_fd >= 0) {
+		::close(current_log_fd);
+		current_log_fd = -1;
+	}
+
+	delete[] _read_buffer;
+	_read_buffer = nullptr;
+	_read_buffer_offset = 0;
+	_read_buffer_len = 0;
+}
+
+//-------------------------------------------------------------------
+bool
+LogListHelper::_fill_read_buffer(uint32_t offset)
+{
+	//-- Start at the sector containing the offset, so the window also covers
+	//-- the data just before it (re-requests of lost packets)
+	const uint32_t start = offset - (offset % kSectorSize);
+	_read_buffer_len = 0;
+
+	if (::lseek(current_log_fd, start, SEEK_SET) != (off_t)start) {
+		PX4LOG_WARN("MavlinkLogHandler::get_log_data Seek error in %s\n", current_log_filename);
+		return false;
+	}
+
+	ssize_t result = ::read(current_log_fd, _read_buffer, kReadBufferSize);
+
+	if (result < 0) {
+		PX4LOG_WARN("MavlinkLogHandler::get_log_data Read error in %s\n", current_log_filename);
+		return false;
+	}
+
+	_read_buffer_offset = start;
+	_read_buffer_len = result;
 	return true;
 }
 
@@ -420,21 +508,27 @@ LogListHelper::get_log_data(uint8_t len, uint8_t *buffer)
 		return 0;
 	}
 
-	if (!current_log_filep) {
+	if (current_log_fd < 0) {
 		PX4LOG_WARN("MavlinkLogHandler::get_log_data file not open %s\n", current_log_filename);
 		return 0;
 	}
 
-	long int offset = current_log_data_offset - ftell(current_log_filep);
+	const uint32_t offset = current_log_data_offset;
 
-	if (offset && fseek(current_log_filep, offset, SEEK_CUR)) {
-		fclose(current_log_filep);
-		current_log_filep = nullptr;
-		PX4LOG_WARN("MavlinkLogHandler::get_log_data Seek error in %s\n", current_log_filename);
+	if (offset < _read_buffer_offset || offset + len > _read_buffer_offset + _read_buffer_len) {
+		if (!_fill_read_buffer(offset)) {
+			_close_log();
+			return 0;
+		}
+	}
+
+	//-- Less than requested at the end of the file
+	if (offset >= _read_buffer_offset + _read_buffer_len) {
 		return 0;
 	}
 
-	size_t result = fread(buffer, 1, len, current_log_filep);
+	size_t result = math::min((uint32_t)len, _read_buffer_offset + _read_buffer_len - offset);
+	memcpy(buffer, _read_buffer + (offset - _read_buffer_offset), result);
 	return result;
 }
 
@@ -77,14 +77,22 @@ public:
 	uint32_t    current_log_size;
 	uint32_t    current_log_data_offset;
 	uint32_t    current_log_data_remaining;
-	FILE       *current_log_filep;
+	int         current_log_fd;
 	char        current_log_filename[128];
 
 private:
 	void        _init();
+	void        _close_log();
+	bool        _fill_read_buffer(uint32_t offset);
 	bool        _get_session_date(const char *path, const char *dir, time_t &date);
 	void        _scan_logs(FILE *f, const char *dir, time_t &date);
 	bool        _get_log_time_size(const char *path, const char *file, time_t &date, uint32_t &size);
+
+	//-- Read-ahead window of the log being sent: the LOG_DATA packets are served from it,
+	//-- so the file is read in large, sector aligned blocks instead of 90 bytes at a time.
+	uint8_t    *_read_buffer;
+	uint32_t    _read_buffer_offset;    ///< file offset of the first byte in the buffer
+	uint32_t    _read_buffer_len;       ///< number of valid bytes in the buffer
 };
 
 // MAVLink LOG_* Message Handler
@@ -116,4 +124,7 @@ private:
 
 	LogListHelper    *_pLogHandlerHelper;
 	Mavlink *_mavlink;
+
+	float       _send_window;   ///< bytes that may be sent now [B]
+	hrt_abstime _last_send;     ///< time of the last send() while active, 0 if idle
 };
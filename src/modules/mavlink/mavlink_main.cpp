@@ -223,6 +223,7 @@ Mavlink::Mavlink() :
 	_baudrate(57600),
 	_datarate(1000),
 	_datarate_events(500),
+	_datarate_configured(false),
 	_rate_mult(1.0f),
 	_last_hw_rate_timestamp(0),
 	_mavlink_param_queue_index(0),
@@ -239,10 +240,20 @@ Mavlink::Mavlink() :
 	_bytes_tx(0),
 	_bytes_txerr(0),
 	_bytes_rx(0),
+	_bytes_log_download(0),
+	_msgs_tx(0),
+	_send_calls(0),
+	_loop_time(0),
+	_loop_iterations(0),
 	_bytes_timestamp(0),
 	_rate_tx(0.0f),
 	_rate_txerr(0.0f),
 	_rate_rx(0.0f),
+	_rate_log_download(0.0f),
+	_rate_msgs_tx(0.0f),
+	_rate_send_calls(0.0f),
+	_loop_load(0.0f),
+	_rate_loop_iterations(0.0f),
 #ifdef __PX4_POSIX
 	_myaddr {},
 	_src_addr{},
@@ -253,6 +264,14 @@ Mavlink::Mavlink() :
 	_broadcast_failed_warned(false),
 	_network_buf{},
 	_network_buf_len(0),
+	_tx_packet_end{},
+	_tx_packet_count(0),
+	_tx_batching(false),
+	_tx_iov{},
+#if defined(__PX4_LINUX)
+	_tx_msgs{},
+#endif
+	_tcp(nullptr),
 #endif
 	_socket_fd(-1),
 	_protocol(SERIAL),
@@ -470,7 +489,7 @@ Mavlink::destroy_all_instances()
 }
 
 int
-Mavlink::get_status_all_instances()
+Mavlink::get_status_all_instances(bool show_streams_status)
 {
 	Mavlink *inst = ::_mavlink_instances;
 
@@ -479,7 +498,13 @@ Mavlink::get_status_all_instances()
 	while (inst != nullptr) {
 
 		printf("\ninstance #%u:\n", iterations);
-		inst->display_status();
+
+		if (show_streams_status) {
+			inst->display_status_streams();
+
+		} else {
+			inst->display_status();
+		}
 
 		/* move on */
 		inst = inst->next;
@@ -896,10 +921,22 @@ Mavlink::get_free_tx_buf()
 	 */
 	int buf_free = 0;
 
-	// if we are using network sockets, return max length of one packet
-	if (get_protocol() == UDP || get_protocol() == TCP) {
+	// if we are using UDP, return max length of one packet
+	if (get_protocol() == UDP) {
 		return  1500;
 
+#ifdef __PX4_POSIX
+
+	} else if (get_protocol() == TCP) {
+		// space left in the TCP transmit buffer after the packets queued in this iteration
+		if (_tcp == nullptr) {
+			return 0;
+		}
+
+		unsigned tcp_free = _tcp->tx_buffer_free();
+		return (tcp_free > _network_buf_len) ? tcp_free - _network_buf_len : 0;
+#endif
+
 	} else {
 		// No FIONSPACE on Linux todo:use SIOCOUTQ  and queue size to emulate FIONSPACE
 #if defined(__PX4_LINUX) || defined(__PX4_DARWIN) || defined(__PX4_CYGWIN)
@@ -938,59 +975,205 @@ Mavlink::send_packet()
 {
 	int ret = -1;
 
+	if (should_transmit()) {
+		++_msgs_tx;
+	}
+
+#ifdef __PX4_POSIX
+
+	if (get_protocol() == UDP || get_protocol() == TCP) {
+		const unsigned packet_start = _tx_packet_count > 0 ? _tx_packet_end[_tx_packet_count - 1] : 0;
+
+		if (get_protocol() == TCP && _network_buf_len > packet_start &&
+		    (_tcp == nullptr || _tcp->tx_buffer_free() < _network_buf_len)) {
+			/* The TCP transmit buffer is full: drop the packet as a whole to keep the framing intact.
+			 * The streams are throttled before this happens (see update_rate_mult()). */
+			const unsigned packet_len = _network_buf_len - packet_start;
+			_network_buf_len = packet_start;
+			_bytes_tx -= packet_len;
+			count_txerr();
+			count_txerrbytes(packet_len);
+		}
+
+		/* Only queue the packet if there is something in the buffer. */
+		if (_network_buf_len > packet_start) {
+			_tx_packet_end[_tx_packet_count++] = _network_buf_len;
+		}
+
+		/* send right away unless the main loop collects a batch, or if the next packet might not fit anymore */
+		if (!_tx_batching || _tx_packet_count == TX_BATCH_MAX_PACKETS ||
+		    _network_buf_len + MAVLINK_MAX_PACKET_LEN > sizeof(_network_buf)) {
+			ret = send_tx_queue();
+
+		} else {
+			ret = _network_buf_len - packet_start;
+		}
+	}
+
+#endif
+
+	pthread_mutex_unlock(&_send_mutex);
+	return ret;
+}
+
+void
+Mavlink::begin_tx_batch()
+{
 #ifdef __PX4_POSIX
 
-	/* Only send packets if there is something in the buffer. */
-	if (_network_buf_len == 0) {
+	if (get_protocol() == UDP || get_protocol() == TCP) {
+		pthread_mutex_lock(&_send_mutex);
+		_tx_batching = true;
 		pthread_mutex_unlock(&_send_mutex);
+	}
+
+#endif
+}
+
+void
+Mavlink::end_tx_batch()
+{
+#ifdef __PX4_POSIX
+
+	if (get_protocol() == UDP || get_protocol() == TCP) {
+		pthread_mutex_lock(&_send_mutex);
+		_tx_batching = false;
+		send_tx_queue();
+		pthread_mutex_unlock(&_send_mutex);
+	}
+
+#endif
+}
+
+#ifdef __PX4_POSIX
+int
+Mavlink::send_tx_queue()
+{
+	if (_tx_packet_count == 0) {
+		_network_buf_len = 0;
 		return 0;
 	}
 
-	if (get_protocol() == UDP) {
+	unsigned packet_start = 0;
 
+	for (unsigned i = 0; i < _tx_packet_count; ++i) {
+		_tx_iov[i].iov_base = &_network_buf[packet_start];
+		_tx_iov[i].iov_len = _tx_packet_end[i] - packet_start;
+		packet_start = _tx_packet_end[i];
+	}
 
-		ret = sendto(_socket_fd, _network_buf, _network_buf_len, 0,
-			     (struct sockaddr *)&_src_addr, sizeof(_src_addr));
+	static_assert(TX_BATCH_MAX_PACKETS <= MavlinkTCP::MAX_SEND_IOV, "TCP send cannot take a full batch");
 
-		struct telemetry_status_s &tstatus = get_rx_status();
+	if (get_protocol() == TCP) {
+		/* one gather write for the whole batch, the stream keeps the packet boundaries */
+		int ret = (_tcp != nullptr) ? _tcp->send(_tx_iov, _tx_packet_count) : -1;
+		++_send_calls;
 
-		/* resend message via broadcast if no valid connection exists */
-		if ((_mode != MAVLINK_MODE_ONBOARD) && broadcast_enabled() &&
-		    (!get_client_source_initialized()
-		     || (hrt_elapsed_time(&tstatus.heartbeat_time) > 3 * 1000 * 1000))) {
+		if (ret < 0) {
+			count_txerr();
+			count_txerrbytes(_network_buf_len);
+		}
 
-			if (!_broadcast_address_found) {
-				find_broadcast_address();
-			}
+		_tx_packet_count = 0;
+		_network_buf_len = 0;
+		return ret;
+	}
 
-			if (_broadcast_address_found && _network_buf_len > 0) {
+	struct telemetry_status_s &tstatus = get_rx_status();
 
-				int bret = sendto(_socket_fd, _network_buf, _network_buf_len, 0,
-						  (struct sockaddr *)&_bcast_addr, sizeof(_bcast_addr));
+	/* resend messages via broadcast if no valid connection exists */
+	bool broadcast = (_mode != MAVLINK_MODE_ONBOARD) && broadcast_enabled() &&
+			 (!get_client_source_initialized()
+			  || (hrt_elapsed_time(&tstatus.heartbeat_time) > 3 * 1000 * 1000));
 
-				if (bret <= 0) {
-					if (!_broadcast_failed_warned) {
-						PX4_ERR("sending broadcast failed, errno: %d: %s", errno, strerror(errno));
-						_broadcast_failed_warned = true;
-					}
+	if (broadcast && !_broadcast_address_found) {
+		find_broadcast_address();
+	}
 
-				} else {
-					_broadcast_failed_warned = false;
-				}
-			}
+	broadcast = broadcast && _broadcast_address_found;
+
+	/* each packet is still sent as its own datagram */
+	const unsigned num_unicast = _tx_packet_count;
+	const unsigned num_datagrams = broadcast ? 2 * _tx_packet_count : _tx_packet_count;
+	bool unicast_failed = false;
+	bool broadcast_failed = false;
+	int broadcast_errno = 0;
+
+#if defined(__PX4_LINUX)
+
+	for (unsigned i = 0; i < num_datagrams; ++i) {
+		struct msghdr &hdr = _tx_msgs[i].msg_hdr;
+		hdr.msg_name = (i < num_unicast) ? &_src_addr : &_bcast_addr;
+		hdr.msg_namelen = sizeof(struct sockaddr_in);
+		hdr.msg_iov = &_tx_iov[i % num_unicast];
+		hdr.msg_iovlen = 1;
+		hdr.msg_control = nullptr;
+		hdr.msg_controllen = 0;
+		hdr.msg_flags = 0;
+	}
+
+	unsigned sent = 0;
+
+	while (sent < num_datagrams) {
+		int ret = sendmmsg(_socket_fd, &_tx_msgs[sent], num_datagrams - sent, 0);
+		++_send_calls;
+
+		if (ret > 0) {
+			sent += ret;
+			continue;
 		}
 
-	} else if (get_protocol() == TCP) {
-		/* not implemented, but possible to do so */
-		PX4_ERR("TCP transport pending implementation");
+		/* skip the datagram that failed */
+		if (sent < num_unicast) {
+			unicast_failed = true;
+
+		} else {
+			broadcast_failed = true;
+			broadcast_errno = errno;
+		}
+
+		++sent;
+	}
+
+#else
+
+	for (unsigned i = 0; i < num_datagrams; ++i) {
+		const struct sockaddr_in *addr = (i < num_unicast) ? &_src_addr : &_bcast_addr;
+		const struct iovec &iov = _tx_iov[i % num_unicast];
+		int ret = sendto(_socket_fd, iov.iov_base, iov.iov_len, 0, (struct sockaddr *)addr, sizeof(*addr));
+		++_send_calls;
+
+		if (ret <= 0) {
+			if (i < num_unicast) {
+				unicast_failed = true;
+
+			} else {
+				broadcast_failed = true;
+				broadcast_errno = errno;
+			}
+		}
 	}
 
-	_network_buf_len = 0;
 #endif
 
-	pthread_mutex_unlock(&_send_mutex);
+	if (broadcast) {
+		if (broadcast_failed) {
+			if (!_broadcast_failed_warned) {
+				PX4_ERR("sending broadcast failed, errno: %d: %s", broadcast_errno, strerror(broadcast_errno));
+				_broadcast_failed_warned = true;
+			}
+
+		} else {
+			_broadcast_failed_warned = false;
+		}
+	}
+
+	int ret = unicast_failed ? -1 : (int)_network_buf_len;
+	_tx_packet_count = 0;
+	_network_buf_len = 0;
 	return ret;
 }
+#endif
 
 void
 Mavlink::send_bytes(const uint8_t *buf, unsigned packet_len)
@@ -1029,7 +1212,7 @@ Mavlink::send_bytes(const uint8_t *buf, unsigned packet_len)
 #ifdef __PX4_POSIX
 
 	else {
-		if (_network_buf_len + packet_len < sizeof(_network_buf) / sizeof(_network_buf[0])) {
+		if (_network_buf_len + packet_len <= sizeof(_network_buf) / sizeof(_network_buf[0])) {
 			memcpy(&_network_buf[_network_buf_len], buf, packet_len);
 			_network_buf_len += packet_len;
 
@@ -1238,6 +1421,40 @@ Mavlink::init_udp()
 #endif
 }
 
+void
+Mavlink::init_tcp()
+{
+#if defined (__PX4_LINUX) || defined (__PX4_DARWIN) || defined(__PX4_CYGWIN)
+
+	_tcp = new MavlinkTCP();
+
+	if (_tcp == nullptr) {
+		PX4_ERR("TCP alloc failed");
+		return;
+	}
+
+	int ret;
+
+	if (_src_addr_initialized) {
+		/* a partner IP was given: connect to it */
+		_src_addr.sin_port = htons(_remote_port);
+		ret = _tcp->connect(_src_addr);
+
+	} else {
+		PX4_DEBUG("Setting up TCP server with port %d", _network_port);
+		ret = _tcp->listen(_network_port);
+	}
+
+	if (ret < 0) {
+		PX4_WARN("TCP setup failed: %s", strerror(-ret));
+	}
+
+	/* only the connected peer can send, so there is no need to wait for its address */
+	_src_addr_initialized = true;
+
+#endif
+}
+
 void
 Mavlink::handle_message(const mavlink_message_t *msg)
 {
@@ -1396,6 +1613,7 @@ Mavlink::configure_stream(const char *stream_name, const float rate)
 				delete stream;
 			}
 
+			_stream_scheduler.invalidate();
 			return OK;
 		}
 	}
@@ -1412,6 +1630,7 @@ Mavlink::configure_stream(const char *stream_name, const float rate)
 	if (stream != nullptr) {
 		stream->set_interval(interval);
 		LL_APPEND(_streams, stream);
+		_stream_scheduler.invalidate();
 
 		return OK;
 	}
@@ -1452,6 +1671,8 @@ Mavlink::adjust_stream_rates(const float multiplier)
 			stream->set_interval(interval);
 		}
 	}
+
+	_stream_scheduler.invalidate();
 }
 
 void
@@ -1687,15 +1908,30 @@ Mavlink::update_rate_mult()
 
 	bool radio_critical = false;
 	bool radio_found = false;
+	unsigned txbuf = 0; ///< free transmit buffer [%]
+	hrt_abstime txbuf_timestamp = 0;
 
 	/* 2nd pass: Now check hardware limits */
 	if (tstatus.type == telemetry_status_s::TELEMETRY_STATUS_RADIO_TYPE_3DR_RADIO) {
 
 		radio_found = true;
+		txbuf = tstatus.txbuf;
+		txbuf_timestamp = tstatus.telem_time;
+	}
 
-		if (tstatus.txbuf < RADIO_BUFFER_LOW_PERCENTAGE) {
-			radio_critical = true;
-		}
+#ifdef __PX4_POSIX
+
+	else if (get_protocol() == TCP && _tcp != nullptr && _tcp->connected()) {
+		/* the TCP transmit buffer is handled like the radio buffer, sampled every 100 ms */
+		radio_found = true;
+		txbuf = (100 * _tcp->tx_buffer_free()) / MavlinkTCP::TX_BUFFER_SIZE;
+		txbuf_timestamp = hrt_absolute_time() / 100000;
+	}
+
+#endif
+
+	if (radio_found && txbuf < RADIO_BUFFER_LOW_PERCENTAGE) {
+		radio_critical = true;
 	}
 
 	float hardware_mult = _rate_mult;
@@ -1704,17 +1940,17 @@ Mavlink::update_rate_mult()
 	if (_rate_txerr > 0.0f && !radio_critical) {
 		hardware_mult = (_rate_tx) / (_rate_tx + _rate_txerr);
 
-	} else if (radio_found && tstatus.telem_time != _last_hw_rate_timestamp) {
+	} else if (radio_found && txbuf_timestamp != _last_hw_rate_timestamp) {
 
-		if (tstatus.txbuf < RADIO_BUFFER_CRITICAL_LOW_PERCENTAGE) {
+		if (txbuf < RADIO_BUFFER_CRITICAL_LOW_PERCENTAGE) {
 			/* this indicates link congestion, reduce rate by 20% */
 			hardware_mult *= 0.80f;
 
-		} else if (tstatus.txbuf < RADIO_BUFFER_LOW_PERCENTAGE) {
+		} else if (txbuf < RADIO_BUFFER_LOW_PERCENTAGE) {
 			/* this indicates link congestion, reduce rate by 2.5% */
 			hardware_mult *= 0.975f;
 
-		} else if (tstatus.txbuf > RADIO_BUFFER_HALF_PERCENTAGE) {
+		} else if (txbuf > RADIO_BUFFER_HALF_PERCENTAGE) {
 			/* this indicates spare bandwidth, increase by 2.5% */
 			hardware_mult *= 1.025f;
 			/* limit to a max multiplier of 1 */
@@ -1726,7 +1962,7 @@ Mavlink::update_rate_mult()
 		hardware_mult = 1.0f;
 	}
 
-	_last_hw_rate_timestamp = tstatus.telem_time;
+	_last_hw_rate_timestamp = txbuf_timestamp;
 
 	/* pick the minimum from bandwidth mult and hardware mult as limit */
 	_rate_mult = fminf(bandwidth_mult, hardware_mult);
@@ -1735,12 +1971,58 @@ Mavlink::update_rate_mult()
 	_rate_mult = fmaxf(0.05f, _rate_mult);
 }
 
+void
+Mavlink::wait_for_update(hrt_abstime wakeup, MavlinkOrbSubscription *const subs[], unsigned num_subs)
+{
+	const hrt_abstime now = hrt_absolute_time();
+
+	if (wakeup > now + _main_loop_delay) {
+		wakeup = now + _main_loop_delay;
+	}
+
+	if (wakeup <= now) {
+		return;
+	}
+
+	hrt_abstime sleep_time = wakeup - now;
+
+	/* only poll published topics: the data of the others is not copied, so they would not block */
+	px4_pollfd_struct_t fds[MAX_WAKEUP_SUBSCRIPTIONS] = {};
+	unsigned num_fds = 0;
+
+	for (unsigned i = 0; i < num_subs && num_fds < MAX_WAKEUP_SUBSCRIPTIONS; i++) {
+		if (subs[i]->is_published() && subs[i]->get_fd() >= 0) {
+			fds[num_fds].fd = subs[i]->get_fd();
+			fds[num_fds].events = POLLIN;
+			num_fds++;
+		}
+	}
+
+	/* poll() has a resolution of 1 ms, the remainder is slept */
+	if (num_fds > 0 && sleep_time >= 1000) {
+		if (px4_poll(fds, num_fds, sleep_time / 1000) > 0) {
+			return;
+		}
+
+		const hrt_abstime after_poll = hrt_absolute_time();
+
+		if (after_poll >= wakeup) {
+			return;
+		}
+
+		sleep_time = wakeup - after_poll;
+	}
+
+	usleep(sleep_time);
+}
+
 int
 Mavlink::task_main(int argc, char *argv[])
 {
 	int ch;
 	_baudrate = 57600;
 	_datarate = 0;
+	_datarate_configured = false;
 	_mode = MAVLINK_MODE_NORMAL;
 	bool _force_flow_control = false;
 
@@ -1763,9 +2045,10 @@ Mavlink::task_main(int argc, char *argv[])
 #ifdef __PX4_POSIX
 	char *eptr;
 	int temp_int_arg;
+	bool use_tcp = false;
 #endif
 
-	while ((ch = px4_getopt(argc, argv, "b:r:d:u:o:m:t:fwxz", &myoptind, &myoptarg)) != EOF) {
+	while ((ch = px4_getopt(argc, argv, "b:r:d:u:o:m:t:fwxzT", &myoptind, &myoptarg)) != EOF) {
 		switch (ch) {
 		case 'b':
 			_baudrate = strtoul(myoptarg, nullptr, 10);
@@ -1779,6 +2062,7 @@ Mavlink::task_main(int argc, char *argv[])
 
 		case 'r':
 			_datarate = strtoul(myoptarg, nullptr, 10);
+			_datarate_configured = true;
 
 			if (_datarate < 10 || _datarate > MAX_DATA_RATE) {
 				PX4_ERR("invalid data rate '%s'", myoptarg);
@@ -1834,12 +2118,17 @@ Mavlink::task_main(int argc, char *argv[])
 			}
 
 			break;
+
+		case 'T':
+			use_tcp = true;
+			break;
 #else
 
 		case 'u':
 		case 'o':
 		case 't':
-			PX4_ERR("UDP options not supported on this platform");
+		case 'T':
+			PX4_ERR("UDP/TCP options not supported on this platform");
 			err_flag = true;
 			break;
 #endif
@@ -1900,6 +2189,14 @@ Mavlink::task_main(int argc, char *argv[])
 		}
 	}
 
+#ifdef __PX4_POSIX
+
+	if (use_tcp) {
+		set_protocol(TCP);
+	}
+
+#endif
+
 	if (err_flag) {
 		usage();
 		return PX4_ERROR;
@@ -1946,6 +2243,25 @@ Mavlink::task_main(int argc, char *argv[])
 
 		PX4_INFO("mode: %s, data rate: %d B/s on udp port %hu remote port %hu",
 			 mavlink_mode_str(_mode), _datarate, _network_port, _remote_port);
+
+	} else if (get_protocol() == TCP) {
+#ifdef __PX4_POSIX
+
+		if (_src_addr_initialized) {
+			PX4_INFO("mode: %s, data rate: %d B/s, tcp connection to %s:%hu",
+				 mavlink_mode_str(_mode), _datarate, inet_ntoa(_src_addr.sin_addr), _remote_port);
+
+		} else {
+			if (Mavlink::get_instance_for_network_port(_network_port) != nullptr) {
+				PX4_ERR("port %d already occupied", _network_port);
+				return PX4_ERROR;
+			}
+
+			PX4_INFO("mode: %s, data rate: %d B/s, tcp server on port %hu",
+				 mavlink_mode_str(_mode), _datarate, _network_port);
+		}
+
+#endif
 	}
 
 	/* initialize send mutex */
@@ -2158,12 +2474,24 @@ Mavlink::task_main(int argc, char *argv[])
 		_main_loop_delay = MAVLINK_MAX_INTERVAL;
 	}
 
+	/* spread the streams over the link: at once, send at most what one main loop iteration could on average */
+	unsigned burst_size = (unsigned)((uint64_t)_datarate * _main_loop_delay / 1000000);
+
+	if (burst_size < MAVLINK_MAX_PACKET_LEN) {
+		burst_size = MAVLINK_MAX_PACKET_LEN;
+	}
+
+	_stream_scheduler.set_data_rate(_datarate, burst_size);
+
 	/* now the instance is fully initialized and we can bump the instance count */
 	LL_APPEND(_mavlink_instances, this);
 
 	/* init socket if necessary */
 	if (get_protocol() == UDP) {
 		init_udp();
+
+	} else if (get_protocol() == TCP) {
+		init_tcp();
 	}
 
 	/* if the protocol is serial, we send the system version blindly */
@@ -2174,14 +2502,20 @@ Mavlink::task_main(int argc, char *argv[])
 	/* start the MAVLink receiver last to avoid a race */
 	MavlinkReceiver::receive_start(&_receive_thread, this);
 
+	hrt_abstime next_stream_update = 0;
+	MavlinkOrbSubscription *const wakeup_subs[] = { cmd_sub, ack_sub, mavlink_log_sub };
+
 	while (!_task_should_exit) {
-		/* main loop */
-		usleep(_main_loop_delay);
+		/* main loop: sleep until the next stream is due or a command, ack or log message arrives */
+		wait_for_update(next_stream_update, wakeup_subs, sizeof(wakeup_subs) / sizeof(wakeup_subs[0]));
 
 		perf_begin(_loop_perf);
 
 		hrt_abstime t = hrt_absolute_time();
 
+		/* collect the packets of this iteration, they are sent at the end in a single call */
+		begin_tx_batch();
+
 		update_rate_mult();
 
 		if (param_sub->update(&param_time, nullptr)) {
@@ -2359,11 +2693,8 @@ Mavlink::task_main(int argc, char *argv[])
 			_subscribe_to_stream = nullptr;
 		}
 
-		/* update streams */
-		MavlinkStream *stream;
-		LL_FOREACH(_streams, stream) {
-			stream->update(t);
-		}
+		/* update the streams that are due */
+		next_stream_update = _stream_scheduler.update(_streams, t);
 
 		/* pass messages from other UARTs */
 		if (_forwarding_on) {
@@ -2413,6 +2744,11 @@ Mavlink::task_main(int argc, char *argv[])
 			}
 		}
 
+		end_tx_batch();
+
+		_loop_time += hrt_elapsed_time(&t);
+		++_loop_iterations;
+
 		/* update TX/RX rates*/
 		if (t > _bytes_timestamp + 1000000) {
 			if (_bytes_timestamp != 0) {
@@ -2420,9 +2756,25 @@ Mavlink::task_main(int argc, char *argv[])
 				_rate_tx = _bytes_tx / dt;
 				_rate_txerr = _bytes_txerr / dt;
 				_rate_rx = _bytes_rx / dt;
+				_rate_log_download = _bytes_log_download / dt;
+				_rate_msgs_tx = _msgs_tx * 1000.0f / dt;
+				_rate_send_calls = _send_calls * 1000.0f / dt;
+				_loop_load = _loop_time / (dt * 1000.0f);
+				_rate_loop_iterations = _loop_iterations * 1000.0f / dt;
+
+				MavlinkStream *stream;
+				LL_FOREACH(_streams, stream) {
+					stream->update_statistics(dt / 1000.0f);
+				}
+
 				_bytes_tx = 0;
 				_bytes_txerr = 0;
 				_bytes_rx = 0;
+				_bytes_log_download = 0;
+				_msgs_tx = 0;
+				_send_calls = 0;
+				_loop_time = 0;
+				_loop_iterations = 0;
 			}
 
 			_bytes_timestamp = t;
@@ -2474,6 +2826,15 @@ Mavlink::task_main(int argc, char *argv[])
 		_socket_fd = -1;
 	}
 
+#ifdef __PX4_POSIX
+
+	if (_tcp != nullptr) {
+		delete _tcp;
+		_tcp = nullptr;
+	}
+
+#endif
+
 	if (_forwarding_on) {
 		message_buffer_destroy();
 		pthread_mutex_destroy(&_message_buffer_mutex);
@@ -2661,6 +3022,17 @@ Mavlink::display_status()
 	printf("\ttx: %.3f kB/s\n", (double)_rate_tx);
 	printf("\ttxerr: %.3f kB/s\n", (double)_rate_txerr);
 	printf("\trx: %.3f kB/s\n", (double)_rate_rx);
+	printf("\ttx msgs: %.1f /s\n", (double)_rate_msgs_tx);
+
+	if (_rate_log_download > 0.0f) {
+		printf("\tlog download: %.3f kB/s\n", (double)_rate_log_download);
+	}
+
+	if (get_protocol() == UDP || get_protocol() == TCP) {
+		printf("\tsend calls: %.1f /s\n", (double)_rate_send_calls);
+	}
+
+	printf("\tmain loop load: %.2f%%, %.1f iterations/s\n", (double)_loop_load * 100., (double)_rate_loop_iterations);
 	printf("\trate mult: %.3f\n", (double)_rate_mult);
 
 	if (_mavlink_ulog) {
@@ -2681,7 +3053,32 @@ Mavlink::display_status()
 		break;
 
 	case TCP:
+#ifdef __PX4_POSIX
+		if (_tcp == nullptr) {
+			printf("TCP (not initialized)\n");
+
+		} else {
+			if (_tcp->server_mode()) {
+				printf("TCP server (%hu), ", _tcp->local_port());
+
+			} else {
+				printf("TCP client, ");
+			}
+
+			if (_tcp->connected()) {
+				printf("connected to %s:%hu\n", inet_ntoa(_tcp->remote_addr().sin_addr), ntohs(_tcp->remote_addr().sin_port));
+
+			} else {
+				printf("not connected\n");
+			}
+
+			printf("\ttx buffer free: %u B, connections: %u, rejected sends: %u\n", (unsigned)_tcp->tx_buffer_free(),
+			       _tcp->num_connections(), _tcp->rejected_sends());
+		}
+
+#else
 		printf("TCP\n");
+#endif
 		break;
 
 	case SERIAL:
@@ -2699,6 +3096,31 @@ Mavlink::display_status()
 	}
 }
 
+void
+Mavlink::display_status_streams()
+{
+	printf("\t%-20s %-26s %13s  %s\n", "Name", "Rate Config (current) [Hz]", "Achieved [Hz]", "Jitter mean/max [us]");
+
+	const float rate_mult = _rate_mult;
+	MavlinkStream *stream;
+	LL_FOREACH(_streams, stream) {
+		const int interval = stream->get_interval();
+
+		if (interval < 0) {
+			printf("\t%-20s %-26s %13.2f\n", stream->get_name(), "unlimited", (double)stream->get_achieved_rate());
+
+		} else {
+			const float rate = (interval > 0) ? 1000000.0f / interval : 0.0f;
+			const float rate_current = stream->const_rate() ? rate : rate * rate_mult;
+			char rates[32];
+			snprintf(rates, sizeof(rates), "%6.2f (%.2f)", (double)rate, (double)rate_current);
+
+			printf("\t%-20s %-26s %13.2f  %8.1f/%u\n", stream->get_name(), rates, (double)stream->get_achieved_rate(),
+			       (double)stream->get_jitter_mean(), stream->get_jitter_max());
+		}
+	}
+}
+
 int
 Mavlink::stream_command(int argc, char *argv[])
 {
@@ -2829,7 +3251,7 @@ static void usage()
 	PRINT_MODULE_DESCRIPTION(
 		R"DESCR_STR(
 ### Description
-This module implements the MAVLink protocol, which can be used on a Serial link or UDP network connection.
+This module implements the MAVLink protocol, which can be used on a Serial link or a UDP or TCP network connection.
 It communicates with the system via uORB: some messages are directly handled in the module (eg. mission
 protocol), others are published via uORB (eg. vehicle_command).
 
@@ -2854,6 +3276,11 @@ $ mavlink start -d /dev/ttyS1 -b 921600 -m onboard -r 80000
 Start mavlink on UDP port 14556 and enable the HIGHRES_IMU message with 50Hz:
 $ mavlink start -u 14556 -r 1000000
 $ mavlink stream -u 14556 -s HIGHRES_IMU -r 50
+
+Wait for a TCP connection on port 5760 (a GCS connecting to a companion computer, for example):
+$ mavlink start -T -u 5760 -r 1000000
+
+On TCP links the sender also reduces the stream rates when the transmit buffer fills up, instead of dropping messages.
 )DESCR_STR");
 
 	PRINT_MODULE_USAGE_NAME("mavlink", "communication");
@@ -2866,6 +3293,7 @@ $ mavlink stream -u 14556 -s HIGHRES_IMU -r 50
 	PRINT_MODULE_USAGE_PARAM_INT('o', 14550, 0, 65536, "Select UDP Network Port (remote)", true);
 	PRINT_MODULE_USAGE_PARAM_STRING('t', "127.0.0.1", nullptr,
 					"Partner IP (broadcasting can be enabled via MAV_BROADCAST param)", true);
+	PRINT_MODULE_USAGE_PARAM_FLAG('T', "Use TCP: listen on the local port, or connect to the partner IP and remote port if -t is given", true);
 #endif
 	PRINT_MODULE_USAGE_PARAM_STRING('m', "normal", "custom|camera|onboard|osd|magic|config|iridium|minimal",
 					"Mode: sets default streams and rates", true);
@@ -2879,6 +3307,7 @@ $ mavlink stream -u 14556 -s HIGHRES_IMU -r 50
 	PRINT_MODULE_USAGE_COMMAND_DESCR("stop-all", "Stop all instances");
 
 	PRINT_MODULE_USAGE_COMMAND_DESCR("status", "Print status for all instances");
+	PRINT_MODULE_USAGE_ARG("streams", "Print all enabled streams with their configured and achieved rates", true);
 
 	PRINT_MODULE_USAGE_COMMAND_DESCR("stream", "Configure the sending rate of a stream for a running instance");
 #ifdef __PX4_POSIX
@@ -2912,7 +3341,8 @@ int mavlink_main(int argc, char *argv[])
 		return Mavlink::destroy_all_instances();
 
 	} else if (!strcmp(argv[1], "status")) {
-		return Mavlink::get_status_all_instances();
+		bool show_streams_status = argc > 2 && strcmp(argv[2], "streams") == 0;
+		return Mavlink::get_status_all_instances(show_streams_status);
 
 	} else if (!strcmp(argv[1], "stream")) {
 		return Mavlink::stream_command(argc, argv);
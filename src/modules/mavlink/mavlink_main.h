@@ -61,6 +61,7 @@
 
 #ifdef __PX4_POSIX
 #include <net/if.h>
+#include "mavlink_tcp.h"
 #endif
 
 #include <uORB/uORB.h>
@@ -71,6 +72,7 @@
 #include "mavlink_bridge_header.h"
 #include "mavlink_orb_subscription.h"
 #include "mavlink_stream.h"
+#include "mavlink_stream_scheduler.h"
 #include "mavlink_messages.h"
 #include "mavlink_shell.h"
 #include "mavlink_ulog.h"
@@ -109,6 +111,11 @@ public:
 	 */
 	void			display_status();
 
+	/**
+	 * Display the status of all enabled streams.
+	 */
+	void			display_status_streams();
+
 	static int		stream_command(int argc, char *argv[]);
 
 	static int		instance_count();
@@ -136,7 +143,7 @@ public:
 
 	static int		destroy_all_instances();
 
-	static int		get_status_all_instances();
+	static int		get_status_all_instances(bool show_streams_status);
 
 	static bool		instance_exists(const char *device_name, Mavlink *self);
 
@@ -299,12 +306,26 @@ public:
 	void			send_bytes(const uint8_t *buf, unsigned packet_len);
 
 	/**
-	 * Flush the transmit buffer and send one MAVLink packet
+	 * End a MAVLINK_START_UART_SEND/MAVLINK_END_UART_SEND transaction.
 	 *
-	 * @return the number of bytes sent or -1 in case of error
+	 * On a network port the packet is queued while the main loop collects
+	 * a batch (see begin_tx_batch()), and sent right away otherwise.
+	 *
+	 * @return the number of bytes sent or queued, or -1 in case of error
 	 */
 	int             	send_packet();
 
+	/**
+	 * Start collecting the packets of a network link, so that they are sent with a single
+	 * system call. Packets sent from other threads in the meantime are added to the batch.
+	 */
+	void			begin_tx_batch();
+
+	/**
+	 * Send the packets collected since begin_tx_batch()
+	 */
+	void			end_tx_batch();
+
 	/**
 	 * Resend message as is, don't change sequence number and CRC.
 	 */
@@ -411,6 +432,11 @@ public:
 	 */
 	void			count_rxbytes(unsigned n) { _bytes_rx += n; };
 
+	/**
+	 * Count log file bytes sent by the log download (LOG_DATA)
+	 */
+	void			count_log_download_bytes(unsigned n) { _bytes_log_download += n; };
+
 	/**
 	 * Get the receive status of this MAVLink link
 	 */
@@ -436,6 +462,8 @@ public:
 
 	void			set_client_source_initialized() { _src_addr_initialized = true; }
 
+	MavlinkTCP		*get_tcp() { return _tcp; }
+
 	bool			get_client_source_initialized() { return _src_addr_initialized; }
 #else
 	bool			get_client_source_initialized() { return true; }
@@ -450,7 +478,22 @@ public:
 	bool			accepting_commands() { return true; /* non-trivial side effects ((!_config_link_on) || (_mode == MAVLINK_MODE_CONFIG));*/ }
 
 	int			get_data_rate()		{ return _datarate; }
-	void			set_data_rate(int rate) { if (rate > 0) { _datarate = rate; } }
+
+	/**
+	 * Rate the link transmits at [B/s]: given by the baudrate on serial links, the configured data rate on
+	 * network links. Network links started without a data rate use NETWORK_LINK_RATE, not the stream default
+	 * derived from the (meaningless) baudrate. Used to size the bursts of bulk transfers (log download, FTP).
+	 */
+	float			get_link_rate()
+	{
+		if (_protocol == SERIAL) {
+			return _baudrate / 10.0f;
+		}
+
+		return _datarate_configured ? (float)_datarate : NETWORK_LINK_RATE;
+	}
+
+	void			set_data_rate(int rate) { if (rate > 0) { _datarate = rate; _datarate_configured = true; } }
 
 	unsigned		get_main_loop_delay() const { return _main_loop_delay; }
 
@@ -508,6 +551,7 @@ private:
 	static constexpr unsigned MAVLINK_MIN_INTERVAL = 1500;
 	static constexpr unsigned MAVLINK_MAX_INTERVAL = 10000;
 	static constexpr float MAVLINK_MIN_MULTIPLIER = 0.0005f;
+	static constexpr float NETWORK_LINK_RATE = 250000.0f; ///< assumed rate of UDP/TCP links started without -r [B/s]
 	mavlink_message_t _mavlink_buffer;
 	mavlink_status_t _mavlink_status;
 
@@ -524,6 +568,7 @@ private:
 
 	MavlinkOrbSubscription	*_subscriptions;
 	MavlinkStream		*_streams;
+	MavlinkStreamScheduler	_stream_scheduler;
 
 	MavlinkShell			*_mavlink_shell;
 	MavlinkULog			*_mavlink_ulog;
@@ -546,6 +591,7 @@ private:
 	int			_baudrate;
 	int			_datarate;		///< data rate for normal streams (attitude, position, etc.)
 	int			_datarate_events;	///< data rate for params, waypoints, text messages
+	bool			_datarate_configured;	///< data rate given with -r or by the GCS, not derived from the baudrate
 	float			_rate_mult;
 	hrt_abstime		_last_hw_rate_timestamp;
 
@@ -572,10 +618,20 @@ private:
 	unsigned		_bytes_tx;
 	unsigned		_bytes_txerr;
 	unsigned		_bytes_rx;
+	unsigned		_bytes_log_download;
+	unsigned		_msgs_tx;
+	unsigned		_send_calls;			///< number of send system calls (network links)
+	uint64_t		_loop_time;			///< time spent in the main loop [us]
+	unsigned		_loop_iterations;
 	uint64_t		_bytes_timestamp;
 	float			_rate_tx;
 	float			_rate_txerr;
 	float			_rate_rx;
+	float			_rate_log_download;
+	float			_rate_msgs_tx;
+	float			_rate_send_calls;
+	float			_loop_load;			///< fraction of time spent in the main loop
+	float			_rate_loop_iterations;
 
 #ifdef __PX4_POSIX
 	struct sockaddr_in _myaddr;
@@ -585,8 +641,18 @@ private:
 	bool _broadcast_address_found;
 	bool _broadcast_address_not_found_warned;
 	bool _broadcast_failed_warned;
-	uint8_t _network_buf[MAVLINK_MAX_PACKET_LEN];
+
+	static constexpr unsigned TX_BATCH_MAX_PACKETS = 32; ///< max number of packets collected for one send call
+	uint8_t _network_buf[MAVLINK_MAX_PACKET_LEN * TX_BATCH_MAX_PACKETS];
 	unsigned _network_buf_len;
+	uint16_t _tx_packet_end[TX_BATCH_MAX_PACKETS]; ///< end offset of each queued packet in _network_buf
+	unsigned _tx_packet_count;
+	bool _tx_batching; ///< true while the main loop collects packets
+	struct iovec _tx_iov[TX_BATCH_MAX_PACKETS];
+#if defined(__PX4_LINUX)
+	struct mmsghdr _tx_msgs[2 * TX_BATCH_MAX_PACKETS]; ///< unicast + broadcast
+#endif
+	MavlinkTCP *_tcp; ///< TCP transport, only allocated for TCP links
 #endif
 	int _socket_fd;
 	Protocol	_protocol;
@@ -673,10 +739,29 @@ private:
 	 */
 	void update_rate_mult();
 
+	static constexpr unsigned MAX_WAKEUP_SUBSCRIPTIONS = 3;
+
+	/**
+	 * Sleep until wakeup, but at most for the main loop delay. Returns early if one of the
+	 * (at most MAX_WAKEUP_SUBSCRIPTIONS) subscriptions gets updated.
+	 */
+	void wait_for_update(hrt_abstime wakeup, MavlinkOrbSubscription *const subs[], unsigned num_subs);
+
 	void find_broadcast_address();
 
+#ifdef __PX4_POSIX
+	/**
+	 * Send all queued packets of a network link (to the partner and if needed via broadcast).
+	 * The caller must hold _send_mutex.
+	 * @return the number of bytes sent or -1 in case of error
+	 */
+	int send_tx_queue();
+#endif
+
 	void init_udp();
 
+	void init_tcp();
+
 	/**
 	 * Main mavlink task.
 	 */
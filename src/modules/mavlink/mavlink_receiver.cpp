@@ -2519,6 +2519,15 @@ MavlinkReceiver::receive_thread(void *arg)
 	hrt_abstime last_send_update = 0;
 
 	while (!_mavlink->_task_should_exit) {
+#ifdef __PX4_POSIX
+
+		if (_mavlink->get_protocol() == TCP && _mavlink->get_tcp() != nullptr) {
+			/* the socket changes with every (re-)connection */
+			_mavlink->get_tcp()->poll_setup(fds[0]);
+		}
+
+#endif
+
 		if (poll(&fds[0], 1, timeout) > 0) {
 			if (_mavlink->get_protocol() == SERIAL) {
 
@@ -2542,8 +2551,9 @@ MavlinkReceiver::receive_thread(void *arg)
 					nread = recvfrom(_mavlink->get_socket_fd(), buf, sizeof(buf), 0, (struct sockaddr *)&srcaddr, &addrlen);
 				}
 
-			} else {
-				// could be TCP or other protocol
+			} else if (_mavlink->get_protocol() == TCP && _mavlink->get_tcp() != nullptr) {
+				/* accepts or completes connections and flushes pending data as well */
+				nread = _mavlink->get_tcp()->receive(fds[0].revents, buf, sizeof(buf));
 			}
 
 			struct sockaddr_in *srcaddr_last = _mavlink->get_client_source_address();
@@ -48,6 +48,8 @@ MavlinkStream::MavlinkStream(Mavlink *mavlink) :
 	_mavlink(mavlink)
 {
 	_last_sent = hrt_absolute_time();
+	_deadline = _last_sent + _interval;
+	_next_update = _deadline;
 }
 
 /**
@@ -58,57 +60,70 @@ MavlinkStream::update(const hrt_abstime &t)
 {
 	update_data();
 
-	// If the message has never been sent before we want
-	// to send it immediately and can return right away
-	if (_last_sent == 0) {
-		// this will give different messages on the same run a different
-		// initial timestamp which will help spacing them out
-		// on the link scheduling
+	// Streams with unlimited rate send whenever there is new data
+	if (_interval < 0) {
 		if (send(t)) {
-			_last_sent = hrt_absolute_time();
+			_last_sent = t;
+			++_stats_sent;
+			return 0;
 		}
 
-		return 0;
+		return -1;
+	}
+
+	// Not due yet (the stream is polled to collect data)
+	if (t < _next_update) {
+		return -1;
 	}
 
-	// One of the previous iterations sent the update
-	// already before the deadline
-	if (_last_sent > t) {
+	// On a TCP link, keep the message if it does not fit into the transmit
+	// buffer anymore, instead of dropping it. So does a stream without new
+	// data: both check again after one main loop delay.
+	if ((_mavlink->get_protocol() == TCP && _mavlink->get_free_tx_buf() < get_size()) || !send(t)) {
+		_next_update = t + _mavlink->get_main_loop_delay();
 		return -1;
 	}
 
-	int64_t dt = t - _last_sent;
-	int interval = (_interval > 0) ? _interval : 0;
+	const hrt_abstime delay = (t > _deadline) ? t - _deadline : 0;
+
+	++_stats_sent;
+	_stats_jitter_sum += delay;
+
+	if (delay > _stats_jitter_max) {
+		_stats_jitter_max = delay;
+	}
+
+	int interval = _interval;
 
 	if (!const_rate()) {
 		interval /= _mavlink->get_rate_mult();
 	}
 
-	// Send the message if it is due or
-	// if it will overrun the next scheduled send interval
-	// by 30% of the interval time. This helps to avoid
-	// sending a scheduled message on average slower than
-	// scheduled. Doing this at 50% would risk sending
-	// the message too often as the loop runtime of the app
-	// needs to be accounted for as well.
-	// This method is not theoretically optimal but a suitable
-	// stopgap as it hits its deadlines well (0.5 Hz, 50 Hz and 250 Hz)
-
-	if (interval == 0 || (dt > (interval - (_mavlink->get_main_loop_delay() / 10) * 3))) {
-		// interval expired, send message
-
-		// If the interval is non-zero and dt is smaller than 1.5 times the interval
-		// do not use the actual time but increment at a fixed rate, so that processing delays do not
-		// distort the average rate. The check of the maximum interval is done to ensure that after a
-		// long time not sending anything, sending multiple messages in a short time is avoided.
-		if (send(t)) {
-			_last_sent = ((interval > 0) && ((int64_t)(1.5f * interval) > dt)) ? _last_sent + interval : t;
-			return 0;
+	// Schedule the next message relative to the deadline, so that processing
+	// delays do not distort the average rate. If the stream fell behind by more
+	// than half an interval, restart from now instead, to avoid sending multiple
+	// messages in a short time.
+	if (delay < (hrt_abstime)interval / 2) {
+		_deadline += interval;
 
-		} else {
-			return -1;
-		}
+	} else {
+		_deadline = t + interval;
 	}
 
-	return -1;
+	_next_update = _deadline;
+	_last_sent = t;
+
+	return 0;
+}
+
+void
+MavlinkStream::update_statistics(float dt)
+{
+	_achieved_rate = (dt > 0.0f) ? _stats_sent / dt : 0.0f;
+	_jitter_mean = (_stats_sent > 0) ? (float)_stats_jitter_sum / _stats_sent : 0.0f;
+	_jitter_max = _stats_jitter_max;
+
+	_stats_sent = 0;
+	_stats_jitter_sum = 0;
+	_stats_jitter_max = 0;
 }
@@ -65,7 +65,12 @@ public:
 	 *
 	 * @param interval the interval in microseconds (us) between messages
 	 */
-	void set_interval(const int interval) { _interval = interval; }
+	void set_interval(const int interval)
+	{
+		_interval = interval;
+		_deadline = _last_sent + ((interval > 0) ? interval : 0);
+		_next_update = _deadline;
+	}
 
 	/**
 	 * Get the interval
@@ -78,6 +83,29 @@ public:
 	 * @return 0 if updated / sent, -1 if unchanged
 	 */
 	int update(const hrt_abstime &t);
+
+	/**
+	 * Time of the next update of a stream with a fixed rate: the deadline of the next message,
+	 * or the time to check again if there was no new data at the deadline.
+	 */
+	hrt_abstime get_next_update() const { return _next_update; }
+
+	/**
+	 * @return true if update() needs to be called at every iteration, instead of at get_next_update():
+	 * streams with unlimited rate send whenever there is new data, others collect data at a high rate
+	 */
+	bool polled() { return _interval < 0 || high_rate_update_data(); }
+
+	/**
+	 * Compute the achieved rate and jitter of the last statistics period and start a new one.
+	 *
+	 * @param dt length of the period [s]
+	 */
+	void update_statistics(float dt);
+
+	float get_achieved_rate() const { return _achieved_rate; }	///< [Hz]
+	float get_jitter_mean() const { return _jitter_mean; }		///< mean delay after the deadline [us]
+	uint32_t get_jitter_max() const { return _jitter_max; }		///< max delay after the deadline [us]
 	virtual const char *get_name() const = 0;
 	virtual uint16_t get_id() = 0;
 
@@ -111,12 +139,28 @@ protected:
 	 * Function to collect/update data for the streams at a high rate independant of
 	 * actual stream rate.
 	 *
-	 * This function is called at every iteration of the mavlink module.
+	 * This function is called at every iteration of the mavlink module if
+	 * high_rate_update_data() returns true, and before sending otherwise.
 	 */
 	virtual void update_data() { }
 
+	/**
+	 * @return true if update_data() needs to be called at every iteration
+	 */
+	virtual bool high_rate_update_data() { return false; }
+
 private:
 	hrt_abstime _last_sent{0};
+	hrt_abstime _deadline{0};		///< nominal time of the next message
+	hrt_abstime _next_update{0};
+
+	uint32_t _stats_sent{0};
+	uint64_t _stats_jitter_sum{0};
+	uint32_t _stats_jitter_max{0};
+
+	float _achieved_rate{0.0f};
+	float _jitter_mean{0.0f};
+	uint32_t _jitter_max{0};
 };
 
 
@@ -0,0 +1,197 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file mavlink_stream_scheduler.cpp
+ * Deadline ordered scheduling of the MAVLink streams.
+ */
+
+#include "mavlink_stream_scheduler.h"
+#include "mavlink_stream.h"
+
+#include <math.h>
+#include <px4_log.h>
+
+MavlinkStreamScheduler::~MavlinkStreamScheduler()
+{
+	delete[] _queue;
+	delete[] _polled;
+}
+
+void
+MavlinkStreamScheduler::set_data_rate(unsigned data_rate, unsigned burst_size)
+{
+	_data_rate = data_rate;
+	_burst_size = burst_size;
+	_budget = _burst_size;
+}
+
+bool
+MavlinkStreamScheduler::rebuild(MavlinkStream *streams)
+{
+	unsigned count = 0;
+
+	for (MavlinkStream *stream = streams; stream != nullptr; stream = stream->next) {
+		++count;
+	}
+
+	if (count > _capacity) {
+		delete[] _queue;
+		delete[] _polled;
+		_queue = new MavlinkStream *[count];
+		_polled = new MavlinkStream *[count];
+
+		if (_queue == nullptr || _polled == nullptr) {
+			PX4_ERR("stream queue alloc failed");
+			delete[] _queue;
+			delete[] _polled;
+			_queue = nullptr;
+			_polled = nullptr;
+			_capacity = 0;
+			return false;
+		}
+
+		_capacity = count;
+	}
+
+	_queue_size = 0;
+	_polled_size = 0;
+
+	for (MavlinkStream *stream = streams; stream != nullptr; stream = stream->next) {
+		if (stream->polled()) {
+			_polled[_polled_size++] = stream;
+
+		} else {
+			_queue[_queue_size++] = stream;
+		}
+	}
+
+	for (unsigned i = _queue_size / 2; i > 0; --i) {
+		sift_down(i - 1);
+	}
+
+	_valid = true;
+	return true;
+}
+
+void
+MavlinkStreamScheduler::sift_down(unsigned index)
+{
+	MavlinkStream *stream = _queue[index];
+	const hrt_abstime next_update = stream->get_next_update();
+
+	for (;;) {
+		unsigned child = 2 * index + 1;
+
+		if (child >= _queue_size) {
+			break;
+		}
+
+		if (child + 1 < _queue_size &&
+		    _queue[child + 1]->get_next_update() < _queue[child]->get_next_update()) {
+			++child;
+		}
+
+		if (next_update <= _queue[child]->get_next_update()) {
+			break;
+		}
+
+		_queue[index] = _queue[child];
+		index = child;
+	}
+
+	_queue[index] = stream;
+}
+
+hrt_abstime
+MavlinkStreamScheduler::update(MavlinkStream *streams, const hrt_abstime &t)
+{
+	if (!_valid && !rebuild(streams)) {
+		/* fall back to visiting every stream */
+		for (MavlinkStream *stream = streams; stream != nullptr; stream = stream->next) {
+			stream->update(t);
+		}
+
+		return NO_DEADLINE;
+	}
+
+	if (_data_rate > 0.0f && _last_update != 0 && t > _last_update) {
+		_budget = fminf(_budget + (t - _last_update) * 1e-6f * _data_rate, _burst_size);
+	}
+
+	_last_update = t;
+
+	/* the sent messages of the polled streams (commands, status texts, ...) are
+	 * accounted for as well, even if that puts the budget into debt */
+	for (unsigned i = 0; i < _polled_size; ++i) {
+		const unsigned size = _polled[i]->get_size();
+
+		if (_polled[i]->update(t) == 0) {
+			_budget -= size;
+		}
+	}
+
+	/* Each stream is updated at most once: afterwards its next update is in the future */
+	for (unsigned i = 0; i < _queue_size; ++i) {
+		MavlinkStream *stream = _queue[0];
+		const hrt_abstime next_update = stream->get_next_update();
+
+		if (next_update > t) {
+			return next_update;
+		}
+
+		const unsigned size = stream->get_size();
+
+		if (_data_rate > 0.0f && !stream->const_rate()) {
+			/* a message larger than the burst size is sent once the budget is full */
+			const float required = fminf(size, _burst_size);
+
+			if (_budget < required) {
+				/* spread the burst: continue when the link has capacity again */
+				return t + (hrt_abstime)((required - _budget) / _data_rate * 1e6f) + 1;
+			}
+		}
+
+		if (stream->update(t) == 0) {
+			_budget -= size;
+		}
+
+		sift_down(0);
+	}
+
+	if (_queue_size == 0) {
+		return NO_DEADLINE;
+	}
+
+	return _queue[0]->get_next_update();
+}
@@ -0,0 +1,102 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file mavlink_stream_scheduler.h
+ * Deadline ordered scheduling of the MAVLink streams.
+ *
+ * Streams with a fixed rate are kept in a priority queue ordered by the time of their next
+ * update, so that only the streams that are due are visited, and the main loop can sleep
+ * until the next one is. Bursts of streams becoming due at the same time are spread
+ * according to the data rate of the link (token bucket).
+ */
+
+#pragma once
+
+#include <drivers/drv_hrt.h>
+
+class MavlinkStream;
+
+class MavlinkStreamScheduler
+{
+public:
+	static constexpr hrt_abstime NO_DEADLINE = UINT64_MAX;
+
+	MavlinkStreamScheduler() = default;
+	~MavlinkStreamScheduler();
+
+	// no copy, assignment, move, move assignment
+	MavlinkStreamScheduler(const MavlinkStreamScheduler &) = delete;
+	MavlinkStreamScheduler &operator=(const MavlinkStreamScheduler &) = delete;
+	MavlinkStreamScheduler(MavlinkStreamScheduler &&) = delete;
+	MavlinkStreamScheduler &operator=(MavlinkStreamScheduler &&) = delete;
+
+	/**
+	 * Set the data rate the streams are spread over.
+	 *
+	 * @param data_rate link data rate [B/s], 0 for no limit
+	 * @param burst_size maximum number of bytes sent at once [B]
+	 */
+	void set_data_rate(unsigned data_rate, unsigned burst_size);
+
+	/**
+	 * The set of streams or their intervals changed: rebuild the queue on the next update.
+	 */
+	void invalidate() { _valid = false; }
+
+	/**
+	 * Update the polled streams, and the streams that are due in the order of their deadlines,
+	 * as far as the data rate permits.
+	 *
+	 * @param streams list of all streams
+	 * @return time of the next required update, NO_DEADLINE if there is none
+	 */
+	hrt_abstime update(MavlinkStream *streams, const hrt_abstime &t);
+
+private:
+	bool rebuild(MavlinkStream *streams);
+
+	void sift_down(unsigned index);
+
+	MavlinkStream **_queue{nullptr};	///< fixed rate streams, min-heap by next update time
+	MavlinkStream **_polled{nullptr};	///< streams updated at every iteration
+	unsigned _queue_size{0};
+	unsigned _polled_size{0};
+	unsigned _capacity{0};
+	bool _valid{false};
+
+	float _data_rate{0.0f};			///< [B/s]
+	float _burst_size{0.0f};		///< [B]
+	float _budget{0.0f};			///< bytes the streams may send now [B]
+	hrt_abstime _last_update{0};
+};
@@ -0,0 +1,412 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file mavlink_tcp.cpp
+ * Non-blocking TCP transport for the MAVLink module.
+ */
+
+#include "mavlink_tcp.h"
+
+#ifdef __PX4_POSIX
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/tcp.h>
+
+#include <px4_log.h>
+
+#ifdef MSG_NOSIGNAL
+static constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static constexpr int SEND_FLAGS = 0; // SO_NOSIGPIPE is set on the socket instead
+#endif
+
+MavlinkTCP::MavlinkTCP()
+{
+	pthread_mutex_init(&_mutex, nullptr);
+}
+
+MavlinkTCP::~MavlinkTCP()
+{
+	close();
+	pthread_mutex_destroy(&_mutex);
+}
+
+int
+MavlinkTCP::listen(uint16_t port)
+{
+	close();
+
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	if (fd < 0) {
+		return -errno;
+	}
+
+	int yes = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+	struct sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	socklen_t addr_len = sizeof(addr);
+
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    ::listen(fd, 1) < 0 ||
+	    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0 ||
+	    getsockname(fd, (struct sockaddr *)&addr, &addr_len) < 0) {
+		int ret = -errno;
+		::close(fd);
+		return ret;
+	}
+
+	_local_port = ntohs(addr.sin_port);
+	_listen_fd = fd;
+	return 0;
+}
+
+int
+MavlinkTCP::connect(const struct sockaddr_in &remote_addr)
+{
+	close();
+
+	_remote_addr = remote_addr;
+	_client_mode = true;
+	_last_connect_attempt = 0;
+	return 0;
+}
+
+void
+MavlinkTCP::close()
+{
+	close_connection();
+
+	if (_listen_fd >= 0) {
+		::close(_listen_fd);
+		_listen_fd = -1;
+	}
+
+	_local_port = 0;
+	_client_mode = false;
+}
+
+int
+MavlinkTCP::setup_connection(int fd)
+{
+	int yes = 1;
+	int send_buffer_size = SOCKET_SEND_BUFFER_SIZE;
+
+	if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0) {
+		int ret = -errno;
+		::close(fd);
+
+		pthread_mutex_lock(&_mutex);
+
+		if (_fd == fd) {
+			_fd = -1;
+			_connecting = false;
+		}
+
+		pthread_mutex_unlock(&_mutex);
+		return ret;
+	}
+
+	/* packets are already collected per main loop iteration, do not delay them any further */
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+	/* keep the amount of data queued in the kernel small, so that the transmit buffer fills up
+	 * (and the stream rates are reduced) before the data gets stale */
+	setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &send_buffer_size, sizeof(send_buffer_size));
+
+#ifdef SO_NOSIGPIPE
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+#endif
+
+	pthread_mutex_lock(&_mutex);
+	_fd = fd;
+	_connecting = false;
+	_connected = true;
+	_peer_lost = false;
+	_tx_buffer_len = 0;
+	++_num_connections;
+	pthread_mutex_unlock(&_mutex);
+
+	return 0;
+}
+
+void
+MavlinkTCP::close_connection()
+{
+	pthread_mutex_lock(&_mutex);
+
+	if (_fd >= 0) {
+		::close(_fd);
+		_fd = -1;
+	}
+
+	_connecting = false;
+	_connected = false;
+	_peer_lost = false;
+	_tx_buffer_len = 0;
+	pthread_mutex_unlock(&_mutex);
+}
+
+void
+MavlinkTCP::poll_setup(struct pollfd &fds)
+{
+	if (_peer_lost) {
+		close_connection();
+	}
+
+	if (_client_mode && _fd < 0 &&
+	    (_last_connect_attempt == 0 || hrt_elapsed_time(&_last_connect_attempt) > RECONNECT_INTERVAL)) {
+
+		_last_connect_attempt = hrt_absolute_time();
+
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+		if (fd >= 0) {
+			if (fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK) < 0) {
+				::close(fd);
+
+			} else if (::connect(fd, (struct sockaddr *)&_remote_addr, sizeof(_remote_addr)) == 0) {
+				setup_connection(fd);
+
+			} else if (errno == EINPROGRESS) {
+				pthread_mutex_lock(&_mutex);
+				_fd = fd;
+				_connecting = true;
+				pthread_mutex_unlock(&_mutex);
+
+			} else {
+				::close(fd);
+			}
+		}
+	}
+
+	pthread_mutex_lock(&_mutex);
+
+	fds.revents = 0;
+
+	if (_fd >= 0) {
+		fds.fd = _fd;
+
+		if (_connecting) {
+			fds.events = POLLOUT;
+
+		} else {
+			fds.events = (_tx_buffer_len > 0) ? (POLLIN | POLLOUT) : POLLIN;
+		}
+
+	} else {
+		/* -1 in client mode, poll() then only waits for the timeout */
+		fds.fd = _listen_fd;
+		fds.events = POLLIN;
+	}
+
+	pthread_mutex_unlock(&_mutex);
+}
+
+ssize_t
+MavlinkTCP::receive(short revents, uint8_t *buf, size_t len)
+{
+	if (revents == 0) {
+		return 0;
+	}
+
+	if (_fd < 0) {
+		if (_listen_fd >= 0 && (revents & POLLIN)) {
+			socklen_t addr_len = sizeof(_remote_addr);
+			int fd = accept(_listen_fd, (struct sockaddr *)&_remote_addr, &addr_len);
+
+			if (fd >= 0) {
+				setup_connection(fd);
+			}
+		}
+
+		return 0;
+	}
+
+	if (_connecting) {
+		int error = 0;
+		socklen_t error_len = sizeof(error);
+
+		if (getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &error_len) == 0 && error == 0) {
+			setup_connection(_fd);
+
+		} else if (error != EINPROGRESS) {
+			close_connection();
+		}
+
+		return 0;
+	}
+
+	if (revents & POLLOUT) {
+		/* flush pending data */
+		send(nullptr, 0);
+	}
+
+	if (revents & (POLLIN | POLLERR | POLLHUP)) {
+		ssize_t nread = recv(_fd, buf, len, 0);
+
+		if (nread > 0) {
+			return nread;
+		}
+
+		if (nread == 0) {
+			/* closed by the peer */
+			close_connection();
+			return 0;
+		}
+
+		if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+			close_connection();
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+ssize_t
+MavlinkTCP::send(const struct iovec *iov, int iovcnt)
+{
+	if (iovcnt > MAX_SEND_IOV) {
+		return -1;
+	}
+
+	size_t len = 0;
+
+	for (int i = 0; i < iovcnt; ++i) {
+		len += iov[i].iov_len;
+	}
+
+	pthread_mutex_lock(&_mutex);
+
+	if (!_connected || _peer_lost) {
+		/* nobody to talk to */
+		pthread_mutex_unlock(&_mutex);
+		return len;
+	}
+
+	if (_tx_buffer_len + len > TX_BUFFER_SIZE) {
+		++_rejected_sends;
+		pthread_mutex_unlock(&_mutex);
+		return -1;
+	}
+
+	if (_tx_buffer_len + len == 0) {
+		pthread_mutex_unlock(&_mutex);
+		return 0;
+	}
+
+	/* pending data goes first, followed by the new data, all in one call */
+	struct iovec vec[MAX_SEND_IOV + 1];
+	int vec_count = 0;
+
+	if (_tx_buffer_len > 0) {
+		vec[vec_count].iov_base = _tx_buffer;
+		vec[vec_count].iov_len = _tx_buffer_len;
+		++vec_count;
+	}
+
+	for (int i = 0; i < iovcnt; ++i) {
+		vec[vec_count++] = iov[i];
+	}
+
+	struct msghdr msg = {};
+	msg.msg_iov = vec;
+	msg.msg_iovlen = vec_count;
+
+	ssize_t written = sendmsg(_fd, &msg, SEND_FLAGS);
+	++_send_calls;
+
+	if (written < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+			/* the receiving thread closes the connection */
+			_peer_lost = true;
+			pthread_mutex_unlock(&_mutex);
+			return -1;
+		}
+
+		written = 0;
+	}
+
+	_bytes_sent += written;
+
+	/* remove the sent data from the transmit buffer */
+	size_t done = written;
+
+	if (done < _tx_buffer_len) {
+		memmove(_tx_buffer, _tx_buffer + done, _tx_buffer_len - done);
+		_tx_buffer_len -= done;
+		done = 0;
+
+	} else {
+		done -= _tx_buffer_len;
+		_tx_buffer_len = 0;
+	}
+
+	/* and append what is left of the new data */
+	for (int i = 0; i < iovcnt; ++i) {
+		const size_t iov_len = iov[i].iov_len;
+
+		if (done >= iov_len) {
+			done -= iov_len;
+			continue;
+		}
+
+		memcpy(&_tx_buffer[_tx_buffer_len], (const uint8_t *)iov[i].iov_base + done, iov_len - done);
+		_tx_buffer_len += iov_len - done;
+		done = 0;
+	}
+
+	pthread_mutex_unlock(&_mutex);
+	return len;
+}
+
+size_t
+MavlinkTCP::tx_buffer_free()
+{
+	pthread_mutex_lock(&_mutex);
+	size_t ret = _connected ? TX_BUFFER_SIZE - _tx_buffer_len : TX_BUFFER_SIZE;
+	pthread_mutex_unlock(&_mutex);
+	return ret;
+}
+
+#endif /* __PX4_POSIX */
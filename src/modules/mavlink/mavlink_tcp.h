@@ -0,0 +1,161 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/**
+ * @file mavlink_tcp.h
+ * Non-blocking TCP transport for the MAVLink module.
+ *
+ * Either listens on a local port and serves one client at a time, or connects to a remote
+ * address and reconnects when the connection is lost. Outgoing packets are passed in as an
+ * iovec array and written together with any still pending data in a single gather write.
+ * Whatever the socket does not accept is kept in a transmit buffer, so packets are never
+ * split on the wire. The free space of that buffer is the backpressure signal for the
+ * stream rate control.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+
+#include <drivers/drv_hrt.h>
+
+class MavlinkTCP
+{
+public:
+	static constexpr size_t TX_BUFFER_SIZE = 16 * 1024;	///< user space transmit buffer [bytes]
+	static constexpr int MAX_SEND_IOV = 32;			///< max number of iovecs per send() call
+
+	MavlinkTCP();
+	~MavlinkTCP();
+
+	// no copy, moving or assignment
+	MavlinkTCP(const MavlinkTCP &) = delete;
+	MavlinkTCP &operator=(const MavlinkTCP &) = delete;
+
+	/**
+	 * Wait for clients on a local port (server mode).
+	 * @param port local port, 0 to let the OS pick one (see local_port())
+	 * @return 0 on success, -errno otherwise
+	 */
+	int listen(uint16_t port);
+
+	/**
+	 * Connect to a remote address (client mode). The connection is established
+	 * in the background, from update() and receive().
+	 * @return 0 on success, -errno otherwise
+	 */
+	int connect(const struct sockaddr_in &remote_addr);
+
+	/**
+	 * Close all sockets and drop pending data.
+	 */
+	void close();
+
+	/**
+	 * Set up the poll entry for the receiving thread: the connection if there is one, the
+	 * listening socket or the connection in progress otherwise. Also (re-)starts connection
+	 * attempts in client mode. fds.fd is set to -1 if there is nothing to wait for.
+	 */
+	void poll_setup(struct pollfd &fds);
+
+	/**
+	 * Handle the poll result: accept a new client, complete a pending connect, flush
+	 * pending data and read received data.
+	 * @param revents the returned events of the poll entry set up by poll_setup()
+	 * @return number of bytes read into buf, 0 if none, -1 on error
+	 */
+	ssize_t receive(short revents, uint8_t *buf, size_t len);
+
+	/**
+	 * Send the data in iov as a whole: either everything is sent or buffered, or nothing.
+	 * Without a connection the data is discarded. Calling it with iovcnt = 0 only flushes
+	 * pending data.
+	 * @return number of bytes accepted, -1 if there is not enough buffer space (or on error)
+	 */
+	ssize_t send(const struct iovec *iov, int iovcnt);
+
+	/**
+	 * Free transmit buffer space [bytes]. This is the amount of data that can be passed
+	 * to send() without being rejected.
+	 */
+	size_t tx_buffer_free();
+
+	bool connected() const { return _connected; }
+
+	bool server_mode() const { return _listen_fd >= 0; }
+
+	/** local port of the listening socket, 0 if not in server mode */
+	uint16_t local_port() const { return _local_port; }
+
+	const struct sockaddr_in &remote_addr() const { return _remote_addr; }
+
+	/** statistics (not reset) */
+	uint64_t bytes_sent() const { return _bytes_sent; }
+	uint32_t send_calls() const { return _send_calls; }
+	uint32_t rejected_sends() const { return _rejected_sends; }
+	uint32_t num_connections() const { return _num_connections; }
+
+private:
+	static constexpr hrt_abstime RECONNECT_INTERVAL = 1000000;	///< [us]
+	static constexpr int SOCKET_SEND_BUFFER_SIZE = 32 * 1024;	///< bounds the latency of queued data
+
+	int setup_connection(int fd);
+	void close_connection();
+
+	pthread_mutex_t _mutex;		///< protects the connection state and the transmit buffer
+
+	int _listen_fd{-1};
+	int _fd{-1};			///< connection (or connection in progress)
+	bool _connecting{false};
+	volatile bool _connected{false};
+	bool _client_mode{false};
+	bool _peer_lost{false};		///< sending failed, the receiving thread closes the connection
+
+	uint16_t _local_port{0};
+	struct sockaddr_in _remote_addr {};
+	hrt_abstime _last_connect_attempt{0};
+
+	uint8_t _tx_buffer[TX_BUFFER_SIZE];
+	size_t _tx_buffer_len{0};
+
+	uint64_t _bytes_sent{0};
+	uint32_t _send_calls{0};
+	uint32_t _rejected_sends{0};
+	uint32_t _num_connections{0};
+};
@@ -38,6 +38,7 @@
 #include <crc32.h>
 #include <stdio.h>
 #include <fcntl.h>
+#include <unit_test_helpers.h>
 
 #include "mavlink_ftp_test.h"
 #include "../mavlink_ftp.h"
@@ -585,6 +586,283 @@ bool MavlinkFtpTest::_burst_test()
 	return true;
 }
 
+/// @brief Tests that a burst returns the current file contents if the file was written since the
+/// previous burst of the same session
+bool MavlinkFtpTest::_burst_rewrite_test()
+{
+	MavlinkFTP::PayloadHeader		payload;
+	const MavlinkFTP::PayloadHeader		*reply;
+	BurstInfo				burst_info;
+	int					fd;
+
+	// Two full packets: the server reads the whole file at once and has nothing to read again at the end
+	const uint32_t file_size = 2 * (MAVLINK_MSG_FILE_TRANSFER_PROTOCOL_FIELD_PAYLOAD_LEN - sizeof(MavlinkFTP::PayloadHeader));
+	uint8_t bytes[file_size];
+
+	memset(bytes, 0x11, file_size);
+	ut_compare("mkdir failed", ::mkdir(_unittest_microsd_dir, S_IRWXU | S_IRWXG | S_IRWXO), 0);
+	ut_assert("open failed", (fd = ::open(_unittest_microsd_file, O_CREAT | O_EXCL | O_WRONLY, S_IRWXU | S_IRWXG | S_IRWXO)) != -1);
+	ut_compare("write failed", ::write(fd, bytes, file_size), (ssize_t)file_size);
+	::close(fd);
+
+	payload.opcode = MavlinkFTP::kCmdOpenFileRO;
+	payload.offset = 0;
+
+	bool success = _send_receive_msg(&payload,		// FTP payload header
+					 strlen(_unittest_microsd_file) + 1,	// size in bytes of data
+					 (uint8_t *)_unittest_microsd_file,	// Data to start into FTP message payload
+					 &reply);		// Payload inside FTP message response
+
+	if (!success) {
+		return false;
+	}
+
+	ut_compare("Didn't get Ack back", reply->opcode, MavlinkFTP::kRspAck);
+	const uint8_t session = reply->session;
+
+	for (int i = 0; i < 2; i++) {
+		if (i > 0) {
+			// Rewrite the file between the bursts
+			memset(bytes, 0x22, file_size);
+			ut_assert("open failed", (fd = ::open(_unittest_microsd_file, O_WRONLY)) != -1);
+			ut_compare("write failed", ::write(fd, bytes, file_size), (ssize_t)file_size);
+			::close(fd);
+		}
+
+		burst_info.burst_state = burst_state_first_ack;
+		burst_info.single_packet_file = false;
+		burst_info.file_size = file_size;
+		burst_info.file_bytes = bytes;
+		burst_info.ftp_test_class = this;
+		_ftp_server->set_unittest_worker(MavlinkFtpTest::receive_message_handler_burst, &burst_info);
+
+		payload.opcode = MavlinkFTP::kCmdBurstReadFile;
+		payload.session = session;
+		payload.offset = 0;
+
+		mavlink_message_t msg;
+		_setup_ftp_msg(&payload, 0, nullptr, &msg);
+		_ftp_server->handle_message(&msg);
+
+		hrt_abstime t = 0;
+		_ftp_server->send(t);
+
+		ut_compare("Incorrect sequence of messages", burst_info.burst_state, burst_state_complete);
+	}
+
+	_ftp_server->set_unittest_worker(MavlinkFtpTest::receive_message_handler_generic, this);
+
+	payload.opcode = MavlinkFTP::kCmdTerminateSession;
+	payload.session = session;
+	payload.size = 0;
+
+	success = _send_receive_msg(&payload, 0, nullptr, &reply);
+
+	if (!success) {
+		return false;
+	}
+
+	ut_compare("Didn't get Ack back", reply->opcode, MavlinkFTP::kRspAck);
+
+	return true;
+}
+
+/// @brief Downloads a large file with burst reads in one and in several concurrent sessions, and with
+/// one Read command per packet for comparison
+bool MavlinkFtpTest::_burst_throughput_test()
+{
+	MavlinkFTP::PayloadHeader		payload;
+	const MavlinkFTP::PayloadHeader		*reply;
+	ThroughputInfo				throughput_info;
+	int					fd;
+
+	uint8_t *bytes = new uint8_t[_throughput_file_size];
+	ut_assert("new failed", bytes != nullptr);
+
+	UnitTestRandom rng(1);
+
+	for (uint32_t i = 0; i < _throughput_file_size; i++) {
+		bytes[i] = rng.next() >> 24;
+	}
+
+	ut_compare("mkdir failed", ::mkdir(_unittest_microsd_dir, S_IRWXU | S_IRWXG | S_IRWXO), 0);
+	ut_assert("open failed", (fd = ::open(_unittest_microsd_file, O_CREAT | O_EXCL | O_WRONLY, S_IRWXU | S_IRWXG | S_IRWXO)) != -1);
+	ut_compare("write failed", ::write(fd, bytes, _throughput_file_size), (ssize_t)_throughput_file_size);
+	::close(fd);
+
+	throughput_info.ftp_test_class = this;
+	throughput_info.file_bytes = bytes;
+	throughput_info.file_size = _throughput_file_size;
+
+	const uint8_t session_counts[] = {1, MavlinkFTP::kMaxSessions};
+
+	for (uint8_t num_sessions : session_counts) {
+		const hrt_abstime elapsed = _burst_read_sessions(num_sessions, &throughput_info);
+
+		if (elapsed == 0) {
+			delete[] bytes;
+			return false;
+		}
+
+		PX4_INFO("burst read, %d session(s): %u bytes in %u bursts, %.1f MB/s", num_sessions,
+			 num_sessions * _throughput_file_size, throughput_info.bursts,
+			 (double)(num_sessions * _throughput_file_size) / (elapsed > 0 ? elapsed : 1));
+
+		ut_assert("Bursts too small", throughput_info.bursts <= num_sessions * (_throughput_file_size / 35000 + 1));
+	}
+
+	// One Read command per packet
+	payload.opcode = MavlinkFTP::kCmdOpenFileRO;
+	payload.offset = 0;
+
+	bool success = _send_receive_msg(&payload,		// FTP payload header
+					 strlen(_unittest_microsd_file) + 1,	// size in bytes of data
+					 (uint8_t *)_unittest_microsd_file,	// Data to start into FTP message payload
+					 &reply);		// Payload inside FTP message response
+
+	if (!success) {
+		delete[] bytes;
+		return false;
+	}
+
+	ut_compare("Didn't get Ack back", reply->opcode, MavlinkFTP::kRspAck);
+
+	payload.opcode = MavlinkFTP::kCmdReadFile;
+	payload.session = reply->session;
+	uint32_t offset = 0;
+	hrt_abstime start = hrt_absolute_time();
+
+	while (offset < _throughput_file_size) {
+		payload.offset = offset;
+
+		success = _send_receive_msg(&payload, 0, nullptr, &reply);
+
+		if (!success || reply->opcode != MavlinkFTP::kRspAck || reply->size == 0
+		    || memcmp(reply->data, &bytes[offset], reply->size) != 0) {
+			delete[] bytes;
+			ut_assert("Read failed", false);
+		}
+
+		offset += reply->size;
+	}
+
+	const hrt_abstime elapsed = hrt_elapsed_time(&start);
+	PX4_INFO("read commands: %u bytes, %.1f MB/s", _throughput_file_size,
+		 (double)_throughput_file_size / (elapsed > 0 ? elapsed : 1));
+
+	delete[] bytes;
+
+	payload.opcode = MavlinkFTP::kCmdTerminateSession;
+	payload.size = 0;
+
+	success = _send_receive_msg(&payload, 0, nullptr, &reply);
+
+	if (!success) {
+		return false;
+	}
+
+	ut_compare("Didn't get Ack back", reply->opcode, MavlinkFTP::kRspAck);
+
+	return true;
+}
+
+hrt_abstime MavlinkFtpTest::_burst_read_sessions(uint8_t num_sessions, ThroughputInfo *throughput_info)
+{
+	MavlinkFTP::PayloadHeader		payload;
+	const MavlinkFTP::PayloadHeader		*reply;
+	uint8_t					sessions[MavlinkFTP::kMaxSessions];
+
+	// Open all the sessions on the same file
+	for (uint8_t i = 0; i < num_sessions; i++) {
+		payload.opcode = MavlinkFTP::kCmdOpenFileRO;
+		payload.offset = 0;
+
+		bool success = _send_receive_msg(&payload,		// FTP payload header
+						 strlen(_unittest_microsd_file) + 1,	// size in bytes of data
+						 (uint8_t *)_unittest_microsd_file,	// Data to start into FTP message payload
+						 &reply);		// Payload inside FTP message response
+
+		if (!success || reply->opcode != MavlinkFTP::kRspAck) {
+			ut_assert("Open failed", false);
+		}
+
+		sessions[i] = reply->session;
+	}
+
+	for (uint8_t i = 0; i < MavlinkFTP::kMaxSessions; i++) {
+		throughput_info->next_offset[i] = 0;
+		throughput_info->request_burst[i] = false;
+		throughput_info->done[i] = true;
+	}
+
+	for (uint8_t i = 0; i < num_sessions; i++) {
+		throughput_info->request_burst[sessions[i]] = true;
+		throughput_info->done[sessions[i]] = false;
+	}
+
+	throughput_info->bursts = 0;
+	throughput_info->errors = 0;
+	_ftp_server->set_unittest_worker(MavlinkFtpTest::receive_message_handler_throughput, throughput_info);
+
+	hrt_abstime start = hrt_absolute_time();
+	bool all_done = false;
+
+	while (!all_done && throughput_info->errors == 0) {
+		// Request the next burst of each session which completed one, like a GCS would
+		for (uint8_t i = 0; i < num_sessions; i++) {
+			if (throughput_info->request_burst[sessions[i]]) {
+				throughput_info->request_burst[sessions[i]] = false;
+				throughput_info->bursts++;
+
+				payload.opcode = MavlinkFTP::kCmdBurstReadFile;
+				payload.session = sessions[i];
+				payload.offset = throughput_info->next_offset[sessions[i]];
+
+				mavlink_message_t msg;
+				_setup_ftp_msg(&payload, 0, nullptr, &msg);
+				_ftp_server->handle_message(&msg);
+			}
+		}
+
+		_ftp_server->send(hrt_absolute_time());
+
+		all_done = true;
+		bool waiting = false;
+
+		for (uint8_t i = 0; i < num_sessions; i++) {
+			all_done = all_done && throughput_info->done[sessions[i]];
+			waiting = waiting || throughput_info->request_burst[sessions[i]];
+		}
+
+		// the server stopped sending without completing a burst
+		if (!all_done && !waiting && _ftp_server->get_size() == 0) {
+			throughput_info->errors++;
+		}
+	}
+
+	const hrt_abstime elapsed = hrt_elapsed_time(&start);
+
+	// Put back generic message handler
+	_ftp_server->set_unittest_worker(MavlinkFtpTest::receive_message_handler_generic, this);
+
+	ut_compare("Burst download failed", throughput_info->errors, 0);
+	ut_compare("Remaining stream packets", _ftp_server->get_size(), 0);
+
+	for (uint8_t i = 0; i < num_sessions; i++) {
+		payload.opcode = MavlinkFTP::kCmdTerminateSession;
+		payload.session = sessions[i];
+		payload.size = 0;
+
+		bool success = _send_receive_msg(&payload, 0, nullptr, &reply);
+
+		if (!success || reply->opcode != MavlinkFTP::kRspAck) {
+			ut_assert("Terminate failed", false);
+		}
+	}
+
+	return elapsed > 0 ? elapsed : 1;
+}
+
 /// @brief Tests for correct reponse to a Read command on an invalid session.
 bool MavlinkFtpTest::_read_badsession_test()
 {
@@ -862,6 +1140,58 @@ bool MavlinkFtpTest::_receive_message_handler_burst(const mavlink_file_transfer_
 	return true;
 }
 
+/// Static method used as callback from MavlinkFTP for the burst throughput test.
+void MavlinkFtpTest::receive_message_handler_throughput(const mavlink_file_transfer_protocol_t *ftp_req,
+		void *worker_data)
+{
+	ThroughputInfo *throughput_info = (ThroughputInfo *)worker_data;
+	throughput_info->ftp_test_class->_receive_message_handler_throughput(ftp_req, throughput_info);
+}
+
+void MavlinkFtpTest::_receive_message_handler_throughput(const mavlink_file_transfer_protocol_t *ftp_msg,
+		ThroughputInfo *throughput_info)
+{
+	const MavlinkFTP::PayloadHeader *reply = reinterpret_cast<const MavlinkFTP::PayloadHeader *>(ftp_msg->payload);
+	const uint8_t session = reply->session;
+
+	// The sessions are numbered independently: continue with the highest sequence number seen, so that
+	// the next request is not taken for a resent one
+	if ((uint16_t)(reply->seq_number + 1 - _expected_seq_number) < 0x8000) {
+		_expected_seq_number = reply->seq_number + 1;
+	}
+
+	if (session >= MavlinkFTP::kMaxSessions || throughput_info->done[session]
+	    || reply->req_opcode != MavlinkFTP::kCmdBurstReadFile) {
+		throughput_info->errors++;
+		return;
+	}
+
+	if (reply->opcode == MavlinkFTP::kRspNak) {
+		// the file ends after the last packet of a burst
+		if (reply->data[0] == MavlinkFTP::kErrEOF && throughput_info->next_offset[session] == throughput_info->file_size) {
+			throughput_info->done[session] = true;
+
+		} else {
+			throughput_info->errors++;
+		}
+
+		return;
+	}
+
+	if (reply->offset != throughput_info->next_offset[session]
+	    || reply->offset + reply->size > throughput_info->file_size
+	    || memcmp(reply->data, &throughput_info->file_bytes[reply->offset], reply->size) != 0) {
+		throughput_info->errors++;
+		return;
+	}
+
+	throughput_info->next_offset[session] += reply->size;
+
+	if (reply->burst_complete) {
+		throughput_info->request_burst[session] = true;
+	}
+}
+
 /// @brief Decode and validate the incoming message
 bool MavlinkFtpTest::_decode_message(const mavlink_file_transfer_protocol_t	*ftp_msg,	///< Incoming FTP message
 				     const MavlinkFTP::PayloadHeader		**payload)	///< Payload inside FTP message response
@@ -952,6 +1282,8 @@ bool MavlinkFtpTest::run_tests()
 	ut_run_test(_read_test);
 	ut_run_test(_read_badsession_test);
 	ut_run_test(_burst_test);
+	ut_run_test(_burst_rewrite_test);
+	ut_run_test(_burst_throughput_test);
 	ut_run_test(_removedirectory_test);
 
 	// TODO FIX: Didn't get Nak back - (reply->opcode:128) (MavlinkFTP::kRspNak:129) (../../src/modules/mavlink/mavlink_tests/mavlink_ftp_test.cpp:730)
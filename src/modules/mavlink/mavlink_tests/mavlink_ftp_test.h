@@ -61,6 +61,20 @@ public:
 
 	static void receive_message_handler_burst(const mavlink_file_transfer_protocol_t *ftp_req, void *worker_data);
 
+	/// Worker data for the burst throughput test
+	struct ThroughputInfo {
+		MavlinkFtpTest		*ftp_test_class;
+		const uint8_t		*file_bytes;
+		uint32_t		file_size;
+		uint32_t		next_offset[MavlinkFTP::kMaxSessions];	///< next expected offset of each session
+		bool			request_burst[MavlinkFTP::kMaxSessions];	///< burst complete, the next one is due
+		bool			done[MavlinkFTP::kMaxSessions];		///< EOF received
+		unsigned		bursts;
+		unsigned		errors;
+	};
+
+	static void receive_message_handler_throughput(const mavlink_file_transfer_protocol_t *ftp_req, void *worker_data);
+
 	static const uint8_t serverSystemId = 50;	///< System ID for server
 	static const uint8_t serverComponentId = 1;	///< Component ID for server
 	static const uint8_t serverChannel = 0;		///< Channel to send to
@@ -87,6 +101,8 @@ private:
 	bool _read_test(void);
 	bool _read_badsession_test(void);
 	bool _burst_test(void);
+	bool _burst_rewrite_test(void);
+	bool _burst_throughput_test(void);
 	bool _removedirectory_test(void);
 	bool _createdirectory_test(void);
 	bool _removefile_test(void);
@@ -121,6 +137,12 @@ private:
 	};
 
 	bool _receive_message_handler_burst(const mavlink_file_transfer_protocol_t *ftp_req, BurstInfo *burst_info);
+	void _receive_message_handler_throughput(const mavlink_file_transfer_protocol_t *ftp_req,
+			ThroughputInfo *throughput_info);
+
+	/// Burst reads the file of the throughput test in num_sessions sessions at once
+	///	@return time it took [us], 0 on failure
+	hrt_abstime _burst_read_sessions(uint8_t num_sessions, ThroughputInfo *throughput_info);
 
 	MavlinkFTP	*_ftp_server;
 	uint16_t	_expected_seq_number;
@@ -129,6 +151,13 @@ private:
 
 	static const char _unittest_microsd_dir[];
 	static const char _unittest_microsd_file[];
+
+	/// Size of the file downloaded by the throughput test
+#ifdef __PX4_NUTTX
+	static const uint32_t _throughput_file_size = 64 * 1024;
+#else
+	static const uint32_t _throughput_file_size = 1024 * 1024;
+#endif
 };
 
 bool mavlink_ftp_test(void);
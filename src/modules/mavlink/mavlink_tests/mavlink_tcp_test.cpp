@@ -0,0 +1,411 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/// @file mavlink_tcp_test.cpp
+///	@brief Tests of the MAVLink TCP transport over loopback: connection handling, framing under
+///	backpressure, throughput and round trip latency.
+
+#include <arpa/inet.h>
+#include <string.h>
+
+#include <drivers/drv_hrt.h>
+
+#include "mavlink_tcp_test.h"
+
+#ifdef __PX4_POSIX
+
+namespace
+{
+
+/// Reassembles the byte stream into fixed size packets and checks their content and order
+class StreamChecker
+{
+public:
+	StreamChecker(uint16_t packet_len) : _packet_len(packet_len) {}
+
+	void feed(const uint8_t *data, size_t len)
+	{
+		while (len > 0) {
+			size_t n = _packet_len - _fill;
+
+			if (n > len) {
+				n = len;
+			}
+
+			memcpy(&_packet[_fill], data, n);
+			_fill += n;
+			data += n;
+			len -= n;
+
+			if (_fill == _packet_len) {
+				uint8_t expected[sizeof(_packet)];
+				fill_packet(expected, _packet_len, _packets);
+
+				if (memcmp(expected, _packet, _packet_len) != 0) {
+					_corrupt = true;
+				}
+
+				++_packets;
+				_fill = 0;
+			}
+		}
+	}
+
+	static void fill_packet(uint8_t *packet, uint16_t len, uint32_t seq)
+	{
+		memcpy(packet, &seq, sizeof(seq));
+
+		for (uint16_t i = sizeof(seq); i < len; ++i) {
+			packet[i] = (uint8_t)(seq * 31 + i);
+		}
+	}
+
+	uint32_t packets() const { return _packets; }
+	bool corrupt() const { return _corrupt; }
+	bool partial() const { return _fill != 0; }
+
+private:
+	const uint16_t _packet_len;
+	uint8_t _packet[280];
+	size_t _fill{0};
+	uint32_t _packets{0};
+	bool _corrupt{false};
+};
+
+}
+
+void MavlinkTcpTest::_fill_packet(uint8_t *packet, uint16_t len, uint32_t seq)
+{
+	StreamChecker::fill_packet(packet, len, seq);
+}
+
+void MavlinkTcpTest::_init()
+{
+	_server = new MavlinkTCP();
+	_client = new MavlinkTCP();
+}
+
+void MavlinkTcpTest::_cleanup()
+{
+	delete _client;
+	_client = nullptr;
+	delete _server;
+	_server = nullptr;
+}
+
+ssize_t MavlinkTcpTest::_pump(MavlinkTCP *tcp, uint8_t *buf, size_t len, int timeout_ms)
+{
+	struct pollfd fds = {};
+	tcp->poll_setup(fds);
+
+	if (poll(&fds, 1, timeout_ms) <= 0) {
+		return 0;
+	}
+
+	return tcp->receive(fds.revents, buf, len);
+}
+
+bool MavlinkTcpTest::_connect()
+{
+	if (_server->listen(0) != 0) {
+		return false;
+	}
+
+	struct sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(_server->local_port());
+	_client->connect(addr);
+
+	uint8_t buf[16];
+
+	for (int i = 0; i < 100 && !(_server->connected() && _client->connected()); ++i) {
+		_pump(_client, buf, sizeof(buf), 10);
+		_pump(_server, buf, sizeof(buf), 10);
+	}
+
+	return _server->connected() && _client->connected();
+}
+
+bool MavlinkTcpTest::_connect_test()
+{
+	// without a connection everything is discarded and nothing is rejected
+	uint8_t packet[_packet_len];
+	_fill_packet(packet, _packet_len, 0);
+	struct iovec iov = { packet, _packet_len };
+	ut_compare("send without connection", _client->send(&iov, 1), _packet_len);
+	ut_compare("tx buffer free without connection", _client->tx_buffer_free(), MavlinkTCP::TX_BUFFER_SIZE);
+
+	ut_assert("connect", _connect());
+	ut_assert("server mode", _server->server_mode());
+	ut_assert("client mode", !_client->server_mode());
+	ut_compare("server connections", _server->num_connections(), 1);
+	ut_compare("client connections", _client->num_connections(), 1);
+
+	return true;
+}
+
+bool MavlinkTcpTest::_reconnect_test()
+{
+	ut_assert("connect", _connect());
+
+	uint8_t buf[64];
+	const uint16_t port = _server->local_port();
+
+	// client goes away: the server waits for the next one
+	delete _client;
+	_client = new MavlinkTCP();
+
+	for (int i = 0; i < 100 && _server->connected(); ++i) {
+		_pump(_server, buf, sizeof(buf), 10);
+	}
+
+	ut_assert("server noticed disconnect", !_server->connected());
+	ut_compare("server still listening", _server->local_port(), port);
+
+	struct sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons(port);
+	_client->connect(addr);
+
+	for (int i = 0; i < 100 && !(_server->connected() && _client->connected()); ++i) {
+		_pump(_client, buf, sizeof(buf), 10);
+		_pump(_server, buf, sizeof(buf), 10);
+	}
+
+	ut_assert("server accepted new client", _server->connected() && _client->connected());
+	ut_compare("server connections", _server->num_connections(), 2);
+
+	// server goes away: the client reconnects once it is back
+	_server->close();
+
+	for (int i = 0; i < 100 && _client->connected(); ++i) {
+		_pump(_client, buf, sizeof(buf), 10);
+	}
+
+	ut_assert("client noticed disconnect", !_client->connected());
+	ut_compare("listen again", _server->listen(port), 0);
+
+	// reconnection attempts are rate limited to one per second
+	for (int i = 0; i < 300 && !(_server->connected() && _client->connected()); ++i) {
+		_pump(_client, buf, sizeof(buf), 10);
+		_pump(_server, buf, sizeof(buf), 0);
+	}
+
+	ut_assert("client reconnected", _server->connected() && _client->connected());
+	ut_compare("client connections", _client->num_connections(), 2);
+
+	return true;
+}
+
+bool MavlinkTcpTest::_backpressure_test()
+{
+	ut_assert("connect", _connect());
+
+	static constexpr int batch_size = 8;
+	uint8_t batch[batch_size][_packet_len];
+	struct iovec iov[batch_size];
+	uint32_t seq = 0;
+
+	// nobody reads on the other side: fill the socket and then the transmit buffer
+	for (int i = 0; i < 100000; ++i) {
+		for (int j = 0; j < batch_size; ++j) {
+			_fill_packet(batch[j], _packet_len, seq + j);
+			iov[j].iov_base = batch[j];
+			iov[j].iov_len = _packet_len;
+		}
+
+		if (_client->send(iov, batch_size) < 0) {
+			break;
+		}
+
+		seq += batch_size;
+	}
+
+	ut_compare("rejected sends", _client->rejected_sends(), 1);
+	ut_less_than("tx buffer full", _client->tx_buffer_free(), batch_size * _packet_len);
+
+	// rejected data is not sent at all, the rest arrives complete and in order
+	StreamChecker checker(_packet_len);
+	uint8_t buf[4096];
+
+	for (int i = 0; i < 10000 && checker.packets() < seq; ++i) {
+		_pump(_client, buf, sizeof(buf), 0);
+		ssize_t nread = _pump(_server, buf, sizeof(buf), 1);
+
+		if (nread > 0) {
+			checker.feed(buf, nread);
+		}
+	}
+
+	ut_compare("packets received", checker.packets(), seq);
+	ut_assert("packets intact and in order", !checker.corrupt());
+	ut_assert("no partial packet", !checker.partial());
+	ut_compare("tx buffer empty", _client->tx_buffer_free(), MavlinkTCP::TX_BUFFER_SIZE);
+
+	return true;
+}
+
+bool MavlinkTcpTest::_throughput_test()
+{
+	ut_assert("connect", _connect());
+
+	// the sender defers sending when the buffer is full, like the mavlink streams do
+	static constexpr int batch_size = 32;
+	static constexpr hrt_abstime duration = 1000000;
+	uint8_t batch[batch_size][_packet_len];
+	struct iovec iov[batch_size];
+	uint32_t seq = 0;
+
+	StreamChecker checker(_packet_len);
+	static uint8_t buf[64 * 1024];
+
+	const hrt_abstime start = hrt_absolute_time();
+
+	while (hrt_elapsed_time(&start) < duration) {
+		if (_client->tx_buffer_free() >= batch_size * _packet_len) {
+			for (int j = 0; j < batch_size; ++j) {
+				_fill_packet(batch[j], _packet_len, seq + j);
+				iov[j].iov_base = batch[j];
+				iov[j].iov_len = _packet_len;
+			}
+
+			ut_compare("send", _client->send(iov, batch_size), batch_size * _packet_len);
+			seq += batch_size;
+
+		} else {
+			_pump(_client, buf, sizeof(buf), 0);
+		}
+
+		ssize_t nread = _pump(_server, buf, sizeof(buf), 0);
+
+		if (nread > 0) {
+			checker.feed(buf, nread);
+		}
+	}
+
+	for (int i = 0; i < 10000 && checker.packets() < seq; ++i) {
+		_pump(_client, buf, sizeof(buf), 0);
+		ssize_t nread = _pump(_server, buf, sizeof(buf), 1);
+
+		if (nread > 0) {
+			checker.feed(buf, nread);
+		}
+	}
+
+	const float elapsed_s = hrt_elapsed_time(&start) * 1e-6f;
+
+	PX4_INFO("throughput: %.1f MB/s, %.0f msgs/s, %.1f msgs per send call",
+		 (double)(seq * _packet_len / elapsed_s / 1e6f), (double)(seq / elapsed_s),
+		 (double)seq / _client->send_calls());
+
+	ut_compare("packets received", checker.packets(), seq);
+	ut_assert("packets intact and in order", !checker.corrupt());
+	ut_compare("rejected sends", _client->rejected_sends(), 0);
+
+	return true;
+}
+
+bool MavlinkTcpTest::_latency_test()
+{
+	ut_assert("connect", _connect());
+
+	// ping-pong of single heartbeat sized packets
+	static constexpr uint16_t len = 21;
+	static constexpr int num_round_trips = 1000;
+	uint8_t packet[len];
+	uint8_t buf[len];
+	struct iovec iov = { packet, len };
+	StreamChecker server_checker(len);
+	StreamChecker client_checker(len);
+
+	hrt_abstime rtt_sum = 0;
+	hrt_abstime rtt_max = 0;
+
+	for (int i = 0; i < num_round_trips; ++i) {
+		const hrt_abstime start = hrt_absolute_time();
+		_fill_packet(packet, len, i);
+		ut_compare("ping", _client->send(&iov, 1), len);
+
+		while (server_checker.packets() == (uint32_t)i && hrt_elapsed_time(&start) < 1000000) {
+			ssize_t nread = _pump(_server, buf, sizeof(buf), 10);
+
+			if (nread > 0) {
+				server_checker.feed(buf, nread);
+			}
+		}
+
+		ut_compare("pong", _server->send(&iov, 1), len);
+
+		while (client_checker.packets() == (uint32_t)i && hrt_elapsed_time(&start) < 1000000) {
+			ssize_t nread = _pump(_client, buf, sizeof(buf), 10);
+
+			if (nread > 0) {
+				client_checker.feed(buf, nread);
+			}
+		}
+
+		const hrt_abstime rtt = hrt_elapsed_time(&start);
+		rtt_sum += rtt;
+
+		if (rtt > rtt_max) {
+			rtt_max = rtt;
+		}
+	}
+
+	PX4_INFO("round trip time: mean %.1f us, max %llu us", (double)rtt_sum / num_round_trips,
+		 (unsigned long long)rtt_max);
+
+	ut_compare("pings received", server_checker.packets(), num_round_trips);
+	ut_compare("pongs received", client_checker.packets(), num_round_trips);
+	ut_assert("packets intact", !server_checker.corrupt() && !client_checker.corrupt());
+
+	return true;
+}
+
+bool MavlinkTcpTest::run_tests()
+{
+	ut_run_test(_connect_test);
+	ut_run_test(_reconnect_test);
+	ut_run_test(_backpressure_test);
+	ut_run_test(_throughput_test);
+	ut_run_test(_latency_test);
+
+	return (_tests_failed == 0);
+}
+
+ut_declare_test(mavlink_tcp_test, MavlinkTcpTest)
+
+#endif /* __PX4_POSIX */
@@ -0,0 +1,80 @@
+/****************************************************************************
+ *
+ *   Copyright (C) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/// @file mavlink_tcp_test.h
+///	@brief Tests of the MAVLink TCP transport over loopback
+
+#pragma once
+
+#include <unit_test.h>
+#include "../mavlink_tcp.h"
+
+class MavlinkTcpTest : public UnitTest
+{
+public:
+	MavlinkTcpTest() = default;
+	virtual ~MavlinkTcpTest() = default;
+
+	virtual bool run_tests(void);
+
+	// We don't want any of these
+	MavlinkTcpTest(const MavlinkTcpTest &) = delete;
+	MavlinkTcpTest &operator=(const MavlinkTcpTest &) = delete;
+
+private:
+	virtual void _init(void);
+	virtual void _cleanup(void);
+
+	bool _connect_test(void);
+	bool _reconnect_test(void);
+	bool _backpressure_test(void);
+	bool _throughput_test(void);
+	bool _latency_test(void);
+
+	/// Connect _client to _server
+	bool _connect(void);
+
+	/// Poll one end of the connection and receive into buf
+	ssize_t _pump(MavlinkTCP *tcp, uint8_t *buf, size_t len, int timeout_ms);
+
+	/// Fill a test packet: length, sequence number and a pattern derived from both
+	static void _fill_packet(uint8_t *packet, uint16_t len, uint32_t seq);
+
+	static constexpr uint16_t _packet_len = 280;	///< MAVLINK_MAX_PACKET_LEN
+
+	MavlinkTCP	*_server{nullptr};
+	MavlinkTCP	*_client{nullptr};
+};
+
+bool mavlink_tcp_test(void);
@@ -38,10 +38,19 @@
 #include <systemlib/err.h>
 
 #include "mavlink_ftp_test.h"
+#ifdef __PX4_POSIX
+#include "mavlink_tcp_test.h"
+#endif
 
 extern "C" __EXPORT int mavlink_tests_main(int argc, char *argv[]);
 
 int mavlink_tests_main(int argc, char *argv[])
 {
-	return mavlink_ftp_test() ? 0 : -1;
+	bool passed = mavlink_ftp_test();
+
+#ifdef __PX4_POSIX
+	passed = mavlink_tcp_test() && passed;
+#endif
+
+	return passed ? 0 : -1;
 }
@@ -66,6 +66,8 @@ Geofence::~Geofence()
 	if (_polygons) {
 		delete[](_polygons);
 	}
+
+	delete[] _polygon_shapes;
 }
 
 void Geofence::updateFence()
@@ -175,6 +177,91 @@ void Geofence::_updateFence()
 
 	}
 
+	_loadShapes();
+}
+
+void Geofence::_loadShapes()
+{
+	delete[] _polygon_shapes;
+	_polygon_shapes = nullptr;
+
+	if (_num_polygons == 0) {
+		return;
+	}
+
+	_polygon_shapes = new GeofencePolygon[_num_polygons];
+
+	if (!_polygon_shapes) {
+		_num_polygons = 0;
+		PX4_ERR("alloc failed");
+		return;
+	}
+
+	map_projection_init(&_projection_reference, 0.0, 0.0);
+	bool have_reference = false;
+
+	for (int polygon_idx = 0; polygon_idx < _num_polygons; ++polygon_idx) {
+		PolygonInfo &polygon = _polygons[polygon_idx];
+		const bool is_circle = polygon.fence_type == NAV_CMD_FENCE_CIRCLE_INCLUSION
+				       || polygon.fence_type == NAV_CMD_FENCE_CIRCLE_EXCLUSION;
+		const uint16_t vertex_count = is_circle ? 1 : polygon.vertex_count;
+		bool valid = true;
+
+		if (!is_circle && !_polygon_shapes[polygon_idx].init(vertex_count)) {
+			PX4_ERR("alloc failed");
+			continue;
+		}
+
+		for (uint16_t i = 0; i < vertex_count; ++i) {
+			mission_fence_point_s vertex;
+
+			if (dm_read(DM_KEY_FENCE_POINTS, polygon.dataman_index + i, &vertex,
+				    sizeof(mission_fence_point_s)) != sizeof(mission_fence_point_s)) {
+				PX4_ERR("dm_read failed");
+				valid = false;
+				break;
+			}
+
+			if (vertex.frame != NAV_FRAME_GLOBAL && vertex.frame != NAV_FRAME_GLOBAL_INT
+			    && vertex.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT
+			    && vertex.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
+				// TODO: handle different frames
+				PX4_ERR("Frame type %i not supported", (int)vertex.frame);
+				valid = false;
+				break;
+			}
+
+			// all shapes share the same reference, so that they can be checked with a single projection
+			if (!have_reference) {
+				map_projection_init(&_projection_reference, vertex.lat, vertex.lon);
+				have_reference = true;
+			}
+
+			float x, y;
+			map_projection_project(&_projection_reference, vertex.lat, vertex.lon, &x, &y);
+
+			if (is_circle) {
+				polygon.circle_x = x;
+				polygon.circle_y = y;
+
+			} else {
+				_polygon_shapes[polygon_idx].setVertex(i, x, y);
+			}
+		}
+
+		if (!valid) {
+			// an invalid shape contains no point
+			if (is_circle) {
+				polygon.circle_radius = 0.0f;
+
+			} else {
+				_polygon_shapes[polygon_idx].init(0);
+			}
+
+		} else if (!is_circle && !_polygon_shapes[polygon_idx].buildIndex()) {
+			PX4_WARN("polygon index alloc failed");
+		}
+	}
 }
 
 bool Geofence::checkAll(const struct vehicle_global_position_s &global_position)
@@ -280,22 +367,20 @@ bool Geofence::checkAll(double lat, double lon, float altitude)
 
 bool Geofence::checkPolygons(double lat, double lon, float altitude)
 {
-	// the following uses dm_read, so first we try to lock all items. If that fails, it (most likely) means
-	// the data is currently being updated (via a mavlink geofence transfer), and we do not check for a violation now
-	if (dm_trylock(DM_KEY_FENCE_POINTS) != 0) {
-		return true;
-	}
+	// the fence data is cached, dataman is only accessed to check if it got updated. If the lock fails, it (most likely)
+	// means the data is currently being updated (via a mavlink geofence transfer), and we check against the previous fence
+	if (dm_trylock(DM_KEY_FENCE_POINTS) == 0) {
+		mission_stats_entry_s stats;
+		int ret = dm_read(DM_KEY_FENCE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
 
-	// we got the lock, now check if the fence data got updated
-	mission_stats_entry_s stats;
-	int ret = dm_read(DM_KEY_FENCE_POINTS, 0, &stats, sizeof(mission_stats_entry_s));
+		if (ret == sizeof(mission_stats_entry_s) && _update_counter != stats.update_counter) {
+			_updateFence();
+		}
 
-	if (ret == sizeof(mission_stats_entry_s) && _update_counter != stats.update_counter) {
-		_updateFence();
+		dm_unlock(DM_KEY_FENCE_POINTS);
 	}
 
 	if (isEmpty()) {
-		dm_unlock(DM_KEY_FENCE_POINTS);
 		/* Empty fence -> accept all points */
 		return true;
 	}
@@ -303,11 +388,12 @@ bool Geofence::checkPolygons(double lat, double lon, float altitude)
 	/* Vertical check */
 	if (_altitude_max > _altitude_min) { // only enable vertical check if configured properly
 		if (altitude > _altitude_max || altitude < _altitude_min) {
-			dm_unlock(DM_KEY_FENCE_POINTS);
 			return false;
 		}
 	}
 
+	float x, y;
+	map_projection_project(&_projection_reference, lat, lon, &x, &y);
 
 	/* Horizontal check: iterate all polygons & circles */
 	bool outside_exclusion = true;
@@ -316,7 +402,7 @@ bool Geofence::checkPolygons(double lat, double lon, float altitude)
 
 	for (int polygon_idx = 0; polygon_idx < _num_polygons; ++polygon_idx) {
 		if (_polygons[polygon_idx].fence_type == NAV_CMD_FENCE_CIRCLE_INCLUSION) {
-			bool inside = insideCircle(_polygons[polygon_idx], lat, lon, altitude);
+			bool inside = insideCircle(_polygons[polygon_idx], x, y);
 
 			if (inside) {
 				inside_inclusion = true;
@@ -325,14 +411,14 @@ bool Geofence::checkPolygons(double lat, double lon, float altitude)
 			had_inclusion_areas = true;
 
 		} else if (_polygons[polygon_idx].fence_type == NAV_CMD_FENCE_CIRCLE_EXCLUSION) {
-			bool inside = insideCircle(_polygons[polygon_idx], lat, lon, altitude);
+			bool inside = insideCircle(_polygons[polygon_idx], x, y);
 
 			if (inside) {
 				outside_exclusion = false;
 			}
 
 		} else { // it's a polygon
-			bool inside = insidePolygon(_polygons[polygon_idx], lat, lon, altitude);
+			bool inside = _polygon_shapes[polygon_idx].inside(x, y);
 
 			if (_polygons[polygon_idx].fence_type == NAV_CMD_FENCE_POLYGON_VERTEX_INCLUSION) {
 				if (inside) {
@@ -349,81 +435,13 @@ bool Geofence::checkPolygons(double lat, double lon, float altitude)
 		}
 	}
 
-	dm_unlock(DM_KEY_FENCE_POINTS);
-
 	return (!had_inclusion_areas || inside_inclusion) && outside_exclusion;
 }
 
-bool Geofence::insidePolygon(const PolygonInfo &polygon, double lat, double lon, float altitude)
-{
-
-	/* Adaptation of algorithm originally presented as
-	 * PNPOLY - Point Inclusion in Polygon Test
-	 * W. Randolph Franklin (WRF)
-	 * Only supports non-complex polygons (not self intersecting)
-	 */
-
-	mission_fence_point_s temp_vertex_i;
-	mission_fence_point_s temp_vertex_j;
-	bool c = false;
-
-	for (unsigned i = 0, j = polygon.vertex_count - 1; i < polygon.vertex_count; j = i++) {
-		if (dm_read(DM_KEY_FENCE_POINTS, polygon.dataman_index + i, &temp_vertex_i,
-			    sizeof(mission_fence_point_s)) != sizeof(mission_fence_point_s)) {
-			break;
-		}
-
-		if (dm_read(DM_KEY_FENCE_POINTS, polygon.dataman_index + j, &temp_vertex_j,
-			    sizeof(mission_fence_point_s)) != sizeof(mission_fence_point_s)) {
-			break;
-		}
-
-		if (temp_vertex_i.frame != NAV_FRAME_GLOBAL && temp_vertex_i.frame != NAV_FRAME_GLOBAL_INT
-		    && temp_vertex_i.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT
-		    && temp_vertex_i.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
-			// TODO: handle different frames
-			PX4_ERR("Frame type %i not supported", (int)temp_vertex_i.frame);
-			break;
-		}
-
-		if (((double)temp_vertex_i.lon >= lon) != ((double)temp_vertex_j.lon >= lon) &&
-		    (lat <= (double)(temp_vertex_j.lat - temp_vertex_i.lat) * (lon - (double)temp_vertex_i.lon) /
-		     (double)(temp_vertex_j.lon - temp_vertex_i.lon) + (double)temp_vertex_i.lat)) {
-			c = !c;
-		}
-	}
-
-	return c;
-}
-
-bool Geofence::insideCircle(const PolygonInfo &polygon, double lat, double lon, float altitude)
+bool Geofence::insideCircle(const PolygonInfo &polygon, float x, float y)
 {
-
-	mission_fence_point_s circle_point;
-
-	if (dm_read(DM_KEY_FENCE_POINTS, polygon.dataman_index, &circle_point,
-		    sizeof(mission_fence_point_s)) != sizeof(mission_fence_point_s)) {
-		PX4_ERR("dm_read failed");
-		return false;
-	}
-
-	if (circle_point.frame != NAV_FRAME_GLOBAL && circle_point.frame != NAV_FRAME_GLOBAL_INT
-	    && circle_point.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT
-	    && circle_point.frame != NAV_FRAME_GLOBAL_RELATIVE_ALT_INT) {
-		// TODO: handle different frames
-		PX4_ERR("Frame type %i not supported", (int)circle_point.frame);
-		return false;
-	}
-
-	if (!map_projection_initialized(&_projection_reference)) {
-		map_projection_init(&_projection_reference, lat, lon);
-	}
-
-	float x1, y1, x2, y2;
-	map_projection_project(&_projection_reference, lat, lon, &x1, &y1);
-	map_projection_project(&_projection_reference, circle_point.lat, circle_point.lon, &x2, &y2);
-	float dx = x1 - x2, dy = y1 - y2;
-	return dx * dx + dy * dy < circle_point.circle_radius * circle_point.circle_radius;
+	float dx = x - polygon.circle_x, dy = y - polygon.circle_y;
+	return dx * dx + dy * dy < polygon.circle_radius * polygon.circle_radius;
 }
 
 bool
@@ -42,6 +42,8 @@
 
 #include <cfloat>
 
+#include "geofence_polygon.h"
+
 #include <px4_module_params.h>
 #include <drivers/drv_hrt.h>
 #include <lib/ecl/geo/geo.h>
@@ -151,11 +153,15 @@ private:
 			uint16_t vertex_count;
 			float circle_radius;
 		};
+		float circle_x; ///< circle center in local coordinates [m]
+		float circle_y;
 	};
 	PolygonInfo *_polygons{nullptr};
 	int _num_polygons{0};
 
-	map_projection_reference_s _projection_reference = {}; ///< reference to convert (lon, lat) to local [m]
+	GeofencePolygon *_polygon_shapes{nullptr}; ///< vertices of each polygon (same index as _polygons, unused for circles)
+
+	map_projection_reference_s _projection_reference = {}; ///< reference to convert (lon, lat) to local [m], set to the first fence point
 
 	DEFINE_PARAMETERS(
 		(ParamInt<px4::params::GF_ACTION>) _param_action,
@@ -176,6 +182,11 @@ private:
 	 */
 	void _updateFence();
 
+	/**
+	 * read the vertices and circle centers of all polygons from dataman and store them in local coordinates
+	 */
+	void _loadShapes();
+
 	/**
 	 * Check if a point passes the Geofence test.
 	 * This takes all polygons and minimum & maximum altitude into account
@@ -199,16 +210,10 @@ private:
 	bool checkAll(const vehicle_global_position_s &global_position);
 	bool checkAll(const vehicle_global_position_s &global_position, float baro_altitude_amsl);
 
-	/**
-	 * Check if a single point is within a polygon
-	 * @return true if within polygon
-	 */
-	bool insidePolygon(const PolygonInfo &polygon, double lat, double lon, float altitude);
-
 	/**
 	 * Check if a single point is within a circle
 	 * @param polygon must be a circle!
 	 * @return true if within polygon the circle
 	 */
-	bool insideCircle(const PolygonInfo &polygon, double lat, double lon, float altitude);
+	bool insideCircle(const PolygonInfo &polygon, float x, float y);
 };
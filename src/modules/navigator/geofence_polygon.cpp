@@ -0,0 +1,235 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * @file geofence_polygon.cpp
+ * In-memory geofence polygon with a spatial index for fast point inclusion tests
+ */
+
+#include "geofence_polygon.h"
+
+GeofencePolygon::~GeofencePolygon()
+{
+	freeIndex();
+	delete[] _vertices;
+}
+
+void GeofencePolygon::freeIndex()
+{
+	delete[] _bucket_start;
+	delete[] _bucket_edges;
+	_bucket_start = nullptr;
+	_bucket_edges = nullptr;
+	_bucket_count = 0;
+}
+
+bool GeofencePolygon::init(uint16_t vertex_count)
+{
+	freeIndex();
+	delete[] _vertices;
+	_vertex_count = 0;
+
+	_vertices = new Vertex[vertex_count];
+
+	if (_vertices == nullptr) {
+		return false;
+	}
+
+	_vertex_count = vertex_count;
+	return true;
+}
+
+uint16_t GeofencePolygon::bucket(float y) const
+{
+	const int b = (int)((y - _min_y) * _bucket_scale);
+
+	if (b < 0) {
+		return 0;
+	}
+
+	return b < _bucket_count ? b : _bucket_count - 1;
+}
+
+bool GeofencePolygon::buildIndex()
+{
+	freeIndex();
+
+	if (_vertex_count == 0) {
+		return true;
+	}
+
+	_min_x = _max_x = _vertices[0].x;
+	_min_y = _max_y = _vertices[0].y;
+
+	for (uint16_t i = 1; i < _vertex_count; ++i) {
+		if (_vertices[i].x < _min_x) { _min_x = _vertices[i].x; }
+
+		if (_vertices[i].x > _max_x) { _max_x = _vertices[i].x; }
+
+		if (_vertices[i].y < _min_y) { _min_y = _vertices[i].y; }
+
+		if (_vertices[i].y > _max_y) { _max_y = _vertices[i].y; }
+	}
+
+	// about one vertex per bucket. Edges spanning several buckets are stored in each of them,
+	// so use less buckets for polygons with many long edges (e.g. a comb) to bound the memory.
+	uint16_t bucket_count = _vertex_count < MAX_BUCKETS ? _vertex_count : MAX_BUCKETS;
+	uint32_t entries;
+
+	for (;;) {
+		_bucket_count = bucket_count;
+		_bucket_scale = (_max_y > _min_y) ? bucket_count / (_max_y - _min_y) : 0.0f;
+		entries = 0;
+
+		for (uint16_t i = 0, j = _vertex_count - 1; i < _vertex_count; j = i++) {
+			if (_vertices[i].y != _vertices[j].y) { // edges parallel to the ray never cross it
+				const uint16_t b0 = bucket(_vertices[i].y);
+				const uint16_t b1 = bucket(_vertices[j].y);
+				entries += (b0 < b1 ? b1 - b0 : b0 - b1) + 1;
+			}
+		}
+
+		if (bucket_count == 1 || entries <= MAX_ENTRIES_PER_VERTEX * _vertex_count) {
+			break;
+		}
+
+		bucket_count /= 2;
+	}
+
+	_bucket_count = 0; // no index until it is complete
+	_bucket_start = new uint32_t[bucket_count + 1];
+	_bucket_edges = new uint16_t[entries > 0 ? entries : 1];
+
+	if (_bucket_start == nullptr || _bucket_edges == nullptr) {
+		freeIndex();
+		return false;
+	}
+
+	// counting sort of the edges into the buckets: count, prefix sum, fill
+	for (uint16_t b = 0; b <= bucket_count; ++b) {
+		_bucket_start[b] = 0;
+	}
+
+	_bucket_count = bucket_count;
+
+	for (uint16_t i = 0, j = _vertex_count - 1; i < _vertex_count; j = i++) {
+		if (_vertices[i].y != _vertices[j].y) {
+			uint16_t b0 = bucket(_vertices[i].y);
+			uint16_t b1 = bucket(_vertices[j].y);
+
+			if (b0 > b1) {
+				const uint16_t tmp = b0;
+				b0 = b1;
+				b1 = tmp;
+			}
+
+			for (uint16_t b = b0; b <= b1; ++b) {
+				++_bucket_start[b + 1];
+			}
+		}
+	}
+
+	for (uint16_t b = 0; b < bucket_count; ++b) {
+		_bucket_start[b + 1] += _bucket_start[b];
+	}
+
+	// _bucket_start[b] is used as fill position of bucket b - 1 and ends up as its start
+	for (uint16_t b = bucket_count; b > 0; --b) {
+		_bucket_start[b] = _bucket_start[b - 1];
+	}
+
+	for (uint16_t i = 0, j = _vertex_count - 1; i < _vertex_count; j = i++) {
+		if (_vertices[i].y != _vertices[j].y) {
+			uint16_t b0 = bucket(_vertices[i].y);
+			uint16_t b1 = bucket(_vertices[j].y);
+
+			if (b0 > b1) {
+				const uint16_t tmp = b0;
+				b0 = b1;
+				b1 = tmp;
+			}
+
+			for (uint16_t b = b0; b <= b1; ++b) {
+				_bucket_edges[_bucket_start[b + 1]++] = i;
+			}
+		}
+	}
+
+	return true;
+}
+
+bool GeofencePolygon::crosses(uint16_t edge, float x, float y) const
+{
+	/* Adaptation of algorithm originally presented as
+	 * PNPOLY - Point Inclusion in Polygon Test
+	 * W. Randolph Franklin (WRF)
+	 */
+	const Vertex &vi = _vertices[edge];
+	const Vertex &vj = _vertices[edge > 0 ? edge - 1 : _vertex_count - 1];
+
+	return ((vi.y >= y) != (vj.y >= y)) &&
+	       (x <= (vj.x - vi.x) * (y - vi.y) / (vj.y - vi.y) + vi.x);
+}
+
+bool GeofencePolygon::inside(float x, float y) const
+{
+	if (_vertex_count == 0) {
+		return false;
+	}
+
+	bool c = false;
+
+	if (_bucket_count == 0) {
+		// no index (allocation failed): check all edges
+		for (uint16_t i = 0; i < _vertex_count; ++i) {
+			if (crosses(i, x, y)) {
+				c = !c;
+			}
+		}
+
+		return c;
+	}
+
+	if (x < _min_x || x > _max_x || y < _min_y || y > _max_y) {
+		return false;
+	}
+
+	const uint16_t b = bucket(y);
+
+	for (uint32_t k = _bucket_start[b]; k < _bucket_start[b + 1]; ++k) {
+		if (crosses(_bucket_edges[k], x, y)) {
+			c = !c;
+		}
+	}
+
+	return c;
+}
@@ -0,0 +1,119 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+/**
+ * @file geofence_polygon.h
+ * In-memory geofence polygon with a spatial index for fast point inclusion tests
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * A polygon in local coordinates [m] (x: north, y: east).
+ *
+ * The inclusion test is the ray casting algorithm (PNPOLY), accelerated by a
+ * bounding box and by sorting the edges into buckets of equal width along the
+ * y axis: only the edges of the bucket containing the tested point can cross
+ * the ray, so a test costs O(edges per bucket) instead of O(vertices).
+ */
+class GeofencePolygon
+{
+public:
+	GeofencePolygon() = default;
+	GeofencePolygon(const GeofencePolygon &) = delete;
+	GeofencePolygon &operator=(const GeofencePolygon &) = delete;
+	~GeofencePolygon();
+
+	/**
+	 * Allocate the vertices, dropping any existing data.
+	 * The vertices are then set with setVertex() and the index built with buildIndex().
+	 * @return false if the allocation failed
+	 */
+	bool init(uint16_t vertex_count);
+
+	void setVertex(uint16_t index, float x, float y)
+	{
+		_vertices[index].x = x;
+		_vertices[index].y = y;
+	}
+
+	/**
+	 * Compute the bounding box and the edge buckets, once all vertices are set.
+	 * @return false if the allocation failed (inside() then checks all edges)
+	 */
+	bool buildIndex();
+
+	/**
+	 * Check if a point is within the polygon.
+	 * Only supports non-complex polygons (not self intersecting)
+	 * @return true if within polygon
+	 */
+	bool inside(float x, float y) const;
+
+	uint16_t vertexCount() const { return _vertex_count; }
+	uint16_t bucketCount() const { return _bucket_count; }
+
+	/** @return number of edges stored in all the buckets */
+	uint32_t bucketEntries() const { return _bucket_count > 0 ? _bucket_start[_bucket_count] : 0; }
+
+private:
+	struct Vertex {
+		float x;
+		float y;
+	};
+
+	/** edge i goes from vertex i - 1 (or the last vertex for i = 0) to vertex i */
+	bool crosses(uint16_t edge, float x, float y) const;
+
+	/** @return bucket of a y coordinate within the bounding box */
+	uint16_t bucket(float y) const;
+
+	void freeIndex();
+
+	static constexpr uint16_t MAX_BUCKETS = 256; ///< upper bound for the number of buckets
+	static constexpr uint32_t MAX_ENTRIES_PER_VERTEX = 8; ///< the bucket count is reduced to stay below this
+
+	Vertex *_vertices{nullptr};
+	uint16_t _vertex_count{0};
+
+	float _min_x{0.0f};
+	float _max_x{0.0f};
+	float _min_y{0.0f};
+	float _max_y{0.0f};
+
+	uint16_t _bucket_count{0}; ///< 0 if there is no index
+	float _bucket_scale{0.0f}; ///< buckets per meter
+	uint32_t *_bucket_start{nullptr}; ///< offset of each bucket in _bucket_edges (_bucket_count + 1 entries)
+	uint16_t *_bucket_edges{nullptr};
+};
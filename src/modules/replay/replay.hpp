@@ -33,13 +33,13 @@
 
 #pragma once
 
-#include <fstream>
 #include <map>
 #include <vector>
 #include <set>
 #include <string>
 
 #include "definitions.hpp"
+#include "ulog_reader.hpp"
 
 #include <px4_module.h>
 #include <uORB/uORBTopics.h>
@@ -51,9 +51,9 @@ namespace px4
 /**
  * @class Replay
  * Parses an ULog file and replays it in 'real-time'. The timestamp of each replayed message is offset
- * to match the starting time of replay. It keeps a stream for each subscription to find the next message
- * to replay. This is necessary because data messages from different subscriptions don't need to be in
- * monotonic increasing order.
+ * to match the starting time of replay. The file is memory-mapped and indexed by msg_id, and each
+ * subscription keeps its position in the index to find the next message to replay. This is necessary
+ * because data messages from different subscriptions don't need to be in monotonic increasing order.
  */
 class Replay : public ModuleBase<Replay>
 {
@@ -77,6 +77,9 @@ public:
 	/** @see ModuleBase::run() */
 	void run() override;
 
+	/** @see ModuleBase::print_status() */
+	int print_status() override;
+
 	/**
 	 * Apply the parameters from the log
 	 * @param quiet do not print an error if true and no log file given via ENV
@@ -93,6 +96,8 @@ public:
 
 	static bool isSetup() { return _replay_file; }
 
+	static const char *replayFile() { return _replay_file; }
+
 protected:
 
 	/**
@@ -134,7 +139,8 @@ protected:
 
 		bool ignored = false; ///< if true, it will not be considered for publication in the main loop
 
-		std::streampos next_read_pos;
+		uint64_t next_read_pos = 0; ///< file offset of the next message
+		size_t next_index = 0; ///< index of next_read_pos in ULogReader::dataMessages()
 		uint64_t next_timestamp; ///< timestamp of the file
 
 		CompatBase *compat = nullptr;
@@ -188,69 +194,78 @@ protected:
 	 * handle the publication of a topic update
 	 * @return true if published, false otherwise
 	 */
-	virtual bool handleTopicUpdate(Subscription &sub, void *data, std::ifstream &replay_file);
+	virtual bool handleTopicUpdate(Subscription &sub, void *data);
+
+	/**
+	 * copy a topic from the file (offset given by the subscription) into _read_buffer
+	 */
+	void readTopicDataToBuffer(const Subscription &sub);
 
 	/**
-	 * read a topic from the file (offset given by the subscription) into _read_buffer
+	 * Find next data message for this subscription, skipping the current one.
+	 * If found, read the timestamp and store the new file offset. When reaching the end
+	 * of the data section, the subscription is set to invalid.
+	 * @return true if a message was found
 	 */
-	void readTopicDataToBuffer(const Subscription &sub, std::ifstream &replay_file);
+	bool nextDataMessage(Subscription &subscription, int msg_id)
+	{
+		return findDataMessage(subscription, msg_id, subscription.next_index + 1);
+	}
 
 	/**
-	 * Find next data message for this subscription, starting with the stored file offset.
-	 * Skip the first message, and if found, read the timestamp and store the new file offset.
-	 * This also takes care of new subscriptions and parameter updates. When reaching EOF,
-	 * the subscription is set to invalid.
-	 * File seek position is arbitrary after this call.
-	 * @return false on file error
+	 * Find the first valid data message for this subscription, starting at a position in the index.
+	 * @see nextDataMessage()
 	 */
-	bool nextDataMessage(std::ifstream &file, Subscription &subscription, int msg_id);
+	bool findDataMessage(Subscription &subscription, int msg_id, size_t index);
 
 	std::vector<Subscription> _subscriptions;
 	std::vector<uint8_t> _read_buffer;
 
+	ULogReader _reader;
+
+	uint32_t _nr_published_messages = 0;
+
 private:
 	std::set<std::string> _overridden_params;
 	std::map<std::string, std::string> _file_formats; ///< all formats we read from the file
 
 	uint64_t _file_start_time;
-	uint64_t _replay_start_time;
-	std::streampos _data_section_start; ///< first ADD_LOGGED_MSG message
+	uint64_t _replay_start_time = 0;
+	uint64_t _data_section_start; ///< first ADD_LOGGED_MSG message
 
-	/** keep track of file position to avoid adding a subscription multiple times. */
-	std::streampos _subscription_file_pos = 0;
+	size_t _next_additional_message = 0; ///< index into ULogReader::additionalMessages()
 
 	uint64_t _read_until_file_position = 1ULL << 60; ///< read limit if log contains appended data
 
-	bool readFileHeader(std::ifstream &file);
+	bool readFileHeader();
 
 	/**
 	 * Read definitions section: check formats, apply parameters and store
 	 * the start of the data section.
 	 * @return true on success
 	 */
-	bool readFileDefinitions(std::ifstream &file);
+	bool readFileDefinitions();
 
-	///file parsing methods. They return false, when further parsing should be aborted.
-	bool readFormat(std::ifstream &file, uint16_t msg_size);
-	bool readAndAddSubscription(std::ifstream &file, uint16_t msg_size);
-	bool readFlagBits(std::ifstream &file, uint16_t msg_size);
+	///file parsing methods. They get a pointer to the message payload and return false, when further parsing should be aborted.
+	bool readFormat(const uint8_t *message, uint16_t msg_size);
+	bool readAndAddSubscription(uint64_t message_offset);
+	bool readFlagBits(const uint8_t *message, uint16_t msg_size);
 
 	/**
-	 * Read the file header and definitions sections. Apply the parameters from this section
+	 * Map the file, read the file header and definitions sections. Apply the parameters from this section
 	 * and apply user-defined overridden parameters.
 	 * @return true on success
 	 */
-	bool readDefinitionsAndApplyParams(std::ifstream &file);
+	bool readDefinitionsAndApplyParams();
 
 	/**
-	 * Read and handle additional messages starting at current file position, while position < end_position.
+	 * Handle the indexed additional messages before end_position that were not handled yet.
 	 * This handles dropout and parameter update messages.
 	 * We need to handle these separately, because they have no timestamp. We look at the file position instead.
-	 * @return false on file error
 	 */
-	bool readAndHandleAdditionalMessages(std::ifstream &file, std::streampos end_position);
-	bool readDropout(std::ifstream &file, uint16_t msg_size);
-	bool readAndApplyParameter(std::ifstream &file, uint16_t msg_size);
+	void readAndHandleAdditionalMessages(uint64_t end_position);
+	bool readDropout(const uint8_t *message, uint16_t msg_size);
+	bool readAndApplyParameter(const uint8_t *message, uint16_t msg_size);
 
 	static const orb_metadata *findTopic(const std::string &name);
 	/** get the array size from a type. eg. float[3] -> return float */
@@ -284,27 +299,53 @@ protected:
 	 * handle ekf2 topic publication in ekf2 replay mode
 	 * @param sub
 	 * @param data
-	 * @param replay_file file currently replayed (file seek position should be considered arbitrary after this call)
 	 * @return true if published, false otherwise
 	 */
-	bool handleTopicUpdate(Subscription &sub, void *data, std::ifstream &replay_file) override;
+	bool handleTopicUpdate(Subscription &sub, void *data) override;
 
 	void onSubscriptionAdded(Subscription &sub, uint16_t msg_id) override;
 
 private:
 
-	bool publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std::ifstream &replay_file);
+	/** statistics of an innovation test ratio over the whole replay */
+	struct TestRatioStatistics {
+		float max = 0.f;
+		double sum = 0.;
+		uint32_t num_samples = 0; ///< number of finite samples, non-finite ones are skipped
+		uint32_t num_failed = 0; ///< number of samples with a ratio > 1 (innovation rejected)
+
+		void update(float ratio)
+		{
+			if (PX4_ISFINITE(ratio)) {
+				max = ratio > max ? ratio : max;
+				sum += ratio;
+				++num_samples;
+				num_failed += ratio > 1.f;
+			}
+		}
+	};
+
+	bool publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps);
+
+	/** check for an estimator_status update and add it to the statistics */
+	void updateEstimatorStatistics();
+
+	/**
+	 * write the summary metrics of the replay as CSV (header and a single row)
+	 * @return true on success
+	 */
+	bool writeSummary(const char *file_name);
 
 	/**
 	 * find the next message for a subscription that matches a given timestamp and publish it
 	 * @param timestamp in 0.1 ms
 	 * @param msg_id
-	 * @param replay_file file currently replayed (file seek position should be considered arbitrary after this call)
 	 * @return true if timestamp found and published
 	 */
-	bool findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id, std::ifstream &replay_file);
+	bool findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id);
 
 	int _vehicle_attitude_sub = -1;
+	int _estimator_status_sub = -1;
 
 	static constexpr uint16_t msg_id_invalid = 0xffff;
 
@@ -319,6 +360,19 @@ private:
 	uint16_t _vehicle_vision_position_msg_id = msg_id_invalid;
 
 	int _topic_counter = 0;
+
+	uint64_t _main_loop_start_time = 0;
+	uint64_t _first_ekf2_timestamp = 0; ///< file time range of the replayed ekf2 updates
+	uint64_t _last_ekf2_timestamp = 0;
+
+	uint32_t _estimator_status_count = 0;
+	uint16_t _filter_fault_flags = 0; ///< all filter faults reported during the replay
+	TestRatioStatistics _mag_test_ratio;
+	TestRatioStatistics _vel_test_ratio;
+	TestRatioStatistics _pos_test_ratio;
+	TestRatioStatistics _hgt_test_ratio;
+	TestRatioStatistics _tas_test_ratio;
+	TestRatioStatistics _hagl_test_ratio;
 };
 
 } //namespace px4
@@ -46,6 +46,7 @@
 #include <px4_tasks.h>
 #include <px4_time.h>
 
+#include <algorithm>
 #include <cstring>
 #include <float.h>
 #include <fstream>
@@ -62,6 +63,7 @@
 // for ekf2 replay
 #include <uORB/topics/airspeed.h>
 #include <uORB/topics/distance_sensor.h>
+#include <uORB/topics/estimator_status.h>
 #include <uORB/topics/landing_target_pose.h>
 #include <uORB/topics/optical_flow.h>
 #include <uORB/topics/sensor_combined.h>
@@ -166,16 +168,16 @@ void Replay::setUserParams(const char *filename)
 	}
 }
 
-bool Replay::readFileHeader(std::ifstream &file)
+bool Replay::readFileHeader()
 {
-	file.seekg(0);
 	ulog_file_header_s msg_header;
-	file.read((char *)&msg_header, sizeof(msg_header));
 
-	if (!file) {
+	if (_reader.size() < sizeof(msg_header)) {
 		return false;
 	}
 
+	memcpy(&msg_header, _reader.data(), sizeof(msg_header));
+
 	_file_start_time = msg_header.timestamp;
 	//verify it's an ULog file
 	char magic[8];
@@ -189,74 +191,72 @@ bool Replay::readFileHeader(std::ifstream &file)
 	return memcmp(magic, msg_header.magic, 7) == 0;
 }
 
-bool Replay::readFileDefinitions(std::ifstream &file)
+bool Replay::readFileDefinitions()
 {
 	PX4_INFO("Applying params from ULog file...");
 
-	ulog_message_header_s message_header;
-	file.seekg(sizeof(ulog_file_header_s));
+	uint64_t offset = sizeof(ulog_file_header_s);
 
 	while (true) {
-		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+		const ulog_message_header_s message_header = _reader.messageHeader(offset);
 
-		if (!file) {
+		if (message_header.msg_type == 0) {
 			return false;
 		}
 
+		const uint8_t *message = _reader.messagePayload(offset);
+
 		switch (message_header.msg_type) {
 		case (int)ULogMessageType::FLAG_BITS:
-			if (!readFlagBits(file, message_header.msg_size)) {
+			if (!readFlagBits(message, message_header.msg_size)) {
 				return false;
 			}
 
 			break;
 
 		case (int)ULogMessageType::FORMAT:
-			if (!readFormat(file, message_header.msg_size)) {
+			if (!readFormat(message, message_header.msg_size)) {
 				return false;
 			}
 
 			break;
 
 		case (int)ULogMessageType::PARAMETER:
-			if (!readAndApplyParameter(file, message_header.msg_size)) {
+			if (!readAndApplyParameter(message, message_header.msg_size)) {
 				return false;
 			}
 
 			break;
 
 		case (int)ULogMessageType::ADD_LOGGED_MSG:
-			_data_section_start = file.tellg() - (streamoff)ULOG_MSG_HEADER_LEN;
+			_data_section_start = offset;
 			return true;
 
 		case (int)ULogMessageType::INFO: //skip
 		case (int)ULogMessageType::INFO_MULTIPLE: //skip
-			file.seekg(message_header.msg_size, ios::cur);
 			break;
 
 		default:
 			PX4_ERR("unknown log definition type %i, size %i (offset %i)",
-				(int)message_header.msg_type, (int)message_header.msg_size, (int)file.tellg());
-			file.seekg(message_header.msg_size, ios::cur);
+				(int)message_header.msg_type, (int)message_header.msg_size, (int)offset);
 			break;
 		}
+
+		offset += ULOG_MSG_HEADER_LEN + message_header.msg_size;
 	}
 
 	return true;
 }
 
-bool Replay::readFlagBits(std::ifstream &file, uint16_t msg_size)
+bool Replay::readFlagBits(const uint8_t *message, uint16_t msg_size)
 {
 	if (msg_size != 40) {
 		PX4_ERR("unsupported message length for FLAG_BITS message (%i)", msg_size);
 		return false;
 	}
 
-	_read_buffer.reserve(msg_size);
-	uint8_t *message = (uint8_t *)_read_buffer.data();
-	file.read((char *)message, msg_size);
-	//uint8_t *compat_flags = message;
-	uint8_t *incompat_flags = message + 8;
+	//const uint8_t *compat_flags = message;
+	const uint8_t *incompat_flags = message + 8;
 
 	// handle & validate the flags
 	bool contains_appended_data = incompat_flags[0] & ULOG_INCOMPAT_FLAG0_DATA_APPENDED_MASK;
@@ -291,18 +291,9 @@ bool Replay::readFlagBits(std::ifstream &file, uint16_t msg_size)
 	return true;
 }
 
-bool Replay::readFormat(std::ifstream &file, uint16_t msg_size)
+bool Replay::readFormat(const uint8_t *message, uint16_t msg_size)
 {
-	_read_buffer.reserve(msg_size + 1);
-	char *format = (char *)_read_buffer.data();
-	file.read(format, msg_size);
-	format[msg_size] = 0;
-
-	if (!file) {
-		return false;
-	}
-
-	string str_format(format);
+	string str_format((const char *)message, msg_size);
 	size_t pos = str_format.find(':');
 
 	if (pos == string::npos) {
@@ -316,27 +307,19 @@ bool Replay::readFormat(std::ifstream &file, uint16_t msg_size)
 	return true;
 }
 
-bool Replay::readAndAddSubscription(std::ifstream &file, uint16_t msg_size)
+bool Replay::readAndAddSubscription(uint64_t message_offset)
 {
-	_read_buffer.reserve(msg_size + 1);
-	char *message = (char *)_read_buffer.data();
-	streampos this_message_pos = file.tellg() - (streamoff)ULOG_MSG_HEADER_LEN;
-	file.read(message, msg_size);
-	message[msg_size] = 0;
+	const ulog_message_header_s message_header = _reader.messageHeader(message_offset);
 
-	if (!file) {
+	if (message_header.msg_type == 0 || message_header.msg_size < 4) {
 		return false;
 	}
 
-	if (file.tellg() <= _subscription_file_pos) { //already read this subscription
-		return true;
-	}
-
-	_subscription_file_pos = file.tellg();
+	const uint8_t *message = _reader.messagePayload(message_offset);
 
-	uint8_t multi_id = *(uint8_t *)message;
+	uint8_t multi_id = message[0];
 	uint16_t msg_id = ((uint16_t) message[1]) | (((uint16_t) message[2]) << 8);
-	string topic_name(message + 3);
+	string topic_name((const char *)message + 3, strnlen((const char *)message + 3, message_header.msg_size - 3));
 	const orb_metadata *orb_meta = findTopic(topic_name);
 
 	if (!orb_meta) {
@@ -394,26 +377,24 @@ bool Replay::readAndAddSubscription(std::ifstream &file, uint16_t msg_size)
 	bool timestamp_found = findFieldOffset(orb_meta->o_fields, "timestamp", subscription.timestamp_offset, field_size);
 
 	if (!timestamp_found) {
+		delete compat;
 		return true;
 	}
 
 	if (field_size != 8) {
 		PX4_ERR("Unsupported timestamp with size %i, ignoring the topic %s", field_size, orb_meta->o_name);
+		delete compat;
 		return true;
 	}
 
-	//find first data message (and the timestamp)
-	streampos cur_pos = file.tellg();
-	subscription.next_read_pos = this_message_pos; //this will be skipped
-
-	if (!nextDataMessage(file, subscription, msg_id)) {
-		return false;
-	}
-
-	file.seekg(cur_pos);
+	//find first data message after the subscription (and the timestamp)
+	const std::vector<uint64_t> &data_messages = _reader.dataMessages(msg_id);
+	const size_t first_index = std::lower_bound(data_messages.begin(), data_messages.end(), message_offset) -
+				   data_messages.begin();
 
-	if (!subscription.orb_meta) {
+	if (!findDataMessage(subscription, msg_id, first_index)) {
 		//no message found. This is not a fatal error
+		delete compat;
 		return true;
 	}
 
@@ -462,50 +443,33 @@ bool Replay::findFieldOffset(const string &format, const string &field_name, int
 }
 
 
-bool Replay::readAndHandleAdditionalMessages(std::ifstream &file, std::streampos end_position)
+void Replay::readAndHandleAdditionalMessages(uint64_t end_position)
 {
-	ulog_message_header_s message_header;
-
-	while (file.tellg() < end_position) {
-		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
-
-		if (!file) {
-			return false;
-		}
-
-		switch (message_header.msg_type) {
-		case (int)ULogMessageType::PARAMETER:
-			if (!readAndApplyParameter(file, message_header.msg_size)) {
-				return false;
-			}
+	const std::vector<uint64_t> &additional_messages = _reader.additionalMessages();
 
-			break;
+	while (_next_additional_message < additional_messages.size() &&
+	       additional_messages[_next_additional_message] < end_position) {
+		const uint64_t offset = additional_messages[_next_additional_message++];
+		const ulog_message_header_s message_header = _reader.messageHeader(offset);
+		const uint8_t *message = _reader.messagePayload(offset);
 
-		case (int)ULogMessageType::DROPOUT:
-			readDropout(file, message_header.msg_size);
-			break;
+		if (message_header.msg_type == (int)ULogMessageType::PARAMETER) {
+			readAndApplyParameter(message, message_header.msg_size);
 
-		default: //skip all others
-			file.seekg(message_header.msg_size, ios::cur);
-			break;
+		} else {
+			readDropout(message, message_header.msg_size);
 		}
 	}
-
-	return true;
 }
 
-bool Replay::readAndApplyParameter(std::ifstream &file, uint16_t msg_size)
+bool Replay::readAndApplyParameter(const uint8_t *message, uint16_t msg_size)
 {
-	_read_buffer.reserve(msg_size);
-	uint8_t *message = (uint8_t *)_read_buffer.data();
-	file.read((char *)message, msg_size);
-
-	if (!file) {
+	if (msg_size < 1 || 1 + message[0] + sizeof(int32_t) > msg_size) {
 		return false;
 	}
 
 	uint8_t key_len = message[0];
-	string key((char *)message + 1, key_len);
+	string key((const char *)message + 1, key_len);
 
 	size_t pos = key.find(' ');
 
@@ -529,103 +493,54 @@ bool Replay::readAndApplyParameter(std::ifstream &file, uint16_t msg_size)
 	param_t handle = param_find(param_name.c_str());
 
 	if (handle != PARAM_INVALID) {
-		param_set(handle, (const void *)(message + 1 + key_len));
+		/* the message is not aligned, copy the value out (int32_t and float have the same size) */
+		int32_t value;
+		memcpy(&value, message + 1 + key_len, sizeof(value));
+		param_set(handle, (const void *)&value);
 	}
 
 	return true;
 }
 
-bool Replay::readDropout(std::ifstream &file, uint16_t msg_size)
+bool Replay::readDropout(const uint8_t *message, uint16_t msg_size)
 {
 	uint16_t duration;
-	file.read((char *)&duration, sizeof(duration));
-
-	PX4_INFO("Dropout in replayed log, %i ms", (int)duration);
-	return file.good();
-}
-
-bool Replay::nextDataMessage(std::ifstream &file, Subscription &subscription, int msg_id)
-{
-	ulog_message_header_s message_header;
-	file.seekg(subscription.next_read_pos);
-	//ignore the first message (it's data we already read)
-	file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
 
-	if (file) {
-		file.seekg(message_header.msg_size, ios::cur);
+	if (msg_size < sizeof(duration)) {
+		return false;
 	}
 
-	uint16_t file_msg_id;
-	bool done = false;
+	memcpy(&duration, message, sizeof(duration));
 
-	while (file && !done) {
-		streampos cur_pos = file.tellg();
-		file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
-
-		if (!file) {
-			break;
-		}
-
-		if (((streamoff)cur_pos) + ULOG_MSG_HEADER_LEN + message_header.msg_size > _read_until_file_position) {
-			file.setstate(std::ios::eofbit);
-			break;
-		}
-
-		switch (message_header.msg_type) {
-		case (int)ULogMessageType::ADD_LOGGED_MSG:
-			readAndAddSubscription(file, message_header.msg_size);
-			break;
-
-		case (int)ULogMessageType::DATA:
-			file.read((char *)&file_msg_id, sizeof(file_msg_id));
-
-			if (file) {
-				if (msg_id == file_msg_id) {
-					if (message_header.msg_size == subscription.orb_meta->o_size_no_padding + 2) {
-						subscription.next_read_pos = cur_pos;
-						file.seekg(subscription.timestamp_offset, ios::cur);
-						file.read((char *)&subscription.next_timestamp, sizeof(subscription.next_timestamp));
-						done = true;
-
-					} else { //sanity check failed!
-						PX4_ERR("data message %s has wrong size %i (expected %i). Skipping",
-							subscription.orb_meta->o_name, message_header.msg_size,
-							subscription.orb_meta->o_size_no_padding + 2);
-						file.seekg(message_header.msg_size - sizeof(file_msg_id), ios::cur);
-					}
-
-				} else { //not the one we are looking for
-					file.seekg(message_header.msg_size - sizeof(file_msg_id), ios::cur);
-				}
-			}
+	PX4_INFO("Dropout in replayed log, %i ms", (int)duration);
+	return true;
+}
 
-			break;
+bool Replay::findDataMessage(Subscription &subscription, int msg_id, size_t index)
+{
+	const std::vector<uint64_t> &data_messages = _reader.dataMessages(msg_id);
 
-		case (int)ULogMessageType::REMOVE_LOGGED_MSG: //skip these
-		case (int)ULogMessageType::PARAMETER:
-		case (int)ULogMessageType::DROPOUT:
-		case (int)ULogMessageType::INFO:
-		case (int)ULogMessageType::INFO_MULTIPLE:
-		case (int)ULogMessageType::SYNC:
-		case (int)ULogMessageType::LOGGING:
-			file.seekg(message_header.msg_size, ios::cur);
-			break;
+	for (; index < data_messages.size(); ++index) {
+		const uint64_t offset = data_messages[index];
+		const ulog_message_header_s message_header = _reader.messageHeader(offset);
 
-		default:
-			//this really should not happen
-			PX4_ERR("unknown log message type %i, size %i (offset %i)",
-				(int)message_header.msg_type, (int)message_header.msg_size, (int)file.tellg());
-			file.seekg(message_header.msg_size, ios::cur);
-			break;
+		if (message_header.msg_size == subscription.orb_meta->o_size_no_padding + 2) {
+			subscription.next_read_pos = offset;
+			subscription.next_index = index;
+			memcpy(&subscription.next_timestamp, _reader.messagePayload(offset) + 2 + subscription.timestamp_offset,
+			       sizeof(subscription.next_timestamp));
+			return true;
 		}
-	}
 
-	if (file.eof()) { //no more data messages for this subscription
-		subscription.orb_meta = nullptr;
-		file.clear();
+		//sanity check failed!
+		PX4_ERR("data message %s has wrong size %i (expected %i). Skipping",
+			subscription.orb_meta->o_name, message_header.msg_size,
+			subscription.orb_meta->o_size_no_padding + 2);
 	}
 
-	return file.good();
+	//no more data messages for this subscription
+	subscription.orb_meta = nullptr;
+	return false;
 }
 
 const orb_metadata *Replay::findTopic(const std::string &name)
@@ -695,7 +610,7 @@ size_t Replay::sizeOfFullType(const std::string &type_name_full)
 	return sizeOfType(type_name) * array_size;
 }
 
-bool Replay::readDefinitionsAndApplyParams(std::ifstream &file)
+bool Replay::readDefinitionsAndApplyParams()
 {
 	// log reader currently assumes little endian
 	int num = 1;
@@ -705,18 +620,18 @@ bool Replay::readDefinitionsAndApplyParams(std::ifstream &file)
 		return false;
 	}
 
-	if (!file.is_open()) {
+	if (!_reader.open(_replay_file)) {
 		PX4_ERR("Failed to open replay file");
 		return false;
 	}
 
-	if (!readFileHeader(file)) {
+	if (!readFileHeader()) {
 		PX4_ERR("Failed to read file header. Not a valid ULog file");
 		return false;
 	}
 
 	//initialize the formats and apply the parameters from the log file
-	if (!readFileDefinitions(file)) {
+	if (!readFileDefinitions()) {
 		PX4_ERR("Failed to read ULog definitions section. Broken file?");
 		return false;
 	}
@@ -727,37 +642,40 @@ bool Replay::readDefinitionsAndApplyParams(std::ifstream &file)
 
 void Replay::run()
 {
-	ifstream replay_file(_replay_file, ios::in | ios::binary);
-
-	if (!readDefinitionsAndApplyParams(replay_file)) {
+	if (!readDefinitionsAndApplyParams()) {
 		return;
 	}
 
-	onEnterMainLoop();
-
-	_replay_start_time = hrt_absolute_time();
+	const hrt_abstime index_start_time = hrt_absolute_time();
 
-	PX4_INFO("Replay in progress...");
+	if (!_reader.buildIndex(_data_section_start, _read_until_file_position)) {
+		PX4_ERR("Failed to index the data section");
+		return;
+	}
 
-	ulog_message_header_s message_header;
-	replay_file.seekg(_data_section_start);
+	PX4_INFO("Indexed %u messages in %.3lf s", _reader.numMessages(),
+		 (double)hrt_elapsed_time(&index_start_time) / 1.e6);
 
-	//we know the next message must be an ADD_LOGGED_MSG
-	replay_file.read((char *)&message_header, ULOG_MSG_HEADER_LEN);
+	onEnterMainLoop();
 
-	if (!readAndAddSubscription(replay_file, message_header.msg_size)) {
-		PX4_ERR("Failed to read subscription");
-		return;
+	//add all subscriptions. Each one starts at the first data message that follows its ADD_LOGGED_MSG
+	for (uint64_t offset : _reader.subscriptionMessages()) {
+		if (!readAndAddSubscription(offset)) {
+			PX4_ERR("Failed to read subscription");
+			return;
+		}
 	}
 
+	_replay_start_time = hrt_absolute_time();
+
+	PX4_INFO("Replay in progress...");
 
 	//we update the timestamps from the file by a constant offset to match
 	//the current replay time
 	const uint64_t timestamp_offset = _replay_start_time - _file_start_time;
-	uint32_t nr_published_messages = 0;
-	streampos last_additional_message_pos = _data_section_start;
+	_nr_published_messages = 0;
 
-	while (!should_exit() && replay_file) {
+	while (!should_exit()) {
 
 		//Find the next message to publish. Messages from different subscriptions don't need
 		//to be in chronological order, so we need to check all subscriptions
@@ -783,32 +701,27 @@ void Replay::run()
 
 		if (next_file_time == 0) {
 			//someone didn't set the timestamp properly. Consider the message invalid
-			nextDataMessage(replay_file, sub, next_msg_id);
+			nextDataMessage(sub, next_msg_id);
 			continue;
 		}
 
 
 		//handle additional messages between last and next published data
-		replay_file.seekg(last_additional_message_pos);
-		streampos next_additional_message_pos = sub.next_read_pos;
-		readAndHandleAdditionalMessages(replay_file, next_additional_message_pos);
-		last_additional_message_pos = next_additional_message_pos;
+		readAndHandleAdditionalMessages(sub.next_read_pos);
 
 
 		const uint64_t publish_timestamp = handleTopicDelay(next_file_time, timestamp_offset);
 
 
 		//It's time to publish
-		readTopicDataToBuffer(sub, replay_file);
+		readTopicDataToBuffer(sub);
 		memcpy(_read_buffer.data() + sub.timestamp_offset, &publish_timestamp, sizeof(uint64_t)); //adjust the timestamp
 
-		if (handleTopicUpdate(sub, _read_buffer.data(), replay_file)) {
-			++nr_published_messages;
+		if (handleTopicUpdate(sub, _read_buffer.data())) {
+			++_nr_published_messages;
 		}
 
-		nextDataMessage(replay_file, sub, next_msg_id);
-
-		//TODO: output status (eg. every sec), including total duration...
+		nextDataMessage(sub, next_msg_id);
 	}
 
 	for (auto &subscription : _subscriptions) {
@@ -824,8 +737,9 @@ void Replay::run()
 	}
 
 	if (!should_exit()) {
-		PX4_INFO("Replay done (published %u msgs, %.3lf s)", nr_published_messages,
-			 (double)hrt_elapsed_time(&_replay_start_time) / 1.e6);
+		const double elapsed = (double)hrt_elapsed_time(&_replay_start_time) / 1.e6;
+		PX4_INFO("Replay done (published %u msgs, %.3lf s, %.0lf msgs/s)", _nr_published_messages, elapsed,
+			 elapsed > 0. ? _nr_published_messages / elapsed : 0.);
 
 		//TODO: should we close the log file & exit (optionally, by adding a parameter -q) ?
 	}
@@ -833,16 +747,29 @@ void Replay::run()
 	onExitMainLoop();
 }
 
-void Replay::readTopicDataToBuffer(const Subscription &sub, std::ifstream &replay_file)
+int Replay::print_status()
+{
+	if (_replay_start_time == 0) {
+		PX4_INFO("Replay not started");
+		return 0;
+	}
+
+	const double elapsed = (double)hrt_elapsed_time(&_replay_start_time) / 1.e6;
+	PX4_INFO("Indexed messages: %u (%llu bytes)", _reader.numMessages(), (unsigned long long)_reader.size());
+	PX4_INFO("Published: %u msgs in %.3lf s (%.0lf msgs/s)", _nr_published_messages, elapsed,
+		 elapsed > 0. ? _nr_published_messages / elapsed : 0.);
+	return 0;
+}
+
+void Replay::readTopicDataToBuffer(const Subscription &sub)
 {
 	const size_t msg_read_size = sub.orb_meta->o_size_no_padding;
 	const size_t msg_write_size = sub.orb_meta->o_size;
 	_read_buffer.reserve(msg_write_size);
-	replay_file.seekg(sub.next_read_pos + (streamoff)(ULOG_MSG_HEADER_LEN + 2)); //skip header & msg id
-	replay_file.read((char *)_read_buffer.data(), msg_read_size);
+	memcpy(_read_buffer.data(), _reader.messagePayload(sub.next_read_pos) + 2, msg_read_size); //skip msg id
 }
 
-bool Replay::handleTopicUpdate(Subscription &sub, void *data, std::ifstream &replay_file)
+bool Replay::handleTopicUpdate(Subscription &sub, void *data)
 {
 	return publishTopic(sub, data);
 }
@@ -908,16 +835,22 @@ bool Replay::publishTopic(Subscription &sub, void *data)
 	return published;
 }
 
-bool ReplayEkf2::handleTopicUpdate(Subscription &sub, void *data, std::ifstream &replay_file)
+bool ReplayEkf2::handleTopicUpdate(Subscription &sub, void *data)
 {
 	if (sub.orb_meta == ORB_ID(ekf2_timestamps)) {
 		ekf2_timestamps_s ekf2_timestamps;
 		memcpy(&ekf2_timestamps, data, sub.orb_meta->o_size);
 
-		if (!publishEkf2Topics(ekf2_timestamps, replay_file)) {
+		if (!publishEkf2Topics(ekf2_timestamps)) {
 			return false;
 		}
 
+		if (_first_ekf2_timestamp == 0) {
+			_first_ekf2_timestamp = ekf2_timestamps.timestamp;
+		}
+
+		_last_ekf2_timestamp = ekf2_timestamps.timestamp;
+
 		px4_pollfd_struct_t fds[1];
 		fds[0].fd = _vehicle_attitude_sub;
 		fds[0].events = POLLIN;
@@ -944,6 +877,8 @@ bool ReplayEkf2::handleTopicUpdate(Subscription &sub, void *data, std::ifstream
 			}
 		}
 
+		updateEstimatorStatistics();
+
 		return true;
 
 	} else if (sub.orb_meta == ORB_ID(vehicle_status) || sub.orb_meta == ORB_ID(vehicle_land_detected)
@@ -993,13 +928,13 @@ void ReplayEkf2::onSubscriptionAdded(Subscription &sub, uint16_t msg_id)
 		      (sub.orb_meta != ORB_ID(vehicle_gps_position) || sub.multi_id == 0);
 }
 
-bool ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std::ifstream &replay_file)
+bool ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps)
 {
 	auto handle_sensor_publication = [&](int16_t timestamp_relative, uint16_t msg_id) {
 		if (timestamp_relative != ekf2_timestamps_s::RELATIVE_TIMESTAMP_INVALID) {
 			// timestamp_relative is already given in 0.1 ms
 			uint64_t t = timestamp_relative + ekf2_timestamps.timestamp / 100; // in 0.1 ms
-			findTimestampAndPublish(t, msg_id, replay_file);
+			findTimestampAndPublish(t, msg_id);
 		}
 	};
 
@@ -1013,7 +948,7 @@ bool ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std
 	handle_sensor_publication(ekf2_timestamps.vision_position_timestamp_rel, _vehicle_vision_position_msg_id);
 
 	// sensor_combined: publish last because ekf2 is polling on this
-	if (!findTimestampAndPublish(ekf2_timestamps.timestamp / 100, _sensor_combined_msg_id, replay_file)) {
+	if (!findTimestampAndPublish(ekf2_timestamps.timestamp / 100, _sensor_combined_msg_id)) {
 		if (_sensor_combined_msg_id == msg_id_invalid) {
 			// subscription not found yet or sensor_combined not contained in log
 			return false;
@@ -1023,7 +958,7 @@ bool ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std
 
 		} else {
 			// we should publish a topic, just publish the same again
-			readTopicDataToBuffer(_subscriptions[_sensor_combined_msg_id], replay_file);
+			readTopicDataToBuffer(_subscriptions[_sensor_combined_msg_id]);
 			publishTopic(_subscriptions[_sensor_combined_msg_id], _read_buffer.data());
 		}
 	}
@@ -1032,7 +967,7 @@ bool ReplayEkf2::publishEkf2Topics(const ekf2_timestamps_s &ekf2_timestamps, std
 
 }
 
-bool ReplayEkf2::findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id, std::ifstream &replay_file)
+bool ReplayEkf2::findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id)
 {
 	if (msg_id == msg_id_invalid) {
 		// could happen if a topic is not logged
@@ -1042,7 +977,7 @@ bool ReplayEkf2::findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id, st
 	Subscription &sub = _subscriptions[msg_id];
 
 	while (sub.next_timestamp / 100 < timestamp && sub.orb_meta) {
-		nextDataMessage(replay_file, sub, msg_id);
+		nextDataMessage(sub, msg_id);
 	}
 
 	if (!sub.orb_meta) { // no messages anymore
@@ -1057,7 +992,7 @@ bool ReplayEkf2::findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id, st
 		return false;
 	}
 
-	readTopicDataToBuffer(sub, replay_file);
+	readTopicDataToBuffer(sub);
 	publishTopic(sub, _read_buffer.data());
 	return true;
 }
@@ -1065,6 +1000,67 @@ bool ReplayEkf2::findTimestampAndPublish(uint64_t timestamp, uint16_t msg_id, st
 void ReplayEkf2::onEnterMainLoop()
 {
 	_vehicle_attitude_sub = orb_subscribe(ORB_ID(vehicle_attitude));
+	_estimator_status_sub = orb_subscribe(ORB_ID(estimator_status));
+	_main_loop_start_time = hrt_absolute_time();
+}
+
+void ReplayEkf2::updateEstimatorStatistics()
+{
+	bool updated = false;
+	orb_check(_estimator_status_sub, &updated);
+
+	if (!updated) {
+		return;
+	}
+
+	estimator_status_s estimator_status;
+	orb_copy(ORB_ID(estimator_status), _estimator_status_sub, &estimator_status);
+
+	++_estimator_status_count;
+	_filter_fault_flags |= estimator_status.filter_fault_flags;
+	_mag_test_ratio.update(estimator_status.mag_test_ratio);
+	_vel_test_ratio.update(estimator_status.vel_test_ratio);
+	_pos_test_ratio.update(estimator_status.pos_test_ratio);
+	_hgt_test_ratio.update(estimator_status.hgt_test_ratio);
+	_tas_test_ratio.update(estimator_status.tas_test_ratio);
+	_hagl_test_ratio.update(estimator_status.hagl_test_ratio);
+}
+
+bool ReplayEkf2::writeSummary(const char *file_name)
+{
+	FILE *file = fopen(file_name, "w");
+
+	if (!file) {
+		PX4_ERR("failed to open %s (%i)", file_name, errno);
+		return false;
+	}
+
+	const double runtime = (double)hrt_elapsed_time(&_main_loop_start_time) / 1.e6;
+	const double log_duration = (double)(_last_ekf2_timestamp - _first_ekf2_timestamp) / 1.e6;
+	const TestRatioStatistics *test_ratios[] = {&_mag_test_ratio, &_vel_test_ratio, &_pos_test_ratio,
+						    &_hgt_test_ratio, &_tas_test_ratio, &_hagl_test_ratio
+						   };
+	const char *test_ratio_names[] = {"mag", "vel", "pos", "hgt", "tas", "hagl"};
+
+	fprintf(file, "log_file,published_msgs,runtime_s,log_duration_s,estimator_status_samples,filter_fault_flags");
+
+	for (const char *name : test_ratio_names) {
+		fprintf(file, ",%s_test_ratio_max,%s_test_ratio_mean,%s_test_ratio_fail_pct", name, name, name);
+	}
+
+	fprintf(file, "\n%s,%u,%.3f,%.3f,%u,%u", replayFile(), _nr_published_messages, runtime, log_duration,
+		_estimator_status_count, _filter_fault_flags);
+
+	for (const TestRatioStatistics *stats : test_ratios) {
+		const double count = stats->num_samples > 0 ? stats->num_samples : 1;
+		fprintf(file, ",%.4f,%.4f,%.2f", (double)stats->max, stats->sum / count, 100. * stats->num_failed / count);
+	}
+
+	fprintf(file, "\n");
+
+	bool ret = ferror(file) == 0;
+	fclose(file);
+	return ret;
 }
 
 void ReplayEkf2::onExitMainLoop()
@@ -1093,8 +1089,18 @@ void ReplayEkf2::onExitMainLoop()
 	print_sensor_statistics(_vehicle_vision_attitude_msg_id, "vehicle_vision_attitude");
 	print_sensor_statistics(_vehicle_vision_position_msg_id, "vehicle_vision_position");
 
+	const char *summary_file = getenv(replay::ENV_SUMMARY);
+
+	if (summary_file && !should_exit()) {
+		if (writeSummary(summary_file)) {
+			PX4_INFO("Replay summary written to %s", summary_file);
+		}
+	}
+
 	orb_unsubscribe(_vehicle_attitude_sub);
 	_vehicle_attitude_sub = -1;
+	orb_unsubscribe(_estimator_status_sub);
+	_estimator_status_sub = -1;
 }
 
 uint64_t ReplayEkf2::handleTopicDelay(uint64_t next_file_time, uint64_t timestamp_offset)
@@ -1114,6 +1120,15 @@ int Replay::custom_command(int argc, char *argv[])
 		return Replay::task_spawn(argc, argv);
 	}
 
+	if (!strcmp(argv[0], "wait")) {
+		// block until the replay is done, so that a startup script can stop the logger and shut down afterwards
+		while (is_running()) {
+			usleep(100000);
+		}
+
+		return 0;
+	}
+
 	return print_usage("unknown command");
 }
 
@@ -1135,6 +1150,10 @@ the log file to be replayed. The second is the mode, specified via `replay_mode`
 - Generic otherwise: this can be used to replay any module(s), but the replay will be done with the same speed as the
   log was recorded.
 
+In ekf2 mode, the optional `replay_summary` variable names a CSV file to which the runtime and the innovation test
+ratio statistics are written when the replay is done. `Tools/ecl_ekf/batch_replay_ekf.py` uses this to replay many
+logs in parallel, each in a separate px4 process.
+
 The module is typically used together with uORB publisher rules, to specify which messages should be replayed.
 The replay module will just publish all messages that are found in the log. It also applies the parameters from
 the log.
@@ -1147,6 +1166,7 @@ page.
 	PRINT_MODULE_USAGE_COMMAND_DESCR("start", "Start replay, using log file from ENV variable 'replay'");
 	PRINT_MODULE_USAGE_COMMAND_DESCR("trystart", "Same as 'start', but silently exit if no log file given");
 	PRINT_MODULE_USAGE_COMMAND_DESCR("tryapplyparams", "Try to apply the parameters from the log file");
+	PRINT_MODULE_USAGE_COMMAND_DESCR("wait", "Wait until the replay is done");
 	PRINT_MODULE_USAGE_DEFAULT_COMMANDS();
 
 	return 0;
@@ -1196,9 +1216,7 @@ int Replay::applyParams(bool quiet)
 		return -ENOMEM;
 	}
 
-	ifstream replay_file(_replay_file, ios::in | ios::binary);
-
-	if (!r->readDefinitionsAndApplyParams(replay_file)) {
+	if (!r->readDefinitionsAndApplyParams()) {
 		ret = -1;
 	}
 
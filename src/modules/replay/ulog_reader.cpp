@@ -0,0 +1,214 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file ulog_reader.cpp
+ * Memory-mapped ULog reader with a per-msg_id index of the data section.
+ */
+
+#include "ulog_reader.hpp"
+
+#include <px4_log.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <lib/log_compression/lz4_frame.h>
+
+namespace px4
+{
+
+bool ULogReader::open(const char *file_name)
+{
+	close();
+
+	int fd = ::open(file_name, O_RDONLY);
+
+	if (fd < 0) {
+		PX4_ERR("failed to open %s (%i)", file_name, errno);
+		return false;
+	}
+
+	struct stat st;
+
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		PX4_ERR("failed to stat %s", file_name);
+		::close(fd);
+		return false;
+	}
+
+	void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // the mapping keeps a reference to the file
+
+	if (mapping == MAP_FAILED) {
+		PX4_ERR("mmap failed (%i)", errno);
+		return false;
+	}
+
+	const uint8_t *data = (const uint8_t *)mapping;
+	uint32_t magic = 0;
+
+	if (st.st_size >= (off_t)sizeof(magic)) {
+		memcpy(&magic, data, sizeof(magic));
+	}
+
+	if (magic == log_compression::LZ4F_MAGIC) {
+		bool ret = decompress(data, st.st_size);
+		munmap(mapping, st.st_size);
+		return ret;
+	}
+
+	// we walk the file mostly sequentially
+	madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+
+	_data = data;
+	_size = st.st_size;
+	_map_size = st.st_size;
+	return true;
+}
+
+bool ULogReader::decompress(const uint8_t *data, size_t size)
+{
+	log_compression::LZ4FrameReader reader;
+
+	if (!reader.init(data, size) || reader.size() == 0) {
+		PX4_ERR("unsupported LZ4 frame");
+		return false;
+	}
+
+	void *mapping = mmap(nullptr, reader.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if (mapping == MAP_FAILED) {
+		PX4_ERR("failed to allocate %llu bytes", (unsigned long long)reader.size());
+		return false;
+	}
+
+	uint8_t *buffer = (uint8_t *)mapping;
+
+	for (unsigned i = 0; i < reader.num_blocks(); ++i) {
+		if (reader.read_block(i, buffer + reader.block_offset(i), reader.block_size(i)) != (int)reader.block_size(i)) {
+			PX4_ERR("corrupt LZ4 block %u", i);
+			munmap(mapping, reader.size());
+			return false;
+		}
+	}
+
+	PX4_INFO("decompressed log: %u blocks, %llu bytes", reader.num_blocks(), (unsigned long long)reader.size());
+
+	_data = buffer;
+	_size = reader.size();
+	_map_size = reader.size();
+	return true;
+}
+
+void ULogReader::close()
+{
+	if (_data) {
+		munmap((void *)_data, _map_size);
+		_data = nullptr;
+	}
+
+	_size = 0;
+	_map_size = 0;
+	_data_messages.clear();
+	_subscription_messages.clear();
+	_additional_messages.clear();
+	_num_messages = 0;
+}
+
+bool ULogReader::buildIndex(uint64_t data_section_start, uint64_t end_position)
+{
+	_data_messages.clear();
+	_subscription_messages.clear();
+	_additional_messages.clear();
+	_num_messages = 0;
+
+	if (end_position > _size) {
+		end_position = _size;
+	}
+
+	uint64_t offset = data_section_start;
+
+	while (offset < end_position) {
+		const ulog_message_header_s header = messageHeader(offset);
+
+		if (header.msg_type == 0 || offset + ULOG_MSG_HEADER_LEN + header.msg_size > end_position) {
+			break;
+		}
+
+		switch (header.msg_type) {
+		case (int)ULogMessageType::DATA:
+			if (header.msg_size >= sizeof(uint16_t)) {
+				uint16_t msg_id;
+				memcpy(&msg_id, messagePayload(offset), sizeof(msg_id));
+
+				if (_data_messages.size() <= msg_id) {
+					_data_messages.resize(msg_id + 1);
+				}
+
+				_data_messages[msg_id].push_back(offset);
+			}
+
+			break;
+
+		case (int)ULogMessageType::ADD_LOGGED_MSG:
+			_subscription_messages.push_back(offset);
+			break;
+
+		case (int)ULogMessageType::PARAMETER:
+		case (int)ULogMessageType::DROPOUT:
+			_additional_messages.push_back(offset);
+			break;
+
+		default: //skip all others
+			break;
+		}
+
+		++_num_messages;
+		offset += ULOG_MSG_HEADER_LEN + header.msg_size;
+	}
+
+	// after indexing, access is random per subscription
+	if (_data) {
+		madvise((void *)_data, _map_size, MADV_NORMAL);
+	}
+
+	return !_subscription_messages.empty();
+}
+
+} //namespace px4
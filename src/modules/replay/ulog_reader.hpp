@@ -0,0 +1,140 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+#include <logger/messages.h>
+
+namespace px4
+{
+
+/**
+ * @class ULogReader
+ * Memory-maps an ULog file and indexes its data section in a single pass.
+ * Messages are accessed through pointers into the mapping, so reading does not need any system calls.
+ * Offsets into the mapping have no alignment: multi-byte fields must be read with memcpy, not through casts.
+ * LZ4 compressed logs (.ulg.lz4, written with 'logger start -z') are decompressed into memory on open.
+ */
+class ULogReader
+{
+public:
+	ULogReader() = default;
+	~ULogReader() { close(); }
+
+	ULogReader(const ULogReader &) = delete;
+	ULogReader &operator=(const ULogReader &) = delete;
+
+	/**
+	 * map a file
+	 * @return true on success
+	 */
+	bool open(const char *file_name);
+
+	void close();
+
+	bool isOpen() const { return _data != nullptr; }
+
+	/** file size (decompressed size for compressed logs) */
+	uint64_t size() const { return _size; }
+
+	/**
+	 * get (a copy of) the header of the message at a file offset
+	 * @return the header, with msg_type 0 if the header or the message payload does not fit into the file
+	 */
+	ulog_message_header_s messageHeader(uint64_t offset) const
+	{
+		ulog_message_header_s header{};
+
+		if (offset + ULOG_MSG_HEADER_LEN > _size) {
+			return header;
+		}
+
+		memcpy(&header, _data + offset, ULOG_MSG_HEADER_LEN);
+
+		if (offset + ULOG_MSG_HEADER_LEN + header.msg_size > _size) {
+			header.msg_type = 0;
+		}
+
+		return header;
+	}
+
+	/** payload of a message, must only be used for offsets where messageHeader() succeeded */
+	const uint8_t *messagePayload(uint64_t offset) const { return _data + offset + ULOG_MSG_HEADER_LEN; }
+
+	const uint8_t *data() const { return _data; }
+
+	/**
+	 * Index the data section: walk all messages in [data_section_start, end_position) and store the offsets
+	 * of data messages per msg_id, of subscriptions and of the messages without timestamp that
+	 * need to be handled in file order (parameter changes and dropouts).
+	 * Parsing stops at the first truncated message.
+	 * @return false if there is no data section
+	 */
+	bool buildIndex(uint64_t data_section_start, uint64_t end_position);
+
+	/** file offsets of all data messages with a msg_id, in file order */
+	const std::vector<uint64_t> &dataMessages(uint16_t msg_id) const
+	{
+		return msg_id < _data_messages.size() ? _data_messages[msg_id] : _empty;
+	}
+
+	/** file offsets of the ADD_LOGGED_MSG messages */
+	const std::vector<uint64_t> &subscriptionMessages() const { return _subscription_messages; }
+
+	/** file offsets of the PARAMETER and DROPOUT messages in the data section */
+	const std::vector<uint64_t> &additionalMessages() const { return _additional_messages; }
+
+	/** number of indexed messages */
+	uint32_t numMessages() const { return _num_messages; }
+
+private:
+	bool decompress(const uint8_t *data, size_t size);
+
+	const uint8_t *_data{nullptr};
+	uint64_t _size{0};
+	size_t _map_size{0}; ///< size of the mapping to unmap (might differ from _size)
+
+	std::vector<std::vector<uint64_t>> _data_messages; ///< indexed by msg_id
+	std::vector<uint64_t> _subscription_messages;
+	std::vector<uint64_t> _additional_messages;
+	uint32_t _num_messages{0};
+
+	const std::vector<uint64_t> _empty;
+};
+
+} //namespace px4
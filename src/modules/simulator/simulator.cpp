@@ -204,9 +204,6 @@ extern "C" {
 					return 0;
 				}
 
-				// enable lockstep support
-				px4_enable_sim_lockstep();
-
 				g_sim_task = px4_task_spawn_cmd("simulator",
 								SCHED_DEFAULT,
 								SCHED_PRIORITY_MAX,
@@ -340,8 +340,11 @@ private:
 
 	bool _initialized;
 	double _realtime_factor;		///< How fast the simulation runs in comparison to real system time
-	hrt_abstime _last_sim_timestamp;
-	hrt_abstime _last_sitl_timestamp;
+	hrt_abstime _last_sim_timestamp{0};
+	hrt_abstime _last_sitl_timestamp{0};
+
+	bool _lockstep{false};			///< the system time follows the simulator (SIM_LOCKSTEP)
+	hrt_abstime _lockstep_offset{0};	///< system time - simulator time in lockstep mode
 
 	// Lib used to do the battery calculations.
 	Battery _battery;
@@ -385,7 +388,8 @@ private:
 	struct vehicle_status_s _vehicle_status;
 
 	DEFINE_PARAMETERS(
-		(ParamFloat<px4::params::SIM_BAT_DRAIN>) _battery_drain_interval_s ///< battery drain interval
+		(ParamFloat<px4::params::SIM_BAT_DRAIN>) _battery_drain_interval_s, ///< battery drain interval
+		(ParamBool<px4::params::SIM_LOCKSTEP>) _param_lockstep
 	)
 
 	void poll_topics();
@@ -296,6 +296,22 @@ void Simulator::handle_message(mavlink_message_t *msg, bool publish)
 			hrt_abstime curr_sitl_time = hrt_absolute_time();
 			hrt_abstime curr_sim_time = imu.time_usec;
 
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+
+			if (_lockstep) {
+				// the simulator defines the time: advance it and wake up everything that is due
+				if (_lockstep_offset == 0) {
+					_lockstep_offset = curr_sitl_time - curr_sim_time;
+				}
+
+				hrt_lockstep_set_time(curr_sim_time + _lockstep_offset);
+
+				// no delay compensation needed
+				compensation_enabled = false;
+			}
+
+#endif
+
 			if (compensation_enabled && _initialized
 			    && _last_sim_timestamp > 0 && _last_sitl_timestamp > 0
 			    && _last_sitl_timestamp < curr_sitl_time
@@ -786,6 +802,18 @@ void Simulator::pollForMAVLinkMessages(bool publish, int udp_port)
 	// reset system time
 	(void)hrt_reset();
 
+	// the simulator needs to provide its time to drive the system time
+	if (_param_lockstep.get()) {
+		if (_last_sim_timestamp > 0) {
+			PX4_INFO("lockstep enabled, time is driven by the simulator");
+			px4_enable_sim_lockstep();
+			_lockstep = true;
+
+		} else {
+			PX4_WARN("simulator does not send time_usec, lockstep disabled");
+		}
+	}
+
 	// subscribe to topics
 	for (unsigned i = 0; i < (sizeof(_actuator_outputs_sub) / sizeof(_actuator_outputs_sub[0])); i++) {
 		_actuator_outputs_sub[i] = orb_subscribe_multi(ORB_ID(actuator_outputs), i);
@@ -822,7 +850,8 @@ void Simulator::pollForMAVLinkMessages(bool publish, int udp_port)
 
 		//timed out
 		if (pret == 0) {
-			if (!sim_delay) {
+			// in lockstep mode the time just stands still until the simulator continues
+			if (!sim_delay && !_lockstep) {
 				// we do not want to spam the console by default
 				// PX4_WARN("mavlink sim timeout for %d ms", max_wait_ms);
 				sim_delay = true;
@@ -58,3 +58,18 @@ PARAM_DEFINE_INT32(SITL_UDP_PRT, 14560);
  * @group SITL
  */
 PARAM_DEFINE_FLOAT(SIM_BAT_DRAIN, 60);
+
+/**
+ * Simulator lockstep
+ *
+ * If enabled, the system time is driven by the simulator: it only advances
+ * with every HIL_SENSOR message, and all timeouts follow the simulated time.
+ * This requires a simulator that waits for the actuator outputs before
+ * stepping further, and allows to run faster than real time.
+ *
+ * @boolean
+ * @reboot_required true
+ *
+ * @group SITL
+ */
+PARAM_DEFINE_INT32(SIM_LOCKSTEP, 0);
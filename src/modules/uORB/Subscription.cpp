@@ -37,7 +37,9 @@
  */
 
 #include "Subscription.hpp"
+#include "uORBDevices.hpp"
 #include <px4_defines.h>
+#include <px4_posix.h>
 
 namespace uORB
 {
@@ -89,6 +91,41 @@ bool SubscriptionBase::update(void *data)
 	return orb_updated;
 }
 
+const void *SubscriptionBase::borrow()
+{
+	_borrowed_node = nullptr;
+
+	if (!updated()) {
+		return nullptr;
+	}
+
+	orb_borrowdata borrow_data;
+
+	if (px4_ioctl(_handle, ORBIOCBORROW, (unsigned long)(uintptr_t)&borrow_data) != PX4_OK) {
+		PX4_ERR("%s borrow failed", _meta->o_name);
+		return nullptr;
+	}
+
+	_borrowed_node = borrow_data.node;
+	_borrowed_generation = borrow_data.generation;
+	_borrowed_seq = borrow_data.seq;
+	_borrowed_newer = borrow_data.newer;
+
+	return borrow_data.data;
+}
+
+bool SubscriptionBase::release()
+{
+	if (_borrowed_node == nullptr) {
+		return false;
+	}
+
+	bool valid = _borrowed_node->borrow_valid(_borrowed_generation, _borrowed_seq, _borrowed_newer);
+	_borrowed_node = nullptr;
+
+	return valid;
+}
+
 SubscriptionBase::~SubscriptionBase()
 {
 	if (orb_unsubscribe(_handle) != PX4_OK) {
@@ -46,6 +46,8 @@
 namespace uORB
 {
 
+class DeviceNode;
+
 /**
  * Base subscription wrapper class, used in list traversal
  * of various subscriptions.
@@ -82,6 +84,21 @@ public:
 	 */
 	bool update(void *data);
 
+	/**
+	 * Zero-copy alternative to update(): get a pointer to the new message
+	 * inside the topic queue instead of copying it.
+	 * The message can be overwritten by a publisher at any time, so anything
+	 * read through the pointer must only be trusted if release() succeeds.
+	 * @return pointer to the message, nullptr if there is no update
+	 */
+	const void *borrow();
+
+	/**
+	 * Finish reading a message obtained with borrow().
+	 * @return true if the message was not overwritten while it was borrowed
+	 */
+	bool release();
+
 	int getHandle() const { return _handle; }
 
 	const orb_metadata *getMeta() const { return _meta; }
@@ -92,6 +109,11 @@ protected:
 	const struct orb_metadata *_meta;
 	unsigned _instance;
 	int _handle;
+
+	DeviceNode *_borrowed_node{nullptr}; ///< node of the currently borrowed message
+	unsigned _borrowed_generation{0};
+	unsigned _borrowed_seq{0};
+	unsigned _borrowed_newer{0};
 };
 
 /**
@@ -178,6 +200,15 @@ public:
 		return orb_copy(_meta, _handle, &_data) == PX4_OK;
 	}
 
+	/**
+	 * Zero-copy access to a new message, see SubscriptionBase::borrow().
+	 * Unlike update(), this does not change the embedded struct returned by get().
+	 */
+	const T *borrow()
+	{
+		return (const T *)SubscriptionBase::borrow();
+	}
+
 	/*
 	 * This function gets the T struct data
 	 * */
@@ -149,3 +149,8 @@ int orb_get_interval(int handle, unsigned *interval)
 {
 	return uORB::Manager::get_instance()->orb_get_interval(handle, interval);
 }
+
+int orb_set_update_bitmap(int handle, uint32_t *bitmap, unsigned bit)
+{
+	return uORB::Manager::get_instance()->orb_set_update_bitmap(handle, bitmap, bit);
+}
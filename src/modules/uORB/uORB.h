@@ -235,6 +235,11 @@ extern int	orb_set_interval(int handle, unsigned interval) __EXPORT;
  */
 extern int	orb_get_interval(int handle, unsigned *interval) __EXPORT;
 
+/**
+ * @see uORB::Manager::orb_set_update_bitmap()
+ */
+extern int	orb_set_update_bitmap(int handle, uint32_t *bitmap, unsigned bit) __EXPORT;
+
 __END_DECLS
 
 /* Diverse uORB header defines */ //XXX: move to better location
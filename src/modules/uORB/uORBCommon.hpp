@@ -43,6 +43,8 @@
 
 namespace uORB
 {
+class DeviceNode;
+
 static const unsigned orb_maxpath = 64;
 
 struct orb_advertdata {
@@ -51,5 +53,18 @@ struct orb_advertdata {
 	int priority;
 };
 
+struct orb_borrowdata {
+	const void *data; /**< message inside the topic queue */
+	DeviceNode *node; /**< node owning the queue, used to validate the message after reading it */
+	unsigned generation; /**< generation of the borrowed message */
+	unsigned seq; /**< publication sequence of the node when the message was borrowed */
+	unsigned newer; /**< number of messages published after the borrowed one, when it was borrowed */
+};
+
+struct orb_notifydata {
+	uint32_t *bitmap; /**< bitmap owned by the subscriber, nullptr to stop the notification */
+	unsigned bit; /**< bit to set in the bitmap on each publication */
+};
+
 }
 #endif // _uORBCommon_hpp_
@@ -50,6 +50,7 @@
 
 #else
 #include <algorithm>
+#include <unistd.h>
 #define FILE_FLAGS(filp) filp->flags
 #define FILE_PRIV(filp) filp->priv
 #define ITERATE_NODE_MAP() \
@@ -64,11 +65,14 @@
 #include "uORBUtils.hpp"
 #include "uORBManager.hpp"
 #include "uORBCommunicator.hpp"
+#include "uORBTopics.h"
 #include <px4_sem.hpp>
 #include <stdlib.h>
 
 using namespace device;
 
+bool uORB::DeviceNode::_latency_enabled = false;
+
 uORB::DeviceNode::SubscriberData *uORB::DeviceNode::filp_to_sd(device::file_t *filp)
 {
 #ifndef __PX4_NUTTX
@@ -81,8 +85,74 @@ uORB::DeviceNode::SubscriberData *uORB::DeviceNode::filp_to_sd(device::file_t *f
 	return (SubscriberData *)(FILE_PRIV(filp));
 }
 
+#ifndef __PX4_NUTTX
+void
+uORB::DeviceNode::seq_wait(unsigned &spins)
+{
+	if (++spins < SEQ_SPIN_MAX) {
+		return;
+	}
+
+	/* The thread we wait for may have been preempted by us. Under SCHED_FIFO it only
+	 * continues if we sleep: sched_yield() does not hand the CPU to a lower priority,
+	 * and a very short sleep (no timer slack for RT threads) barely lets it run. */
+	spins = 0;
+	usleep(SEQ_SLEEP_US);
+}
+
+unsigned
+uORB::DeviceNode::seq_write_begin()
+{
+	/* claim the node by making the sequence odd. Concurrent publishers of the same
+	 * instance are rare, so spinning here is cheaper than a mutex. */
+	unsigned seq = __atomic_load_n(&_seq, __ATOMIC_RELAXED);
+	unsigned spins = 0;
+
+	for (;;) {
+		if ((seq & 1) == 0 &&
+		    __atomic_compare_exchange_n(&_seq, &seq, seq + 1, true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+			break;
+		}
+
+		seq_wait(spins);
+		seq = __atomic_load_n(&_seq, __ATOMIC_RELAXED);
+	}
+
+	/* the buffer must not be modified before readers can see the odd sequence */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	return seq + 1;
+}
+
+void
+uORB::DeviceNode::seq_write_end(unsigned seq)
+{
+	__atomic_store_n(&_seq, seq + 1, __ATOMIC_RELEASE);
+}
+
+unsigned
+uORB::DeviceNode::seq_read_begin() const
+{
+	unsigned seq;
+	unsigned spins = 0;
+
+	while ((seq = __atomic_load_n(&_seq, __ATOMIC_ACQUIRE)) & 1) {
+		/* a publisher is in the middle of a write */
+		seq_wait(spins);
+	}
+
+	return seq;
+}
+
+bool
+uORB::DeviceNode::seq_read_retry(unsigned seq) const
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&_seq, __ATOMIC_RELAXED) != seq;
+}
+#endif /* __PX4_NUTTX */
+
 uORB::DeviceNode::DeviceNode(const struct orb_metadata *meta, const char *name, const char *path,
-			     int priority, unsigned int queue_size) :
+			     int priority, uint8_t instance, unsigned int queue_size) :
 	CDev(name, path),
 	_meta(meta),
 	_data(nullptr),
@@ -91,6 +161,7 @@ uORB::DeviceNode::DeviceNode(const struct orb_metadata *meta, const char *name,
 	_priority((uint8_t)priority),
 	_published(false),
 	_queue_size(queue_size),
+	_instance(instance),
 	_subscriber_count(0),
 	_publisher(0)
 {
@@ -102,6 +173,18 @@ uORB::DeviceNode::~DeviceNode()
 		delete[] _data;
 	}
 
+	if (_latency != nullptr) {
+		LatencyHistogram *histogram = _latency->total.next;
+
+		while (histogram != nullptr) {
+			LatencyHistogram *next = histogram->next;
+			delete histogram;
+			histogram = next;
+		}
+
+		delete[] _latency->publish_time;
+		delete _latency;
+	}
 }
 
 int
@@ -196,6 +279,18 @@ uORB::DeviceNode::close(device::file_t *filp)
 				hrt_cancel(&sd->update_interval->update_call);
 			}
 
+			if (sd->latency) {
+				/* keep the histogram for statistics, a new subscriber may take it over */
+				lock();
+				sd->latency->active = false;
+				unlock();
+			}
+
+			if (sd->update_bitmap) {
+				orb_notifydata notify_data{};
+				set_update_bitmap(sd, &notify_data);
+			}
+
 			remove_internal_subscriber();
 			delete sd;
 			sd = nullptr;
@@ -220,33 +315,58 @@ uORB::DeviceNode::read(device::file_t *filp, char *buffer, size_t buflen)
 		return -EIO;
 	}
 
+	const unsigned previous_generation = sd->generation;
+	unsigned generation;
+	unsigned message;
+	hrt_abstime publish_time = 0;
+
 	/*
 	 * Perform an atomic copy & state update
 	 */
+#ifdef __PX4_NUTTX
 	ATOMIC_ENTER;
 
-	if (_generation > sd->generation + _queue_size) {
-		/* Reader is too far behind: some messages are lost */
-		_lost_messages += _generation - (sd->generation + _queue_size);
-		sd->generation = _generation - _queue_size;
-	}
-
-	if (_generation == sd->generation && sd->generation > 0) {
-		/* The subscriber already read the latest message, but nothing new was published yet.
-		 * Return the previous message
-		 */
-		--sd->generation;
-	}
+	generation = previous_generation;
+	_lost_messages += next_message(generation, message);
 
 	/* if the caller doesn't want the data, don't give it to them */
 	if (nullptr != buffer) {
-		memcpy(buffer, _data + (_meta->o_size * (sd->generation % _queue_size)), _meta->o_size);
+		memcpy(buffer, _data + (_meta->o_size * (message % _queue_size)), _meta->o_size);
 	}
 
-	if (sd->generation < _generation) {
-		++sd->generation;
+	if (nullptr != _latency) {
+		publish_time = _latency->publish_time[message % _queue_size];
 	}
 
+#else
+	LatencyData *latency = __atomic_load_n(&_latency, __ATOMIC_ACQUIRE);
+	unsigned seq;
+	uint32_t lost_messages;
+
+	do {
+		seq = seq_read_begin();
+		generation = previous_generation;
+		lost_messages = next_message(generation, message);
+
+		if (nullptr != buffer) {
+			memcpy(buffer, _data + (_meta->o_size * (message % _queue_size)), _meta->o_size);
+		}
+
+		if (nullptr != latency) {
+			publish_time = latency->publish_time[message % _queue_size];
+		}
+
+		/* if a publisher modified the queue while we copied from it, try again */
+	} while (seq_read_retry(seq));
+
+	if (lost_messages > 0) {
+		__atomic_fetch_add(&_lost_messages, lost_messages, __ATOMIC_RELAXED);
+	}
+
+#endif
+
+	sd->generation = generation;
+
 	/* set priority */
 	sd->set_priority(_priority);
 
@@ -256,11 +376,138 @@ uORB::DeviceNode::read(device::file_t *filp, char *buffer, size_t buflen)
 	 */
 	sd->set_update_reported(false);
 
+#ifdef __PX4_NUTTX
 	ATOMIC_LEAVE;
+#endif
+
+	if (_latency_enabled) {
+		record_latency(sd, previous_generation, message, publish_time);
+	}
 
 	return _meta->o_size;
 }
 
+uint32_t
+uORB::DeviceNode::next_message(unsigned &generation, unsigned &message)
+{
+	const unsigned node_generation = _generation;
+	uint32_t lost_messages = 0;
+
+	if (node_generation > generation + _queue_size) {
+		/* Reader is too far behind: some messages are lost */
+		lost_messages = node_generation - (generation + _queue_size);
+		generation = node_generation - _queue_size;
+	}
+
+	if (node_generation == generation && generation > 0) {
+		/* The subscriber already read the latest message, but nothing new was published yet.
+		 * Return the previous message
+		 */
+		--generation;
+	}
+
+	message = generation;
+
+	if (generation < node_generation) {
+		++generation;
+	}
+
+	return lost_messages;
+}
+
+int
+uORB::DeviceNode::borrow(SubscriberData *sd, orb_borrowdata *borrow_data)
+{
+	/* if the object has not been written yet, there is nothing to borrow */
+	if (_data == nullptr) {
+		return -EIO;
+	}
+
+	const unsigned previous_generation = sd->generation;
+	unsigned generation = previous_generation;
+	unsigned message;
+	hrt_abstime publish_time = 0;
+
+	/* only the state is updated here, the data itself is validated by the caller
+	 * through borrow_valid() once it is done reading it */
+#ifdef __PX4_NUTTX
+	ATOMIC_ENTER;
+	_lost_messages += next_message(generation, message);
+
+	if (nullptr != _latency) {
+		publish_time = _latency->publish_time[message % _queue_size];
+	}
+
+	ATOMIC_LEAVE;
+
+	borrow_data->seq = 0;
+	borrow_data->newer = 0;
+#else
+	LatencyData *latency = __atomic_load_n(&_latency, __ATOMIC_ACQUIRE);
+	unsigned seq;
+	unsigned node_generation;
+	uint32_t lost_messages;
+
+	/* take the queue state as a consistent snapshot, release() checks the publications since */
+	do {
+		seq = seq_read_begin();
+		node_generation = _generation;
+		generation = previous_generation;
+		lost_messages = next_message(generation, message);
+
+		if (nullptr != latency) {
+			publish_time = latency->publish_time[message % _queue_size];
+		}
+
+	} while (seq_read_retry(seq));
+
+	if (lost_messages > 0) {
+		__atomic_fetch_add(&_lost_messages, lost_messages, __ATOMIC_RELAXED);
+	}
+
+	borrow_data->seq = seq;
+	borrow_data->newer = node_generation - message - 1;
+#endif
+
+	sd->generation = generation;
+	sd->set_priority(_priority);
+	sd->set_update_reported(false);
+
+	if (_latency_enabled) {
+		record_latency(sd, previous_generation, message, publish_time);
+	}
+
+	borrow_data->data = _data + (_meta->o_size * (message % _queue_size));
+	borrow_data->node = this;
+	borrow_data->generation = message;
+
+	return PX4_OK;
+}
+
+bool
+uORB::DeviceNode::borrow_valid(unsigned generation, unsigned seq, unsigned newer) const
+{
+	/* The slot of a message is reused by the publication of generation + _queue_size. */
+#ifdef __PX4_NUTTX
+	(void)seq;
+	(void)newer;
+	return _generation - generation <= _queue_size;
+#else
+	(void)generation;
+
+	/* all reads of the borrowed data must have completed before we look at the sequence */
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	const uint32_t seq_now = __atomic_load_n(&_seq, __ATOMIC_ACQUIRE);
+
+	/* publications started since the borrow, including one in progress: each moves the sequence by 2.
+	 * Only distances are compared, so the wrap-around of the counters does not matter. */
+	const uint32_t published = (uint32_t)(seq_now - seq + 1) / 2;
+
+	/* the slot survives the publications that fill the remaining queue entries */
+	return published + newer < _queue_size;
+#endif
+}
+
 ssize_t
 uORB::DeviceNode::write(device::file_t *filp, const char *buffer, size_t buflen)
 {
@@ -310,18 +557,73 @@ uORB::DeviceNode::write(device::file_t *filp, const char *buffer, size_t buflen)
 		return -EIO;
 	}
 
+	/* the latency measurement needs the publication time of every message in the queue */
+	if (_latency_enabled && nullptr == _latency) {
+#ifdef __PX4_NUTTX
+
+		if (!up_interrupt_context()) {
+#endif
+			lock();
+
+			if (nullptr == _latency) {
+				LatencyData *latency = new LatencyData();
+
+				if (latency != nullptr) {
+					latency->publish_time = new hrt_abstime[_queue_size]();
+
+					if (latency->publish_time == nullptr) {
+						delete latency;
+						latency = nullptr;
+					}
+				}
+
+				/* readers access it without the lock */
+				__atomic_store_n(&_latency, latency, __ATOMIC_RELEASE);
+			}
+
+			unlock();
+#ifdef __PX4_NUTTX
+		}
+
+#endif
+	}
+
 	/* Perform an atomic copy. */
+#ifdef __PX4_NUTTX
 	ATOMIC_ENTER;
+#else
+	/* take the timestamp outside of the write section to keep it as short as possible */
+	const hrt_abstime now = hrt_absolute_time();
+	const unsigned seq = seq_write_begin();
+#endif
 	memcpy(_data + (_meta->o_size * (_generation % _queue_size)), buffer, _meta->o_size);
 
 	/* update the timestamp and generation count */
+#ifdef __PX4_NUTTX
 	_last_update = hrt_absolute_time();
+#else
+	_last_update = now;
+#endif
+
+	if (nullptr != _latency) {
+		_latency->publish_time[_generation % _queue_size] = _last_update;
+	}
+
 	/* wrap-around happens after ~49 days, assuming a publisher rate of 1 kHz */
 	_generation++;
 
 	_published = true;
 
+#ifdef __PX4_NUTTX
 	ATOMIC_LEAVE;
+#else
+	seq_write_end(seq);
+#endif
+
+	/* flag the update to the subscribers with an update bitmap */
+	if (__atomic_load_n(&_notify_list, __ATOMIC_ACQUIRE) != nullptr) {
+		notify_update_bitmaps();
+	}
 
 	/* notify any poll waiters */
 	poll_notify(POLLIN);
@@ -329,6 +631,81 @@ uORB::DeviceNode::write(device::file_t *filp, const char *buffer, size_t buflen)
 	return _meta->o_size;
 }
 
+void
+uORB::DeviceNode::notify_update_bitmaps()
+{
+#ifdef __PX4_NUTTX
+	ATOMIC_ENTER;
+
+	for (SubscriberData *sd = _notify_list; sd != nullptr; sd = sd->next_notify) {
+		__atomic_fetch_or(&sd->update_bitmap[sd->update_bit / 32], (uint32_t)1 << (sd->update_bit % 32),
+				  __ATOMIC_RELEASE);
+	}
+
+	ATOMIC_LEAVE;
+#else
+	/* walk the list without the node lock (a mutex on POSIX): set_update_bitmap() waits until there
+	 * are no walkers before it modifies an entry it unlinked, and the entry is freed only after that */
+	__atomic_fetch_add(&_notify_walkers, 1, __ATOMIC_SEQ_CST);
+
+	for (SubscriberData *sd = __atomic_load_n(&_notify_list, __ATOMIC_ACQUIRE); sd != nullptr;
+	     sd = __atomic_load_n(&sd->next_notify, __ATOMIC_ACQUIRE)) {
+		__atomic_fetch_or(&sd->update_bitmap[sd->update_bit / 32], (uint32_t)1 << (sd->update_bit % 32),
+				  __ATOMIC_RELEASE);
+	}
+
+	__atomic_fetch_sub(&_notify_walkers, 1, __ATOMIC_RELEASE);
+#endif
+}
+
+int
+uORB::DeviceNode::set_update_bitmap(SubscriberData *sd, const orb_notifydata *notify_data)
+{
+	ATOMIC_ENTER;
+
+	/* unlink it first, if it already had a bitmap */
+	if (sd->update_bitmap != nullptr) {
+		SubscriberData **prev = &_notify_list;
+
+		while (*prev != nullptr && *prev != sd) {
+			prev = &(*prev)->next_notify;
+		}
+
+		if (*prev == sd) {
+			__atomic_store_n(prev, sd->next_notify, __ATOMIC_RELEASE);
+		}
+
+#ifndef __PX4_NUTTX
+		/* publishers that are still walking the list might be at sd: let them pass it (this is
+		 * rare, and the walk is short) */
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		unsigned spins = 0;
+
+		while (__atomic_load_n(&_notify_walkers, __ATOMIC_ACQUIRE) != 0) {
+			seq_wait(spins);
+		}
+
+#endif
+		sd->update_bitmap = nullptr;
+	}
+
+	if (notify_data->bitmap != nullptr) {
+		sd->update_bitmap = notify_data->bitmap;
+		sd->update_bit = notify_data->bit;
+		sd->next_notify = _notify_list;
+		__atomic_store_n(&_notify_list, sd, __ATOMIC_RELEASE);
+
+		/* data the subscriber did not read yet counts as an update as well */
+		if (_published && sd->generation != _generation) {
+			__atomic_fetch_or(&sd->update_bitmap[sd->update_bit / 32], (uint32_t)1 << (sd->update_bit % 32),
+					  __ATOMIC_RELEASE);
+		}
+	}
+
+	ATOMIC_LEAVE;
+	return PX4_OK;
+}
+
 int
 uORB::DeviceNode::ioctl(device::file_t *filp, int cmd, unsigned long arg)
 {
@@ -336,9 +713,19 @@ uORB::DeviceNode::ioctl(device::file_t *filp, int cmd, unsigned long arg)
 
 	switch (cmd) {
 	case ORBIOCLASTUPDATE: {
+#ifdef __PX4_NUTTX
 			ATOMIC_ENTER;
 			*(hrt_abstime *)arg = _last_update;
 			ATOMIC_LEAVE;
+#else
+			unsigned seq;
+
+			do {
+				seq = seq_read_begin();
+				*(hrt_abstime *)arg = _last_update;
+			} while (seq_read_retry(seq));
+
+#endif
 			return PX4_OK;
 		}
 
@@ -417,6 +804,12 @@ uORB::DeviceNode::ioctl(device::file_t *filp, int cmd, unsigned long arg)
 
 		return OK;
 
+	case ORBIOCBORROW:
+		return borrow(sd, (orb_borrowdata *)arg);
+
+	case ORBIOCSETNOTIFY:
+		return set_update_bitmap(sd, (const orb_notifydata *)arg);
+
 	default:
 		/* give it to the superclass */
 		return CDev::ioctl(filp, cmd, arg);
@@ -707,6 +1100,64 @@ uORB::DeviceNode::update_deferred_trampoline(void *arg)
 	node->update_deferred();
 }
 
+void
+uORB::DeviceNode::record_latency(SubscriberData *sd, unsigned previous_generation, unsigned message,
+				 hrt_abstime publish_time)
+{
+	/* only count the first read of a message */
+	if (publish_time == 0 || (int)(message - previous_generation) < 0) {
+		return;
+	}
+
+	const hrt_abstime latency = hrt_absolute_time() - publish_time;
+
+	_latency->total.add(latency);
+
+	if (sd->latency == nullptr) {
+		lock();
+
+		/* take over the histogram of a subscriber that is gone, or add a new one */
+		LatencyHistogram *histogram = _latency->total.next;
+
+		while (histogram != nullptr && histogram->active) {
+			histogram = histogram->next;
+		}
+
+		if (histogram != nullptr) {
+			histogram->reset();
+			histogram->active = true;
+
+		} else {
+			histogram = new LatencyHistogram();
+
+			if (histogram != nullptr) {
+				histogram->next = _latency->total.next;
+				/* the list is traversed without the lock */
+				__atomic_store_n(&_latency->total.next, histogram, __ATOMIC_RELEASE);
+			}
+		}
+
+		if (histogram != nullptr) {
+			histogram->subscriber = px4_getpid();
+		}
+
+		unlock();
+
+		sd->latency = histogram;
+	}
+
+	if (sd->latency != nullptr) {
+		sd->latency->add(latency);
+	}
+}
+
+uORB::LatencyHistogram *
+uORB::DeviceNode::latency_histograms()
+{
+	LatencyData *latency = __atomic_load_n(&_latency, __ATOMIC_ACQUIRE);
+	return latency ? &latency->total : nullptr;
+}
+
 bool
 uORB::DeviceNode::print_statistics(bool reset)
 {
@@ -714,8 +1165,9 @@ uORB::DeviceNode::print_statistics(bool reset)
 		return false;
 	}
 
-	lock();
 	//This can be wrong: if a reader never reads, _lost_messages will not be increased either
+#ifdef __PX4_NUTTX
+	lock();
 	uint32_t lost_messages = _lost_messages;
 
 	if (reset) {
@@ -723,6 +1175,10 @@ uORB::DeviceNode::print_statistics(bool reset)
 	}
 
 	unlock();
+#else
+	/* readers account lost messages without taking the lock */
+	uint32_t lost_messages = reset ? __atomic_exchange_n(&_lost_messages, 0, __ATOMIC_RELAXED) : _lost_messages;
+#endif
 
 	PX4_INFO("%s: %i", _meta->o_name, lost_messages);
 	return true;
@@ -840,6 +1296,26 @@ uORB::DeviceMaster::DeviceMaster() :
 	CDev("obj_master", TOPIC_MASTER_DEVICE_PATH)
 {
 	_last_statistics_output = hrt_absolute_time();
+
+	/* size the index for a load factor of at most ~2/3 with every generated topic advertised once */
+	unsigned index_size = 16;
+
+	while (index_size < orb_topics_count() * 3 / 2) {
+		index_size <<= 1;
+	}
+
+	_node_index = new uORB::DeviceNode *[index_size]();
+
+	if (_node_index != nullptr) {
+		_node_index_mask = index_size - 1;
+	}
+}
+
+uORB::DeviceMaster::~DeviceMaster()
+{
+	setLatencyReporting(false);
+
+	delete[] _node_index;
 }
 
 int
@@ -887,6 +1363,21 @@ uORB::DeviceMaster::ioctl(device::file_t *filp, int cmd, unsigned long arg)
 					*(adv->instance) = group_tries;
 				}
 
+				/* an existing node does not need to be constructed just to see its registration fail */
+				bool index_complete;
+				uORB::DeviceNode *indexed_node = findInIndex(meta, group_tries, index_complete);
+
+				if (indexed_node != nullptr) {
+					if (!indexed_node->is_published()) {
+						/* nothing has been published yet, lets claim it */
+						indexed_node->set_priority(adv->priority);
+						ret = PX4_OK;
+					}
+
+					group_tries++;
+					continue;
+				}
+
 				const char *objname = meta->o_name; //no need for a copy, meta->o_name will never be freed or changed
 
 				/* driver wants a permanent copy of the path, so make one here */
@@ -897,7 +1388,7 @@ uORB::DeviceMaster::ioctl(device::file_t *filp, int cmd, unsigned long arg)
 				}
 
 				/* construct the new node */
-				uORB::DeviceNode *node = new uORB::DeviceNode(meta, objname, devpath, adv->priority);
+				uORB::DeviceNode *node = new uORB::DeviceNode(meta, objname, devpath, adv->priority, group_tries);
 
 				/* if we didn't get a device, that's bad */
 				if (node == nullptr) {
@@ -915,7 +1406,11 @@ uORB::DeviceMaster::ioctl(device::file_t *filp, int cmd, unsigned long arg)
 					if (ret == -EEXIST) {
 						/* if the node exists already, get the existing one and check if
 						 * something has been published yet. */
-						uORB::DeviceNode *existing_node = getDeviceNodeLocked(devpath);
+						uORB::DeviceNode *existing_node = nullptr;
+
+						if (!index_complete) {
+							existing_node = getDeviceNodeLocked(devpath);
+						}
 
 						if ((existing_node != nullptr) && !(existing_node->is_published())) {
 							/* nothing has been published yet, lets claim it */
@@ -937,6 +1432,7 @@ uORB::DeviceMaster::ioctl(device::file_t *filp, int cmd, unsigned long arg)
 #else
 					_node_map[std::string(devpath)] = node;
 #endif
+					addToIndexLocked(node);
 				}
 
 				group_tries++;
@@ -1055,19 +1551,44 @@ void uORB::DeviceMaster::addNewDeviceNodes(DeviceNodeStatisticsData **first_node
 
 #define CLEAR_LINE "\033[K"
 
+static void print_latency_histogram(const char *label, const uORB::LatencyHistogram &histogram)
+{
+	printf(CLEAR_LINE "    %-10s %8u %6u %6u %6u %6u\n", label, (unsigned)histogram.count(),
+	       (unsigned)histogram.percentile(50), (unsigned)histogram.percentile(90),
+	       (unsigned)histogram.percentile(99), (unsigned)histogram.max());
+}
+
 void uORB::DeviceMaster::showTop(char **topic_filter, int num_filters)
 {
 
 	bool print_active_only = true;
+	bool print_all = false;
+	bool print_latency = false;
 
-	if (topic_filter && num_filters > 0) {
+	while (topic_filter && num_filters > 0 && topic_filter[0][0] == '-') {
 		if (!strcmp("-a", topic_filter[0])) {
-			num_filters = 0;
+			print_all = true;
+
+		} else if (!strcmp("-l", topic_filter[0])) {
+			print_latency = true;
 		}
 
+		++topic_filter;
+		--num_filters;
+	}
+
+	if (print_all) {
+		num_filters = 0; // -a prints all topics, the filters are ignored
+	}
+
+	if (print_all || num_filters > 0) {
 		print_active_only = false; // print non-active if -a or some filter given
 	}
 
+	if (print_latency) {
+		DeviceNode::set_latency_enabled(true);
+	}
+
 	printf("\033[2J\n"); //clear screen
 
 	lock();
@@ -1158,6 +1679,11 @@ void uORB::DeviceMaster::showTop(char **topic_filter, int num_filters)
 #else
 			printf(CLEAR_LINE "%*s INST #SUB #MSG #LOST #QSIZE\n", -(int)max_topic_name_length + 2, "TOPIC NAME");
 #endif
+
+			if (print_latency) {
+				printf(CLEAR_LINE "    %-10s %8s %6s %6s %6s %6s [us]\n", "LATENCY", "#READS", "P50", "P90", "P99", "MAX");
+			}
+
 			cur_node = first_node;
 
 			while (cur_node) {
@@ -1171,6 +1697,19 @@ void uORB::DeviceMaster::showTop(char **topic_filter, int num_filters)
 					       cur_node->node->get_meta()->o_name, (int)cur_node->instance,
 					       (int)cur_node->node->subscriber_count(), cur_node->pub_msg_delta,
 					       (int)cur_node->lost_msg_delta, cur_node->node->get_queue_size());
+
+					LatencyHistogram *histogram = print_latency ? cur_node->node->latency_histograms() : nullptr;
+
+					for (; histogram != nullptr; histogram = histogram->next) {
+						if (histogram->subscriber < 0) {
+							print_latency_histogram("all", *histogram);
+
+						} else if (histogram->active) {
+							char label[16];
+							snprintf(label, sizeof(label), "task %i", histogram->subscriber);
+							print_latency_histogram(label, *histogram);
+						}
+					}
 				}
 
 				cur_node = cur_node->next;
@@ -1182,6 +1721,11 @@ void uORB::DeviceMaster::showTop(char **topic_filter, int num_filters)
 		}
 	}
 
+	/* leave the measurement running if the histograms are published */
+	if (print_latency && !_latency_reporting) {
+		DeviceNode::set_latency_enabled(false);
+	}
+
 	//cleanup
 	cur_node = first_node;
 
@@ -1194,6 +1738,98 @@ void uORB::DeviceMaster::showTop(char **topic_filter, int num_filters)
 
 #undef CLEAR_LINE
 
+void uORB::DeviceMaster::setLatencyReporting(bool enabled)
+{
+	if (enabled == _latency_reporting) {
+		return;
+	}
+
+	_latency_reporting = enabled;
+	DeviceNode::set_latency_enabled(enabled);
+
+	if (enabled) {
+		work_queue(LPWORK, &_latency_work, (worker_t)&DeviceMaster::latencyReportTrampoline, this, 0);
+
+	} else {
+		work_cancel(LPWORK, &_latency_work);
+	}
+}
+
+void uORB::DeviceMaster::latencyReportTrampoline(void *arg)
+{
+	uORB::DeviceMaster *dev_master = (uORB::DeviceMaster *)arg;
+
+	dev_master->latencyReport();
+}
+
+void uORB::DeviceMaster::latencyReport()
+{
+	struct {
+		DeviceNode *node;
+		LatencyHistogram *histogram;
+	} reports[LATENCY_REPORTS_PER_INTERVAL];
+	int num_reports = 0;
+	unsigned index = 0;
+
+	lock();
+
+	ITERATE_NODE_MAP() {
+		INIT_NODE_MAP_VARS(node, node_name)
+
+		for (LatencyHistogram *histogram = node->latency_histograms();
+		     histogram != nullptr && num_reports < LATENCY_REPORTS_PER_INTERVAL; histogram = histogram->next, ++index) {
+
+			if (index >= _latency_report_cursor && histogram->count() != histogram->published_count) {
+				reports[num_reports].node = node;
+				reports[num_reports].histogram = histogram;
+				++num_reports;
+			}
+		}
+
+		if (num_reports == LATENCY_REPORTS_PER_INTERVAL) {
+			break;
+		}
+	}
+
+	unlock();
+
+	/* continue after the last reported histogram next time, or start over once we reached the end */
+	_latency_report_cursor = num_reports == LATENCY_REPORTS_PER_INTERVAL ? index : 0;
+
+	/* publish without holding the lock, advertising needs it */
+	uorb_latency_s report{};
+
+	for (int i = 0; i < num_reports; ++i) {
+		LatencyHistogram *histogram = reports[i].histogram;
+
+		report.timestamp = hrt_absolute_time();
+		strncpy(report.topic_name, reports[i].node->get_meta()->o_name, sizeof(report.topic_name) - 1);
+		report.instance = reports[i].node->get_instance();
+		report.subscriber = histogram->subscriber;
+		histogram->copy_buckets(report.buckets);
+		report.max = histogram->max();
+		report.count = 0;
+
+		for (int bucket = 0; bucket < LatencyHistogram::NUM_BUCKETS; ++bucket) {
+			report.count += report.buckets[bucket];
+		}
+
+		histogram->published_count = report.count;
+
+		if (_latency_pub == nullptr) {
+			_latency_pub = orb_advertise_queue(ORB_ID(uorb_latency), &report, uorb_latency_s::ORB_QUEUE_LENGTH);
+
+		} else {
+			orb_publish(ORB_ID(uorb_latency), _latency_pub, &report);
+		}
+	}
+
+	if (_latency_reporting) {
+		work_queue(LPWORK, &_latency_work, (worker_t)&DeviceMaster::latencyReportTrampoline, this,
+			   USEC2TICK(LATENCY_REPORT_INTERVAL));
+	}
+}
+
 uORB::DeviceNode *uORB::DeviceMaster::getDeviceNode(const char *nodepath)
 {
 	lock();
@@ -1205,6 +1841,84 @@ uORB::DeviceNode *uORB::DeviceMaster::getDeviceNode(const char *nodepath)
 }
 
 
+unsigned uORB::DeviceMaster::indexSlot(const struct orb_metadata *meta, uint8_t instance) const
+{
+	/* metadata are statically allocated and at least 4 byte aligned, so drop the low bits */
+	uint32_t hash = (uint32_t)((uintptr_t)meta >> 2) * 2654435761u; // Knuth's multiplicative hash
+	return (hash + instance) & _node_index_mask;
+}
+
+void uORB::DeviceMaster::addToIndexLocked(uORB::DeviceNode *node)
+{
+	if (_node_index == nullptr) {
+		return;
+	}
+
+	unsigned slot = indexSlot(node->get_meta(), node->get_instance());
+
+	for (unsigned probes = 0; probes <= _node_index_mask; ++probes) {
+		if (_node_index[slot] == nullptr) {
+			/* publish the node to lock-free readers */
+			__atomic_store_n(&_node_index[slot], node, __ATOMIC_RELEASE);
+			return;
+		}
+
+		slot = (slot + 1) & _node_index_mask;
+	}
+
+	PX4_WARN("uORB topic index full");
+	__atomic_store_n(&_node_index_overflow, true, __ATOMIC_RELEASE);
+}
+
+uORB::DeviceNode *uORB::DeviceMaster::findInIndex(const struct orb_metadata *meta, uint8_t instance, bool &complete)
+{
+	complete = false;
+
+	if (_node_index == nullptr) {
+		return nullptr;
+	}
+
+	unsigned slot = indexSlot(meta, instance);
+
+	for (unsigned probes = 0; probes <= _node_index_mask; ++probes) {
+		uORB::DeviceNode *node = __atomic_load_n(&_node_index[slot], __ATOMIC_ACQUIRE);
+
+		if (node == nullptr) {
+			break;
+		}
+
+		if (node->get_meta() == meta && node->get_instance() == instance) {
+			complete = true;
+			return node;
+		}
+
+		slot = (slot + 1) & _node_index_mask;
+	}
+
+	complete = !__atomic_load_n(&_node_index_overflow, __ATOMIC_ACQUIRE);
+	return nullptr;
+}
+
+uORB::DeviceNode *uORB::DeviceMaster::getDeviceNode(const struct orb_metadata *meta, uint8_t instance)
+{
+	bool complete;
+	uORB::DeviceNode *node = findInIndex(meta, instance, complete);
+
+	if (node != nullptr || complete) {
+		return node;
+	}
+
+	/* no index available or it is incomplete: search by path */
+	char nodepath[orb_maxpath];
+	int inst = instance;
+
+	if (uORB::Utils::node_mkpath(nodepath, meta, &inst) != OK) {
+		return nullptr;
+	}
+
+	return getDeviceNode(nodepath);
+}
+
 #ifdef __PX4_NUTTX
 uORB::DeviceNode *uORB::DeviceMaster::getDeviceNodeLocked(const char *nodepath)
 {
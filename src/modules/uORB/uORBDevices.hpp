@@ -35,6 +35,8 @@
 
 #include <stdint.h>
 #include "uORBCommon.hpp"
+#include "uORBLatency.hpp"
+#include <px4_workqueue.h>
 
 
 #ifdef __PX4_NUTTX
@@ -63,7 +65,7 @@ class uORB::DeviceNode : public device::CDev
 {
 public:
 	DeviceNode(const struct orb_metadata *meta, const char *name, const char *path,
-		   int priority, unsigned int queue_size = 1);
+		   int priority, uint8_t instance = 0, unsigned int queue_size = 1);
 	~DeviceNode();
 
 	/**
@@ -184,9 +186,33 @@ public:
 	uint32_t lost_message_count() const { return _lost_messages; }
 	unsigned int published_message_count() const { return _generation; }
 	const struct orb_metadata *get_meta() const { return _meta; }
+	uint8_t get_instance() const { return _instance; }
 
 	void set_priority(uint8_t priority) { _priority = priority; }
 
+	/**
+	 * Check whether a message obtained with ORBIOCBORROW is still intact, i.e. no publisher
+	 * started to overwrite its slot in the queue. Call this after the data has been consumed.
+	 * @param generation the generation returned with the borrowed message
+	 * @param seq the sequence snapshot returned with the borrowed message
+	 * @param newer the number of newer messages in the queue returned with the borrowed message
+	 * @return true if the message was valid the whole time
+	 */
+	bool borrow_valid(unsigned generation, unsigned seq, unsigned newer) const;
+
+	/**
+	 * Enable or disable measuring the publish-to-read latency of all topics.
+	 */
+	static void set_latency_enabled(bool enabled) { _latency_enabled = enabled; }
+	static bool latency_enabled() { return _latency_enabled; }
+
+	/**
+	 * Get the latency histograms of this topic: the first one is the sum over all subscribers,
+	 * followed by one per subscriber (linked via next). Entries are never freed.
+	 * @return nullptr if the latency was never measured
+	 */
+	LatencyHistogram *latency_histograms();
+
 protected:
 	virtual pollevent_t poll_state(device::file_t *filp);
 	virtual void poll_notify_one(px4_pollfd_struct_t *fds, pollevent_t events);
@@ -205,12 +231,27 @@ private:
 		unsigned  generation; /**< last generation the subscriber has seen */
 		int   flags; /**< lowest 8 bits: priority of publisher, 9. bit: update_reported bit */
 		UpdateIntervalData *update_interval; /**< if null, no update interval */
+		LatencyHistogram *latency; /**< latency histogram of this subscriber, allocated on the first measurement */
+		uint32_t *update_bitmap; /**< if not null, update_bit gets set in it on every publication */
+		unsigned update_bit;
+		SubscriberData *next_notify; /**< next subscriber in _notify_list */
 
 		int priority() const { return flags & 0xff; }
-		void set_priority(uint8_t prio) { flags = (flags & ~0xff) | prio; }
+		void set_priority(uint8_t prio) { set_flags(0xff, prio); }
 
 		bool update_reported() const { return flags & (1 << 8); }
-		void set_update_reported(bool update_reported_flag) { flags = (flags & ~(1 << 8)) | (((int)update_reported_flag) << 8); }
+		void set_update_reported(bool update_reported_flag) { set_flags(1 << 8, ((int)update_reported_flag) << 8); }
+
+	private:
+		/* the reader updates the flags without holding the node lock, while a publisher might
+		 * concurrently do the same from poll_notify_one(), so modify them atomically */
+		void set_flags(int mask, int value)
+		{
+			int old_flags = __atomic_load_n(&flags, __ATOMIC_RELAXED);
+
+			while (!__atomic_compare_exchange_n(&flags, &old_flags, (old_flags & ~mask) | value, true,
+							    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+		}
 	};
 
 	const struct orb_metadata *_meta; /**< object metadata information */
@@ -220,6 +261,7 @@ private:
 	uint8_t   _priority;  /**< priority of the topic */
 	bool _published;  /**< has ever data been published */
 	uint8_t _queue_size; /**< maximum number of elements in the queue */
+	const uint8_t _instance; /**< multi-instance index of the topic */
 	int16_t _subscriber_count;
 
 	inline static SubscriberData    *filp_to_sd(device::file_t *filp);
@@ -236,6 +278,71 @@ private:
 	uint32_t _lost_messages = 0; ///< nr of lost messages for all subscribers. If two subscribers lose the same
 	///message, it is counted as two.
 
+	struct LatencyData {
+		hrt_abstime *publish_time; /**< publication time of each queue slot */
+		LatencyHistogram total;
+	};
+	LatencyData *_latency = nullptr; ///< allocated by the first publication after the measurement got enabled
+
+	SubscriberData *_notify_list = nullptr; ///< subscribers with an update bitmap, modified in an atomic section
+#ifndef __PX4_NUTTX
+	unsigned _notify_walkers = 0; ///< publishers in notify_update_bitmaps(), which walk _notify_list without a lock
+#endif
+
+	static bool _latency_enabled;
+
+	/**
+	 * Add a read message to the latency histograms.
+	 * @param previous_generation generation of the subscriber before the read
+	 * @param message generation of the message that was read
+	 * @param publish_time publication time of the message, 0 if unknown
+	 */
+	void record_latency(SubscriberData *sd, unsigned previous_generation, unsigned message, hrt_abstime publish_time);
+
+#ifndef __PX4_NUTTX
+	/**
+	 * Sequence counter protecting _data, _generation and _last_update (seqlock).
+	 * It is odd while a publisher copies into the buffer. Publishers serialize on it,
+	 * readers never block: they retry their copy if the counter changed meanwhile.
+	 */
+	unsigned _seq = 0;
+
+	static constexpr unsigned SEQ_SPIN_MAX = 100; ///< busy-wait iterations before sleeping in seq_wait()
+	static constexpr unsigned SEQ_SLEEP_US = 50; ///< sleep time of seq_wait() [us]
+
+	/** back off while waiting for another thread (odd sequence, notify walkers), sleeps every SEQ_SPIN_MAX calls */
+	static void seq_wait(unsigned &spins);
+
+	inline unsigned seq_write_begin();
+	inline void seq_write_end(unsigned seq);
+	inline unsigned seq_read_begin() const;
+	inline bool seq_read_retry(unsigned seq) const;
+#endif /* __PX4_NUTTX */
+
+	/**
+	 * Determine the next message in the queue for a subscriber.
+	 * Must be called within an atomic section (or a seqlock read section).
+	 * @param generation in: last generation the subscriber has seen, out: updated generation
+	 * @param message generation of the message to hand out, its slot is message % _queue_size
+	 * @return number of messages the subscriber lost
+	 */
+	uint32_t next_message(unsigned &generation, unsigned &message);
+
+	/**
+	 * Set or remove the update bitmap of a subscriber (ORBIOCSETNOTIFY).
+	 */
+	int set_update_bitmap(SubscriberData *sd, const orb_notifydata *notify_data);
+
+	/**
+	 * Set the update bit of all subscribers in _notify_list.
+	 */
+	void notify_update_bitmaps();
+
+	/**
+	 * Get the next message in place for a subscriber (ORBIOCBORROW).
+	 */
+	int borrow(SubscriberData *sd, orb_borrowdata *borrow_data);
+
 	/**
 	 * Perform a deferred update for a rate-limited subscriber.
 	 */
@@ -281,6 +388,13 @@ public:
 	 */
 	uORB::DeviceNode *getDeviceNode(const char *node_name);
 
+	/**
+	 * Find a node given its topic and instance, using the topic index.
+	 * This does not take the lock, since nodes are only ever added and never removed.
+	 * @return node if exists, nullptr otherwise
+	 */
+	uORB::DeviceNode *getDeviceNode(const struct orb_metadata *meta, uint8_t instance);
+
 	/**
 	 * Print statistics for each existing topic.
 	 * @param reset if true, reset statistics afterwards
@@ -296,10 +410,18 @@ public:
 	 */
 	void showTop(char **topic_filter, int num_filters);
 
+	/**
+	 * Start or stop publishing the latency histograms of all topics as uorb_latency, so that
+	 * they can be logged. This also enables or disables the latency measurement.
+	 */
+	void setLatencyReporting(bool enabled);
+
+	bool latencyReporting() const { return _latency_reporting; }
+
 private:
 	// Private constructor, uORB::Manager takes care of its creation
 	DeviceMaster();
-	virtual ~DeviceMaster() = default;
+	virtual ~DeviceMaster();
 
 	struct DeviceNodeStatisticsData {
 		DeviceNode *node;
@@ -322,10 +444,50 @@ private:
 	 */
 	uORB::DeviceNode *getDeviceNodeLocked(const char *node_name);
 
+	/**
+	 * Add a node to the topic index.
+	 * _lock must already be held when calling this.
+	 */
+	void addToIndexLocked(uORB::DeviceNode *node);
+
+	/**
+	 * Lock-free lookup in the topic index.
+	 * @param complete set to true if the result is definitive, false if the node map must be searched
+	 * @return node if found, nullptr otherwise
+	 */
+	uORB::DeviceNode *findInIndex(const struct orb_metadata *meta, uint8_t instance, bool &complete);
+
+	inline unsigned indexSlot(const struct orb_metadata *meta, uint8_t instance) const;
+
 #ifdef __PX4_NUTTX
 	ORBMap _node_map;
 #else
 	std::map<std::string, uORB::DeviceNode *> _node_map;
 #endif
+
+	/**
+	 * Open addressing hash table (linear probing) of all nodes, keyed by (meta, instance).
+	 * It is sized for the generated topic list, if it fills up anyway the remaining nodes
+	 * are only found through _node_map.
+	 */
+	uORB::DeviceNode **_node_index{nullptr};
+	unsigned _node_index_mask{0};
+	bool _node_index_overflow{false};
+
+	static constexpr unsigned LATENCY_REPORT_INTERVAL = 100000; ///< [us]
+	static constexpr int LATENCY_REPORTS_PER_INTERVAL = 4; ///< keep this below the uorb_latency queue length
+
+	static void latencyReportTrampoline(void *arg);
+
+	/**
+	 * Publish the histograms that changed since their last publication, round-robin
+	 * through all topics if there are more than LATENCY_REPORTS_PER_INTERVAL.
+	 */
+	void latencyReport();
+
+	struct work_s _latency_work {};
+	orb_advert_t _latency_pub{nullptr};
+	unsigned _latency_report_cursor{0}; ///< index of the histogram to start the next report with
+	volatile bool _latency_reporting{false};
 	hrt_abstime       _last_statistics_output;
 };
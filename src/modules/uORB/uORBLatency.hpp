@@ -0,0 +1,128 @@
+/****************************************************************************
+ *
+ *   Copyright (c) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <drivers/drv_hrt.h>
+#include <uORB/topics/uorb_latency.h>
+
+namespace uORB
+{
+class LatencyHistogram;
+}
+
+/**
+ * Fixed-bucket histogram of the publish-to-read latency of a topic.
+ *
+ * Bucket i counts latencies in [2^i, 2^(i+1)) us, bucket 0 also counts 0 us and the last
+ * bucket everything above. Concurrent readers update it without locking.
+ */
+class uORB::LatencyHistogram
+{
+public:
+	static constexpr int NUM_BUCKETS = uorb_latency_s::NUM_BUCKETS;
+
+	void add(hrt_abstime latency)
+	{
+		const uint32_t latency_us = latency > UINT32_MAX ? UINT32_MAX : (uint32_t)latency;
+		int bucket = latency_us < 2 ? 0 : 31 - __builtin_clz(latency_us);
+
+		if (bucket >= NUM_BUCKETS) {
+			bucket = NUM_BUCKETS - 1;
+		}
+
+		__atomic_fetch_add(&_buckets[bucket], 1, __ATOMIC_RELAXED);
+
+		uint32_t max = __atomic_load_n(&_max, __ATOMIC_RELAXED);
+
+		while (latency_us > max && !__atomic_compare_exchange_n(&_max, &max, latency_us, true,
+				__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+	}
+
+	uint32_t count() const
+	{
+		uint32_t count = 0;
+
+		for (int i = 0; i < NUM_BUCKETS; ++i) {
+			count += _buckets[i];
+		}
+
+		return count;
+	}
+
+	uint32_t max() const { return _max; }
+
+	/**
+	 * Get an upper bound for a latency percentile, i.e. the upper end of the bucket it falls into.
+	 * @param percent 0...100
+	 * @return latency [us], 0 if nothing was measured
+	 */
+	uint32_t percentile(int percent) const
+	{
+		const uint32_t total = count();
+		const uint64_t target = ((uint64_t)total * percent + 99) / 100;
+		uint64_t sum = 0;
+
+		for (int i = 0; i < NUM_BUCKETS - 1; ++i) {
+			sum += _buckets[i];
+
+			if (sum >= target && sum > 0) {
+				const uint32_t bucket_end = 1u << (i + 1);
+				return bucket_end < _max ? bucket_end : _max;
+			}
+		}
+
+		return _max;
+	}
+
+	void copy_buckets(uint32_t *buckets) const { memcpy(buckets, _buckets, sizeof(_buckets)); }
+
+	void reset()
+	{
+		memset(_buckets, 0, sizeof(_buckets));
+		_max = 0;
+		published_count = 0;
+	}
+
+	int subscriber{-1}; /**< task id of the subscriber, -1 for the sum of all subscribers of a topic */
+	bool active{true}; /**< false if the subscriber closed the topic (the entry can be reused) */
+	uint32_t published_count{0}; /**< count() at the time the histogram was last published */
+	LatencyHistogram *next{nullptr};
+
+private:
+	uint32_t _buckets[NUM_BUCKETS] {};
+	uint32_t _max{0};
+};
@@ -70,6 +70,13 @@ modules are allowed to publish which topics. This is used for system-wide replay
 ### Examples
 Monitor topic publication rates. Besides `top`, this is an important command for general system inspection:
 $ uorb top
+
+To find out how long messages wait until they are read, show the publish-to-read latency per topic and
+subscriber (the percentiles are upper bounds, given by the power-of-two histogram buckets):
+$ uorb top -l
+
+The latency histograms can also be published as `uorb_latency` topic, so that they get logged:
+$ uorb latency start
 )DESCR_STR");
 
 	PRINT_MODULE_USAGE_NAME("uorb", "communication");
@@ -77,7 +84,10 @@ $ uorb top
 	PRINT_MODULE_USAGE_COMMAND_DESCR("status", "Print topic statistics");
 	PRINT_MODULE_USAGE_COMMAND_DESCR("top", "Monitor topic publication rates");
 	PRINT_MODULE_USAGE_PARAM_FLAG('a', "print all instead of only currently publishing topics", true);
+	PRINT_MODULE_USAGE_PARAM_FLAG('l', "measure and print publish-to-read latency histograms", true);
 	PRINT_MODULE_USAGE_ARG("<filter1> [<filter2>]", "topic(s) to match (implies -a)", true);
+	PRINT_MODULE_USAGE_COMMAND_DESCR("latency", "Measure topic latencies and publish the histograms");
+	PRINT_MODULE_USAGE_ARG("start|stop", "Start or stop", false);
 }
 
 int
@@ -146,6 +156,22 @@ uorb_main(int argc, char *argv[])
 		return OK;
 	}
 
+	if (!strcmp(argv[1], "latency")) {
+		if (g_dev == nullptr) {
+			PX4_INFO("uorb is not running");
+			return OK;
+		}
+
+		if (argc > 2 && !strcmp(argv[2], "start")) {
+			g_dev->setLatencyReporting(true);
+			return OK;
+
+		} else if (argc > 2 && !strcmp(argv[2], "stop")) {
+			g_dev->setLatencyReporting(false);
+			return OK;
+		}
+	}
+
 	usage();
 	return -EINVAL;
 }
@@ -113,50 +113,35 @@ uORB::DeviceMaster *uORB::Manager::get_device_master()
 
 int uORB::Manager::orb_exists(const struct orb_metadata *meta, int instance)
 {
-	/*
-	 * Generate the path to the node and try to open it.
-	 */
-	char path[orb_maxpath];
-	int inst = instance;
-	int ret = uORB::Utils::node_mkpath(path, meta, &inst);
-
-	if (ret != OK) {
-		errno = -ret;
+	if (meta == nullptr || instance < 0 || instance >= ORB_MULTI_MAX_INSTANCES) {
+		errno = EINVAL;
 		return PX4_ERROR;
 	}
 
-#if defined(__PX4_NUTTX)
-	struct stat buffer;
-	ret = stat(path, &buffer);
-#else
-	ret = px4_access(path, F_OK);
+	DeviceMaster *device_master = get_device_master();
 
-	if (ret == -1 && meta != nullptr && !_remote_topics.empty()) {
-		ret = (_remote_topics.find(meta->o_name) != _remote_topics.end()) ? OK : PX4_ERROR;
+	if (device_master == nullptr) {
+		return PX4_ERROR;
 	}
 
-#endif
+	uORB::DeviceNode *node = device_master->getDeviceNode(meta, (uint8_t)instance);
 
-	if (ret == 0) {
+	if (node != nullptr) {
 		// we know the topic exists, but it's not necessarily advertised/published yet (for example
 		// if there is only a subscriber)
-		// The open() will not lead to memory allocations.
-		int fd = px4_open(path, 0);
+		return node->is_published() ? PX4_OK : PX4_ERROR;
+	}
 
-		if (fd >= 0) {
-			unsigned long is_published;
+#if !defined(__PX4_NUTTX)
 
-			if (px4_ioctl(fd, ORBIOCISPUBLISHED, (unsigned long)&is_published) == 0) {
-				if (!is_published) {
-					ret = PX4_ERROR;
-				}
-			}
-
-			px4_close(fd);
-		}
+	if (!_remote_topics.empty() && _remote_topics.find(meta->o_name) != _remote_topics.end()) {
+		return PX4_OK;
 	}
 
-	return ret;
+#endif
+
+	errno = ENOENT;
+	return PX4_ERROR;
 }
 
 orb_advert_t uORB::Manager::orb_advertise_multi(const struct orb_metadata *meta, const void *data, int *instance,
@@ -318,6 +303,14 @@ int uORB::Manager::orb_get_interval(int handle, unsigned *interval)
 	return ret;
 }
 
+int uORB::Manager::orb_set_update_bitmap(int handle, uint32_t *bitmap, unsigned bit)
+{
+	orb_notifydata notify_data;
+	notify_data.bitmap = bitmap;
+	notify_data.bit = bit;
+	return px4_ioctl(handle, ORBIOCSETNOTIFY, (unsigned long)&notify_data);
+}
+
 
 int uORB::Manager::node_advertise
 (
@@ -326,31 +319,25 @@ int uORB::Manager::node_advertise
 	int priority
 )
 {
-	int fd = -1;
-	int ret = PX4_ERROR;
+	DeviceMaster *device_master = get_device_master();
+
+	if (device_master == nullptr) {
+		return PX4_ERROR;
+	}
 
 	/* fill advertiser data */
 	const struct orb_advertdata adv = { meta, instance, priority };
 
-	/* open the control device */
-	fd = px4_open(TOPIC_MASTER_DEVICE_PATH, 0);
-
-	if (fd < 0) {
-		goto out;
-	}
-
-	/* advertise the object */
-	ret = px4_ioctl(fd, ORBIOCADVERTISE, (unsigned long)(uintptr_t)&adv);
+	/* advertise the object: call the master directly, opening the control device only costs a path lookup */
+	int ret = device_master->ioctl(nullptr, ORBIOCADVERTISE, (unsigned long)(uintptr_t)&adv);
 
 	/* it's PX4_OK if it already exists */
-	if ((PX4_OK != ret) && (EEXIST == errno)) {
+	if (ret == -EEXIST) {
 		ret = PX4_OK;
-	}
-
-out:
 
-	if (fd >= 0) {
-		px4_close(fd);
+	} else if (ret < 0) {
+		errno = -ret;
+		ret = PX4_ERROR;
 	}
 
 	return ret;
@@ -359,9 +346,6 @@ out:
 int uORB::Manager::node_open(const struct orb_metadata *meta, const void *data, bool advertiser, int *instance,
 			     int priority)
 {
-	char path[orb_maxpath];
-	int fd = -1, ret;
-
 	/*
 	 * If meta is null, the object was not defined, i.e. it is not
 	 * known to the system.  We can't advertise/subscribe such a thing.
@@ -379,51 +363,36 @@ int uORB::Manager::node_open(const struct orb_metadata *meta, const void *data,
 		return PX4_ERROR;
 	}
 
+	DeviceMaster *device_master = get_device_master();
+
+	if (device_master == nullptr) {
+		return PX4_ERROR;
+	}
+
+	uORB::DeviceNode *node = nullptr;
+
 	/* if we have an instance and are an advertiser, we will generate a new node and set the instance,
-	 * so we do not need to open here */
+	 * so we do not need to look it up here */
 	if (!instance || !advertiser) {
-		/*
-		 * Generate the path to the node and try to open it.
-		 */
-		ret = uORB::Utils::node_mkpath(path, meta, instance);
-
-		if (ret != OK) {
-			errno = -ret;
-			return PX4_ERROR;
-		}
+		const int inst = instance ? *instance : 0;
 
-		/* open the path as either the advertiser or the subscriber */
-		fd = px4_open(path, advertiser ? PX4_F_WRONLY : PX4_F_RDONLY);
+		if (inst >= 0 && inst < ORB_MULTI_MAX_INSTANCES) {
+			node = device_master->getDeviceNode(meta, (uint8_t)inst);
+		}
 
 	} else {
 		*instance = 0;
 	}
 
 	/* we may need to advertise the node... */
-	if (fd < 0) {
-
-		/* try to create the node */
-		ret = node_advertise(meta, instance, priority);
-
-		if (ret == PX4_OK) {
-			/* update the path, as it might have been updated during the node_advertise call */
-			ret = uORB::Utils::node_mkpath(path, meta, instance);
-
-			if (ret != PX4_OK) {
-				errno = -ret;
-				return PX4_ERROR;
-			}
-		}
-
-		/* on success, try the open again */
-		if (ret == PX4_OK) {
-			fd = px4_open(path, (advertiser) ? PX4_F_WRONLY : PX4_F_RDONLY);
-		}
+	if (node == nullptr && node_advertise(meta, instance, priority) == PX4_OK) {
+		/* the instance might have been updated during the node_advertise call */
+		node = device_master->getDeviceNode(meta, (uint8_t)(instance ? *instance : 0));
 	}
 
 	/*
 	 else if (advertiser) {
-		 * We have a valid fd and are an advertiser.
+		 * We have a valid node and are an advertiser.
 		 * This can happen if the topic is already subscribed/published, and orb_advertise() is called,
 		 * where instance==nullptr.
 		 * We would need to set the priority here (via px4_ioctl(fd, ...) and a new IOCTL), but orb_advertise()
@@ -432,6 +401,27 @@ int uORB::Manager::node_open(const struct orb_metadata *meta, const void *data,
 	 }
 	 */
 
+	if (node == nullptr) {
+		errno = EIO;
+		return PX4_ERROR;
+	}
+
+	/* open the node as either the advertiser or the subscriber */
+#ifdef __PX4_NUTTX
+	/* file descriptors come from the VFS, which can only open by path */
+	char path[orb_maxpath];
+	const int ret = uORB::Utils::node_mkpath(path, meta, instance);
+
+	if (ret != OK) {
+		errno = -ret;
+		return PX4_ERROR;
+	}
+
+	int fd = px4_open(path, advertiser ? PX4_F_WRONLY : PX4_F_RDONLY);
+#else
+	int fd = px4_open_device(node, advertiser ? PX4_F_WRONLY : PX4_F_RDONLY);
+#endif
+
 	if (fd < 0) {
 		errno = EIO;
 		return PX4_ERROR;
@@ -350,6 +350,23 @@ public:
 	 */
 	int	orb_get_interval(int handle, unsigned *interval);
 
+	/**
+	 * Get notified about the publications of a subscription through a bitmap.
+	 *
+	 * Every publication atomically sets the bit in the bitmap (which the subscriber clears,
+	 * e.g. with an atomic exchange of each word). This lets a subscriber with many
+	 * subscriptions, like the logger, find the updated topics without checking all of them.
+	 * If the subscription already has unread data, the bit is set right away.
+	 * The notification ignores the interval set with orb_set_interval().
+	 *
+	 * @param handle  A handle returned from orb_subscribe.
+	 * @param bitmap  Array of 32 bit words. It must stay valid until the subscription is closed
+	 *                or the notification is removed by passing nullptr.
+	 * @param bit     Index of the bit to set (bit % 32 of the word bit / 32).
+	 * @return    OK on success, PX4_ERROR otherwise with ERRNO set accordingly.
+	 */
+	int	orb_set_update_bitmap(int handle, uint32_t *bitmap, unsigned bit);
+
 	/**
 	 * Method to set the uORBCommunicator::IChannel instance.
 	 * @param comm_channel
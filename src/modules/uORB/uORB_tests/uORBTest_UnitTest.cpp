@@ -33,14 +33,22 @@
 
 #include "uORBTest_UnitTest.hpp"
 #include "../uORBCommon.hpp"
+#include "../Subscription.hpp"
+#include "../uORBDevices.hpp"
+#include "../uORBManager.hpp"
+#include "../uORBTopics.h"
+#include "../uORBUtils.hpp"
 #include <px4_config.h>
 #include <px4_time.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 #include <poll.h>
 
 ORB_DEFINE(orb_test, struct orb_test, sizeof(orb_test), "ORB_TEST:int val;hrt_abstime time;");
 ORB_DEFINE(orb_multitest, struct orb_test, sizeof(orb_test), "ORB_MULTITEST:int val;hrt_abstime time;");
+ORB_DEFINE(orb_test_latency, struct orb_test, sizeof(orb_test), "ORB_TEST_LATENCY:int val;hrt_abstime time;");
+ORB_DEFINE(orb_test_notify, struct orb_test, sizeof(orb_test), "ORB_TEST_NOTIFY:int val;hrt_abstime time;");
 
 ORB_DEFINE(orb_test_medium, struct orb_test_medium, sizeof(orb_test_medium),
 	   "ORB_TEST_MEDIUM:int val;hrt_abstime time;char[64] junk;");
@@ -53,6 +61,10 @@ ORB_DEFINE(orb_test_medium_queue_poll, struct orb_test_medium, sizeof(orb_test_m
 
 ORB_DEFINE(orb_test_large, struct orb_test_large, sizeof(orb_test_large),
 	   "ORB_TEST_LARGE:int val;hrt_abstime time;char[512] junk;");
+ORB_DEFINE(orb_test_large_concurrent, struct orb_test_large, sizeof(orb_test_large),
+	   "ORB_TEST_LARGE:int val;hrt_abstime time;char[512] junk;");
+ORB_DEFINE(orb_test_borrow, struct orb_test_large, sizeof(orb_test_large),
+	   "ORB_TEST_LARGE:int val;hrt_abstime time;char[512] junk;");
 
 uORBTest::UnitTest &uORBTest::UnitTest::instance()
 {
@@ -195,7 +207,31 @@ int uORBTest::UnitTest::test()
 		return ret;
 	}
 
-	return test_queue_poll_notify();
+	ret = test_queue_poll_notify();
+
+	if (ret != OK) {
+		return ret;
+	}
+
+	ret = test_borrow();
+
+	if (ret != OK) {
+		return ret;
+	}
+
+	ret = test_latency();
+
+	if (ret != OK) {
+		return ret;
+	}
+
+	ret = test_update_bitmap();
+
+	if (ret != OK) {
+		return ret;
+	}
+
+	return test_concurrent_copy();
 }
 
 int uORBTest::UnitTest::test_unadvertise()
@@ -231,6 +267,95 @@ int uORBTest::UnitTest::test_unadvertise()
 }
 
 
+int uORBTest::UnitTest::lookup_test()
+{
+	test_note("---------------- LOOKUP TEST ------------------");
+
+	uORB::DeviceMaster *device_master = uORB::Manager::get_instance()->get_device_master();
+
+	if (device_master == nullptr) {
+		return test_fail("no DeviceMaster");
+	}
+
+	/* make sure a node exists for every generated topic: subscribing creates it without publishing */
+	const size_t num_topics = orb_topics_count();
+	const struct orb_metadata *const *topics = orb_get_topics();
+	int *handles = new int[num_topics];
+
+	if (handles == nullptr) {
+		return test_fail("alloc failed");
+	}
+
+	for (size_t i = 0; i < num_topics; ++i) {
+		handles[i] = orb_subscribe(topics[i]);
+	}
+
+	const int iterations = 1000;
+	int ret = OK;
+
+	/* lookup by node path, through the node map */
+	hrt_abstime start = hrt_absolute_time();
+
+	for (int k = 0; k < iterations && ret == OK; ++k) {
+		for (size_t i = 0; i < num_topics; ++i) {
+			char nodepath[uORB::orb_maxpath];
+			uORB::Utils::node_mkpath(nodepath, topics[i]);
+
+			if (device_master->getDeviceNode(nodepath) == nullptr) {
+				ret = test_fail("%s not found by path", topics[i]->o_name);
+				break;
+			}
+		}
+	}
+
+	hrt_abstime path_elapsed = hrt_elapsed_time(&start);
+
+	/* lookup by metadata, through the topic index */
+	start = hrt_absolute_time();
+
+	for (int k = 0; k < iterations && ret == OK; ++k) {
+		for (size_t i = 0; i < num_topics; ++i) {
+			if (device_master->getDeviceNode(topics[i], 0) == nullptr) {
+				ret = test_fail("%s not found in index", topics[i]->o_name);
+				break;
+			}
+		}
+	}
+
+	hrt_abstime index_elapsed = hrt_elapsed_time(&start);
+
+	/* orb_exists() is what e.g. the logger polls for topics that are not published yet */
+	start = hrt_absolute_time();
+
+	for (int k = 0; k < iterations && ret == OK; ++k) {
+		for (size_t i = 0; i < num_topics; ++i) {
+			orb_exists(topics[i], ORB_MULTI_MAX_INSTANCES - 1);
+		}
+	}
+
+	hrt_abstime exists_elapsed = hrt_elapsed_time(&start);
+
+	for (size_t i = 0; i < num_topics; ++i) {
+		if (handles[i] >= 0) {
+			orb_unsubscribe(handles[i]);
+		}
+	}
+
+	delete[] handles;
+
+	if (ret != OK) {
+		return ret;
+	}
+
+	const double num_lookups = (double)iterations * num_topics;
+	test_note("%i topics, %i lookups each", (int)num_topics, iterations);
+	test_note("  by path:      %8.1f ns/lookup", path_elapsed * 1000. / num_lookups);
+	test_note("  by index:     %8.1f ns/lookup", index_elapsed * 1000. / num_lookups);
+	test_note("  orb_exists(): %8.1f ns/call", exists_elapsed * 1000. / num_lookups);
+
+	return OK;
+}
+
 int uORBTest::UnitTest::info()
 {
 	return OK;
@@ -815,6 +940,282 @@ int uORBTest::UnitTest::test_queue_poll_notify()
 }
 
 
+int uORBTest::UnitTest::test_borrow()
+{
+	test_note("Testing zero-copy subscription");
+
+	struct orb_test_large t;
+	t.val = 0;
+	memset(t.junk, 0, sizeof(t.junk));
+
+	uORB::Subscription<orb_test_large> sub(ORB_ID(orb_test_borrow));
+
+	if (sub.borrow() != nullptr) {
+		return test_fail("borrow before advertise");
+	}
+
+	orb_advert_t ptopic = orb_advertise(ORB_ID(orb_test_borrow), &t);
+
+	if (ptopic == nullptr) {
+		return test_fail("advertise failed: %d", errno);
+	}
+
+	t.val = 42;
+	orb_publish(ORB_ID(orb_test_borrow), ptopic, &t);
+
+	const orb_test_large *u = sub.borrow();
+
+	if (u == nullptr) {
+		return test_fail("borrow failed");
+	}
+
+	if (u->val != t.val) {
+		return test_fail("borrow mismatch: %d expected %d", u->val, t.val);
+	}
+
+	if (!sub.release()) {
+		return test_fail("release reported an overwritten message");
+	}
+
+	if (sub.updated()) {
+		return test_fail("spurious updated flag after borrow");
+	}
+
+	/* a publication while the message is borrowed must invalidate it (queue size 1) */
+	t.val = 43;
+	orb_publish(ORB_ID(orb_test_borrow), ptopic, &t);
+
+	u = sub.borrow();
+
+	if (u == nullptr || u->val != t.val) {
+		return test_fail("borrow(2) failed");
+	}
+
+	t.val = 44;
+	orb_publish(ORB_ID(orb_test_borrow), ptopic, &t);
+
+	if (sub.release()) {
+		return test_fail("release did not detect the overwritten message");
+	}
+
+	orb_unadvertise(ptopic);
+
+	return test_note("PASS zero-copy subscription");
+}
+
+int uORBTest::UnitTest::test_latency()
+{
+	test_note("Testing latency histograms");
+
+	const bool latency_enabled = uORB::DeviceNode::latency_enabled();
+	uORB::DeviceNode::set_latency_enabled(true);
+
+	struct orb_test t {};
+
+	orb_advert_t ptopic = orb_advertise(ORB_ID(orb_test_latency), &t);
+
+	if (ptopic == nullptr) {
+		return test_fail("advertise failed: %d", errno);
+	}
+
+	int sfd = orb_subscribe(ORB_ID(orb_test_latency));
+	const int num_messages = 10;
+
+	for (t.val = 0; t.val < num_messages; ++t.val) {
+		orb_publish(ORB_ID(orb_test_latency), ptopic, &t);
+		usleep(1000);
+		orb_copy(ORB_ID(orb_test_latency), sfd, &t);
+	}
+
+	/* reading a message again must not be counted */
+	orb_copy(ORB_ID(orb_test_latency), sfd, &t);
+
+	uORB::DeviceNode *node = uORB::Manager::get_instance()->get_device_master()->getDeviceNode(ORB_ID(orb_test_latency), 0);
+	uORB::LatencyHistogram *histogram = node ? node->latency_histograms() : nullptr;
+
+	orb_unsubscribe(sfd);
+	orb_unadvertise(ptopic);
+	uORB::DeviceNode::set_latency_enabled(latency_enabled);
+
+	if (histogram == nullptr) {
+		return test_fail("no latency measured");
+	}
+
+	if (histogram->count() != num_messages) {
+		return test_fail("got %i measurements, expected %i", (int)histogram->count(), num_messages);
+	}
+
+	if (histogram->max() < 1000 || histogram->percentile(50) < 1000) {
+		return test_fail("latency too low: %i us", (int)histogram->max());
+	}
+
+	histogram = histogram->next;
+
+	if (histogram == nullptr || histogram->subscriber != px4_getpid() || histogram->count() != num_messages) {
+		return test_fail("no latency measured for the subscriber");
+	}
+
+	return test_note("PASS latency histograms, max latency: %i us", (int)histogram->max());
+}
+
+int uORBTest::UnitTest::test_update_bitmap()
+{
+	test_note("Testing update bitmap");
+
+	struct orb_test t {};
+	uint32_t bitmap[2] = {};
+	const unsigned bit = 37;
+	const uint32_t mask = 1u << (bit % 32);
+
+	orb_advert_t ptopic = orb_advertise(ORB_ID(orb_test_notify), &t);
+
+	if (ptopic == nullptr) {
+		return test_fail("advertise failed: %d", errno);
+	}
+
+	int sfd = orb_subscribe(ORB_ID(orb_test_notify));
+
+	/* the advertised data is not read yet, so it must be flagged right away */
+	if (orb_set_update_bitmap(sfd, bitmap, bit) != PX4_OK) {
+		return test_fail("orb_set_update_bitmap failed (%i)", errno);
+	}
+
+	if (bitmap[0] != 0 || bitmap[1] != mask) {
+		return test_fail("unread data not flagged (0x%x 0x%x)", bitmap[0], bitmap[1]);
+	}
+
+	orb_copy(ORB_ID(orb_test_notify), sfd, &t);
+	bitmap[1] = 0;
+
+	t.val = 1;
+	orb_publish(ORB_ID(orb_test_notify), ptopic, &t);
+
+	if (bitmap[0] != 0 || bitmap[1] != mask) {
+		return test_fail("publication not flagged (0x%x 0x%x)", bitmap[0], bitmap[1]);
+	}
+
+	/* unregister: further publications must not touch the bitmap */
+	bitmap[1] = 0;
+	orb_set_update_bitmap(sfd, nullptr, 0);
+	orb_publish(ORB_ID(orb_test_notify), ptopic, &t);
+
+	if (bitmap[1] != 0) {
+		return test_fail("bitmap set after unregistering");
+	}
+
+	/* unsubscribing must unregister as well */
+	orb_set_update_bitmap(sfd, bitmap, bit);
+	bitmap[1] = 0;
+	orb_unsubscribe(sfd);
+	orb_publish(ORB_ID(orb_test_notify), ptopic, &t);
+	orb_unadvertise(ptopic);
+
+	if (bitmap[1] != 0) {
+		return test_fail("bitmap set after unsubscribing");
+	}
+
+	return test_note("PASS update bitmap");
+}
+
+int uORBTest::UnitTest::pub_test_concurrent_entry(int argc, char *argv[])
+{
+	uORBTest::UnitTest &t = uORBTest::UnitTest::instance();
+	return t.pub_test_concurrent_main();
+}
+
+int uORBTest::UnitTest::pub_test_concurrent_main()
+{
+	struct orb_test_large t;
+	orb_advert_t ptopic;
+	t.val = 0;
+	memset(t.junk, 0, sizeof(t.junk));
+
+	if ((ptopic = orb_advertise(ORB_ID(orb_test_large_concurrent), &t)) == nullptr) {
+		_thread_should_exit = true;
+		return test_fail("advertise failed: %d", errno);
+	}
+
+	/* publish as fast as possible, every message is filled with a single value */
+	while (!_thread_should_exit) {
+		++t.val;
+		t.time = hrt_absolute_time();
+		memset(t.junk, t.val & 0xff, sizeof(t.junk));
+		orb_publish(ORB_ID(orb_test_large_concurrent), ptopic, &t);
+	}
+
+	orb_unadvertise(ptopic);
+
+	return 0;
+}
+
+int uORBTest::UnitTest::test_concurrent_copy()
+{
+	test_note("Testing concurrent publish & copy");
+
+	struct orb_test_large t;
+	int sfd;
+
+	if ((sfd = orb_subscribe(ORB_ID(orb_test_large_concurrent))) < 0) {
+		return test_fail("subscribe failed: %d", errno);
+	}
+
+	_thread_should_exit = false;
+
+	char *const args[1] = { nullptr };
+	int pubsub_task = px4_task_spawn_cmd("uorb_test_concurrent",
+					     SCHED_DEFAULT,
+					     SCHED_PRIORITY_MAX - 5,
+					     1500,
+					     (px4_main_t)&uORBTest::UnitTest::pub_test_concurrent_entry,
+					     args);
+
+	if (pubsub_task < 0) {
+		return test_fail("failed launching task");
+	}
+
+	const int num_copies = 100000;
+	int num_updates = 0;
+	int last_val = 0;
+	int ret = OK;
+
+	for (int i = 0; i < num_copies && ret == OK; ++i) {
+		bool updated = false;
+		orb_check(sfd, &updated);
+
+		if (!updated) {
+			continue;
+		}
+
+		orb_copy(ORB_ID(orb_test_large_concurrent), sfd, &t);
+		++num_updates;
+
+		/* a copy overlapping a publication shows up as a message with mixed contents */
+		for (unsigned j = 0; j < sizeof(t.junk); ++j) {
+			if (t.junk[j] != (char)(t.val & 0xff)) {
+				ret = test_fail("torn read: val %i, junk[%i] = %i", t.val, j, (int)t.junk[j]);
+				break;
+			}
+		}
+
+		if (t.val < last_val) {
+			ret = test_fail("copy went back in time (%i after %i)", t.val, last_val);
+		}
+
+		last_val = t.val;
+	}
+
+	_thread_should_exit = true;
+	usleep(100 * 1000);
+	orb_unsubscribe(sfd);
+
+	if (ret != OK) {
+		return ret;
+	}
+
+	return test_note("PASS concurrent publish & copy, got %i updates", num_updates);
+}
+
+
 int uORBTest::UnitTest::test_fail(const char *fmt, ...)
 {
 	va_list ap;
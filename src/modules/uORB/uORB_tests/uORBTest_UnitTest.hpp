@@ -44,6 +44,8 @@ struct orb_test {
 };
 ORB_DECLARE(orb_test);
 ORB_DECLARE(orb_multitest);
+ORB_DECLARE(orb_test_latency);
+ORB_DECLARE(orb_test_notify);
 
 
 struct orb_test_medium {
@@ -62,6 +64,8 @@ struct orb_test_large {
 	char junk[512];
 };
 ORB_DECLARE(orb_test_large);
+ORB_DECLARE(orb_test_large_concurrent);
+ORB_DECLARE(orb_test_borrow);
 
 
 namespace uORBTest
@@ -78,6 +82,7 @@ public:
 	~UnitTest() {}
 	int test();
 	template<typename S> int latency_test(orb_id_t T, bool print);
+	int lookup_test();
 	int info();
 
 private:
@@ -116,6 +121,20 @@ private:
 	int test_queue_poll_notify();
 	volatile int _num_messages_sent = 0;
 
+	/* zero-copy subscription */
+	int test_borrow();
+
+	/* publish-to-read latency histograms */
+	int test_latency();
+
+	/* update notification bitmap */
+	int test_update_bitmap();
+
+	/* concurrent publish & copy (torn reads) */
+	int test_concurrent_copy();
+	static int pub_test_concurrent_entry(int argc, char *argv[]);
+	int pub_test_concurrent_main();
+
 	int test_fail(const char *fmt, ...);
 	int test_note(const char *fmt, ...);
 };
@@ -44,7 +44,7 @@ extern "C" { __EXPORT int uorb_tests_main(int argc, char *argv[]); }
 
 static void usage()
 {
-	PX4_INFO("Usage: uorb_tests [latency_test]");
+	PX4_INFO("Usage: uorb_tests [latency_test|lookup_test]");
 }
 
 int
@@ -90,6 +90,13 @@ uorb_tests_main(int argc, char *argv[])
 		}
 	}
 
+	/*
+	 * Compare topic lookup by path and by index.
+	 */
+	if (argc > 1 && !strcmp(argv[1], "lookup_test")) {
+		return uORBTest::UnitTest::instance().lookup_test();
+	}
+
 #endif
 
 	usage();
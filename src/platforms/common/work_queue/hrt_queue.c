@@ -131,6 +131,13 @@ int hrt_work_queue(struct work_s *work, worker_t worker, void *arg, uint32_t del
 #else
 		//wqueue->pid == own task? -> don't signal
 		px4_task_kill(wqueue->pid, SIGCONT);      /* Wake up the worker thread */
+#endif
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+
+		if (hrt_lockstep_enabled()) {
+			px4_sem_post(&_hrt_work_wakeup);
+		}
+
 #endif
 	}
 
@@ -70,6 +70,9 @@ struct wqueue_s g_hrt_work;
  * Private Variables
  ****************************************************************************/
 px4_sem_t _hrt_work_lock;
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+px4_sem_t _hrt_work_wakeup;
+#endif
 
 /****************************************************************************
  * Private Functions
@@ -215,6 +218,20 @@ static void hrt_work_process()
 	 */
 	hrt_work_unlock();
 
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+
+	if (hrt_lockstep_enabled()) {
+		/* the time only advances with the simulation, so wait for the simulated time
+		 * (or until hrt_work_queue() wakes us up) */
+		struct timespec ts;
+		px4_clock_gettime(CLOCK_REALTIME, &ts);
+		abstime_to_ts(&ts, ts_to_abstime(&ts) + next);
+		px4_sem_timedwait(&_hrt_work_wakeup, &ts);
+		return;
+	}
+
+#endif
+
 	/* might sleep less if a signal received and new item was queued */
 	//PX4_INFO("Sleeping for %u usec", next);
 	usleep(next);
@@ -274,6 +291,10 @@ static int work_hrtthread(int argc, char *argv[])
 void hrt_work_queue_init(void)
 {
 	px4_sem_init(&_hrt_work_lock, 0, 1);
+#ifdef ENABLE_LOCKSTEP_SCHEDULER
+	px4_sem_init(&_hrt_work_wakeup, 0, 0);
+	px4_sem_setprotocol(&_hrt_work_wakeup, SEM_PRIO_NONE);
+#endif
 	memset(&g_hrt_work, 0, sizeof(g_hrt_work));
 
 	// Create high priority worker thread
@@ -42,6 +42,7 @@
 #include <queue.h>
 #include <px4_workqueue.h>
 #include "work_lock.h"
+#include "work_heap.h"
 
 #ifdef CONFIG_SCHED_WORKQUEUE
 
@@ -88,7 +89,7 @@
 
 int work_cancel(int qid, struct work_s *work)
 {
-	struct wqueue_s *wqueue = &g_work[qid];
+	struct work_heap_s *heap = &_work_heap[qid];
 
 	//DEBUGASSERT(work != NULL && (unsigned)qid < NWORKERS);
 
@@ -99,17 +100,12 @@ int work_cancel(int qid, struct work_s *work)
 
 	work_lock(qid);
 
-	if (work->worker != NULL) {
-		/* A little test of the integrity of the work queue */
-
-		//DEBUGASSERT(work->dq.flink ||(dq_entry_t *)work == wqueue->q.tail);
-		//DEBUGASSERT(work->dq.blink ||(dq_entry_t *)work == wqueue->q.head);
-
+	if (work->worker != NULL && work_heap_contains(heap, work)) {
 		/* Remove the entry from the work queue and make sure that it is
 		 * mark as availalbe (i.e., the worker field is nullified).
 		 */
 
-		dq_rem((dq_entry_t *)work, &wqueue->q);
+		work_heap_remove(heap, work);
 		work->worker = NULL;
 	}
 
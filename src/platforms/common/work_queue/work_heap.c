@@ -0,0 +1,128 @@
+/****************************************************************************
+ *
+ * Copyright (C) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file work_heap.c
+ *
+ * Deadline-ordered min-heap for the work queues.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include "work_heap.h"
+
+static void heap_set(struct work_heap_s *heap, unsigned index, struct work_s *work)
+{
+	heap->items[index] = work;
+	work->heap_index = index;
+}
+
+static void sift_up(struct work_heap_s *heap, unsigned index)
+{
+	struct work_s *work = heap->items[index];
+	const uint64_t deadline = work_deadline(work);
+
+	while (index > 0) {
+		const unsigned parent = (index - 1) / 2;
+
+		if (work_deadline(heap->items[parent]) <= deadline) {
+			break;
+		}
+
+		heap_set(heap, index, heap->items[parent]);
+		index = parent;
+	}
+
+	heap_set(heap, index, work);
+}
+
+static void sift_down(struct work_heap_s *heap, unsigned index)
+{
+	struct work_s *work = heap->items[index];
+	const uint64_t deadline = work_deadline(work);
+
+	for (;;) {
+		unsigned child = 2 * index + 1;
+
+		if (child >= heap->size) {
+			break;
+		}
+
+		if (child + 1 < heap->size && work_deadline(heap->items[child + 1]) < work_deadline(heap->items[child])) {
+			++child;
+		}
+
+		if (deadline <= work_deadline(heap->items[child])) {
+			break;
+		}
+
+		heap_set(heap, index, heap->items[child]);
+		index = child;
+	}
+
+	heap_set(heap, index, work);
+}
+
+int work_heap_insert(struct work_heap_s *heap, struct work_s *work)
+{
+	if (heap->size == heap->capacity) {
+		const unsigned capacity = heap->capacity > 0 ? heap->capacity * 2 : 32;
+		struct work_s **items = (struct work_s **)realloc(heap->items, capacity * sizeof(struct work_s *));
+
+		if (items == NULL) {
+			return -ENOMEM;
+		}
+
+		heap->items = items;
+		heap->capacity = capacity;
+	}
+
+	heap_set(heap, heap->size++, work);
+	sift_up(heap, work->heap_index);
+
+	return PX4_OK;
+}
+
+void work_heap_remove(struct work_heap_s *heap, struct work_s *work)
+{
+	const unsigned index = work->heap_index;
+	struct work_s *last = heap->items[--heap->size];
+
+	if (index < heap->size) {
+		/* move the last item into the gap, and restore the order from there */
+		heap_set(heap, index, last);
+		sift_down(heap, index);
+		sift_up(heap, last->heap_index);
+	}
+}
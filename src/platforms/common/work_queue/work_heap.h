@@ -0,0 +1,73 @@
+/****************************************************************************
+ *
+ * Copyright (C) 2018 PX4 Development Team. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name PX4 nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#pragma once
+
+#include <px4_defines.h>
+#include <px4_workqueue.h>
+#include <stdbool.h>
+
+__BEGIN_DECLS
+
+/**
+ * Pending work of a work queue, ordered by deadline (binary min-heap).
+ * Each work_s stores its position in heap_index, so it can be removed in O(log n).
+ */
+struct work_heap_s {
+	struct work_s **items;
+	unsigned size;
+	unsigned capacity;
+};
+
+/* pending work of each work queue, protected by work_lock() */
+extern struct work_heap_s _work_heap[];
+
+/* time at which the work is due [us] */
+static inline uint64_t work_deadline(const struct work_s *work)
+{
+	return work->qtime + (uint64_t)work->delay * USEC_PER_TICK;
+}
+
+static inline bool work_heap_contains(const struct work_heap_s *heap, const struct work_s *work)
+{
+	return work->heap_index < heap->size && heap->items[work->heap_index] == work;
+}
+
+/* add work, returns -ENOMEM if the heap could not grow */
+int work_heap_insert(struct work_heap_s *heap, struct work_s *work);
+
+/* remove work, which must be contained in the heap */
+void work_heap_remove(struct work_heap_s *heap, struct work_s *work);
+
+__END_DECLS
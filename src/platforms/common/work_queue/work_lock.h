@@ -40,4 +40,8 @@
 void work_lock(int id);
 void work_unlock(int id);
 
+#include <px4_sem.h>
+/* wakes up a worker thread when new work became the first one due */
+extern px4_sem_t _work_wakeup[];
+
 #endif // _work_lock_h_
@@ -42,12 +42,13 @@
 #include <px4_workqueue.h>
 #include <px4_tasks.h>
 
-#include <signal.h>
 #include <stdint.h>
 #include <queue.h>
 #include <stdio.h>
 #include <semaphore.h>
+#include <drivers/drv_hrt.h>
 #include "work_lock.h"
+#include "work_heap.h"
 
 #ifdef CONFIG_SCHED_WORKQUEUE
 
@@ -106,33 +107,42 @@
 
 int work_queue(int qid, struct work_s *work, worker_t worker, void *arg, uint32_t delay)
 {
-	struct wqueue_s *wqueue = &g_work[qid];
+	struct work_heap_s *heap = &_work_heap[qid];
+	int ret;
 
 	//DEBUGASSERT(work != NULL && (unsigned)qid < NWORKERS);
 
-	/* First, initialize the work structure */
+	/* This must be done with the queue locked, since the worker threads
+	 * might be looking at the work structure while we modify it.
+	 */
+
+	work_lock(qid);
+
+	/* If the work is still pending, reschedule it */
+
+	if (work_heap_contains(heap, work)) {
+		work_heap_remove(heap, work);
+	}
+
+	/* Initialize the work structure, time-tag it and put it in the work queue */
 
 	work->worker = worker;           /* Work callback */
 	work->arg    = arg;              /* Callback argument */
 	work->delay  = delay;            /* Delay until work performed */
+	work->qtime  = hrt_absolute_time(); /* Time work queued */
 
-	/* Now, time-tag that entry and put it in the work queue.  This must be
-	 * done with interrupts disabled.  This permits this function to be called
-	 * from with task logic or interrupt handlers.
-	 */
+	ret = work_heap_insert(heap, work);
 
-	work_lock(qid);
-	work->qtime  = clock_systimer(); /* Time work queued */
+	if (ret != PX4_OK) {
+		work->worker = NULL;
 
-	dq_addlast((dq_entry_t *)work, &wqueue->q);
-#ifdef __PX4_QURT
-	px4_task_kill(wqueue->pid, SIGALRM);      /* Wake up the worker thread */
-#else
-	px4_task_kill(wqueue->pid, SIGCONT);      /* Wake up the worker thread */
-#endif
+	} else if (work->heap_index == 0) {
+		/* This is the next work due: wake up a worker thread to wait for it */
+		px4_sem_post(&_work_wakeup[qid]);
+	}
 
 	work_unlock(qid);
-	return PX4_OK;
+	return ret;
 }
 
 #endif /* CONFIG_SCHED_WORKQUEUE */
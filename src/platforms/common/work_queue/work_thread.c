@@ -45,11 +45,19 @@
 #include <px4_workqueue.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <queue.h>
 #include <pthread.h>
 #include <drivers/drv_hrt.h>
+#include <perf/perf_counter.h>
 #include "work_lock.h"
+#include "work_heap.h"
+
+#if defined(__PX4_POSIX) && !defined(__PX4_CYGWIN)
+#include <execinfo.h>
+#endif
 
 #ifdef CONFIG_SCHED_WORKQUEUE
 
@@ -57,10 +65,41 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* Number of worker threads per work queue. Work items of the same queue run
+ * concurrently if there is more than one (but an item never runs in parallel
+ * to itself, see _work_running), so a slow item does not delay everything else.
+ */
+#ifndef CONFIG_SCHED_HPNTHREADS
+#  define CONFIG_SCHED_HPNTHREADS 1
+#endif
+
+#ifndef CONFIG_SCHED_LPNTHREADS
+#  define CONFIG_SCHED_LPNTHREADS 1
+#endif
+
+#if CONFIG_SCHED_HPNTHREADS > CONFIG_SCHED_LPNTHREADS
+#  define WORK_MAX_THREADS CONFIG_SCHED_HPNTHREADS
+#else
+#  define WORK_MAX_THREADS CONFIG_SCHED_LPNTHREADS
+#endif
+
+/* Maximum number of work items per queue with perf counters (power of 2) */
+#define WORK_PERF_ITEMS 64
+
 /****************************************************************************
  * Private Type Declarations
  ****************************************************************************/
 
+/* Perf counters of a work item, looked up by the address of its work_s */
+struct work_perf_s {
+	const struct work_s *work;
+	worker_t worker;
+	perf_counter_t runtime; /* execution time of the worker */
+	perf_counter_t latency; /* time between the deadline and the start of the execution */
+	char runtime_name[48];
+	char latency_name[48];
+};
+
 /****************************************************************************
  * Public Variables
  ****************************************************************************/
@@ -72,122 +111,355 @@ struct wqueue_s g_work[NWORKERS];
  * Private Variables
  ****************************************************************************/
 px4_sem_t _work_lock[NWORKERS];
+px4_sem_t _work_wakeup[NWORKERS];
+struct work_heap_s _work_heap[NWORKERS];
+
+static const char *const _work_queue_names[NWORKERS] = { "hpwork", "lpwork" };
+static struct work_perf_s _work_perf[NWORKERS][WORK_PERF_ITEMS];
+
+/* The work items currently executed by the worker threads of each queue. A
+ * work item that is queued again while it runs stays in the heap until it
+ * has returned, the thread executing it then picks it up.
+ */
+static const struct work_s *_work_running[NWORKERS][WORK_MAX_THREADS];
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: work_perf_name
+ *
+ * Description:
+ *   Name the perf counters of a work item after the symbol of its worker
+ *   function, which identifies the module. Falls back to the worker address
+ *   if there is no symbol table.
+ *
+ ****************************************************************************/
+
+static void work_perf_name(int lock_id, struct work_perf_s *perf)
+{
+	char symbol[32];
+	snprintf(symbol, sizeof(symbol), "%p", perf->worker);
+
+#if defined(__PX4_POSIX) && !defined(__PX4_CYGWIN)
+	void *address = (void *)perf->worker;
+	char **symbols = backtrace_symbols(&address, 1);
+
+	if (symbols) {
+		/* format: "binary(symbol+offset) [address]" */
+		const char *begin = strchr(symbols[0], '(');
+		const char *end = begin ? strpbrk(begin, "+)") : NULL;
+
+		if (end && end - begin > 1) {
+			int len = end - begin - 1;
+
+			if (len > (int)sizeof(symbol) - 1) {
+				len = sizeof(symbol) - 1;
+			}
+
+			memcpy(symbol, begin + 1, len);
+			symbol[len] = '\0';
+		}
+
+		free(symbols);
+	}
+
+#endif
+
+	snprintf(perf->runtime_name, sizeof(perf->runtime_name), "%s: %s runtime",
+		 _work_queue_names[lock_id], symbol);
+	snprintf(perf->latency_name, sizeof(perf->latency_name), "%s: %s latency",
+		 _work_queue_names[lock_id], symbol);
+}
+
+/****************************************************************************
+ * Name: work_perf_find
+ *
+ * Description:
+ *   Look up the perf counters of a work item. If alloc is set, they are
+ *   allocated if the work item has none yet. Must be called with the work
+ *   queue locked.
+ *
+ * Returned Value:
+ *   The counters, or NULL if there are none (or the table is full)
+ *
+ ****************************************************************************/
+
+static struct work_perf_s *work_perf_find(int lock_id, const struct work_s *work, worker_t worker, bool alloc)
+{
+	const unsigned slot = (unsigned)((uintptr_t)work / sizeof(void *));
+	struct work_perf_s *unused = NULL;
+
+	for (unsigned i = 0; i < WORK_PERF_ITEMS; i++) {
+		struct work_perf_s *perf = &_work_perf[lock_id][(slot + i) & (WORK_PERF_ITEMS - 1)];
+
+		if (perf->work == work) {
+			if (perf->worker == worker) {
+				return perf;
+			}
+
+			if (!alloc) {
+				return NULL;
+			}
+
+			/* The work structure has been reused for another worker, so the
+			 * item the counters belong to is gone: they start over.
+			 */
+			perf_free(perf->runtime);
+			perf_free(perf->latency);
+			unused = perf;
+			break;
+		}
+
+		if (perf->work == NULL) {
+			unused = perf;
+			break;
+		}
+	}
+
+	if (!alloc || unused == NULL) {
+		return NULL;
+	}
+
+	unused->work = work;
+	unused->worker = worker;
+	work_perf_name(lock_id, unused);
+	unused->runtime = perf_alloc(PC_ELAPSED, unused->runtime_name);
+	unused->latency = perf_alloc(PC_ELAPSED, unused->latency_name);
+	return unused;
+}
+
+/****************************************************************************
+ * Name: work_is_running
+ *
+ * Description:
+ *   Check if a work item is being executed by one of the worker threads.
+ *   Must be called with the work queue locked.
+ *
+ ****************************************************************************/
+
+static bool work_is_running(int lock_id, const struct work_s *work)
+{
+	for (int i = 0; i < WORK_MAX_THREADS; i++) {
+		if (_work_running[lock_id][i] == work) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/****************************************************************************
+ * Name: work_next
+ *
+ * Description:
+ *   Get the due work item with the earliest deadline that is not being
+ *   executed by another worker thread, and update the time until the next
+ *   work is due. Must be called with the work queue locked.
+ *
+ *   Usually this is the first item of the heap. Only if it is running the
+ *   whole heap is searched, as the order of the other items is not known.
+ *
+ * Returned Value:
+ *   The work item, or NULL if none is due
+ *
+ ****************************************************************************/
+
+static struct work_s *work_next(int lock_id, uint64_t now, uint32_t *next)
+{
+	struct work_heap_s *heap = &_work_heap[lock_id];
+	struct work_s *ready = NULL;
+	uint64_t ready_deadline = 0;
+
+	for (unsigned i = 0; i < heap->size; i++) {
+		struct work_s *work = heap->items[i];
+
+		if (work_is_running(lock_id, work)) {
+			/* the thread executing it picks it up when done */
+			continue;
+		}
+
+		/* qtime is the time that the work was added to the work queue, a
+		 * delay of zero will always execute immediately.
+		 */
+		const uint64_t deadline = work_deadline(work);
+
+		if (deadline > now) {
+			if (deadline - now < *next) {
+				*next = deadline - now;
+			}
+
+		} else if (ready == NULL || deadline < ready_deadline) {
+			ready = work;
+			ready_deadline = deadline;
+		}
+
+		if (i == 0) {
+			/* the first item is due earliest of all */
+			break;
+		}
+	}
+
+	return ready;
+}
+
 /****************************************************************************
  * Name: work_process
  *
  * Description:
  *   This is the logic that performs actions placed on any work list.
+ *   The pending work is ordered by deadline, so only the due items are
+ *   looked at, earliest deadline first.
  *
  * Input parameters:
- *   wqueue - Describes the work queue to be processed
+ *   lock_id - The work queue to be processed
  *
  * Returned Value:
  *   None
  *
  ****************************************************************************/
 
-static void work_process(struct wqueue_s *wqueue, int lock_id)
+static void work_process(int lock_id)
 {
-	volatile struct work_s *work;
+	struct work_heap_s *heap = &_work_heap[lock_id];
+	const struct work_s **running = NULL;
+	struct work_s *work;
+	struct work_perf_s *perf;
 	worker_t  worker;
 	void *arg;
-	uint64_t elapsed;
-	uint32_t remaining;
+	uint64_t now;
+	uint64_t deadline;
+	uint64_t start;
 	uint32_t next;
-
-	/* Then process queued work.  We need to keep interrupts disabled while
-	 * we process items in the work list.
-	 */
+	struct timespec ts;
 
 	next  = CONFIG_SCHED_WORKPERIOD;
 
 	work_lock(lock_id);
 
-	work  = (struct work_s *)wqueue->q.head;
+	/* Find the running slot of this thread: there are as many as threads,
+	 * and each thread releases its slot before it looks for one again.
+	 */
 
-	while (work) {
-		/* Is this work ready?  It is ready if there is no delay or if
-		 * the delay has elapsed. qtime is the time that the work was added
-		 * to the work queue.  It will always be greater than or equal to
-		 * zero.  Therefore a delay of zero will always execute immediately.
-		 */
+	for (int i = 0; i < WORK_MAX_THREADS; i++) {
+		if (_work_running[lock_id][i] == NULL) {
+			running = &_work_running[lock_id][i];
+			break;
+		}
+	}
 
-		elapsed = USEC2TICK(clock_systimer() - work->qtime);
+	while ((work = work_next(lock_id, (now = hrt_absolute_time()), &next)) != NULL) {
+		deadline = work_deadline(work);
 
-		//printf("work_process: in ticks elapsed=%lu delay=%u\n", elapsed, work->delay);
-		if (elapsed >= work->delay) {
-			/* Remove the ready-to-execute work from the list */
+		/* Remove the ready-to-execute work from the queue */
 
-			(void)dq_rem((struct dq_entry_s *)work, &wqueue->q);
+		work_heap_remove(heap, work);
 
-			/* Extract the work description from the entry (in case the work
-			 * instance by the re-used after it has been de-queued).
-			 */
+		/* Extract the work description from the entry (in case the work
+		 * instance by the re-used after it has been de-queued).
+		 */
 
-			worker = work->worker;
-			arg    = work->arg;
+		worker = work->worker;
+		arg    = work->arg;
 
-			/* Mark the work as no longer being queued */
+		/* Mark the work as no longer being queued, but as running, so that
+		 * no other worker thread executes it in parallel if it is queued
+		 * again meanwhile.
+		 */
 
-			work->worker = NULL;
+		work->worker = NULL;
+		*running = work;
 
-			/* Do the work.  Re-enable interrupts while the work is being
-			 * performed... we don't have any idea how long that will take!
-			 */
+		perf = work_perf_find(lock_id, work, worker, true);
 
-			work_unlock(lock_id);
+		if (perf) {
+			perf_set_elapsed(perf->latency, now - deadline);
+		}
 
-			if (!worker) {
-				PX4_WARN("MESSED UP: worker = 0\n");
+		/* Do the work without holding the lock, the other worker threads
+		 * (and work_queue()) need it meanwhile, so the perf counters are
+		 * looked up again afterwards.
+		 */
 
-			} else {
-				worker(arg);
-			}
+		work_unlock(lock_id);
 
-			/* Now, unfortunately, since we re-enabled interrupts we don't
-			 * know the state of the work list and we will have to start
-			 * back at the head of the list.
-			 */
+		start = hrt_absolute_time();
 
-			work_lock(lock_id);
-			work  = (struct work_s *)wqueue->q.head;
+		if (!worker) {
+			PX4_WARN("MESSED UP: worker = 0\n");
 
 		} else {
-			/* This one is not ready.. will it be ready before the next
-			 * scheduled wakeup interval?
-			 */
-
-			/* Here: elapsed < work->delay */
-			remaining = USEC_PER_TICK * (work->delay - elapsed);
+			worker(arg);
+		}
 
-			if (remaining < next) {
-				/* Yes.. Then schedule to wake up when the work is ready */
+		const uint64_t elapsed = hrt_elapsed_time(&start);
 
-				next = remaining;
-			}
+		work_lock(lock_id);
 
-			/* Then try the next in the list. */
+		*running = NULL;
+		perf = work_perf_find(lock_id, work, worker, false);
 
-			work = (struct work_s *)work->dq.flink;
+		if (perf) {
+			perf_set_elapsed(perf->runtime, elapsed);
 		}
 	}
 
-	/* Wait awhile to check the work list.  We will wait here until either
-	 * the time elapses or until we are awakened by a signal.
-	 */
 	work_unlock(lock_id);
 
-	usleep(next);
+	/* Wait until the next work is due, or until work_queue() wakes us up
+	 * for new work. In lockstep mode this waits on the simulated time.
+	 */
+
+	px4_clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += next / 1000000;
+	ts.tv_nsec += (next % 1000000) * 1000;
+
+	if (ts.tv_nsec >= 1000000000) {
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
+
+	px4_sem_timedwait(&_work_wakeup[lock_id], &ts);
+}
+
+/****************************************************************************
+ * Name: work_queue_start
+ *
+ * Description:
+ *   Start the worker threads of a work queue.
+ *
+ ****************************************************************************/
+
+static void work_queue_start(int lock_id, int priority, px4_main_t entry, int nthreads)
+{
+	char name[16];
+
+	for (int i = 0; i < nthreads; i++) {
+		if (i == 0) {
+			snprintf(name, sizeof(name), "%s", _work_queue_names[lock_id]);
+
+		} else {
+			snprintf(name, sizeof(name), "%s%i", _work_queue_names[lock_id], i);
+		}
+
+		px4_task_t pid = px4_task_spawn_cmd(name,
+						    SCHED_DEFAULT,
+						    priority,
+						    2000,
+						    entry,
+						    (char *const *)NULL);
+
+		if (i == 0) {
+			g_work[lock_id].pid = pid;
+		}
+	}
 }
 
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
+
 void work_queues_init(void)
 {
 	px4_sem_init(&_work_lock[HPWORK], 0, 1);
@@ -196,21 +468,16 @@ void work_queues_init(void)
 	px4_sem_init(&_work_lock[USRWORK], 0, 1);
 #endif
 
-	// Create high priority worker thread
-	g_work[HPWORK].pid = px4_task_spawn_cmd("hpwork",
-						SCHED_DEFAULT,
-						SCHED_PRIORITY_MAX - 1,
-						2000,
-						work_hpthread,
-						(char *const *)NULL);
-
-	// Create low priority worker thread
-	g_work[LPWORK].pid = px4_task_spawn_cmd("lpwork",
-						SCHED_DEFAULT,
-						SCHED_PRIORITY_MIN,
-						2000,
-						work_lpthread,
-						(char *const *)NULL);
+	for (int i = 0; i < NWORKERS; i++) {
+		px4_sem_init(&_work_wakeup[i], 0, 0);
+		px4_sem_setprotocol(&_work_wakeup[i], SEM_PRIO_NONE);
+	}
+
+	// Create high priority worker threads
+	work_queue_start(HPWORK, SCHED_PRIORITY_MAX - 1, work_hpthread, CONFIG_SCHED_HPNTHREADS);
+
+	// Create low priority worker threads
+	work_queue_start(LPWORK, SCHED_PRIORITY_MIN, work_lpthread, CONFIG_SCHED_LPNTHREADS);
 
 }
 
@@ -267,7 +534,7 @@ int work_hpthread(int argc, char *argv[])
 		 * we process items in the work list.
 		 */
 
-		work_process(&g_work[HPWORK], HPWORK);
+		work_process(HPWORK);
 	}
 
 	return PX4_OK; /* To keep some compilers happy */
@@ -293,7 +560,7 @@ int work_lpthread(int argc, char *argv[])
 		 * we process items in the work list.
 		 */
 
-		work_process(&g_work[LPWORK], LPWORK);
+		work_process(LPWORK);
 	}
 
 	return PX4_OK; /* To keep some compilers happy */
@@ -321,7 +588,7 @@ int work_usrthread(int argc, char *argv[])
 		 * we process items in the work list.
 		 */
 
-		work_process(&g_work[USRWORK], USRWORK);
+		work_process(USRWORK);
 	}
 
 	return PX4_OK; /* To keep some compilers happy */
@@ -42,6 +42,7 @@
 #include "wqueue_test.h"
 
 #include <px4_time.h>
+#include <px4_defines.h>
 #include <px4_workqueue.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -91,6 +92,42 @@ void WQueueTest::do_hp_work()
 	work_queue(HPWORK, &_hpwork, (worker_t)&hp_worker_cb, this, 1000);
 }
 
+static int order[3];
+static volatile int num_ordered = 0;
+
+void WQueueTest::order_worker_cb(void *p)
+{
+	order[num_ordered++] = (int)(intptr_t)p;
+}
+
+int WQueueTest::test_deadline_order()
+{
+	// queued in a different order than they are due
+	const int delays_ms[3] = {30, 10, 20};
+	work_s work[3];
+	memset(work, 0, sizeof(work));
+
+	for (int i = 0; i < 3; ++i) {
+		work_queue(LPWORK, &work[i], (worker_t)&order_worker_cb, (void *)(intptr_t)delays_ms[i],
+			   USEC2TICK(delays_ms[i] * 1000));
+	}
+
+	usleep(200000);
+
+	// the work structures are on the stack: make sure none is left queued
+	for (int i = 0; i < 3; ++i) {
+		work_cancel(LPWORK, &work[i]);
+	}
+
+	if (num_ordered != 3 || order[0] != 10 || order[1] != 20 || order[2] != 30) {
+		printf("work not executed in deadline order\n");
+		return 1;
+	}
+
+	printf("deadline order ok\n");
+	return 0;
+}
+
 int WQueueTest::main()
 {
 	appState.setRunning(true);
@@ -109,5 +146,5 @@ int WQueueTest::main()
 		sleep(2);
 	}
 
-	return 0;
+	return test_deadline_order();
 }
@@ -62,6 +62,9 @@ public:
 private:
 	static void hp_worker_cb(void *p);
 	static void lp_worker_cb(void *p);
+	static void order_worker_cb(void *p);
+
+	int test_deadline_order();
 
 	void do_lp_work(void);
 	void do_hp_work(void);
@@ -46,6 +46,9 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <cstring>
+#include <pthread.h>
+#include <stdlib.h>
+#include <algorithm>
 
 px4::AppState HRTTest::appState;
 
@@ -91,3 +94,211 @@ int HRTTest::main()
 
 	return 0;
 }
+
+struct BenchmarkThreadData {
+	pthread_t thread;
+	unsigned num_calls;
+	unsigned num_time_jumps_back;
+	hrt_abstime max_step;
+};
+
+static volatile bool bench_start = false;
+
+static void *benchmark_thread(void *arg)
+{
+	BenchmarkThreadData *data = (BenchmarkThreadData *)arg;
+
+	while (!bench_start) {
+		usleep(100);
+	}
+
+	hrt_abstime last = hrt_absolute_time();
+
+	for (unsigned i = 0; i < data->num_calls; ++i) {
+		hrt_abstime now = hrt_absolute_time();
+
+		if (now < last) {
+			++data->num_time_jumps_back;
+
+		} else if (now - last > data->max_step) {
+			data->max_step = now - last;
+		}
+
+		last = now;
+	}
+
+	return nullptr;
+}
+
+int HRTTest::benchmark(int num_threads)
+{
+	const unsigned num_calls = 2000000;
+	BenchmarkThreadData *threads = new BenchmarkThreadData[num_threads];
+
+	if (threads == nullptr) {
+		return -1;
+	}
+
+	bench_start = false;
+
+	for (int i = 0; i < num_threads; ++i) {
+		threads[i].num_calls = num_calls;
+		threads[i].num_time_jumps_back = 0;
+		threads[i].max_step = 0;
+
+		if (pthread_create(&threads[i].thread, nullptr, &benchmark_thread, &threads[i]) != 0) {
+			PX4_ERR("pthread_create failed");
+			num_threads = i;
+			break;
+		}
+	}
+
+	struct timespec ts_start, ts_end;
+	clock_gettime(CLOCK_MONOTONIC, &ts_start);
+	bench_start = true;
+
+	int ret = 0;
+
+	for (int i = 0; i < num_threads; ++i) {
+		pthread_join(threads[i].thread, nullptr);
+
+		if (threads[i].num_time_jumps_back > 0) {
+			PX4_ERR("thread %i: time went back %u times", i, threads[i].num_time_jumps_back);
+			ret = -1;
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+	hrt_abstime max_step = 0;
+
+	for (int i = 0; i < num_threads; ++i) {
+		if (threads[i].max_step > max_step) {
+			max_step = threads[i].max_step;
+		}
+	}
+
+	delete[] threads;
+
+	double elapsed = (ts_end.tv_sec - ts_start.tv_sec) + (ts_end.tv_nsec - ts_start.tv_nsec) * 1e-9;
+	double total_calls = (double)num_calls * num_threads;
+
+	PX4_INFO("%i threads, %u calls each: %.3f s", num_threads, num_calls, elapsed);
+	PX4_INFO("%.1f ns per call (per thread), %.2f Mcalls/s total",
+		 elapsed * 1e9 / num_calls, total_calls / elapsed * 1e-6);
+	PX4_INFO("largest step between two calls: %llu us", (unsigned long long)max_step);
+
+	return ret;
+}
+
+struct JitterData {
+	struct hrt_call call;
+	hrt_abstime first_deadline;
+	hrt_abstime period;
+	unsigned count;
+	volatile unsigned num_calls;
+	hrt_abstime *latency;
+	unsigned num_early;
+};
+
+static void jitter_callout(void *arg)
+{
+	JitterData *data = (JitterData *)arg;
+	hrt_abstime now = hrt_absolute_time();
+
+	if (data->num_calls >= data->count) {
+		return;
+	}
+
+	/* the interval is timed between the scheduled call times */
+	hrt_abstime deadline = data->first_deadline + data->num_calls * data->period;
+
+	if (now < deadline) {
+		++data->num_early;
+		data->latency[data->num_calls] = 0;
+
+	} else {
+		data->latency[data->num_calls] = now - deadline;
+	}
+
+	data->num_calls = data->num_calls + 1;
+}
+
+int HRTTest::jitter(unsigned period_us, unsigned count)
+{
+	JitterData data;
+	memset(&data, 0, sizeof(data));
+	data.latency = new hrt_abstime[count];
+
+	if (data.latency == nullptr) {
+		return -1;
+	}
+
+	data.period = period_us;
+	data.count = count;
+
+	const hrt_abstime delay = 10000;
+	data.first_deadline = hrt_absolute_time() + delay;
+	hrt_call_every(&data.call, delay, period_us, jitter_callout, &data);
+
+	while (data.num_calls < count) {
+		usleep(10000);
+	}
+
+	hrt_cancel(&data.call);
+
+	std::sort(data.latency, data.latency + count);
+
+	double sum = 0.0;
+
+	for (unsigned i = 0; i < count; ++i) {
+		sum += data.latency[i];
+	}
+
+	PX4_INFO("%u callouts every %u us: latency avg %.1f us, min %llu, median %llu, 99%% %llu, max %llu us",
+		 count, period_us, sum / count,
+		 (unsigned long long)data.latency[0],
+		 (unsigned long long)data.latency[count / 2],
+		 (unsigned long long)data.latency[(count * 99) / 100],
+		 (unsigned long long)data.latency[count - 1]);
+
+	delete[] data.latency;
+
+	int ret = 0;
+
+	if (data.num_early > 0) {
+		PX4_ERR("%u callouts ran before their deadline", data.num_early);
+		ret = -1;
+	}
+
+	/* insert and cancel lots of calls in the future: should not depend on the number of queued calls */
+	const unsigned num_queued = 20000;
+	struct hrt_call *calls = new struct hrt_call[num_queued];
+
+	if (calls == nullptr) {
+		return -1;
+	}
+
+	memset(calls, 0, num_queued * sizeof(calls[0]));
+
+	hrt_abstime start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < num_queued; ++i) {
+		hrt_call_after(&calls[i], 10000000 + (rand() % 100000000), nullptr, nullptr);
+	}
+
+	hrt_abstime inserted = hrt_absolute_time();
+
+	for (unsigned i = 0; i < num_queued; ++i) {
+		hrt_cancel(&calls[i]);
+	}
+
+	hrt_abstime cancelled = hrt_absolute_time();
+
+	delete[] calls;
+
+	PX4_INFO("%u queued calls: %.3f us per insert, %.3f us per cancel", num_queued,
+		 (double)(inserted - start) / num_queued, (double)(cancelled - inserted) / num_queued);
+
+	return ret;
+}
@@ -50,5 +50,19 @@ public:
 
 	int main();
 
+	/**
+	 * Multi-threaded hrt_absolute_time() benchmark
+	 * @param num_threads number of threads calling hrt_absolute_time() concurrently
+	 */
+	int benchmark(int num_threads);
+
+	/**
+	 * Callout jitter of a periodic hrt_call_every(), and the cost of inserting and
+	 * cancelling many queued calls
+	 * @param period_us callout period
+	 * @param count number of callouts to measure
+	 */
+	int jitter(unsigned period_us, unsigned count);
+
 	static px4::AppState appState; /* track requests to terminate app */
 };
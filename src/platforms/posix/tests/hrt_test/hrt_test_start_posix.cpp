@@ -42,6 +42,7 @@
 #include <px4_tasks.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdlib.h>
 #include <sched.h>
 
 static int daemon_task;             /* Handle of deamon task / thread */
@@ -50,10 +51,47 @@ extern "C" __EXPORT int hrt_test_main(int argc, char *argv[]);
 int hrt_test_main(int argc, char *argv[])
 {
 	if (argc < 2) {
-		PX4_WARN("usage: hrt_test_main {start|stop|status}\n");
+		PX4_WARN("usage: hrt_test_main {start|stop|status|bench [threads]|jitter [period_us] [count]}\n");
 		return 1;
 	}
 
+	if (!strcmp(argv[1], "bench")) {
+		int num_threads = 8;
+
+		if (argc > 2) {
+			num_threads = atoi(argv[2]);
+		}
+
+		if (num_threads < 1) {
+			PX4_WARN("invalid number of threads\n");
+			return 1;
+		}
+
+		HRTTest test;
+		return test.benchmark(num_threads);
+	}
+
+	if (!strcmp(argv[1], "jitter")) {
+		int period_us = 1000;
+		int count = 5000;
+
+		if (argc > 2) {
+			period_us = atoi(argv[2]);
+		}
+
+		if (argc > 3) {
+			count = atoi(argv[3]);
+		}
+
+		if (period_us < 1 || count < 1) {
+			PX4_WARN("invalid period or count\n");
+			return 1;
+		}
+
+		HRTTest test;
+		return test.jitter(period_us, count);
+	}
+
 	if (!strcmp(argv[1], "start")) {
 
 		if (HRTTest::appState.isRunning()) {
@@ -88,6 +126,6 @@ int hrt_test_main(int argc, char *argv[])
 		return 0;
 	}
 
-	PX4_WARN("usage: hrttest_main {start|stop|status}\n");
+	PX4_WARN("usage: hrttest_main {start|stop|status|bench [threads]|jitter [period_us] [count]}\n");
 	return 1;
 }
@@ -50,7 +50,12 @@
 #define sem_setprotocol(s,p)
 #endif
 
-#if defined(__PX4_DARWIN) || defined(__PX4_CYGWIN)
+#if defined(__PX4_DARWIN) || defined(__PX4_CYGWIN) || defined(ENABLE_LOCKSTEP_SCHEDULER)
+
+/* in lockstep mode, the timeouts need to follow the simulated time, which
+ * sem_timedwait() cannot do */
+
+#include <pthread.h>
 
 __BEGIN_DECLS
 
@@ -29,6 +29,17 @@ __EXPORT unsigned int sleep(unsigned int sec);
 
 __END_DECLS
 
+#elif defined(ENABLE_LOCKSTEP_SCHEDULER)
+
+__BEGIN_DECLS
+
+/* follows the simulated time in lockstep mode (see drv_hrt.c) */
+__EXPORT int px4_clock_gettime(clockid_t clk_id, struct timespec *tp);
+
+__END_DECLS
+
+#define px4_clock_settime clock_settime
+
 #else
 
 #define px4_clock_gettime clock_gettime
@@ -58,8 +58,8 @@ __BEGIN_DECLS
 #define NWORKERS 2
 
 struct wqueue_s {
-	pid_t             pid; /* The task ID of the worker thread */
-	struct dq_queue_s q;   /* The queue of pending work */
+	pid_t             pid; /* The task ID of the (first) worker thread */
+	struct dq_queue_s q;   /* The queue of pending work (HRT work queue only) */
 };
 
 extern struct wqueue_s g_work[NWORKERS];
@@ -74,6 +74,7 @@ struct work_s {
 	void *arg;             /* Callback argument */
 	uint64_t  qtime;       /* Time work queued */
 	uint32_t  delay;       /* Delay until work performed */
+	uint32_t  heap_index;  /* Position in the deadline heap of the work queue */
 };
 
 /****************************************************************************
@@ -116,6 +116,10 @@ usage(const char *reason)
 Load or append mixer files to the ESC driver.
 
 Note that the driver must support the used ioctl's, which is the case on NuttX, but for example not on RPi.
+
+If the directory of the mixer file contains a precompiled mixer set (mixers.bin, generated at build time
+from the ROMFS mixers), the precompiled form of the mixer is loaded instead of parsing the text file.
+Drivers without support for it (e.g. px4io) get the text file.
 )DESCR_STR");
 
 
@@ -151,6 +155,17 @@ load(const char *devname, const char *fname, bool append)
 
 	char buf[2048];
 
+	/* use the precompiled mixer if there is one, and if the device supports it */
+	const int image_size = load_mixer_binary(fname, &buf[0], sizeof(buf));
+
+	if (image_size > 0) {
+		const mixer_binary_buf_s image = { &buf[0], (unsigned)image_size };
+
+		if (px4_ioctl(dev, MIXERIOCLOADBIN, (unsigned long)&image) == 0) {
+			return 0;
+		}
+	}
+
 	if (load_mixer_file(fname, &buf[0], sizeof(buf)) < 0) {
 		PX4_ERR("can't load mixer file: %s", fname);
 		return 1;
@@ -37,6 +37,7 @@
  * SD Card benchmarking
  */
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <fcntl.h>
@@ -49,12 +50,17 @@
 #include <px4_log.h>
 
 #include <drivers/drv_hrt.h>
+#include <lib/async_file/async_file.h>
+#include <perf/perf_counter.h>
 
 static void	usage(void);
 
 /** sequential write speed test */
 static void	write_test(int fd, uint8_t *block, int block_size);
 
+/** sequential write speed test with the asynchronous writer (as used by the logger) */
+static void	async_write_test(uint8_t *block, int block_size);
+
 /**
  * Measure the time for fsync.
  * @param fd
@@ -69,6 +75,10 @@ static const char *BENCHMARK_FILE = PX4_ROOTFSDIR"/fs/microsd/benchmark.tmp";
 static int num_runs; ///< number of runs
 static int run_duration; ///< duration of a single run [ms]
 static bool synchronized; ///< call fsync after each block?
+static bool async_io; ///< compare against asynchronous I/O?
+
+static const size_t ASYNC_BLOCK_SIZE = 32 * 1024; ///< size of an asynchronous write request
+static const unsigned ASYNC_NUM_BLOCKS = 8;
 
 static void
 usage()
@@ -80,6 +90,7 @@ usage()
 	PRINT_MODULE_USAGE_PARAM_INT('r', 5, 1, 1000, "Number of runs", true);
 	PRINT_MODULE_USAGE_PARAM_INT('d', 2000, 1, 100000, "Duration of a run in ms", true);
 	PRINT_MODULE_USAGE_PARAM_FLAG('s', "Call fsync after each block (default=at end of each run)", true);
+	PRINT_MODULE_USAGE_PARAM_FLAG('a', "Repeat the test with asynchronous direct I/O (io_uring, Linux only)", true);
 }
 
 int
@@ -90,10 +101,11 @@ sd_bench_main(int argc, char *argv[])
 	int ch;
 	const char *myoptarg = NULL;
 	synchronized = false;
+	async_io = false;
 	num_runs = 5;
 	run_duration = 2000;
 
-	while ((ch = px4_getopt(argc, argv, "b:r:d:s", &myoptind, &myoptarg)) != EOF) {
+	while ((ch = px4_getopt(argc, argv, "b:r:d:sa", &myoptind, &myoptarg)) != EOF) {
 		switch (ch) {
 		case 'b':
 			block_size = strtol(myoptarg, NULL, 0);
@@ -111,6 +123,10 @@ sd_bench_main(int argc, char *argv[])
 			synchronized = true;
 			break;
 
+		case 'a':
+			async_io = true;
+			break;
+
 		default:
 			usage();
 			return -1;
@@ -145,9 +161,13 @@ sd_bench_main(int argc, char *argv[])
 
 	PX4_INFO("Using block size = %i bytes, sync=%i", block_size, (int)synchronized);
 	write_test(bench_fd, block, block_size);
+	close(bench_fd);
+
+	if (async_io) {
+		async_write_test(block, block_size);
+	}
 
 	free(block);
-	close(bench_fd);
 	unlink(BENCHMARK_FILE);
 
 	return 0;
@@ -212,3 +232,76 @@ void write_test(int fd, uint8_t *block, int block_size)
 
 	PX4_INFO("  Avg   : %8.2lf KB/s", (double)block_size * total_blocks / total_elapsed / 1024.);
 }
+
+void async_write_test(uint8_t *block, int block_size)
+{
+	PX4_INFO("");
+	PX4_INFO("Testing Sequential Write Speed with asynchronous I/O...");
+	double total_elapsed = 0.;
+	unsigned int total_blocks = 0;
+	perf_counter_t perf_latency = perf_alloc(PC_ELAPSED, "sd_bench_async_write");
+
+	for (int run = 0; run < num_runs; ++run) {
+		async_file_t file = async_file_open(BENCHMARK_FILE, PX4_O_MODE_666, ASYNC_BLOCK_SIZE, ASYNC_NUM_BLOCKS,
+						    perf_latency);
+
+		if (!file) {
+			PX4_ERR("Can't open benchmark file for asynchronous I/O (%i)", errno);
+			break;
+		}
+
+		if (run == 0) {
+			PX4_INFO("  %u requests of %zu bytes, direct=%i", ASYNC_NUM_BLOCKS, ASYNC_BLOCK_SIZE,
+				 (int)async_file_is_direct(file));
+		}
+
+		hrt_abstime start = hrt_absolute_time();
+		unsigned int num_blocks = 0;
+		unsigned int max_write_time = 0;
+
+		while (hrt_elapsed_time(&start) < run_duration * 1000) {
+
+			hrt_abstime write_start = hrt_absolute_time();
+			int written = async_file_write(file, block, block_size);
+			unsigned int write_time = hrt_elapsed_time(&write_start) / 1000;
+
+			if (write_time > max_write_time) {
+				max_write_time = write_time;
+			}
+
+			if (written != block_size) {
+				PX4_ERR("Write error (%i)", written);
+				async_file_close(file);
+				perf_free(perf_latency);
+				return;
+			}
+
+			if (synchronized) {
+				async_file_sync(file);
+			}
+
+			++num_blocks;
+		}
+
+		//closing waits for all the requests and does an fsync
+		hrt_abstime close_start = hrt_absolute_time();
+		async_file_close(file);
+		unsigned int close_time = hrt_elapsed_time(&close_start) / 1000;
+
+		//report
+		double elapsed = hrt_elapsed_time(&start) / 1.e6;
+		PX4_INFO("  Run %2i: %8.2lf KB/s, max write time: %i ms (=%7.2lf KB/s), close: %i ms", run,
+			 (double)block_size * num_blocks / elapsed / 1024.,
+			 max_write_time, (double)block_size / max_write_time * 1000. / 1024., close_time);
+
+		total_elapsed += elapsed;
+		total_blocks += num_blocks;
+	}
+
+	if (total_elapsed > 0.) {
+		PX4_INFO("  Avg   : %8.2lf KB/s", (double)block_size * total_blocks / total_elapsed / 1024.);
+	}
+
+	perf_print_counter(perf_latency);
+	perf_free(perf_latency);
+}
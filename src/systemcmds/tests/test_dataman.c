@@ -62,6 +62,7 @@ static bool *task_returned_error;
 int test_dataman(int argc, char *argv[]);
 
 #define NUM_MISSIONS_TEST 50
+#define NUM_MISSIONS_BENCHMARK 1000
 
 #define DM_MAX_DATA_SIZE sizeof(struct mission_s)
 
@@ -156,6 +157,61 @@ fail:
 	return -1;
 }
 
+/* time the dataman access patterns of a large mission: the upload from mavlink, the feasibility check (which
+ * reads all items in several passes) and the mission advance in navigator (current and next items) */
+static int
+benchmark_mission(void)
+{
+	const unsigned num_items = NUM_MISSIONS_BENCHMARK < DM_KEY_WAYPOINTS_OFFBOARD_1_MAX ? NUM_MISSIONS_BENCHMARK :
+				   DM_KEY_WAYPOINTS_OFFBOARD_1_MAX;
+	const unsigned num_feasibility_passes = 8;
+	struct mission_item_s item;
+	memset(&item, 0, sizeof(item));
+
+	hrt_abstime start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < num_items; i++) {
+		item.lat = i;
+
+		if (dm_write(DM_KEY_WAYPOINTS_OFFBOARD_1, i, DM_PERSIST_IN_FLIGHT_RESET, &item, sizeof(item)) != sizeof(item)) {
+			PX4_ERR("benchmark: write failed, index %d", i);
+			return -1;
+		}
+	}
+
+	const hrt_abstime upload_time = hrt_elapsed_time(&start);
+	start = hrt_absolute_time();
+
+	for (unsigned pass = 0; pass < num_feasibility_passes; pass++) {
+		for (unsigned i = 0; i < num_items; i++) {
+			if (dm_read(DM_KEY_WAYPOINTS_OFFBOARD_1, i, &item, sizeof(item)) != sizeof(item) || item.lat != i) {
+				PX4_ERR("benchmark: read failed, index %d", i);
+				return -1;
+			}
+		}
+	}
+
+	const hrt_abstime feasibility_time = hrt_elapsed_time(&start);
+	start = hrt_absolute_time();
+
+	for (unsigned i = 0; i < num_items; i++) {
+		for (unsigned next = i; next < i + 3 && next < num_items; next++) {
+			if (dm_read(DM_KEY_WAYPOINTS_OFFBOARD_1, next, &item, sizeof(item)) != sizeof(item) || item.lat != next) {
+				PX4_ERR("benchmark: read failed, index %d", next);
+				return -1;
+			}
+		}
+	}
+
+	const hrt_abstime advance_time = hrt_elapsed_time(&start);
+
+	PX4_INFO("%d items: upload %.1f ms, feasibility check (%d passes) %.1f ms, mission advance %.1f us per item",
+		 num_items, (double)upload_time / 1000, num_feasibility_passes, (double)feasibility_time / 1000,
+		 (double)advance_time / num_items);
+
+	return 0;
+}
+
 int test_dataman(int argc, char *argv[])
 {
 	int i = 0;
@@ -210,6 +266,10 @@ int test_dataman(int argc, char *argv[])
 		return -1;
 	}
 
+	if (benchmark_mission() != 0) {
+		return -1;
+	}
+
 	dm_restart(DM_INIT_REASON_IN_FLIGHT);
 
 	for (i = 0; i < NUM_MISSIONS_TEST; i++) {
@@ -0,0 +1,190 @@
+#include <unit_test.h>
+#include <unit_test_helpers.h>
+
+#include <modules/navigator/geofence_polygon.h>
+#include <mathlib/mathlib.h>
+#include <math.h>
+
+class GeofenceTest : public UnitTest
+{
+public:
+	virtual bool run_tests();
+
+private:
+	bool simplePolygon();
+	bool largePolygons();
+	bool combPolygon();
+	bool benchmark();
+
+	/** star shaped polygon around the origin with a pseudo-random radius for each vertex */
+	bool make_star(GeofencePolygon &polygon, uint16_t vertex_count, float radius);
+
+	/** reference implementation: ray casting over all edges */
+	bool inside_reference(float x, float y) const;
+
+	static constexpr uint16_t MAX_VERTICES = 4096;
+
+	float _x[MAX_VERTICES];
+	float _y[MAX_VERTICES];
+	uint16_t _vertex_count{0};
+	UnitTestRandom _random;
+};
+
+bool GeofenceTest::run_tests()
+{
+	ut_run_test(simplePolygon);
+	ut_run_test(largePolygons);
+	ut_run_test(combPolygon);
+	ut_run_test(benchmark);
+
+	return (_tests_failed == 0);
+}
+
+bool GeofenceTest::make_star(GeofencePolygon &polygon, uint16_t vertex_count, float radius)
+{
+	if (!polygon.init(vertex_count)) {
+		return false;
+	}
+
+	_vertex_count = vertex_count;
+
+	for (uint16_t i = 0; i < vertex_count; ++i) {
+		const float angle = 2.0f * M_PI_F * i / vertex_count;
+		const float r = radius * (0.5f + 0.25f * (_random.uniform(1.0f) + 1.0f));
+		_x[i] = r * cosf(angle);
+		_y[i] = r * sinf(angle);
+		polygon.setVertex(i, _x[i], _y[i]);
+	}
+
+	return polygon.buildIndex();
+}
+
+bool GeofenceTest::inside_reference(float x, float y) const
+{
+	bool c = false;
+
+	for (unsigned i = 0, j = _vertex_count - 1; i < _vertex_count; j = i++) {
+		if (((_y[i] >= y) != (_y[j] >= y)) && (x <= (_x[j] - _x[i]) * (y - _y[i]) / (_y[j] - _y[i]) + _x[i])) {
+			c = !c;
+		}
+	}
+
+	return c;
+}
+
+bool GeofenceTest::simplePolygon()
+{
+	GeofencePolygon polygon;
+	ut_assert_true(polygon.init(4));
+	polygon.setVertex(0, 0.0f, 0.0f);
+	polygon.setVertex(1, 100.0f, 0.0f);
+	polygon.setVertex(2, 100.0f, 50.0f);
+	polygon.setVertex(3, 0.0f, 50.0f);
+	ut_assert_true(polygon.buildIndex());
+	ut_assert_true(polygon.bucketCount() > 0);
+
+	ut_assert_true(polygon.inside(50.0f, 25.0f));
+	ut_assert_true(polygon.inside(1.0f, 49.0f));
+	ut_assert_false(polygon.inside(-1.0f, 25.0f));
+	ut_assert_false(polygon.inside(50.0f, 51.0f));
+	ut_assert_false(polygon.inside(1000.0f, -1000.0f));
+
+	GeofencePolygon empty;
+	ut_assert_false(empty.inside(0.0f, 0.0f));
+
+	return true;
+}
+
+bool GeofenceTest::largePolygons()
+{
+	const uint16_t vertex_counts[] = {3, 20, 200, 1000, MAX_VERTICES};
+
+	for (uint16_t vertex_count : vertex_counts) {
+		GeofencePolygon polygon;
+		ut_assert_true(make_star(polygon, vertex_count, 1000.0f));
+
+		unsigned num_inside = 0;
+
+		for (unsigned i = 0; i < 5000; ++i) {
+			const float x = _random.uniform(1100.0f);
+			const float y = _random.uniform(1100.0f);
+			const bool inside = polygon.inside(x, y);
+			ut_compare("inside", inside, inside_reference(x, y));
+			num_inside += inside;
+		}
+
+		// the vertices are on the edges of the buckets and bounding box
+		for (uint16_t i = 0; i < vertex_count; ++i) {
+			ut_compare("vertex", polygon.inside(_x[i], _y[i]), inside_reference(_x[i], _y[i]));
+		}
+
+		ut_assert_true(num_inside > 0 && num_inside < 5000);
+	}
+
+	return true;
+}
+
+bool GeofenceTest::combPolygon()
+{
+	// a comb with long teeth along the bucket axis: each tooth edge spans the whole polygon
+	const uint16_t num_teeth = 500;
+	GeofencePolygon polygon;
+	ut_assert_true(polygon.init(num_teeth * 4));
+	_vertex_count = num_teeth * 4;
+
+	for (uint16_t t = 0; t < num_teeth; ++t) {
+		const float x = t * 10.0f;
+		const uint16_t i = t * 4;
+		_x[i] = x;
+		_y[i] = 0.0f;
+		_x[i + 1] = x;
+		_y[i + 1] = 1000.0f;
+		_x[i + 2] = x + 5.0f;
+		_y[i + 2] = 1000.0f;
+		_x[i + 3] = x + 5.0f;
+		_y[i + 3] = -10.0f;
+	}
+
+	for (uint16_t i = 0; i < _vertex_count; ++i) {
+		polygon.setVertex(i, _x[i], _y[i]);
+	}
+
+	ut_assert_true(polygon.buildIndex());
+
+	// the memory of the index stays bounded
+	ut_assert_true(polygon.bucketEntries() <= 8u * _vertex_count);
+
+	for (unsigned i = 0; i < 5000; ++i) {
+		const float x = _random.uniform(2600.0f) + 2500.0f;
+		const float y = _random.uniform(600.0f) + 500.0f;
+		ut_compare("inside", polygon.inside(x, y), inside_reference(x, y));
+	}
+
+	return true;
+}
+
+bool GeofenceTest::benchmark()
+{
+	const uint16_t vertex_counts[] = {20, 200, MAX_VERTICES};
+	const unsigned num_checks = 2000;
+
+	for (uint16_t vertex_count : vertex_counts) {
+		GeofencePolygon polygon;
+		ut_assert_true(make_star(polygon, vertex_count, 1000.0f));
+
+		unsigned num_inside = 0;
+
+		const UnitTestBenchmark result = ut_benchmark(num_checks, [&](unsigned) {
+			num_inside += polygon.inside(_random.uniform(1100.0f), _random.uniform(1100.0f));
+		}, [&](unsigned) {
+			num_inside += inside_reference(_random.uniform(1100.0f), _random.uniform(1100.0f));
+		});
+
+		PX4_INFO("%4i vertices, %3i buckets: %.3f us per check (all edges: %.3f us), %i inside",
+			 (int)vertex_count, (int)polygon.bucketCount(), result.time, result.reference_time, num_inside);
+	}
+
+	return true;
+}
+
+ut_declare_test_c(test_geofence, GeofenceTest)
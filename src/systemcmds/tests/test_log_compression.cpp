@@ -0,0 +1,369 @@
+#include <unit_test.h>
+#include <unit_test_helpers.h>
+
+#include <drivers/drv_hrt.h>
+#include <lib/log_compression/lz4_frame.h>
+#include <mathlib/mathlib.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+using namespace log_compression;
+
+class LogCompressionTest : public UnitTest
+{
+public:
+	virtual bool run_tests();
+
+private:
+	bool blockRoundtrip();
+	bool frameIndex();
+	bool benchmark();
+	bool writeFrame();
+
+	/** fill a buffer with ULog-like data: data messages of a few topics with increasing timestamps */
+	void generate_log_data(uint8_t *buffer, size_t size);
+
+	bool compress_frame(const uint8_t *data, size_t size, size_t block_size, uint8_t *frame, size_t &frame_size,
+			    bool with_trailer);
+
+	/** write a buffer to a file, false on error */
+	bool write_file(const char *path, const uint8_t *buffer, size_t size);
+
+#ifdef __PX4_NUTTX
+	static constexpr size_t DATA_SIZE = 64 * 1024;
+#else
+	static constexpr size_t DATA_SIZE = 1024 * 1024;
+#endif
+
+	/** written by writeFrame(), for a check with the reference LZ4 implementation */
+	static constexpr const char *FRAME_DIR = PX4_ROOTFSDIR "/fs/microsd/";
+	static constexpr const char *FRAME_DATA_FILE = PX4_ROOTFSDIR "/fs/microsd/log_compression_test.ulg";
+	static constexpr const char *FRAME_FILE = PX4_ROOTFSDIR "/fs/microsd/log_compression_test.ulg.lz4";
+};
+
+bool LogCompressionTest::run_tests()
+{
+	ut_run_test(blockRoundtrip);
+	ut_run_test(frameIndex);
+	ut_run_test(benchmark);
+	ut_run_test(writeFrame);
+
+	return (_tests_failed == 0);
+}
+
+void LogCompressionTest::generate_log_data(uint8_t *buffer, size_t size)
+{
+	uint64_t timestamp = 1000000;
+	UnitTestRandom rng(1);
+	size_t pos = 0;
+
+	while (pos < size) {
+		timestamp += 4000 + rng.state() % 40;
+
+		for (uint16_t msg_id = 0; msg_id < 4; ++msg_id) {
+			/* header (size, type 'D'), msg id, timestamp, float fields */
+			uint8_t msg[3 + 2 + 8 + 16 * 4];
+			const unsigned num_fields = 4 + msg_id * 4;
+			const uint16_t msg_size = 2 + 8 + num_fields * 4;
+
+			msg[0] = (uint8_t)msg_size;
+			msg[1] = (uint8_t)(msg_size >> 8);
+			msg[2] = 'D';
+			memcpy(&msg[3], &msg_id, sizeof(msg_id));
+			memcpy(&msg[5], &timestamp, sizeof(timestamp));
+
+			for (unsigned i = 0; i < num_fields; ++i) {
+				const float noise = ((rng.next() >> 16) & 0xff) * 1e-4f;
+				const float value = 9.81f * sinf(timestamp * 1e-6f * (i + 1)) + noise;
+				memcpy(&msg[13 + i * 4], &value, sizeof(value));
+			}
+
+			const size_t n = math::min(3 + (size_t)msg_size, size - pos);
+			memcpy(buffer + pos, msg, n);
+			pos += n;
+
+			if (pos >= size) {
+				break;
+			}
+		}
+	}
+}
+
+bool LogCompressionTest::compress_frame(const uint8_t *data, size_t size, size_t block_size, uint8_t *frame,
+					size_t &frame_size, bool with_trailer)
+{
+	LZ4FrameEncoder encoder;
+
+	if (!encoder.init(block_size)) {
+		return false;
+	}
+
+	size_t n;
+	const uint8_t *out = encoder.begin(n);
+	memcpy(frame, out, n);
+	frame_size = n;
+
+	/* feed it in chunks like the log writer, with a partial block flush from time to time */
+	size_t pos = 0;
+	unsigned chunk = 0;
+
+	while (pos < size) {
+		const size_t chunk_size = math::min((size_t)(4096 + (chunk * 997) % 3000), size - pos);
+		size_t consumed = 0;
+
+		while (consumed < chunk_size) {
+			consumed += encoder.append(data + pos + consumed, chunk_size - consumed);
+
+			if (encoder.block_full()) {
+				out = encoder.compress_block(n);
+				memcpy(frame + frame_size, out, n);
+				frame_size += n;
+			}
+		}
+
+		pos += chunk_size;
+
+		if (++chunk % 20 == 0 && (out = encoder.compress_block(n))) {
+			memcpy(frame + frame_size, out, n);
+			frame_size += n;
+		}
+	}
+
+	if ((out = encoder.compress_block(n))) {
+		memcpy(frame + frame_size, out, n);
+		frame_size += n;
+	}
+
+	if (with_trailer) {
+		out = encoder.end(n);
+		memcpy(frame + frame_size, out, n);
+		frame_size += n;
+	}
+
+	return frame_size == encoder.bytes_out() || !with_trailer;
+}
+
+bool LogCompressionTest::blockRoundtrip()
+{
+	static constexpr size_t size = 4096;
+	uint8_t *data = new uint8_t[size];
+	uint8_t *compressed = new uint8_t[lz4_compress_bound(size)];
+	uint8_t *decompressed = new uint8_t[size];
+	uint16_t *hash_table = new uint16_t[LZ4_HASH_TABLE_SIZE];
+	bool ret = data && compressed && decompressed && hash_table;
+
+	for (int pattern = 0; ret && pattern < 4; ++pattern) {
+		UnitTestRandom rng(42);
+
+		for (size_t i = 0; i < size; ++i) {
+			const uint32_t seed = rng.next();
+
+			switch (pattern) {
+			case 0: data[i] = 0; break;
+
+			case 1: data[i] = seed >> 24; break; // incompressible
+
+			case 2: data[i] = "PX4 ULog "[i % 9]; break;
+
+			default: data[i] = (i % 64 < 8) ? (seed >> 24) : i / 64; break;
+			}
+		}
+
+		/* all the sizes around the minimum match and end of block limits, and a full block */
+		for (size_t n = 0; ret && n <= size; n = (n < 32) ? n + 1 : n * 2) {
+			const size_t block_size = math::min(n, size);
+			int compressed_size = lz4_compress(data, block_size, compressed, lz4_compress_bound(block_size), hash_table);
+			int decompressed_size = lz4_decompress(compressed, compressed_size, decompressed, size);
+
+			if (compressed_size < 0 || decompressed_size != (int)block_size
+			    || memcmp(data, decompressed, block_size) != 0
+			    || lz4_decompressed_size(compressed, compressed_size) != (int)block_size) {
+				PX4_ERR("roundtrip failed: pattern %i, size %i", pattern, (int)block_size);
+				ret = false;
+			}
+
+			if (pattern == 0 && block_size == size && compressed_size > 64) {
+				PX4_ERR("zeros not compressed: %i", compressed_size);
+				ret = false;
+			}
+		}
+	}
+
+	/* a too small output buffer and truncated input must be rejected */
+	if (ret) {
+		int compressed_size = lz4_compress(data, size, compressed, lz4_compress_bound(size), hash_table);
+		ret = lz4_decompress(compressed, compressed_size, decompressed, size / 2) == -1
+		      && lz4_decompress(compressed, compressed_size - 1, decompressed, size) == -1
+		      && lz4_decompressed_size(compressed, compressed_size - 1) == -1;
+	}
+
+	delete[] data;
+	delete[] compressed;
+	delete[] decompressed;
+	delete[] hash_table;
+
+	/* frame header checksum (xxHash32 reference value) */
+	const uint8_t flags[2] = {0x60, 0x40};
+	ut_assert_true(ret);
+	ut_compare("header checksum", xxh32_short(flags, 2, 0) >> 8 & 0xff, 0x82);
+
+	return true;
+}
+
+bool LogCompressionTest::frameIndex()
+{
+	static constexpr size_t size = DATA_SIZE / 4;
+	static constexpr size_t block_size = 8 * 1024;
+	uint8_t *data = new uint8_t[size];
+	uint8_t *frame = new uint8_t[lz4_compress_bound(size) + 64 * 1024];
+	uint8_t *block = new uint8_t[block_size];
+	bool ret = data && frame && block;
+	size_t frame_size = 0;
+
+	if (ret) {
+		generate_log_data(data, size);
+	}
+
+	/* with the index, and without it (log not closed) */
+	for (int with_trailer = 1; ret && with_trailer >= 0; --with_trailer) {
+		LZ4FrameReader reader;
+
+		if (!compress_frame(data, size, block_size, frame, frame_size, with_trailer) || !reader.init(frame, frame_size)) {
+			PX4_ERR("compression failed");
+			ret = false;
+			break;
+		}
+
+		if (reader.has_index() != (bool)with_trailer || reader.size() != size || reader.max_block_size() > block_size) {
+			PX4_ERR("wrong frame info: index %i, size %i", reader.has_index(), (int)reader.size());
+			ret = false;
+		}
+
+		/* random access */
+		UnitTestRandom rng(7);
+
+		for (int i = 0; ret && i < 100; ++i) {
+			const uint64_t offset = rng.next() % size;
+			const int b = reader.find_block(offset);
+			const int n = b >= 0 ? reader.read_block(b, block, block_size) : -1;
+
+			if (n < 0 || (size_t)n != reader.block_size(b) || offset < reader.block_offset(b)
+			    || offset >= reader.block_offset(b) + n || memcmp(block, data + reader.block_offset(b), n) != 0) {
+				PX4_ERR("random access at %i failed", (int)offset);
+				ret = false;
+			}
+		}
+
+		ret = ret && reader.find_block(size) == -1;
+	}
+
+	delete[] data;
+	delete[] frame;
+	delete[] block;
+
+	ut_assert_true(ret);
+	return true;
+}
+
+bool LogCompressionTest::benchmark()
+{
+	uint8_t *data = new uint8_t[DATA_SIZE];
+	uint8_t *frame = new uint8_t[lz4_compress_bound(DATA_SIZE) + 64 * 1024];
+	uint8_t *block = new uint8_t[LZ4_MAX_BLOCK_SIZE];
+	bool ret = data && frame && block;
+
+	if (ret) {
+		generate_log_data(data, DATA_SIZE);
+	}
+
+	/* a NuttX-class block size and the one used on POSIX */
+	const size_t block_sizes[] = {16 * 1024, 64 * 1024};
+
+	for (size_t block_size : block_sizes) {
+		if (!ret) {
+			break;
+		}
+
+		size_t frame_size;
+		hrt_abstime start = hrt_absolute_time();
+		ret = compress_frame(data, DATA_SIZE, block_size, frame, frame_size, true);
+		const hrt_abstime compress_time = hrt_elapsed_time(&start);
+
+		LZ4FrameReader reader;
+		ret = ret && reader.init(frame, frame_size);
+		start = hrt_absolute_time();
+
+		for (unsigned b = 0; ret && b < reader.num_blocks(); ++b) {
+			ret = reader.read_block(b, block, LZ4_MAX_BLOCK_SIZE) == (int)reader.block_size(b);
+		}
+
+		const hrt_abstime decompress_time = hrt_elapsed_time(&start);
+
+		PX4_INFO("block size %5i: ratio %.2f, compression %.1f MB/s, decompression %.1f MB/s",
+			 (int)block_size, (double)DATA_SIZE / frame_size, (double)DATA_SIZE / math::max(compress_time, (hrt_abstime)1),
+			 (double)DATA_SIZE / math::max(decompress_time, (hrt_abstime)1));
+
+		ret = ret && frame_size < DATA_SIZE;
+	}
+
+	delete[] data;
+	delete[] frame;
+	delete[] block;
+
+	ut_assert_true(ret);
+	return true;
+}
+
+bool LogCompressionTest::write_file(const char *path, const uint8_t *buffer, size_t size)
+{
+	FILE *file = fopen(path, "wb");
+
+	if (!file) {
+		PX4_ERR("can't open %s", path);
+		return false;
+	}
+
+	const bool ret = fwrite(buffer, 1, size, file) == size;
+	return (fclose(file) == 0) && ret;
+}
+
+bool LogCompressionTest::writeFrame()
+{
+	/* Tools/check_lz4_frame.py decodes the frame with the reference implementation
+	 * and compares it to the data, see posix_log_compression_lz4 in sitl_tests.cmake */
+	struct stat st;
+
+	if (stat(FRAME_DIR, &st) != 0) {
+		PX4_INFO("no storage at %s, skipping", FRAME_DIR);
+		return true;
+	}
+
+	static constexpr size_t size = DATA_SIZE / 4;
+	uint8_t *data = new uint8_t[size];
+	uint8_t *frame = new uint8_t[lz4_compress_bound(size) + 64 * 1024];
+	bool ret = data && frame;
+	size_t frame_size = 0;
+
+	if (ret) {
+		generate_log_data(data, size);
+
+		/* the block size of the logger */
+#ifdef __PX4_NUTTX
+		ret = compress_frame(data, size, 16 * 1024, frame, frame_size, true);
+#else
+		ret = compress_frame(data, size, 64 * 1024, frame, frame_size, true);
+#endif
+	}
+
+	ret = ret && write_file(FRAME_DATA_FILE, data, size) && write_file(FRAME_FILE, frame, frame_size);
+
+	delete[] data;
+	delete[] frame;
+
+	ut_assert_true(ret);
+	return true;
+}
+
+ut_declare_test_c(test_log_compression, LogCompressionTest)
@@ -0,0 +1,227 @@
+#include <unit_test.h>
+#include <unit_test_helpers.h>
+
+#include <matrix/math.hpp>
+#include <modules/local_position_estimator/BlockLocalPositionEstimator.hpp>
+#include <math.h>
+
+typedef BlockLocalPositionEstimator LPE;
+
+class LPETest : public UnitTest
+{
+public:
+	virtual bool run_tests();
+
+private:
+	bool dynamics();
+	bool covariance();
+	bool prediction();
+	bool benchmark();
+
+	/** state space matrices like LPE::initSS() and LPE::updateSSStates() */
+	void random_model(float roll, float pitch, float yaw);
+
+	/** random symmetric positive definite covariance */
+	void random_covariance();
+
+	/** reference implementation: the dense matrix products */
+	Vector<float, LPE::n_x> dynamics_reference(const Vector<float, LPE::n_x> &x) const
+	{
+		return _A * x + _B * _u;
+	}
+
+	Matrix<float, LPE::n_x, LPE::n_x> covariance_reference(float dt) const
+	{
+		return (_A * _P + _P * _A.transpose() + _B * _R * _B.transpose() + _Q) * dt;
+	}
+
+	/** @return true if a and b are equal up to rounding */
+	template<size_t M, size_t N>
+	bool equal(const Matrix<float, M, N> &a, const Matrix<float, M, N> &b) const
+	{
+		for (size_t i = 0; i < M; i++) {
+			for (size_t j = 0; j < N; j++) {
+				if (fabsf(a(i, j) - b(i, j)) > 1e-6f * (1.0f + fabsf(b(i, j)))) {
+					PX4_ERR("(%i, %i): %.9g != %.9g", (int)i, (int)j, (double)a(i, j), (double)b(i, j));
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	Matrix<float, LPE::n_x, LPE::n_x> _A;
+	Matrix<float, LPE::n_x, LPE::n_u> _B;
+	Matrix<float, LPE::n_u, LPE::n_u> _R;
+	Matrix<float, LPE::n_x, LPE::n_x> _Q;
+	Matrix<float, LPE::n_x, LPE::n_x> _P;
+	Vector<float, LPE::n_u> _u;
+	UnitTestRandom _random;
+};
+
+bool LPETest::run_tests()
+{
+	ut_run_test(dynamics);
+	ut_run_test(covariance);
+	ut_run_test(prediction);
+	ut_run_test(benchmark);
+
+	return (_tests_failed == 0);
+}
+
+void LPETest::random_model(float roll, float pitch, float yaw)
+{
+	const Dcmf R_att(Eulerf(roll, pitch, yaw));
+
+	_A.setZero();
+	_A(LPE::X_x, LPE::X_vx) = 1;
+	_A(LPE::X_y, LPE::X_vy) = 1;
+	_A(LPE::X_z, LPE::X_vz) = 1;
+
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			_A(LPE::X_vx + i, LPE::X_bx + j) = -R_att(i, j);
+		}
+	}
+
+	_B.setZero();
+	_B(LPE::X_vx, LPE::U_ax) = 1;
+	_B(LPE::X_vy, LPE::U_ay) = 1;
+	_B(LPE::X_vz, LPE::U_az) = 1;
+
+	_R.setZero();
+	_R(LPE::U_ax, LPE::U_ax) = 0.012f * 0.012f;
+	_R(LPE::U_ay, LPE::U_ay) = 0.012f * 0.012f;
+	_R(LPE::U_az, LPE::U_az) = 0.02f * 0.02f;
+
+	_Q.setZero();
+
+	for (int i = 0; i < LPE::n_x; i++) {
+		_Q(i, i) = 1e-4f * (1.0f + _random.uniform(1.0f));
+	}
+
+	for (int i = 0; i < LPE::n_u; i++) {
+		_u(i) = _random.uniform(20.0f);
+	}
+}
+
+void LPETest::random_covariance()
+{
+	Matrix<float, LPE::n_x, LPE::n_x> L;
+
+	for (int i = 0; i < LPE::n_x; i++) {
+		for (int j = 0; j < LPE::n_x; j++) {
+			L(i, j) = _random.uniform(2.0f);
+		}
+	}
+
+	_P = L * L.transpose();
+}
+
+bool LPETest::dynamics()
+{
+	for (int n = 0; n < 1000; n++) {
+		random_model(_random.uniform(M_PI_F), _random.uniform(M_PI_F / 2), _random.uniform(M_PI_F));
+		Vector<float, LPE::n_x> x;
+
+		for (int i = 0; i < LPE::n_x; i++) {
+			x(i) = _random.uniform(100.0f);
+		}
+
+		ut_assert_true(equal(LPE::dynamics(_A, x, _u), dynamics_reference(x)));
+	}
+
+	return true;
+}
+
+bool LPETest::covariance()
+{
+	for (int n = 0; n < 1000; n++) {
+		random_model(_random.uniform(M_PI_F), _random.uniform(M_PI_F / 2), _random.uniform(M_PI_F));
+		random_covariance();
+
+		Matrix<float, LPE::n_x, LPE::n_x> dP;
+		LPE::covarianceDerivative(_A, _P, _R, _Q, 0.01f, dP);
+		ut_assert_true(equal(dP, covariance_reference(0.01f)));
+	}
+
+	return true;
+}
+
+bool LPETest::prediction()
+{
+	// integrate a flight with a changing attitude, with both implementations
+	const float h = 0.01f;
+	Vector<float, LPE::n_x> x;
+	Vector<float, LPE::n_x> x_ref;
+	Matrix<float, LPE::n_x, LPE::n_x> P;
+	Matrix<float, LPE::n_x, LPE::n_x> P_ref;
+
+	random_model(0, 0, 0);
+	random_covariance();
+	P = _P;
+	P_ref = _P;
+
+	for (int n = 0; n < 2000; n++) {
+		const float t = n * h;
+		random_model(0.3f * sinf(t), 0.2f * cosf(0.7f * t), t);
+
+		Vector<float, LPE::n_x> k1, k2, k3, k4;
+		k1 = LPE::dynamics(_A, x, _u);
+		k2 = LPE::dynamics(_A, x + k1 * h / 2, _u);
+		k3 = LPE::dynamics(_A, x + k2 * h / 2, _u);
+		k4 = LPE::dynamics(_A, x + k3 * h, _u);
+		x += (k1 + k2 * 2 + k3 * 2 + k4) * (h / 6);
+
+		k1 = dynamics_reference(x_ref);
+		k2 = dynamics_reference(x_ref + k1 * h / 2);
+		k3 = dynamics_reference(x_ref + k2 * h / 2);
+		k4 = dynamics_reference(x_ref + k3 * h);
+		x_ref += (k1 + k2 * 2 + k3 * 2 + k4) * (h / 6);
+
+		Matrix<float, LPE::n_x, LPE::n_x> dP;
+		_P = P;
+		LPE::covarianceDerivative(_A, _P, _R, _Q, h, dP);
+		P += dP;
+
+		_P = P_ref;
+		P_ref += covariance_reference(h);
+	}
+
+	ut_assert_true(equal(x, x_ref));
+	ut_assert_true(equal(P, P_ref));
+
+	return true;
+}
+
+bool LPETest::benchmark()
+{
+	const unsigned num_runs = 10000;
+	Vector<float, LPE::n_x> x;
+	Matrix<float, LPE::n_x, LPE::n_x> dP;
+	float sum = 0;
+
+	random_model(0.1f, 0.2f, 0.3f);
+	random_covariance();
+
+	const UnitTestBenchmark result = ut_benchmark(num_runs, [&](unsigned n) {
+		x(LPE::X_bx) = n * 1e-6f;
+		x = LPE::dynamics(_A, x, _u);
+		_P(LPE::X_tz, LPE::X_tz) = n;
+		LPE::covarianceDerivative(_A, _P, _R, _Q, 0.01f, dP);
+		sum += x(LPE::X_vx) + dP(LPE::X_x, LPE::X_x);
+	}, [&](unsigned n) {
+		x(LPE::X_bx) = n * 1e-6f;
+		x = dynamics_reference(x);
+		_P(LPE::X_tz, LPE::X_tz) = n;
+		dP = covariance_reference(0.01f);
+		sum += x(LPE::X_vx) + dP(LPE::X_x, LPE::X_x);
+	});
+
+	PX4_INFO("prediction: %.3f us (dense: %.3f us) %.1f", result.time, result.reference_time, (double)sum);
+
+	return true;
+}
+
+ut_declare_test_c(test_lpe, LPETest)
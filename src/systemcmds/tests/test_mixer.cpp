@@ -40,6 +40,7 @@
 #include <limits>
 #include <dirent.h>
 #include <string.h>
+#include <crc32.h>
 
 #include <px4_config.h>
 #include <mixer/mixer.h>
@@ -54,6 +55,7 @@
 #include "tests_main.h"
 
 #include <unit_test.h>
+#include <unit_test_helpers.h>
 
 static int	mixer_callback(uintptr_t handle,
 			       uint8_t control_group,
@@ -103,6 +105,10 @@ private:
 	bool loadQuadTest();
 	bool loadComplexTest();
 	bool loadAllTest();
+	bool mixerKernelTest();
+	bool mixerBenchmark();
+	bool loadBinaryTest();
+	bool loadBinaryAllTest();
 	bool load_mixer(const char *filename, unsigned expected_count, bool verbose = false);
 	bool load_mixer(const char *filename, const char *buf, unsigned loaded, unsigned expected_count,
 			const unsigned chunk_size, bool verbose);
@@ -124,6 +130,10 @@ bool MixerTest::run_tests()
 	ut_run_test(loadComplexTest);
 	ut_run_test(loadAllTest);
 	ut_run_test(mixerTest);
+	ut_run_test(mixerKernelTest);
+	ut_run_test(mixerBenchmark);
+	ut_run_test(loadBinaryTest);
+	ut_run_test(loadBinaryAllTest);
 
 	return (_tests_failed == 0);
 }
@@ -576,6 +586,431 @@ bool MixerTest::mixerTest()
 	return true;
 }
 
+/* keys of the geometries in src/lib/mixer/geometries */
+static const char *const multirotor_geometries[] = {
+	"4x", "4+", "4w", "4h", "4dc", "4s", "4vt", "4y", "4x1p", "3y", "2-",
+	"6x", "6+", "6c", "6t", "6a", "6m", "8x", "8+", "8c", "8cw"
+};
+
+/* auxiliary outputs: passthrough, asymmetric scaling with limits, sum of two controls, null */
+static const char *const aux_mixers[] = {
+	"M: 1\nS: 0 4 10000 10000 0 -10000 10000\n",
+	"M: 1\nO: 10000 10000 0 -10000 10000\nS: 0 5 -5000 8000 1000 -10000 10000\n",
+	"M: 2\nO: 8000 9000 -500 -9000 9000\nS: 0 0 10000 10000 0 -10000 10000\nS: 0 6 -10000 -10000 0 -10000 10000\n",
+	"M: 1\nS: 0 7 20000 20000 0 -10000 10000\n",
+	"Z:\n",
+};
+
+static constexpr unsigned num_aux_mixers = sizeof(aux_mixers) / sizeof(aux_mixers[0]);
+
+/**
+ * Load a multirotor geometry and the auxiliary mixers into a group, and the same
+ * mixers into a list of single mixers, which are mixed one by one (as MixerGroup
+ * did before the mixers were compiled).
+ */
+static bool
+load_kernel_mixers(const char *geometry, MixerGroup &group, Mixer **mixers)
+{
+	char text[64];
+	snprintf(text, sizeof(text), "R: %s 10000 10000 10000 0\n", geometry);
+
+	unsigned buflen = strlen(text);
+	group.load_from_buf(text, buflen);
+	buflen = strlen(text);
+	mixers[0] = MultirotorMixer::from_text(mixer_callback, 0, text, buflen);
+
+	for (unsigned i = 0; i < num_aux_mixers; i++) {
+		buflen = strlen(aux_mixers[i]);
+		group.load_from_buf(aux_mixers[i], buflen);
+		buflen = strlen(aux_mixers[i]);
+
+		if (aux_mixers[i][0] == 'Z') {
+			mixers[i + 1] = NullMixer::from_text(aux_mixers[i], buflen);
+
+		} else {
+			mixers[i + 1] = SimpleMixer::from_text(mixer_callback, 0, aux_mixers[i], buflen);
+		}
+	}
+
+	for (unsigned i = 0; i < num_aux_mixers + 1; i++) {
+		if (mixers[i] == nullptr) {
+			return false;
+		}
+	}
+
+	return group.count() == num_aux_mixers + 1;
+}
+
+static unsigned
+mix_one_by_one(Mixer **mixers, float *outputs, unsigned space)
+{
+	unsigned index = 0;
+
+	for (unsigned i = 0; i < num_aux_mixers + 1 && index < space; i++) {
+		index += mixers[i]->mix(outputs + index, space - index);
+	}
+
+	return index;
+}
+
+bool MixerTest::mixerKernelTest()
+{
+	UnitTestRandom rng(1);
+	bool ret = true;
+
+	for (const char *geometry : multirotor_geometries) {
+		MixerGroup group(mixer_callback, 0);
+		Mixer *mixers[num_aux_mixers + 1] {};
+
+		if (!load_kernel_mixers(geometry, group, mixers)) {
+			PX4_ERR("%s: load failed", geometry);
+			ret = false;
+		}
+
+		for (unsigned n = 0; ret && n < 2000; n++) {
+			/* random controls, partly out of range, and all the multirotor mixer modes */
+			for (unsigned i = 0; i < output_max; i++) {
+				actuator_controls[i] = rng.uniform(1.2f);
+			}
+
+			const bool airmode = (n / 250) % 2;
+			const float thrust_factor = (n < 1000) ? 0.0f : 0.3f;
+			group.set_airmode(airmode);
+			group.set_thrust_factor(thrust_factor);
+			mixers[0]->set_airmode(airmode);
+			mixers[0]->set_thrust_factor(thrust_factor);
+
+			if (n % 2) {
+				group.set_max_delta_out_once(0.05f);
+				mixers[0]->set_max_delta_out_once(0.05f);
+			}
+
+			float outputs[16];
+			float expected[16];
+			const unsigned space = (n % 100 == 0) ? 3 : 16; // outputs are cut off
+			const unsigned mixed = group.mix(outputs, space);
+			const unsigned expected_mixed = mix_one_by_one(mixers, expected, space);
+			uint16_t expected_saturation = 0;
+
+			for (unsigned i = 0; i < num_aux_mixers + 1; i++) {
+				expected_saturation |= mixers[i]->get_saturation_status();
+			}
+
+			if (mixed != expected_mixed || group.get_saturation_status() != expected_saturation) {
+				PX4_ERR("%s: mixed %u outputs (expected %u), saturation 0x%x (expected 0x%x)", geometry, mixed, expected_mixed,
+					group.get_saturation_status(), expected_saturation);
+				ret = false;
+			}
+
+			for (unsigned i = 0; ret && i < mixed && i < space; i++) {
+				if (outputs[i] != expected[i]) {
+					PX4_ERR("%s: output %u: %.6f != %.6f", geometry, i, (double)outputs[i], (double)expected[i]);
+					ret = false;
+				}
+			}
+		}
+
+		for (unsigned i = 0; i < num_aux_mixers + 1; i++) {
+			delete mixers[i];
+		}
+
+		if (!ret) {
+			break;
+		}
+	}
+
+	ut_assert_true(ret);
+	return true;
+}
+
+bool MixerTest::mixerBenchmark()
+{
+	const unsigned num_cycles = 10000;
+	bool ret = true;
+	float sum = 0.0f;
+
+	for (const char *geometry : multirotor_geometries) {
+		MixerGroup group(mixer_callback, 0);
+		Mixer *mixers[num_aux_mixers + 1] {};
+		float outputs[16];
+		unsigned mixed = 0;
+
+		if (!load_kernel_mixers(geometry, group, mixers)) {
+			ret = false;
+		}
+
+		for (unsigned i = 0; i < output_max; i++) {
+			actuator_controls[i] = 0.1f * i;
+		}
+
+		hrt_abstime start = hrt_absolute_time();
+
+		for (unsigned n = 0; ret && n < num_cycles; n++) {
+			actuator_controls[0] = n * (0.2f / num_cycles);
+			mixed = group.mix(outputs, 16);
+			sum += outputs[0];
+		}
+
+		const hrt_abstime kernel_time = hrt_elapsed_time(&start);
+		start = hrt_absolute_time();
+
+		for (unsigned n = 0; ret && n < num_cycles; n++) {
+			actuator_controls[0] = n * (0.2f / num_cycles);
+			mix_one_by_one(mixers, outputs, 16);
+			sum += outputs[0];
+		}
+
+		const hrt_abstime one_by_one_time = hrt_elapsed_time(&start);
+
+		PX4_INFO("%-4s %2u outputs: %.3f us per cycle (mixers called one by one: %.3f us)", geometry, mixed,
+			 (double)kernel_time / num_cycles, (double)one_by_one_time / num_cycles);
+
+		for (unsigned i = 0; i < num_aux_mixers + 1; i++) {
+			delete mixers[i];
+		}
+	}
+
+	ut_assert_true(ret && PX4_ISFINITE(sum));
+	return true;
+}
+
+/* the mixers of the binary image built by loadBinaryTest() */
+static const char *const binary_test_text =
+	"R: 4x 10000 10000 10000 0\n"
+	"M: 1\nS: 0 4 10000 10000 0 -10000 10000\n"
+	"M: 2\nO: 8000 9000 -500 -9000 9000\nS: 0 0 10000 10000 0 -10000 10000\nS: 0 6 -10000 -10000 0 -10000 10000\n"
+	"Z:\n"
+	"H: 3\nT: 0 3000 6000 8000 10000\nP: -3000 -1500 0 2000 3000\n"
+	"S: 0 10000 10000 0 -8000 8000\nS: 140 10000 -10000 0 -8000 8000\nS: 220 10000 -10000 0 -8000 8000\n";
+
+/** scaler with the values of a mixer text line, converted like the text parser */
+static mixer_scaler_s
+text_scaler(int negative_scale, int positive_scale, int offset, int min_output, int max_output)
+{
+	mixer_scaler_s scaler;
+	scaler.negative_scale = negative_scale / 10000.0f;
+	scaler.positive_scale = positive_scale / 10000.0f;
+	scaler.offset = offset / 10000.0f;
+	scaler.min_output = min_output / 10000.0f;
+	scaler.max_output = max_output / 10000.0f;
+	return scaler;
+}
+
+static void
+binary_add_record(uint8_t *image, unsigned &size, char type, uint8_t control_count, const void *payload,
+		  uint16_t payload_size)
+{
+	mixer_binary_record_s record;
+	record.type = type;
+	record.control_count = control_count;
+	record.size = payload_size;
+	memcpy(image + size, &record, sizeof(record));
+
+	if (payload_size > 0) {
+		memcpy(image + size + sizeof(record), payload, payload_size);
+	}
+
+	size += sizeof(record) + payload_size;
+}
+
+static void
+binary_finish(uint8_t *image, unsigned size)
+{
+	mixer_binary_header_s header;
+	header.magic = MIXER_BINARY_MAGIC;
+	header.version = MIXER_BINARY_VERSION;
+	header.size = size - sizeof(header);
+	header.crc = crc32part(image + sizeof(header), header.size, 0);
+	memcpy(image, &header, sizeof(header));
+}
+
+static void
+binary_add_multirotor(uint8_t *image, unsigned &size, const char *geometry)
+{
+	mixer_binary_multirotor_s config {};
+	strncpy(config.geometry, geometry, sizeof(config.geometry) - 1);
+	config.roll_scale = 1.0f;
+	config.pitch_scale = 1.0f;
+	config.yaw_scale = 1.0f;
+	config.idle_speed = 0.0f;
+	binary_add_record(image, size, 'R', 0, &config, sizeof(config));
+}
+
+bool MixerTest::loadBinaryTest()
+{
+	uint8_t image[1024];
+	unsigned size = sizeof(mixer_binary_header_s);
+	uint8_t payload[MIXER_SIMPLE_SIZE(2)];
+	mixer_simple_s *simple = (mixer_simple_s *)payload;
+
+	binary_add_multirotor(image, size, "4x");
+
+	simple->control_count = 1;
+	simple->output_scaler = text_scaler(10000, 10000, 0, -10000, 10000);
+	simple->controls[0].control_group = 0;
+	simple->controls[0].control_index = 4;
+	simple->controls[0].scaler = text_scaler(10000, 10000, 0, -10000, 10000);
+	binary_add_record(image, size, 'M', 1, simple, MIXER_SIMPLE_SIZE(1));
+
+	simple->control_count = 2;
+	simple->output_scaler = text_scaler(8000, 9000, -500, -9000, 9000);
+	simple->controls[0].control_group = 0;
+	simple->controls[0].control_index = 0;
+	simple->controls[0].scaler = text_scaler(10000, 10000, 0, -10000, 10000);
+	simple->controls[1].control_group = 0;
+	simple->controls[1].control_index = 6;
+	simple->controls[1].scaler = text_scaler(-10000, -10000, 0, -10000, 10000);
+	binary_add_record(image, size, 'M', 2, simple, MIXER_SIMPLE_SIZE(2));
+
+	binary_add_record(image, size, 'Z', 0, nullptr, 0);
+
+	mixer_heli_s heli {};
+	const unsigned angles[3] = {0, 140, 220};
+	const int scales[3] = {10000, -10000, -10000};
+	const int throttle_curve[HELI_CURVES_NR_POINTS] = {0, 3000, 6000, 8000, 10000};
+	const int pitch_curve[HELI_CURVES_NR_POINTS] = {-3000, -1500, 0, 2000, 3000};
+	heli.control_count = 3;
+
+	for (unsigned i = 0; i < HELI_CURVES_NR_POINTS; i++) {
+		heli.throttle_curve[i] = ((float)throttle_curve[i]) / 10000.0f;
+		heli.pitch_curve[i] = ((float)pitch_curve[i]) / 10000.0f;
+	}
+
+	for (unsigned i = 0; i < 3; i++) {
+		heli.servos[i].angle = ((float)angles[i]) * M_PI_F / 180.0f;
+		heli.servos[i].arm_length = 1.0f;
+		heli.servos[i].scale = ((float)scales[i]) / 10000.0f;
+		heli.servos[i].offset = 0.0f;
+		heli.servos[i].min_output = -0.8f;
+		heli.servos[i].max_output = 0.8f;
+	}
+
+	binary_add_record(image, size, 'H', 3, &heli, sizeof(heli));
+	binary_finish(image, size);
+
+	MixerGroup text_group(mixer_callback, 0);
+	MixerGroup binary_group(mixer_callback, 0);
+	unsigned buflen = strlen(binary_test_text);
+	text_group.load_from_buf(binary_test_text, buflen);
+	ut_compare("text mixers", text_group.count(), 5);
+	ut_compare("binary load", binary_group.load_from_binary(image, size), 0);
+	ut_compare("binary mixers", binary_group.count(), 5);
+
+	UnitTestRandom rng(1);
+
+	for (unsigned n = 0; n < 1000; n++) {
+		for (unsigned i = 0; i < output_max; i++) {
+			actuator_controls[i] = rng.uniform(1.2f);
+		}
+
+		float outputs[16];
+		float expected[16];
+		const unsigned mixed = binary_group.mix(outputs, 16);
+		ut_compare("outputs", mixed, text_group.mix(expected, 16));
+		ut_compare("saturation", binary_group.get_saturation_status(), text_group.get_saturation_status());
+
+		for (unsigned i = 0; i < mixed; i++) {
+			ut_assert_true(outputs[i] == expected[i]);
+		}
+	}
+
+	/* damaged images are rejected without changing the group */
+	image[size - 1] ^= 1;
+	ut_assert_true(binary_group.load_from_binary(image, size) != 0);
+	image[size - 1] ^= 1;
+	ut_assert_true(binary_group.load_from_binary(image, size - 1) != 0);
+
+	/* a valid image with an unknown geometry after another mixer */
+	size = sizeof(mixer_binary_header_s);
+	binary_add_record(image, size, 'Z', 0, nullptr, 0);
+	binary_add_multirotor(image, size, "9q");
+	binary_finish(image, size);
+	ut_assert_true(binary_group.load_from_binary(image, size) != 0);
+
+	/* a simple mixer with less controls than announced */
+	size = sizeof(mixer_binary_header_s);
+	binary_add_record(image, size, 'M', 2, simple, MIXER_SIMPLE_SIZE(1));
+	binary_finish(image, size);
+	ut_assert_true(binary_group.load_from_binary(image, size) != 0);
+
+	ut_compare("group unchanged", binary_group.count(), 5);
+
+	return true;
+}
+
+bool MixerTest::loadBinaryAllTest()
+{
+	DIR *dp = opendir(MIXER_ONBOARD_PATH);
+
+	if (dp == nullptr) {
+		PX4_ERR("File open failed");
+		return false;
+	}
+
+	unsigned compared = 0;
+	bool ret = true;
+	struct dirent *result;
+
+	while (ret && (result = readdir(dp)) != nullptr) {
+		const size_t len = strlen(result->d_name);
+
+		if (len < 4 || strcmp(result->d_name + len - 4, ".mix") != 0) {
+			continue;
+		}
+
+		char path[PATH_MAX];
+		static char text[2048];
+		static uint8_t image[2048];
+		snprintf(path, sizeof(path), "%s/%s", MIXER_ONBOARD_PATH, result->d_name);
+
+		const int size = load_mixer_binary(path, image, sizeof(image));
+
+		if (size < 0 || load_mixer_file(path, text, sizeof(text) - 1) < 0) {
+			continue;
+		}
+
+		/* like px4io, terminate the last line */
+		strcat(text, "\n");
+		unsigned buflen = strlen(text);
+
+		MixerGroup text_group(mixer_callback, 0);
+		MixerGroup binary_group(mixer_callback, 0);
+		text_group.load_from_buf(text, buflen);
+
+		if (binary_group.load_from_binary(image, size) != 0 || binary_group.count() != text_group.count()) {
+			PX4_ERR("%s: loaded %u binary mixers, %u text mixers", result->d_name, binary_group.count(), text_group.count());
+			ret = false;
+		}
+
+		UnitTestRandom rng(1);
+
+		for (unsigned n = 0; ret && n < 200; n++) {
+			for (unsigned i = 0; i < output_max; i++) {
+				actuator_controls[i] = rng.uniform(1.2f);
+			}
+
+			float outputs[32];
+			float expected[32];
+			const unsigned mixed = binary_group.mix(outputs, 32);
+			ret = mixed == text_group.mix(expected, 32) && memcmp(outputs, expected, mixed * sizeof(float)) == 0;
+
+			if (!ret) {
+				PX4_ERR("%s: outputs differ", result->d_name);
+			}
+		}
+
+		compared++;
+	}
+
+	closedir(dp);
+
+	/* the mixer set is generated for the ROMFS image, SITL uses the text files */
+	PX4_INFO("compared %u binary mixers in %s", compared, MIXER_ONBOARD_PATH);
+
+	ut_assert_true(ret);
+	return true;
+}
+
 static int
 mixer_callback(uintptr_t handle, uint8_t control_group, uint8_t control_index, float &control)
 {
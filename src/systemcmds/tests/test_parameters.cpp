@@ -1,5 +1,6 @@
 #include <unit_test.h>
 
+#include <drivers/drv_hrt.h>
 #include <px4_defines.h>
 #include <fcntl.h>
 
@@ -29,6 +30,7 @@ private:
 	bool _assert_parameter_float_value(param_t param, float expected);
 
 	bool _set_all_int_parameters_to(int32_t value);
+	bool _import_benchmark(const char *param_config_name);
 
 	// tests on the test parameters (TEST_RC_X, TEST_RC2_X, TEST_1, TEST_2, TEST_3)
 	bool SimpleFind();
@@ -42,6 +44,7 @@ private:
 	// tests on system parameters
 	// WARNING, can potentially trash your system
 	bool exportImportAll();
+	bool importBenchmark();
 };
 
 bool ParameterTest::_assert_parameter_int_value(param_t param, int32_t expected)
@@ -484,6 +487,128 @@ bool ParameterTest::exportImportAll()
 	return ret;
 }
 
+bool ParameterTest::_import_benchmark(const char *param_config_name)
+{
+	// a big airframe config: 600 changed parameters
+	static constexpr unsigned NUM_CHANGED = 600;
+	static constexpr float MAGIC_FLOAT_VAL = 0.314159f;
+
+	// create the config: change every n-th parameter, spread over the whole table
+	param_reset_all();
+
+	const unsigned N = param_count();
+	const unsigned step = N > NUM_CHANGED ? N / NUM_CHANGED : 1;
+	unsigned num_changed = 0;
+
+	for (unsigned i = 0; i < N && num_changed < NUM_CHANGED; i += step) {
+		param_t p = param_for_index(i);
+
+		if (param_type(p) == PARAM_TYPE_INT32) {
+			const int32_t set_val = p + 1;
+			param_set_no_notification(p, &set_val);
+			num_changed++;
+
+		} else if (param_type(p) == PARAM_TYPE_FLOAT) {
+			const float set_val = (float)p + MAGIC_FLOAT_VAL;
+			param_set_no_notification(p, &set_val);
+			num_changed++;
+		}
+	}
+
+	int fd = open(param_config_name, O_WRONLY | O_CREAT | O_TRUNC, PX4_O_MODE_666);
+
+	if (fd < 0) {
+		PX4_ERR("open '%s' failed (%i)", param_config_name, errno);
+		return false;
+	}
+
+	int result = param_export(fd, false);
+	close(fd);
+
+	ut_compare("param_export failed", PX4_OK, result);
+
+	// load it the same way as on boot
+	param_reset_all();
+
+	fd = open(param_config_name, O_RDONLY);
+
+	if (fd < 0) {
+		PX4_ERR("open '%s' failed (%i)", param_config_name, errno);
+		return false;
+	}
+
+	const hrt_abstime start = hrt_absolute_time();
+	result = param_import(fd);
+	const hrt_abstime elapsed = hrt_elapsed_time(&start);
+	close(fd);
+
+	ut_compare("param_import failed", PX4_OK, result);
+
+	PX4_INFO("param_import of %u changed parameters: %.3f ms", num_changed, (double)elapsed / 1e3);
+
+	// check the imported values
+	for (unsigned i = 0, checked = 0; i < N && checked < num_changed; i += step) {
+		param_t p = param_for_index(i);
+
+		if (param_type(p) == PARAM_TYPE_INT32) {
+			ut_compare("imported value does not match", true, _assert_parameter_int_value(p, p + 1));
+			checked++;
+
+		} else if (param_type(p) == PARAM_TYPE_FLOAT) {
+			ut_compare("imported value does not match", true, _assert_parameter_float_value(p, (float)p + MAGIC_FLOAT_VAL));
+			checked++;
+		}
+	}
+
+	return true;
+}
+
+bool ParameterTest::importBenchmark()
+{
+	const char *param_backup_name = PX4_ROOTFSDIR "/fs/microsd/param_backup";
+	const char *param_config_name = PX4_ROOTFSDIR "/fs/microsd/param_bench";
+
+	// backup current parameters
+	int fd = open(param_backup_name, O_WRONLY | O_CREAT | O_TRUNC, PX4_O_MODE_666);
+
+	if (fd < 0) {
+		PX4_ERR("open '%s' failed (%i)", param_backup_name, errno);
+		return false;
+	}
+
+	int result = param_export(fd, false);
+	close(fd);
+
+	if (result != PX4_OK) {
+		PX4_ERR("param_export failed");
+		return false;
+	}
+
+	// the parameters are changed from here on: restore them whatever the outcome
+	bool ret = _import_benchmark(param_config_name);
+	unlink(param_config_name);
+
+	// restore original params
+	param_reset_all();
+
+	fd = open(param_backup_name, O_RDONLY);
+
+	if (fd < 0) {
+		PX4_ERR("open '%s' failed (%i)", param_backup_name, errno);
+		return false;
+	}
+
+	result = param_import(fd);
+	close(fd);
+
+	if (result < 0) {
+		PX4_ERR("importing from '%s' failed (%i)", param_backup_name, result);
+		return false;
+	}
+
+	return ret;
+}
+
 bool ParameterTest::run_tests()
 {
 	param_control_autosave(false);
@@ -500,6 +625,7 @@ bool ParameterTest::run_tests()
 	// WARNING, can potentially trash your system
 #ifdef __PX4_POSIX
 	ut_run_test(exportImportAll);
+	ut_run_test(importBenchmark);
 #endif /* __PX4_POSIX */
 
 	param_control_autosave(true);
@@ -108,11 +108,14 @@ const struct {
 	{"dataman",		test_dataman, OPT_NOJIGTEST | OPT_NOALLTEST},
 	{"file2",		test_file2,	OPT_NOJIGTEST},
 	{"float",		test_float,	0},
+	{"geofence",		test_geofence,	0},
 	{"gpio",		test_gpio,	OPT_NOJIGTEST | OPT_NOALLTEST},
 	{"hott_telemetry",	test_hott_telemetry,	OPT_NOJIGTEST | OPT_NOALLTEST},
 	{"hrt",			test_hrt,	OPT_NOJIGTEST | OPT_NOALLTEST},
 	{"int",			test_int,	0},
 	{"jig_voltages",	test_jig_voltages,	OPT_NOALLTEST},
+	{"log_compression",	test_log_compression,	0},
+	{"lpe",			test_lpe,	0},
 	{"mathlib",		test_mathlib,	0},
 	{"matrix",		test_matrix,	0},
 	{"mount",		test_mount,	OPT_NOJIGTEST | OPT_NOALLTEST},